@@ -1882,6 +1882,21 @@ typedef struct job_info_msg {
 	slurm_job_info_t *job_array;	/* the job records */
 } job_info_msg_t;
 
+#define JOB_DELTA_FULL	SLURM_BIT(0) /* job_info holds every job, discard
+				      * all previously loaded records */
+
+typedef struct job_info_delta_msg {
+	time_t epoch;		/* identifies the controller's generation
+				 * sequence, pass back on the next request */
+	uint16_t flags;		/* JOB_DELTA_* flags */
+	job_info_msg_t *job_info; /* jobs created or modified since the
+				   * requested generation */
+	uint32_t purged_cnt;	/* number of purged_job_ids */
+	uint32_t *purged_job_ids; /* jobs purged or no longer visible */
+	uint64_t update_gen;	/* generation of this data, pass back on
+				 * the next request */
+} job_info_delta_msg_t;
+
 typedef struct step_update_request_msg {
 	uint32_t job_id;
 	uint32_t step_id;
@@ -3107,6 +3122,50 @@ typedef struct stats_info_response_msg {
 	time_t   bf_when_last_cycle;
 	uint32_t bf_active;
 
+	uint32_t job_hash_cnt;
+	char **job_hash_name;
+	uint32_t *job_hash_size;
+	uint32_t *job_hash_records;
+	uint64_t *job_hash_lookups;
+	uint64_t *job_hash_probes;
+	uint32_t *job_hash_probe_max;
+	uint32_t *job_hash_resizes;
+
+	uint32_t rpc_pool_threads;
+	uint32_t rpc_pool_queue_cnt;
+	char **rpc_pool_queue_name;
+	uint32_t *rpc_pool_queue_depth;
+	uint32_t *rpc_pool_queue_depth_max;
+	uint32_t *rpc_pool_queue_count;
+	uint64_t *rpc_pool_queue_wait_time;
+	uint32_t *rpc_pool_queue_wait_max;
+	uint32_t *rpc_pool_queue_rejected;
+
+	uint32_t record_pool_cnt;
+	char **record_pool_name;
+	uint32_t *record_pool_obj_size;
+	uint32_t *record_pool_in_use;
+	uint32_t *record_pool_slabs;
+	uint64_t *record_pool_allocs;
+
+	uint32_t fwd_hop_bucket_cnt;
+	uint32_t *fwd_hop_usec;
+	uint32_t *fwd_hop_cnt;
+	uint32_t fwd_failed;
+	uint32_t fwd_rerouted;
+
+	uint32_t lock_bucket_cnt;
+	uint32_t *lock_bucket_usec;
+	uint32_t lock_caller_cnt;
+	char **lock_caller;
+	uint16_t *lock_type;	/* 0:conf, 1:job, 2:node, 3:part, 4:fed */
+	uint16_t *lock_level;	/* 1:read, 2:write */
+	uint32_t *lock_cnt;
+	uint64_t *lock_wait_usec;
+	uint64_t *lock_hold_usec;
+	uint32_t *lock_wait_hist;	/* lock_bucket_cnt per caller */
+	uint32_t *lock_hold_hist;	/* lock_bucket_cnt per caller */
+
 	uint32_t rpc_type_size;
 	uint16_t *rpc_type_id;
 	uint32_t *rpc_type_cnt;
@@ -3390,6 +3449,21 @@ extern int slurm_submit_batch_job(job_desc_msg_t *job_desc_msg,
 extern int slurm_submit_batch_het_job(List job_req_list,
 				      submit_response_msg_t **slurm_alloc_msg);
 
+/*
+ * slurm_submit_batch_job_list - issue RPC to submit independent batch jobs
+ *	for later execution, each job is accepted or rejected on its own
+ * NOTE: free the response using slurm_list_destroy
+ * IN job_req_list - List of batch job requests, type job_desc_msg_t, fewer
+ *	than 65535 jobs
+ * OUT resp_list - List of responses, type submit_response_msg_t, one per
+ *	request and in the same order. A rejected request has a job_id of zero
+ *	and the reason in error_code and job_submit_user_msg.
+ * NOTE: Not supported by federated clusters, every request is rejected
+ *	with ESLURM_NOT_SUPPORTED
+ * RET SLURM_SUCCESS on success, otherwise return SLURM_ERROR with errno set
+ */
+extern int slurm_submit_batch_job_list(List job_req_list, List *resp_list);
+
 /*
  * slurm_free_submit_response_response_msg - free slurm
  *	job submit response message
@@ -3826,6 +3900,13 @@ extern int slurm_job_cpus_allocated_str_on_node(char *cpus,
  */
 extern void slurm_free_job_info_msg(job_info_msg_t *job_buffer_ptr);
 
+/*
+ * slurm_free_job_info_delta_msg - free the job delta response message
+ * IN msg - pointer to job delta response message
+ * NOTE: buffer is loaded by slurm_load_jobs_delta()
+ */
+extern void slurm_free_job_info_delta_msg(job_info_delta_msg_t *msg);
+
 /*
  * slurm_free_priority_factors_response_msg - free the job priority factor
  *	information response message
@@ -3919,6 +4000,24 @@ extern int slurm_load_jobs(time_t update_time,
 			   job_info_msg_t **job_info_msg_pptr,
 			   uint16_t show_flags);
 
+/*
+ * slurm_load_jobs_delta - issue RPC to get the jobs created, modified or
+ *	purged since a previous slurm_load_jobs_delta() call
+ * IN epoch - epoch from the previous response, 0 on the first call
+ * IN update_gen - update_gen from the previous response, 0 on the first call
+ * OUT delta_msg_pptr - place to store the job delta response. If
+ *	JOB_DELTA_FULL is set in its flags, job_info holds every job and any
+ *	previously loaded records must be discarded. Otherwise replace
+ *	previously loaded records by job_id with those in job_info and remove
+ *	the records listed in purged_job_ids.
+ * IN show_flags - job filtering options (SHOW_FEDERATION is not supported)
+ * RET 0 or -1 on error, errno is SLURM_NO_CHANGE_IN_DATA if nothing changed
+ * NOTE: free the response using slurm_free_job_info_delta_msg
+ */
+extern int slurm_load_jobs_delta(time_t epoch, uint64_t update_gen,
+				 job_info_delta_msg_t **delta_msg_pptr,
+				 uint16_t show_flags);
+
 /*
  * slurm_notify_job - send message to the job's stdout,
  *	usable only by user root
@@ -79,6 +79,7 @@ typedef enum {
 	SLURMCTLD_COMMUNICATIONS_SEND_ERROR,
 	SLURMCTLD_COMMUNICATIONS_RECEIVE_ERROR,
 	SLURMCTLD_COMMUNICATIONS_SHUTDOWN_ERROR,
+	SLURMCTLD_COMMUNICATIONS_BACKOFF,
 
 	/* _info.c/communication layer RESPONSE_SLURM_RC message codes */
 	SLURM_NO_CHANGE_IN_DATA =			1900,
@@ -1651,6 +1651,28 @@ extern List slurmdb_job_modify(void *db_conn,
  */
 extern List slurmdb_jobs_get(void *db_conn, slurmdb_job_cond_t *job_cond);
 
+/*
+ * Called by slurmdb_jobs_get_chunked() with each chunk of jobs found.
+ * IN:  job_list - List of slurmdb_job_rec_t *, freed after the call returns
+ *	so records to be kept must be removed from it
+ * IN:  arg - as given to slurmdb_jobs_get_chunked()
+ * RET: SLURM_SUCCESS to keep going, anything else to ignore the rest
+ */
+typedef int (*slurmdb_job_chunk_f) (List job_list, void *arg);
+
+/*
+ * get info from the storage in chunks of a bounded number of jobs, so the
+ * whole result never needs to be held in memory at once
+ * NOTE: unlike slurmdb_jobs_get() jobs of multiple clusters are not sorted
+ *	 together, they are returned one cluster after another
+ * IN:  slurmdb_job_cond_t *job_cond
+ * IN:  chunk_cb - called with each chunk of jobs, in order
+ * IN:  arg - passed to chunk_cb
+ * RET: SLURM_SUCCESS or error code, errno is set on failure
+ */
+extern int slurmdb_jobs_get_chunked(void *db_conn, slurmdb_job_cond_t *job_cond,
+				    slurmdb_job_chunk_f chunk_cb, void *arg);
+
 /*
  * Fix runaway jobs
  * IN: jobs, a list of all the runaway jobs
@@ -70,6 +70,20 @@ extern List slurmdb_jobs_get(void *db_conn, slurmdb_job_cond_t *job_cond)
 	return jobacct_storage_g_get_jobs_cond(db_conn, db_api_uid, job_cond);
 }
 
+/*
+ * get info from the storage in chunks of a bounded number of jobs
+ * RET: SLURM_SUCCESS or error code
+ */
+extern int slurmdb_jobs_get_chunked(void *db_conn, slurmdb_job_cond_t *job_cond,
+				    slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	if (db_api_uid == -1)
+		db_api_uid = getuid();
+
+	return jobacct_storage_g_get_jobs_cond_chunked(db_conn, db_api_uid,
+						       job_cond, chunk_cb, arg);
+}
+
 /*
  * Fix runaway jobs
  * IN: jobs, a list of all the runaway jobs
@@ -1383,6 +1383,58 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	return rc;
 }
 
+/*
+ * slurm_load_jobs_delta - issue RPC to get the jobs created, modified or
+ *	purged since a previous slurm_load_jobs_delta() call
+ * IN epoch - epoch from the previous response, 0 on the first call
+ * IN update_gen - update_gen from the previous response, 0 on the first call
+ * OUT delta_msg_pptr - place to store the job delta response
+ * IN show_flags - job filtering options
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_delta_msg
+ */
+extern int slurm_load_jobs_delta(time_t epoch, uint64_t update_gen,
+				 job_info_delta_msg_t **delta_msg_pptr,
+				 uint16_t show_flags)
+{
+	slurm_msg_t req_msg, resp_msg;
+	job_info_delta_request_msg_t req;
+	int rc = SLURM_SUCCESS;
+
+	*delta_msg_pptr = NULL;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	memset(&req, 0, sizeof(req));
+	req.epoch        = epoch;
+	req.update_gen   = update_gen;
+	req.show_flags   = (show_flags | SHOW_LOCAL) & (~SHOW_FEDERATION);
+	req_msg.msg_type = REQUEST_JOB_INFO_DELTA;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					   working_cluster_rec) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_JOB_INFO_DELTA:
+		*delta_msg_pptr = (job_info_delta_msg_t *) resp_msg.data;
+		resp_msg.data = NULL;
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		break;
+	default:
+		rc = SLURM_UNEXPECTED_MSG_ERROR;
+		break;
+	}
+	if (rc)
+		slurm_seterrno_ret(rc);
+
+	return SLURM_SUCCESS;
+}
+
 /*
  * slurm_load_job_user - issue RPC to get slurm information about all jobs
  *	to be run as the specified user
@@ -153,3 +153,65 @@ extern int slurm_submit_batch_het_job(List job_req_list,
 
 	return SLURM_SUCCESS;
 }
+
+/*
+ * slurm_submit_batch_job_list - issue RPC to submit independent batch jobs
+ *	for later execution, each job is accepted or rejected on its own
+ * NOTE: free the response using slurm_list_destroy
+ * IN job_req_list - List of batch job requests, type job_desc_msg_t, fewer
+ *	than 65535 jobs
+ * OUT resp_list - List of responses, type submit_response_msg_t, one per
+ *	request and in the same order. A rejected request has a job_id of zero
+ *	and the reason in error_code and job_submit_user_msg.
+ * RET SLURM_SUCCESS on success, otherwise return SLURM_ERROR with errno set
+ */
+extern int slurm_submit_batch_job_list(List job_req_list, List *resp_list)
+{
+	int rc, cnt = 0;
+	job_desc_msg_t *req;
+	slurm_msg_t req_msg;
+	slurm_msg_t resp_msg;
+	ListIterator iter;
+
+	*resp_list = NULL;
+	if (job_req_list)
+		cnt = list_count(job_req_list);
+	if ((cnt == 0) || (cnt >= NO_VAL16))
+		slurm_seterrno_ret(EINVAL);
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+
+	/*
+	 * set session id for this request
+	 */
+	iter = list_iterator_create(job_req_list);
+	while ((req = (job_desc_msg_t *) list_next(iter))) {
+		if (req->alloc_sid == NO_VAL)
+			req->alloc_sid = getsid(0);
+	}
+	list_iterator_destroy(iter);
+
+	req_msg.msg_type = REQUEST_SUBMIT_BATCH_JOB_LIST;
+	req_msg.data     = job_req_list;
+
+	rc = slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					    working_cluster_rec);
+	if (rc == SLURM_ERROR)
+		return SLURM_ERROR;
+	switch (resp_msg.msg_type) {
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		*resp_list = (List) resp_msg.data;
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+	}
+
+	return SLURM_SUCCESS;
+}
@@ -46,6 +46,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_BIT_AVX2 1
+#endif
+
 #include "src/common/bitstring.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
@@ -67,6 +72,15 @@
 #define	_bit_mask(bit) ((bitstr_t)1 << ((bit)&BITSTR_MAXPOS))
 #endif
 
+/* mask for the bits of a partial last word that are within nbits */
+#ifdef SLURM_BIGENDIAN
+#define _bit_tail_mask(nbits) \
+	((bitstr_t)~(BITSTR_MAXVAL >> ((nbits) & BITSTR_MAXPOS)))
+#else
+#define _bit_tail_mask(nbits) \
+	((bitstr_t)(((uint64_t)1 << ((nbits) & BITSTR_MAXPOS)) - 1))
+#endif
+
 /* number of bits actually allocated to a bitstr */
 #define _bitstr_bits(name) 	((name)[1])
 
@@ -146,6 +160,276 @@ strong_alias(bit_nffs,		slurm_bit_nffs);
 strong_alias(bit_copybits,	slurm_bit_copybits);
 strong_alias(bit_get_bit_num,	slurm_bit_get_bit_num);
 strong_alias(bit_get_pos_num,	slurm_bit_get_pos_num);
+strong_alias(bit_and_count,	slurm_bit_and_count);
+
+/* operations applied word by word to a pair of bitstrings */
+typedef enum {
+	BIT_OP_NONE,		/* b1 */
+	BIT_OP_AND,		/* b1 & b2 */
+	BIT_OP_AND_NOT,		/* b1 & ~b2 */
+	BIT_OP_OR,		/* b1 | b2 */
+	BIT_OP_OR_NOT,		/* b1 | ~b2 */
+	BIT_OP_XOR,		/* b1 ^ b2 */
+} bit_op_t;
+
+#ifdef HAVE___BUILTIN_POPCOUNTLL
+#define hweight __builtin_popcountll
+#else
+/*
+ * Returns the hamming weight (i.e. the number of bits set) in a word.
+ * NOTE: This routine borrowed from Linux 4.9 <tools/lib/hweight.c>.
+ */
+static uint64_t
+hweight(uint64_t w)
+{
+        w -= (w >> 1) & 0x5555555555555555ul;
+        w =  (w & 0x3333333333333333ul) + ((w >> 2) & 0x3333333333333333ul);
+        w =  (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0ful;
+        return (w * 0x0101010101010101ul) >> 56;
+}
+#endif
+
+static inline bitstr_t _bit_word_op(bitstr_t w1, bitstr_t w2, bit_op_t op)
+{
+	switch (op) {
+	case BIT_OP_AND:
+		return w1 & w2;
+	case BIT_OP_AND_NOT:
+		return w1 & ~w2;
+	case BIT_OP_OR:
+		return w1 | w2;
+	case BIT_OP_OR_NOT:
+		return w1 | ~w2;
+	case BIT_OP_XOR:
+		return w1 ^ w2;
+	default:
+		return w1;
+	}
+}
+
+#ifdef HAVE_BIT_AVX2
+/*
+ * AVX2 versions of the word loops below, four words at a time. They are
+ * compiled for AVX2 regardless of the build flags and only called once
+ * _have_avx2() has confirmed the CPU supports it.
+ */
+#define _have_avx2() __builtin_cpu_supports("avx2")
+
+__attribute__((target("avx2")))
+static inline __m256i _avx2_op(__m256i v1, __m256i v2, bit_op_t op)
+{
+	switch (op) {
+	case BIT_OP_AND:
+		return _mm256_and_si256(v1, v2);
+	case BIT_OP_AND_NOT:
+		return _mm256_andnot_si256(v2, v1);
+	case BIT_OP_OR:
+		return _mm256_or_si256(v1, v2);
+	case BIT_OP_OR_NOT:
+		return _mm256_or_si256(v1, _mm256_xor_si256(
+					       v2, _mm256_set1_epi64x(-1)));
+	case BIT_OP_XOR:
+		return _mm256_xor_si256(v1, v2);
+	default:
+		return v1;
+	}
+}
+
+/* Per 64-bit lane population count, see Mula et al. arXiv:1611.07612 */
+__attribute__((target("avx2")))
+static inline __m256i _avx2_popcount(__m256i v)
+{
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+						1, 2, 2, 3, 2, 3, 3, 4,
+						0, 1, 1, 2, 1, 2, 2, 3,
+						1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0f);
+	__m256i lo = _mm256_and_si256(v, low_mask);
+	__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+	__m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+				      _mm256_shuffle_epi8(lookup, hi));
+
+	return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static int64_t _avx2_words_op(bitstr_t *b1, bitstr_t *b2, int64_t words,
+			      bit_op_t op)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= words; i += 4) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) &b1[i]);
+		__m256i v2 = _mm256_loadu_si256((__m256i *) &b2[i]);
+
+		_mm256_storeu_si256((__m256i *) &b1[i], _avx2_op(v1, v2, op));
+	}
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int64_t _avx2_words_any(bitstr_t *b1, bitstr_t *b2, int64_t words,
+			       bit_op_t op, bool *found)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= words; i += 4) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) &b1[i]);
+		__m256i v2 = _mm256_loadu_si256((__m256i *) &b2[i]);
+		__m256i v = _avx2_op(v1, v2, op);
+
+		if (!_mm256_testz_si256(v, v)) {
+			*found = true;
+			break;
+		}
+	}
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int64_t _avx2_words_count(bitstr_t *b1, bitstr_t *b2, int64_t words,
+				 bit_op_t op, bool store, int64_t *count)
+{
+	__m256i sum = _mm256_setzero_si256();
+	int64_t i;
+
+	for (i = 0; (i + 4) <= words; i += 4) {
+		__m256i v1 = _mm256_loadu_si256((__m256i *) &b1[i]);
+		__m256i v2 = b2 ? _mm256_loadu_si256((__m256i *) &b2[i]) : v1;
+		__m256i v = _avx2_op(v1, v2, op);
+
+		if (store)
+			_mm256_storeu_si256((__m256i *) &b1[i], v);
+		sum = _mm256_add_epi64(sum, _avx2_popcount(v));
+	}
+	*count += _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+		  _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+
+	return i;
+}
+#endif
+
+/*
+ * b1 = b1 <op> b2 over the first nbits of each, whole words at a time.
+ */
+static void _bit_words_op(bitstr_t *b1, bitstr_t *b2, bitoff_t nbits,
+			  bit_op_t op)
+{
+	int64_t i = 0, words = _bitstr_words(nbits) - BITSTR_OVERHEAD;
+
+	b1 += BITSTR_OVERHEAD;
+	b2 += BITSTR_OVERHEAD;
+#ifdef HAVE_BIT_AVX2
+	if (_have_avx2())
+		i = _avx2_words_op(b1, b2, words, op);
+#endif
+	for ( ; i < words; i++)
+		b1[i] = _bit_word_op(b1[i], b2[i], op);
+}
+
+/*
+ * Return true if any of the first nbits of (b1 <op> b2) is set, stopping at
+ * the first word found.
+ */
+static bool _bit_words_any(bitstr_t *b1, bitstr_t *b2, bitoff_t nbits,
+			   bit_op_t op)
+{
+	int64_t i = 0, words = nbits >> BITSTR_SHIFT;
+	bool found = false;
+
+	b1 += BITSTR_OVERHEAD;
+	b2 += BITSTR_OVERHEAD;
+#ifdef HAVE_BIT_AVX2
+	if (_have_avx2()) {
+		i = _avx2_words_any(b1, b2, words, op, &found);
+		if (found)
+			return true;
+	}
+#endif
+	for ( ; i < words; i++) {
+		if (_bit_word_op(b1[i], b2[i], op))
+			return true;
+	}
+	if (nbits & BITSTR_MAXPOS)
+		return (_bit_word_op(b1[i], b2[i], op) & _bit_tail_mask(nbits));
+
+	return false;
+}
+
+/*
+ * Count the bits set in the first nbits of (b1 <op> b2), also storing the
+ * result in b1 if store is set. b2 may be NULL for BIT_OP_NONE.
+ */
+static int32_t _bit_words_count(bitstr_t *b1, bitstr_t *b2, bitoff_t nbits,
+				bit_op_t op, bool store)
+{
+	int64_t i = 0, count = 0, words = nbits >> BITSTR_SHIFT;
+	bitstr_t word;
+
+	b1 += BITSTR_OVERHEAD;
+	if (!b2)
+		b2 = b1;
+	else
+		b2 += BITSTR_OVERHEAD;
+#ifdef HAVE_BIT_AVX2
+	if (_have_avx2())
+		i = _avx2_words_count(b1, b2, words, op, store, &count);
+#endif
+	for ( ; i < words; i++) {
+		word = _bit_word_op(b1[i], b2[i], op);
+		if (store)
+			b1[i] = word;
+		count += hweight(word);
+	}
+	if (nbits & BITSTR_MAXPOS) {
+		word = _bit_word_op(b1[i], b2[i], op);
+		if (store)
+			b1[i] = word;
+		count += hweight(word & _bit_tail_mask(nbits));
+	}
+
+	return count;
+}
+
+/*
+ * Find the first n contiguous bits set (or clear) in b, skipping over words
+ * that are all set or all clear.
+ */
+static bitoff_t _bit_nff(bitstr_t *b, int32_t n, bool set)
+{
+	bitoff_t bit = 0, nbits = _bitstr_bits(b);
+	bitstr_t match = set ? BITSTR_MAXVAL : 0;
+	int32_t cnt = 0;
+
+	while (bit < nbits) {
+		bitstr_t word = b[_bit_word(bit)];
+
+		if (!(bit & BITSTR_MAXPOS) &&
+		    ((bit + BITSTR_MAXPOS) < nbits)) {
+			if (word == match) {
+				bit += sizeof(bitstr_t) * 8;
+				cnt += sizeof(bitstr_t) * 8;
+				if (cnt >= n)
+					return bit - cnt;
+				continue;
+			} else if (word == ~match) {
+				bit += sizeof(bitstr_t) * 8;
+				cnt = 0;
+				continue;
+			}
+		}
+		if (((word & _bit_mask(bit)) != 0) == set) {
+			if (++cnt >= n)
+				return bit - (cnt - 1);
+		} else
+			cnt = 0;
+		bit++;
+	}
+
+	return -1;
+}
 
 /*
  * Allocate a bitstring.
@@ -335,6 +619,11 @@ bit_ffc(bitstr_t *b)
 			bit += sizeof(bitstr_t)*8;
 			continue;
 		}
+#if HAVE___BUILTIN_CLZLL && (defined SLURM_BIGENDIAN)
+		value = bit + __builtin_clzll(~b[word]);
+#elif HAVE___BUILTIN_CTZLL && (!defined SLURM_BIGENDIAN)
+		value = bit + __builtin_ctzll(~b[word]);
+#else
 		while (bit < _bitstr_bits(b) && _bit_word(bit) == word) {
 			if (!bit_test(b, bit)) {
 				value = bit;
@@ -342,8 +631,12 @@ bit_ffc(bitstr_t *b)
 			}
 			bit++;
 		}
+#endif
 	}
-	return value;
+	if (value < _bitstr_bits(b))
+		return value;
+	else
+		return -1;
 }
 
 /* Find the first n contiguous bits clear in b.
@@ -354,26 +647,10 @@ bit_ffc(bitstr_t *b)
 bitoff_t
 bit_nffc(bitstr_t *b, int32_t n)
 {
-	bitoff_t value = -1;
-	bitoff_t bit;
-	int32_t cnt = 0;
-
 	_assert_bitstr_valid(b);
 	xassert(n > 0 && n < _bitstr_bits(b));
 
-	for (bit = 0; bit < _bitstr_bits(b); bit++) {
-		if (bit_test(b, bit)) {		/* fail */
-			cnt = 0;
-		} else {
-			cnt++;
-			if (cnt >= n) {
-				value = bit - (cnt - 1);
-				break;
-			}
-		}
-	}
-
-	return value;
+	return _bit_nff(b, n, false);
 }
 
 /* Find n contiguous bits clear in b starting at some offset.
@@ -433,26 +710,10 @@ bit_noc(bitstr_t *b, int32_t n, int32_t seed)
 bitoff_t
 bit_nffs(bitstr_t *b, int32_t n)
 {
-	bitoff_t value = -1;
-	bitoff_t bit;
-	int32_t cnt = 0;
-
 	_assert_bitstr_valid(b);
 	xassert(n > 0 && n <= _bitstr_bits(b));
 
-	for (bit = 0; bit <= _bitstr_bits(b) - n; bit++) {
-		if (!bit_test(b, bit)) {	/* fail */
-			cnt = 0;
-		} else {
-			cnt++;
-			if (cnt >= n) {
-				value = bit - (cnt - 1);
-				break;
-			}
-		}
-	}
-
-	return value;
+	return _bit_nff(b, n, true);
 }
 
 /*
@@ -570,19 +831,11 @@ bit_fill_gaps(bitstr_t *b)
 int
 bit_super_set(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
-		                           b2[_bit_word(bit)]))
-			return 0;
-	}
-
-	return 1;
+	return !_bit_words_any(b1, b2, _bitstr_bits(b1), BIT_OP_AND_NOT);
 }
 
 /*
@@ -591,20 +844,13 @@ bit_super_set(bitstr_t *b1, bitstr_t *b2)
 extern int
 bit_equal(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
 	if (_bitstr_bits(b1) != _bitstr_bits(b2))
 		return 0;
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != b2[_bit_word(bit)])
-			return 0;
-	}
-
-	return 1;
+	return !_bit_words_any(b1, b2, _bitstr_bits(b1), BIT_OP_XOR);
 }
 
 
@@ -617,14 +863,10 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit, bit_cnt;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
-	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
-	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	_bit_words_op(b1, b2, MIN(_bitstr_bits(b1), _bitstr_bits(b2)), BIT_OP_AND);
 }
 
 /*
@@ -634,14 +876,10 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit, bit_cnt;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
-	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
-	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
+	_bit_words_op(b1, b2, MIN(_bitstr_bits(b1), _bitstr_bits(b2)), BIT_OP_AND_NOT);
 }
 
 /*
@@ -667,14 +905,10 @@ bit_not(bitstr_t *b)
 void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit, bit_cnt;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
-	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
-	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	_bit_words_op(b1, b2, MIN(_bitstr_bits(b1), _bitstr_bits(b2)), BIT_OP_OR);
 }
 
 /*
@@ -684,14 +918,10 @@ bit_or(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_or_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit, bit_cnt;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
-	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
-	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= ~b2[_bit_word(bit)];
+	_bit_words_op(b1, b2, MIN(_bitstr_bits(b1), _bitstr_bits(b2)), BIT_OP_OR_NOT);
 }
 
 /*
@@ -728,23 +958,6 @@ bit_copybits(bitstr_t *dest, bitstr_t *src)
 	memcpy(&dest[BITSTR_OVERHEAD], &src[BITSTR_OVERHEAD], len);
 }
 
-#ifdef HAVE___BUILTIN_POPCOUNTLL
-#define hweight __builtin_popcountll
-#else
-/*
- * Returns the hamming weight (i.e. the number of bits set) in a word.
- * NOTE: This routine borrowed from Linux 4.9 <tools/lib/hweight.c>.
- */
-static uint64_t
-hweight(uint64_t w)
-{
-        w -= (w >> 1) & 0x5555555555555555ul;
-        w =  (w & 0x3333333333333333ul) + ((w >> 2) & 0x3333333333333333ul);
-        w =  (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0ful;
-        return (w * 0x0101010101010101ul) >> 56;
-}
-#endif
-
 /*
  * Count the number of bits set in bitstring.
  *   b (IN)		bitstring to check
@@ -753,21 +966,9 @@ hweight(uint64_t w)
 int32_t
 bit_set_count(bitstr_t *b)
 {
-	int32_t count = 0;
-	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
-
 	_assert_bitstr_valid(b);
 
-	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
-	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b, bit))
-			count++;
-	}
-	return count;
+	return _bit_words_count(b, NULL, _bitstr_bits(b), BIT_OP_NONE, false);
 }
 
 /*
@@ -804,54 +1005,44 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 	return count;
 }
 
-static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
+/*
+ * return number of bits set in b1 that are also set in b2, 0 if no overlap
+ */
+extern int32_t bit_overlap(bitstr_t *b1, bitstr_t *b2)
 {
-	int32_t count = 0;
-	int64_t anded;
-	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
-		if (count_it)
-			count += hweight(anded);
-		else if (anded)
-			return 1;
-	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b1, bit) && bit_test(b2, bit)) {
-			if (count_it)
-				count++;
-			else
-				return 1;
-		}
-	}
-
-	return count;
+	return _bit_words_count(b1, b2, _bitstr_bits(b1), BIT_OP_AND, false);
 }
 
 /*
- * return number of bits set in b1 that are also set in b2, 0 if no overlap
+ * return 1 if there is at least one bit set in b1 that is also set in b2, 0 if
+ * no overlap
  */
-extern int32_t bit_overlap(bitstr_t *b1, bitstr_t *b2)
+extern int32_t bit_overlap_any(bitstr_t *b1, bitstr_t *b2)
 {
-	return _bit_overlap_internal(b1, b2, 1);
+	_assert_bitstr_valid(b1);
+	_assert_bitstr_valid(b2);
+	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
+
+	return _bit_words_any(b1, b2, _bitstr_bits(b1), BIT_OP_AND);
 }
 
 /*
- * return 1 if there is at least one bit set in b1 that is also set in b2, 0 if
- * no overlap
+ * b1 &= b2 and return the number of bits left set in b1, in one pass
+ *   b1 (IN/OUT)	first bitmap
+ *   b2 (IN)		second bitmap, same size as b1
+ *   RETURN		count of set bits in b1
  */
-extern int32_t bit_overlap_any(bitstr_t *b1, bitstr_t *b2)
+extern int32_t bit_and_count(bitstr_t *b1, bitstr_t *b2)
 {
-	return _bit_overlap_internal(b1, b2, 0);
+	_assert_bitstr_valid(b1);
+	_assert_bitstr_valid(b2);
+	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
+
+	return _bit_words_count(b1, b2, _bitstr_bits(b1), BIT_OP_AND, true);
 }
 
 /*
@@ -0,0 +1,226 @@
+/*****************************************************************************\
+ *  conn_cache.c - cache of idle connections to slurmd for reuse
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "src/common/conn_cache.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/net.h"
+#include "src/common/read_config.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+
+/*
+ * Cached connections are not reused after half the time slurmd keeps them
+ * open, so slurmd never closes one just as it is being reused
+ */
+#define CONN_REUSE_SECS (KEEP_CONN_IDLE_SECS / 2)
+
+typedef struct {
+	char key[sizeof(uint16_t) * 2 + sizeof(struct in6_addr)];
+	uint32_t key_len;
+	int fd;
+	time_t last_used;
+} conn_ent_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *cache_hash = NULL;	/* conn_ent_t by address */
+static uint32_t cache_max = 0;
+
+static void _ent_key_id(void *item, const char **key, uint32_t *key_len)
+{
+	conn_ent_t *ent = item;
+
+	*key = ent->key;
+	*key_len = ent->key_len;
+}
+
+static void _ent_free(void *item)
+{
+	conn_ent_t *ent = item;
+
+	(void) close(ent->fd);
+	xfree(ent);
+}
+
+/* Build the cache key, the family, port and address of addr */
+static bool _make_key(slurm_addr_t *addr, conn_ent_t *ent)
+{
+	uint16_t family = addr->ss_family;
+
+	memcpy(ent->key, &family, sizeof(family));
+	if (addr->ss_family == AF_INET) {
+		struct sockaddr_in *in = (struct sockaddr_in *) addr;
+
+		memcpy(ent->key + 2, &in->sin_port, sizeof(in->sin_port));
+		memcpy(ent->key + 4, &in->sin_addr, sizeof(in->sin_addr));
+		ent->key_len = 4 + sizeof(in->sin_addr);
+	} else if (addr->ss_family == AF_INET6) {
+		struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) addr;
+
+		memcpy(ent->key + 2, &in6->sin6_port, sizeof(in6->sin6_port));
+		memcpy(ent->key + 4, &in6->sin6_addr, sizeof(in6->sin6_addr));
+		ent->key_len = 4 + sizeof(in6->sin6_addr);
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+static void _find_expired(void *item, void *arg)
+{
+	conn_ent_t *ent = item;
+	List expired = arg;
+
+	if ((time(NULL) - ent->last_used) >= CONN_REUSE_SECS)
+		list_append(expired, ent);
+}
+
+/* Close connections idle too long to be reused. cache_mutex must be locked */
+static void _purge_expired(void)
+{
+	List expired = list_create(NULL);
+	conn_ent_t *ent;
+
+	xhash_walk(cache_hash, _find_expired, expired);
+	while ((ent = list_pop(expired)))
+		xhash_delete(cache_hash, ent->key, ent->key_len);
+	FREE_NULL_LIST(expired);
+}
+
+extern void conn_cache_init(uint32_t max_conns)
+{
+	slurm_mutex_lock(&cache_mutex);
+	cache_max = max_conns;
+	if (cache_max && !cache_hash)
+		cache_hash = xhash_init(_ent_key_id, _ent_free);
+	slurm_mutex_unlock(&cache_mutex);
+
+	if (max_conns)
+		debug("%s: keeping up to %u idle connections to slurmd",
+		      __func__, max_conns);
+}
+
+extern void conn_cache_fini(void)
+{
+	slurm_mutex_lock(&cache_mutex);
+	cache_max = 0;
+	xhash_free_ptr(&cache_hash);
+	slurm_mutex_unlock(&cache_mutex);
+}
+
+extern bool conn_cache_enabled(uint16_t protocol_version)
+{
+	/* Older slurmd close the connection after each message */
+	return (cache_max &&
+		(protocol_version >= SLURM_22_05_PROTOCOL_VERSION));
+}
+
+extern int conn_cache_get(slurm_addr_t *addr)
+{
+	conn_ent_t key_ent, *ent;
+	struct pollfd pfd;
+	int fd;
+
+	if (!cache_max || !_make_key(addr, &key_ent))
+		return -1;
+
+	slurm_mutex_lock(&cache_mutex);
+	ent = xhash_pop(cache_hash, key_ent.key, key_ent.key_len);
+	slurm_mutex_unlock(&cache_mutex);
+	if (!ent)
+		return -1;
+
+	fd = ent->fd;
+	if ((time(NULL) - ent->last_used) >= CONN_REUSE_SECS) {
+		_ent_free(ent);
+		return -1;
+	}
+	xfree(ent);
+
+	/*
+	 * Nothing is expected from an idle connection, so if it is readable
+	 * slurmd has closed it
+	 */
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) != 0) {
+		log_flag(NET, "%s: cached connection to %pA closed by peer",
+			 __func__, addr);
+		(void) close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+extern void conn_cache_put(slurm_addr_t *addr, int fd)
+{
+	conn_ent_t *ent = xmalloc(sizeof(*ent));
+
+	ent->fd = fd;
+	ent->last_used = time(NULL);
+	if (!_make_key(addr, ent)) {
+		_ent_free(ent);
+		return;
+	}
+
+	slurm_mutex_lock(&cache_mutex);
+	if (cache_max && (xhash_count(cache_hash) >= cache_max))
+		_purge_expired();
+	if (!cache_max || (xhash_count(cache_hash) >= cache_max) ||
+	    xhash_get(cache_hash, ent->key, ent->key_len)) {
+		/* Full, or another connection to addr is already idle */
+		slurm_mutex_unlock(&cache_mutex);
+		_ent_free(ent);
+		return;
+	}
+	xhash_add(cache_hash, ent);
+	slurm_mutex_unlock(&cache_mutex);
+
+	/*
+	 * Messages are written as a length then a body, do not wait for the
+	 * length to be acked before sending the body on the reused connection
+	 */
+	net_set_nodelay(fd);
+}
@@ -0,0 +1,67 @@
+/*****************************************************************************\
+ *  conn_cache.h - cache of idle connections to slurmd for reuse
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _CONN_CACHE_H
+#define _CONN_CACHE_H
+
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * Enable the cache. Until this is called conn_cache_get() returns no
+ * connections and conn_cache_put() closes every connection it is given.
+ * IN max_conns - most idle connections kept open, 0 to disable
+ */
+extern void conn_cache_init(uint32_t max_conns);
+
+/* Close all cached connections and disable the cache */
+extern void conn_cache_fini(void);
+
+/* RET true if messages to a daemon of this version may use the cache */
+extern bool conn_cache_enabled(uint16_t protocol_version);
+
+/*
+ * Take an idle connection to addr out of the cache
+ * RET open file descriptor, or -1 if none is cached or it was closed by the
+ *     peer
+ */
+extern int conn_cache_get(slurm_addr_t *addr);
+
+/*
+ * Return a connection to addr after a complete exchange of messages. It is
+ * kept for reuse if the cache has room, otherwise it is closed.
+ */
+extern void conn_cache_put(slurm_addr_t *addr, int fd);
+
+#endif
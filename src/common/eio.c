@@ -48,14 +48,21 @@
 #define POLLRDHUP POLLHUP
 #endif
 
+#if defined(__linux__)
+#define HAVE_EIO_EPOLL 1
+#include <sys/epoll.h>
+#endif
+
 #include "src/common/fd.h"
 #include "src/common/eio.h"
 #include "src/common/log.h"
 #include "src/common/list.h"
 #include "src/common/net.h"
+#include "src/common/read_config.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
@@ -80,6 +87,26 @@ strong_alias(eio_signal_wakeup,		slurm_eio_signal_wakeup);
  * it wakes up.
  */
 #define EIO_MAGIC 0xe1e10
+
+#ifdef HAVE_EIO_EPOLL
+#define EIO_EPOLL_MAX_EVENTS 1024	/* events returned per epoll_wait() */
+
+/* epoll registration of one file descriptor, indexed by fd */
+typedef struct {
+	eio_obj_t *obj;		/* object last registered on this fd */
+	uint32_t events;	/* EPOLL* events requested for obj */
+	uint32_t pass;		/* last mainloop pass that wanted this fd */
+	uint32_t gen;		/* registration of obj, see _epoll_data() */
+	bool registered;	/* in the epoll set, false if always ready */
+} eio_epoll_slot_t;
+
+/* Event to dispatch without waiting on epoll */
+typedef struct {
+	int fd;
+	short revents;
+} eio_epoll_ready_t;
+#endif
+
 struct eio_handle_components {
 	int  magic;
 	int  fds[2];
@@ -88,10 +115,31 @@ struct eio_handle_components {
 	uint16_t shutdown_wait;
 	List obj_list;
 	List new_objs;
+
+	bool use_epoll;		/* else poll() every object on each pass */
+#ifdef HAVE_EIO_EPOLL
+	int epfd;
+	bool epoll_rebuild;	/* discard the epoll set and start over */
+	uint32_t pass;
+	uint32_t gen;		/* last registration generation */
+	eio_epoll_slot_t *slots;
+	int slot_cnt;
+	eio_epoll_ready_t *ready;
+	int ready_cnt;
+	int ready_size;
+	struct epoll_event *events;
+	int max_events;
+#endif
 };
 
 /* Function prototypes */
 
+#ifdef HAVE_EIO_EPOLL
+static void         _epoll_close(eio_handle_t *eio);
+static int          _epoll_mainloop(eio_handle_t *eio);
+#endif
+static int          _poll_mainloop(eio_handle_t *eio);
+
 static int          _poll_internal(struct pollfd *pfds, unsigned int nfds,
 				   time_t shutdown_time);
 static unsigned int _poll_setup_pollfds(struct pollfd *, eio_obj_t **, List);
@@ -124,6 +172,12 @@ eio_handle_t *eio_handle_create(uint16_t shutdown_wait)
 	if (shutdown_wait > 0)
 		eio->shutdown_wait = shutdown_wait;
 
+#ifdef HAVE_EIO_EPOLL
+	eio->epfd = -1;
+	if (!xstrcasestr(slurm_conf.comm_params, "EioPoll"))
+		eio->use_epoll = true;
+#endif
+
 	return eio;
 }
 
@@ -133,6 +187,12 @@ void eio_handle_destroy(eio_handle_t *eio)
 	xassert(eio->magic == EIO_MAGIC);
 	close(eio->fds[0]);
 	close(eio->fds[1]);
+#ifdef HAVE_EIO_EPOLL
+	_epoll_close(eio);
+	xfree(eio->slots);
+	xfree(eio->ready);
+	xfree(eio->events);
+#endif
 	FREE_NULL_LIST(eio->obj_list);
 	FREE_NULL_LIST(eio->new_objs);
 	slurm_mutex_destroy(&eio->shutdown_mutex);
@@ -268,6 +328,23 @@ static int _eio_wakeup_handler(eio_handle_t *eio)
 }
 
 int eio_handle_mainloop(eio_handle_t *eio)
+{
+	xassert (eio != NULL);
+	xassert (eio->magic == EIO_MAGIC);
+
+#ifdef HAVE_EIO_EPOLL
+	if (eio->use_epoll) {
+		int rc = _epoll_mainloop(eio);
+
+		if (eio->use_epoll)
+			return rc;
+		/* else fall back to poll() */
+	}
+#endif
+	return _poll_mainloop(eio);
+}
+
+static int _poll_mainloop(eio_handle_t *eio)
 {
 	int            retval  = 0;
 	struct pollfd *pollfds = NULL;
@@ -276,9 +353,6 @@ int eio_handle_mainloop(eio_handle_t *eio)
 	unsigned int   n       = 0;
 	time_t shutdown_time;
 
-	xassert (eio != NULL);
-	xassert (eio->magic == EIO_MAGIC);
-
 	while (1) {
 		/* Alloc memory for pfds and map if needed */
 		n = list_count(eio->obj_list);
@@ -486,6 +560,328 @@ static void _poll_handle_event(short revents, eio_obj_t *obj, List objList)
 	}
 }
 
+#ifdef HAVE_EIO_EPOLL
+/*
+ * epoll backend
+ *
+ * The readable() and writable() callbacks are still asked about every object
+ * on each pass, as they may have side effects and there is no other way to
+ * learn that an object's interest has changed. The kernel is only told about
+ * fds whose interest changed though, and only ready fds are returned, rather
+ * than copying in and scanning every fd on each wakeup as poll() does.
+ *
+ * An fd may be closed by a handler before it can be removed from the epoll
+ * set. If the open file was shared with another process, its registration
+ * lives on and may report events under an fd number since reused by another
+ * object. Each registration's generation goes with the fd in the epoll data,
+ * so such events are recognized and the epoll set is rebuilt without them.
+ * Files that do not support epoll (regular files) are treated as always
+ * ready, as poll() does.
+ */
+
+static void _epoll_close(eio_handle_t *eio)
+{
+	if (eio->epfd >= 0)
+		close(eio->epfd);
+	eio->epfd = -1;
+	for (int i = 0; i < eio->slot_cnt; i++) {
+		eio->slots[i].obj = NULL;
+		eio->slots[i].registered = false;
+	}
+}
+
+/* The wakeup pipe is registered with generation 0 */
+static uint64_t _epoll_data(int fd, uint32_t gen)
+{
+	return (((uint64_t) gen << 32) | (uint32_t) fd);
+}
+
+static int _epoll_open(eio_handle_t *eio)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+
+	if ((eio->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		error("%s: epoll_create1: %m", __func__);
+		return SLURM_ERROR;
+	}
+
+	ev.data.u64 = _epoll_data(eio->fds[0], 0);
+	if (epoll_ctl(eio->epfd, EPOLL_CTL_ADD, eio->fds[0], &ev) < 0) {
+		error("%s: epoll_ctl: %m", __func__);
+		_epoll_close(eio);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static void _epoll_add_ready(eio_handle_t *eio, int fd, short revents)
+{
+	if (eio->ready_cnt >= eio->ready_size) {
+		eio->ready_size = MAX(16, eio->ready_size * 2);
+		xrecalloc(eio->ready, eio->ready_size,
+			  sizeof(eio_epoll_ready_t));
+	}
+	eio->ready[eio->ready_cnt].fd = fd;
+	eio->ready[eio->ready_cnt].revents = revents;
+	eio->ready_cnt++;
+}
+
+static short _epoll_to_poll(uint32_t events)
+{
+	short revents = 0;
+
+	if (events & EPOLLIN)
+		revents |= POLLIN;
+	if (events & EPOLLOUT)
+		revents |= POLLOUT;
+	if (events & EPOLLERR)
+		revents |= POLLERR;
+	if (events & EPOLLHUP)
+		revents |= POLLHUP;
+	if (events & EPOLLRDHUP)
+		revents |= POLLRDHUP;
+
+	return revents;
+}
+
+/* Same interest as _poll_setup_pollfds() */
+static uint32_t _epoll_obj_events(eio_obj_t *obj)
+{
+	bool writable = _is_writable(obj);
+	bool readable = _is_readable(obj);
+
+	if (writable && readable)
+		return (EPOLLOUT | EPOLLIN | EPOLLHUP | EPOLLRDHUP);
+	else if (readable)
+		return (EPOLLIN | EPOLLRDHUP);
+	else if (writable)
+		return (EPOLLOUT | EPOLLHUP);
+	return 0;
+}
+
+/* Register one object's interest, RET SLURM_ERROR to fall back to poll() */
+static int _epoll_setup_obj(eio_handle_t *eio, eio_obj_t *obj,
+			    uint32_t events)
+{
+	struct epoll_event ev = { .events = events };
+	eio_epoll_slot_t *slot;
+	int fd = obj->fd, op, rc;
+
+	if (fd >= eio->slot_cnt) {
+		eio->slot_cnt = MAX(fd + 1, eio->slot_cnt * 2);
+		xrecalloc(eio->slots, eio->slot_cnt, sizeof(eio_epoll_slot_t));
+	}
+	slot = &eio->slots[fd];
+
+	if (slot->pass == eio->pass) {
+		debug("%s: fd %d shared by more than one object, falling back to poll()",
+		      __func__, fd);
+		return SLURM_ERROR;
+	}
+	slot->pass = eio->pass;
+
+	if (slot->registered && (slot->obj == obj) && (slot->events == events))
+		return SLURM_SUCCESS;
+
+	if (slot->obj != obj) {
+		if (++eio->gen == 0)
+			eio->gen = 1;
+		slot->gen = eio->gen;
+	}
+	ev.data.u64 = _epoll_data(fd, slot->gen);
+	op = slot->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	rc = epoll_ctl(eio->epfd, op, fd, &ev);
+	if (rc && (errno == ENOENT) && (op == EPOLL_CTL_MOD))
+		rc = epoll_ctl(eio->epfd, EPOLL_CTL_ADD, fd, &ev);
+	else if (rc && (errno == EEXIST) && (op == EPOLL_CTL_ADD))
+		rc = epoll_ctl(eio->epfd, EPOLL_CTL_MOD, fd, &ev);
+
+	slot->obj = obj;
+	slot->events = events;
+	slot->registered = !rc;
+	if (!rc)
+		return SLURM_SUCCESS;
+
+	if (errno == EPERM) {
+		/* Not pollable, always ready */
+		_epoll_add_ready(eio, fd,
+				 _epoll_to_poll(events) & (POLLIN | POLLOUT));
+	} else if (errno == EBADF) {
+		_epoll_add_ready(eio, fd, POLLNVAL);
+	} else {
+		error("%s: epoll_ctl(%d): %m", __func__, fd);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Bring the epoll set up to date with every object's current interest
+ * RET count of objects of interest or -1 to fall back to poll()
+ */
+static int _epoll_setup(eio_handle_t *eio)
+{
+	ListIterator iter;
+	eio_obj_t *obj;
+	uint32_t events;
+	int nobjs = 0;
+
+	if (eio->epoll_rebuild) {
+		_epoll_close(eio);
+		eio->epoll_rebuild = false;
+	}
+	if ((eio->epfd < 0) && _epoll_open(eio))
+		return -1;
+
+	if (++eio->pass == 0)	/* 0 marks slots not wanted last pass */
+		eio->pass = 1;
+	eio->ready_cnt = 0;
+
+	iter = list_iterator_create(eio->obj_list);
+	while ((obj = list_next(iter))) {
+		if (!(events = _epoll_obj_events(obj)) || (obj->fd < 0))
+			continue;
+		if (_epoll_setup_obj(eio, obj, events)) {
+			nobjs = -1;
+			break;
+		}
+		nobjs++;
+	}
+	list_iterator_destroy(iter);
+
+	if (nobjs < 0)
+		return nobjs;
+
+	/* Remove fds no longer of interest */
+	for (int fd = 0; fd < eio->slot_cnt; fd++) {
+		eio_epoll_slot_t *slot = &eio->slots[fd];
+
+		if (slot->pass == eio->pass)
+			continue;
+		/*
+		 * If the fd was closed, any registration left is recognized
+		 * by its generation should it report an event
+		 */
+		if (slot->registered &&
+		    (epoll_ctl(eio->epfd, EPOLL_CTL_DEL, fd, NULL) < 0) &&
+		    (errno != EBADF) && (errno != ENOENT))
+			eio->epoll_rebuild = true;
+		slot->obj = NULL;
+		slot->pass = 0;
+		slot->registered = false;
+	}
+
+	if (eio->max_events < MIN(nobjs + 1, EIO_EPOLL_MAX_EVENTS)) {
+		eio->max_events = MIN(nobjs + 1, EIO_EPOLL_MAX_EVENTS);
+		xrecalloc(eio->events, eio->max_events,
+			  sizeof(struct epoll_event));
+	}
+
+	return nobjs;
+}
+
+static int _epoll_internal(eio_handle_t *eio, time_t shutdown_time)
+{
+	int n, timeout;
+
+	if (eio->ready_cnt)
+		timeout = 0;
+	else if (shutdown_time)
+		timeout = 1000;	/* Return every 1000 msec during shutdown */
+	else
+		timeout = -1;
+	while ((n = epoll_wait(eio->epfd, eio->events, eio->max_events,
+			       timeout)) < 0) {
+		switch (errno) {
+		case EINTR:
+			return 0;
+		case EAGAIN:
+			continue;
+		default:
+			error("epoll_wait: %m");
+			return -1;
+		}
+	}
+
+	return n;
+}
+
+static int _epoll_mainloop(eio_handle_t *eio)
+{
+	int retval = 0, n, fd;
+	time_t shutdown_time;
+	bool wakeup;
+
+	while (1) {
+		debug4("eio: handling events for %d objects",
+		       list_count(eio->obj_list));
+		n = _epoll_setup(eio);
+		if (n < 0) {
+			_epoll_close(eio);
+			eio->use_epoll = false;
+			return SLURM_ERROR;
+		}
+		if (n == 0)
+			break;
+
+		/* Get shutdown_time to pass to _epoll_internal */
+		slurm_mutex_lock(&eio->shutdown_mutex);
+		shutdown_time = eio->shutdown_time;
+		slurm_mutex_unlock(&eio->shutdown_mutex);
+		if ((n = _epoll_internal(eio, shutdown_time)) < 0) {
+			retval = -1;
+			break;
+		}
+
+		/* See if we've been told to shut down by eio_signal_shutdown */
+		wakeup = false;
+		for (int i = 0; i < n; i++) {
+			if (eio->events[i].data.u64 ==
+			    _epoll_data(eio->fds[0], 0))
+				wakeup = true;
+		}
+		if (wakeup)
+			_eio_wakeup_handler(eio);
+
+		for (int i = 0; i < n; i++) {
+			uint64_t data = eio->events[i].data.u64;
+
+			if (data == _epoll_data(eio->fds[0], 0))
+				continue;
+			fd = (int) (uint32_t) data;
+			if ((fd >= eio->slot_cnt) || !eio->slots[fd].obj ||
+			    (_epoll_data(fd, eio->slots[fd].gen) != data)) {
+				/* Stale registration of a closed fd */
+				eio->epoll_rebuild = true;
+				continue;
+			}
+			_poll_handle_event(_epoll_to_poll(
+						   eio->events[i].events),
+					   eio->slots[fd].obj, eio->obj_list);
+		}
+		for (int i = 0; i < eio->ready_cnt; i++) {
+			fd = eio->ready[i].fd;
+			_poll_handle_event(eio->ready[i].revents,
+					   eio->slots[fd].obj, eio->obj_list);
+		}
+
+		slurm_mutex_lock(&eio->shutdown_mutex);
+		shutdown_time = eio->shutdown_time;
+		slurm_mutex_unlock(&eio->shutdown_mutex);
+		if (shutdown_time &&
+		    (difftime(time(NULL), shutdown_time)>=eio->shutdown_wait)) {
+			error("%s: Abandoning IO %d secs after job shutdown initiated",
+			      __func__, eio->shutdown_wait);
+			break;
+		}
+	}
+
+	return retval;
+}
+#endif
+
 static struct io_operations *_ops_copy(struct io_operations *ops)
 {
 	struct io_operations *ret = xmalloc(sizeof(*ops));
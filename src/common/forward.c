@@ -52,9 +52,17 @@
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+/*
+ * A host that failed to take a message is not used as the head of a branch
+ * for this long, unless it replies to a message first
+ */
+#define FWD_FAIL_AVOID_SECS 300
+
 typedef struct {
 	pthread_cond_t *notify;
 	int            *p_thr_count;
@@ -73,6 +81,164 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  header_t *header, int timeout,
 				  int hl_count);
 
+typedef struct {
+	char *name;
+	time_t failed;
+} fwd_fail_t;
+
+static pthread_mutex_t fwd_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *fwd_fail_hash = NULL;	/* fwd_fail_t by host name */
+static fwd_stats_t fwd_stats = {
+	.hop_usec = { 1000, 10000, 100000, 1000000, 10000000, NO_VAL },
+};
+
+static void _fwd_fail_key_id(void *item, const char **key, uint32_t *key_len)
+{
+	fwd_fail_t *fail = item;
+
+	*key = fail->name;
+	*key_len = strlen(fail->name);
+}
+
+static void _fwd_fail_free(void *item)
+{
+	fwd_fail_t *fail = item;
+
+	xfree(fail->name);
+	xfree(fail);
+}
+
+/* fwd_stats_mutex must be locked */
+static void _fwd_fail_add(char *name, time_t now)
+{
+	fwd_fail_t *fail;
+
+	if (!fwd_fail_hash)
+		fwd_fail_hash = xhash_init(_fwd_fail_key_id, _fwd_fail_free);
+
+	if ((fail = xhash_get_str(fwd_fail_hash, name))) {
+		fail->failed = now;
+		return;
+	}
+	fail = xmalloc(sizeof(*fail));
+	fail->name = xstrdup(name);
+	fail->failed = now;
+	xhash_add(fwd_fail_hash, fail);
+}
+
+/* fwd_stats_mutex must be locked */
+static bool _fwd_failed_recently(char *name, time_t now)
+{
+	fwd_fail_t *fail;
+
+	if (!(fail = xhash_get_str(fwd_fail_hash, name)))
+		return false;
+	if (fail->failed + FWD_FAIL_AVOID_SECS > now)
+		return true;
+	xhash_delete_str(fwd_fail_hash, name);
+	return false;
+}
+
+/*
+ * Note which hosts of a branch replied and which could not be reached, as
+ * reported by the branch head. Replies without a node name are from head.
+ */
+static void _fwd_note_replies(List ret_list, char *head)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	time_t now = time(NULL);
+
+	if (!ret_list)
+		return;
+
+	slurm_mutex_lock(&fwd_stats_mutex);
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		char *name = ret_data_info->node_name ?
+			     ret_data_info->node_name : head;
+
+		if (ret_data_info->type == RESPONSE_FORWARD_FAILED)
+			_fwd_fail_add(name, now);
+		else if (fwd_fail_hash && xhash_count(fwd_fail_hash))
+			xhash_delete_str(fwd_fail_hash, name);
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&fwd_stats_mutex);
+}
+
+/* Count one hop started at tv in the latency histogram */
+static void _fwd_note_hop(struct timeval *tv)
+{
+	uint32_t usec = slurm_delta_tv(tv);
+	int i;
+
+	slurm_mutex_lock(&fwd_stats_mutex);
+	for (i = 0; i < (FWD_HOP_BUCKETS - 1); i++) {
+		if (usec < fwd_stats.hop_usec[i])
+			break;
+	}
+	fwd_stats.hop_cnt[i]++;
+	slurm_mutex_unlock(&fwd_stats_mutex);
+}
+
+/*
+ * Move hosts that failed recently from the head of each branch to its end,
+ * so a responsive host forwards the message and a dead one only costs its
+ * own timeout rather than forcing the branch to be abandoned. The branches
+ * keep their members, so the topology of a route plugin split is preserved.
+ */
+static void _fwd_avoid_failed_heads(hostlist_t *sp_hl, int hl_count)
+{
+	hostlist_iterator_t itr;
+	hostlist_t failed_hl;
+	time_t now = time(NULL);
+	char *name;
+	int i, j, failed, count;
+
+	slurm_mutex_lock(&fwd_stats_mutex);
+	if (!fwd_fail_hash || !xhash_count(fwd_fail_hash)) {
+		slurm_mutex_unlock(&fwd_stats_mutex);
+		return;
+	}
+
+	for (j = 0; j < hl_count; j++) {
+		if ((count = hostlist_count(sp_hl[j])) < 2)
+			continue;
+
+		failed = 0;
+		itr = hostlist_iterator_create(sp_hl[j]);
+		while ((name = hostlist_next(itr))) {
+			bool skip = _fwd_failed_recently(name, now);
+
+			free(name);
+			if (!skip)
+				break;
+			failed++;
+		}
+		hostlist_iterator_destroy(itr);
+		if (!failed || (failed == count))
+			continue;
+
+		failed_hl = hostlist_create(NULL);
+		for (i = 0; i < failed; i++) {
+			name = hostlist_shift(sp_hl[j]);
+			hostlist_push_host(failed_hl, name);
+			free(name);
+		}
+		if (slurm_conf.debug_flags & DEBUG_FLAG_ROUTE) {
+			char *hosts = hostlist_ranged_string_xmalloc(failed_hl);
+			log_flag(ROUTE, "%s: not using %s as branch head, failed recently",
+				 __func__, hosts);
+			xfree(hosts);
+		}
+		hostlist_push_list(sp_hl[j], failed_hl);
+		hostlist_destroy(failed_hl);
+		fwd_stats.rerouted++;
+	}
+	slurm_mutex_unlock(&fwd_stats_mutex);
+}
+
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 {
 	if (fwd_tree) {
@@ -106,6 +272,7 @@ void *_forward_thread(void *arg)
 	char *buf = NULL;
 	int steps = 0;
 	int start_timeout = fwd_msg->timeout;
+	struct timeval tv;
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(hl))) {
@@ -123,6 +290,8 @@ void *_forward_thread(void *arg)
 			}
 			goto cleanup;
 		}
+		memset(&tv, 0, sizeof(tv));
+		(void) slurm_delta_tv(&tv);
 		if ((fd = slurm_open_msg_conn(&addr)) < 0) {
 			error("forward_thread to %s: %m", name);
 
@@ -244,6 +413,8 @@ void *_forward_thread(void *arg)
 		}
 
 		ret_list = slurm_receive_msgs(fd, steps, fwd_msg->timeout);
+		_fwd_note_hop(&tv);
+		_fwd_note_replies(ret_list, name);
 		/* info("sent %d forwards got %d back", */
 		/*      fwd_msg->header.forward.cnt, list_count(ret_list)); */
 
@@ -346,6 +517,7 @@ void *_fwd_tree_thread(void *arg)
 	char *name = NULL;
 	char *buf = NULL;
 	slurm_msg_t send_msg;
+	struct timeval tv;
 
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
@@ -383,8 +555,12 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		memset(&tv, 0, sizeof(tv));
+		(void) slurm_delta_tv(&tv);
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
+		_fwd_note_hop(&tv);
+		_fwd_note_replies(ret_list, name);
 
 		xfree(send_msg.forward.nodelist);
 
@@ -543,7 +719,8 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 		       sizeof(slurm_addr_t));
 
 		fwd_msg->header.version = header->version;
-		fwd_msg->header.flags = header->flags;
+		/* The connection to each child is only used once */
+		fwd_msg->header.flags = header->flags & ~SLURM_MSG_KEEP_CONN;
 		fwd_msg->header.msg_type = header->msg_type;
 		fwd_msg->header.body_length = header->body_length;
 		fwd_msg->header.ret_list = NULL;
@@ -606,6 +783,7 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 		hostlist_destroy(hl);
 		return SLURM_ERROR;
 	}
+	_fwd_avoid_failed_heads(sp_hl, hl_count);
 
 	_forward_msg_internal(NULL, sp_hl, forward_struct, header,
 			      forward_struct->timeout, hl_count);
@@ -650,6 +828,7 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 		error("unable to split forward hostlist");
 		return NULL;
 	}
+	_fwd_avoid_failed_heads(sp_hl, hl_count);
 	slurm_mutex_init(&tree_mutex);
 	slurm_cond_init(&notify, NULL);
 
@@ -708,9 +887,32 @@ extern void mark_as_failed_forward(List *ret_list, char *node_name, int err)
 	ret_data_info->err = err;
 	list_push(*ret_list, ret_data_info);
 
+	if (err != SLURM_UNKNOWN_FORWARD_ADDR) {
+		slurm_mutex_lock(&fwd_stats_mutex);
+		_fwd_fail_add(node_name, time(NULL));
+		fwd_stats.failed++;
+		slurm_mutex_unlock(&fwd_stats_mutex);
+	}
+
 	return;
 }
 
+extern void forward_get_stats(fwd_stats_t *stats)
+{
+	slurm_mutex_lock(&fwd_stats_mutex);
+	memcpy(stats, &fwd_stats, sizeof(*stats));
+	slurm_mutex_unlock(&fwd_stats_mutex);
+}
+
+extern void forward_reset_stats(void)
+{
+	slurm_mutex_lock(&fwd_stats_mutex);
+	memset(fwd_stats.hop_cnt, 0, sizeof(fwd_stats.hop_cnt));
+	fwd_stats.failed = 0;
+	fwd_stats.rerouted = 0;
+	slurm_mutex_unlock(&fwd_stats_mutex);
+}
+
 extern void forward_wait(slurm_msg_t * msg)
 {
 	int count = 0;
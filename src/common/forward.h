@@ -111,6 +111,27 @@ extern void mark_as_failed_forward(List *ret_list, char *node_name, int err);
 
 extern void forward_wait(slurm_msg_t *msg);
 
+#define FWD_HOP_BUCKETS 6
+
+/*
+ * Forwarding statistics for this process. A hop is one message sent to the
+ * head of a branch and the wait for the replies of the whole branch.
+ */
+typedef struct {
+	uint32_t hop_usec[FWD_HOP_BUCKETS];	/* bucket upper bounds, the
+						 * last is NO_VAL (no limit) */
+	uint32_t hop_cnt[FWD_HOP_BUCKETS];	/* hops completed per bucket */
+	uint32_t failed;	/* hosts we failed to reach */
+	uint32_t rerouted;	/* branches given a new head because the
+				 * first host failed recently */
+} fwd_stats_t;
+
+/* Fill stats with the forwarding statistics of this process */
+extern void forward_get_stats(fwd_stats_t *stats);
+
+/* Clear the hop and failure counts, not the failed host list */
+extern void forward_reset_stats(void);
+
 /*
  * no_resp_forward - Used to respond for nodes not able to respond since
  *                   the parent had failed in some way
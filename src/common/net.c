@@ -114,6 +114,20 @@ cleanup:
 	return -1;
 }
 
+/* send small writes on socket without waiting for earlier data to be acked */
+extern int net_set_nodelay(int sock)
+{
+	int opt_int = 1;
+
+	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt_int,
+		       sizeof(opt_int)) < 0) {
+		error("Unable to set nodelay socket option: %m");
+		return -1;
+	}
+
+	return 0;
+}
+
 /* set keep alive time on socket */
 extern int net_set_keep_alive(int sock)
 {
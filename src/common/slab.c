@@ -0,0 +1,324 @@
+/*****************************************************************************\
+ *  slab.c - fixed size object pools
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slab.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/*
+ * Target size of each block, objects larger than this get one per block.
+ * Blocks are mapped directly so that releasing one returns its pages to the
+ * system instead of leaving a hole in the heap.
+ */
+#define SLAB_BLOCK_SIZE (64 * 1024)
+/* Per object header, keeps objects aligned as malloc() would */
+#define SLAB_HDR_SIZE 16
+#define SLAB_ALIGN(s) (((s) + 15) & ~((size_t) 15))
+
+#define SLAB_MAGIC 0x51ab51ab
+
+typedef struct slab slab_t;
+
+struct slab {
+	slab_t *next;
+	slab_t *prev;
+	void *free_list;	/* freed objects, linked through first word */
+	uint32_t carved;	/* objects handed out at least once */
+	uint32_t in_use;
+	char *objs;
+};
+
+typedef struct {
+	slab_t *slab;
+#ifndef NDEBUG
+	uint32_t magic;
+#endif
+} slab_hdr_t;
+
+struct slab_pool {
+	char *name;
+	size_t obj_size;
+	size_t stride;
+	size_t slab_size;
+	uint32_t objs_per_slab;
+
+	pthread_mutex_t mutex;
+	slab_t *partial;	/* blocks with free objects */
+	slab_t *full;
+	slab_t *spare;		/* one empty block kept for reuse */
+
+	uint32_t slabs;
+	uint32_t in_use;
+	uint64_t allocs;
+	uint64_t frees;
+
+	slab_pool_t *next;	/* all pools, for slab_get_stats() */
+};
+
+static pthread_mutex_t pools_mutex = PTHREAD_MUTEX_INITIALIZER;
+static slab_pool_t *pools = NULL;
+
+static void _unlink(slab_t **head, slab_t *slab)
+{
+	if (slab->prev)
+		slab->prev->next = slab->next;
+	else
+		*head = slab->next;
+	if (slab->next)
+		slab->next->prev = slab->prev;
+	slab->next = slab->prev = NULL;
+}
+
+static void _push(slab_t **head, slab_t *slab)
+{
+	slab->prev = NULL;
+	slab->next = *head;
+	if (*head)
+		(*head)->prev = slab;
+	*head = slab;
+}
+
+static slab_t *_map_slab(slab_pool_t *pool)
+{
+	slab_t *slab = mmap(NULL, pool->slab_size, (PROT_READ | PROT_WRITE),
+			    (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+
+	if (slab == MAP_FAILED)
+		fatal("%s: mmap(%zu) for %s pool: %m",
+		      __func__, pool->slab_size, pool->name);
+
+	/* Anonymous mappings are zero filled */
+	slab->objs = (char *) slab + SLAB_ALIGN(sizeof(*slab));
+	pool->slabs++;
+
+	return slab;
+}
+
+static void _unmap_slab(slab_pool_t *pool, slab_t *slab)
+{
+	if (munmap(slab, pool->slab_size))
+		error("%s: munmap for %s pool: %m", __func__, pool->name);
+	pool->slabs--;
+}
+
+static void _free_slabs(slab_pool_t *pool, slab_t *slab)
+{
+	slab_t *next;
+
+	for (; slab; slab = next) {
+		next = slab->next;
+		_unmap_slab(pool, slab);
+	}
+}
+
+extern slab_pool_t *slab_pool_create(const char *name, size_t obj_size)
+{
+	slab_pool_t *pool = xmalloc(sizeof(*pool));
+
+	xassert(obj_size);
+
+	pool->name = xstrdup(name);
+	pool->obj_size = obj_size;
+	pool->stride = SLAB_HDR_SIZE + SLAB_ALIGN(obj_size);
+	pool->objs_per_slab = MAX(1, ((SLAB_BLOCK_SIZE -
+					SLAB_ALIGN(sizeof(slab_t))) /
+				       pool->stride));
+	pool->slab_size = SLAB_ALIGN(sizeof(slab_t)) +
+			  (pool->stride * pool->objs_per_slab);
+	slurm_mutex_init(&pool->mutex);
+
+	slurm_mutex_lock(&pools_mutex);
+	pool->next = pools;
+	pools = pool;
+	slurm_mutex_unlock(&pools_mutex);
+
+	return pool;
+}
+
+extern void slab_pool_destroy(slab_pool_t *pool)
+{
+	slab_pool_t **pp;
+
+	if (!pool)
+		return;
+
+	slurm_mutex_lock(&pools_mutex);
+	for (pp = &pools; *pp; pp = &(*pp)->next) {
+		if (*pp == pool) {
+			*pp = pool->next;
+			break;
+		}
+	}
+	slurm_mutex_unlock(&pools_mutex);
+
+	if (pool->in_use)
+		debug("%s: %s pool destroyed with %u objects in use",
+		      __func__, pool->name, pool->in_use);
+
+	_free_slabs(pool, pool->partial);
+	_free_slabs(pool, pool->full);
+	_free_slabs(pool, pool->spare);
+	slurm_mutex_destroy(&pool->mutex);
+	xfree(pool->name);
+	xfree(pool);
+}
+
+extern void *slab_alloc(slab_pool_t *pool)
+{
+	slab_t *slab;
+	slab_hdr_t *hdr;
+	void *obj;
+
+	xassert(pool);
+
+	slurm_mutex_lock(&pool->mutex);
+	if (!(slab = pool->partial)) {
+		if ((slab = pool->spare)) {
+			pool->spare = NULL;
+		} else {
+			/*
+			 * Objects are carved from the block as needed, so
+			 * pages of a new block are only touched once used.
+			 */
+			slab = _map_slab(pool);
+		}
+		_push(&pool->partial, slab);
+	}
+
+	if ((obj = slab->free_list)) {
+		slab->free_list = *((void **) obj);
+		hdr = (slab_hdr_t *) ((char *) obj - SLAB_HDR_SIZE);
+	} else {
+		hdr = (slab_hdr_t *) (slab->objs +
+				      (pool->stride * slab->carved++));
+		hdr->slab = slab;
+		obj = (char *) hdr + SLAB_HDR_SIZE;
+	}
+#ifndef NDEBUG
+	hdr->magic = SLAB_MAGIC;
+#endif
+
+	if ((++slab->in_use == pool->objs_per_slab)) {
+		_unlink(&pool->partial, slab);
+		_push(&pool->full, slab);
+	}
+	pool->in_use++;
+	pool->allocs++;
+	slurm_mutex_unlock(&pool->mutex);
+
+	memset(obj, 0, pool->obj_size);
+	return obj;
+}
+
+extern void slab_free(slab_pool_t *pool, void *obj)
+{
+	slab_hdr_t *hdr;
+	slab_t *slab;
+
+	if (!obj)
+		return;
+
+	xassert(pool);
+
+	hdr = (slab_hdr_t *) ((char *) obj - SLAB_HDR_SIZE);
+	xassert(hdr->magic == SLAB_MAGIC);
+	slab = hdr->slab;
+#ifndef NDEBUG
+	hdr->magic = ~SLAB_MAGIC;
+	memset(obj, 0x5a, pool->obj_size);
+#endif
+
+	slurm_mutex_lock(&pool->mutex);
+	xassert(slab->in_use);
+	if (slab->in_use-- == pool->objs_per_slab) {
+		_unlink(&pool->full, slab);
+		_push(&pool->partial, slab);
+	}
+	*((void **) obj) = slab->free_list;
+	slab->free_list = obj;
+
+	if (!slab->in_use) {
+		/* Keep one empty block, release the rest */
+		_unlink(&pool->partial, slab);
+		if (pool->spare) {
+			_unmap_slab(pool, slab);
+		} else {
+			pool->spare = slab;
+		}
+	}
+	pool->in_use--;
+	pool->frees++;
+	slurm_mutex_unlock(&pool->mutex);
+}
+
+extern uint32_t slab_get_stats(slab_stats_t **stats)
+{
+	slab_pool_t *pool;
+	uint32_t cnt = 0, i = 0;
+
+	slurm_mutex_lock(&pools_mutex);
+	for (pool = pools; pool; pool = pool->next)
+		cnt++;
+	*stats = xcalloc(cnt, sizeof(**stats));
+	for (pool = pools; pool; pool = pool->next, i++) {
+		slurm_mutex_lock(&pool->mutex);
+		(*stats)[i].name = xstrdup(pool->name);
+		(*stats)[i].obj_size = pool->obj_size;
+		(*stats)[i].objs_per_slab = pool->objs_per_slab;
+		(*stats)[i].slabs = pool->slabs;
+		(*stats)[i].in_use = pool->in_use;
+		(*stats)[i].allocs = pool->allocs;
+		(*stats)[i].frees = pool->frees;
+		slurm_mutex_unlock(&pool->mutex);
+	}
+	slurm_mutex_unlock(&pools_mutex);
+
+	return cnt;
+}
+
+extern void slab_free_stats(slab_stats_t *stats, uint32_t cnt)
+{
+	for (int i = 0; i < cnt; i++)
+		xfree(stats[i].name);
+	xfree(stats);
+}
@@ -0,0 +1,89 @@
+/*****************************************************************************\
+ *  slab.h - fixed size object pools
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _SLURM_SLAB_H
+#define _SLURM_SLAB_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/*
+ * A slab pool hands out zeroed objects of one size, carved from large
+ * blocks. This avoids a heap allocation (and its header) per object and keeps
+ * records of one type packed together. Blocks left empty by slab_free() are
+ * returned to the heap, except for one kept for reuse.
+ */
+typedef struct slab_pool slab_pool_t;
+
+typedef struct {
+	char *name;
+	uint32_t obj_size;
+	uint32_t objs_per_slab;
+	uint32_t slabs;		/* blocks currently allocated */
+	uint32_t in_use;	/* objects currently allocated */
+	uint64_t allocs;	/* objects allocated since pool creation */
+	uint64_t frees;		/* objects freed since pool creation */
+} slab_stats_t;
+
+/*
+ * Create a pool for objects of obj_size bytes.
+ * IN name - identifies the pool in slab_get_stats()
+ * RET pool, destroy with slab_pool_destroy()
+ */
+extern slab_pool_t *slab_pool_create(const char *name, size_t obj_size);
+
+/*
+ * Free a pool and every block it holds. Objects still allocated from the pool
+ * become invalid.
+ */
+extern void slab_pool_destroy(slab_pool_t *pool);
+
+/* Allocate a zeroed object from pool */
+extern void *slab_alloc(slab_pool_t *pool);
+
+/* Return an object obtained with slab_alloc() to its pool, NULL is ignored */
+extern void slab_free(slab_pool_t *pool, void *obj);
+
+/*
+ * Get statistics for every pool in this process.
+ * OUT stats - xmalloc'd array, free with slab_free_stats()
+ * RET number of entries in stats
+ */
+extern uint32_t slab_get_stats(slab_stats_t **stats);
+
+extern void slab_free_stats(slab_stats_t *stats, uint32_t cnt);
+
+#endif
@@ -192,6 +192,9 @@ typedef struct slurm_acct_storage_ops {
 	int  (*job_suspend)        (void *db_conn, job_record_t *job_ptr);
 	List (*get_jobs_cond)      (void *db_conn, uint32_t uid,
 				    slurmdb_job_cond_t *job_cond);
+	int (*get_jobs_cond_chunked)(void *db_conn, uint32_t uid,
+				     slurmdb_job_cond_t *job_cond,
+				     slurmdb_job_chunk_f chunk_cb, void *arg);
 	int (*archive_dump)        (void *db_conn,
 				    slurmdb_archive_cond_t *arch_cond);
 	int (*archive_load)        (void *db_conn,
@@ -276,6 +279,7 @@ static const char *syms[] = {
 	"jobacct_storage_p_step_complete",
 	"jobacct_storage_p_suspend",
 	"jobacct_storage_p_get_jobs_cond",
+	"jobacct_storage_p_get_jobs_cond_chunked",
 	"jobacct_storage_p_archive",
 	"jobacct_storage_p_archive_load",
 	"acct_storage_p_update_shares_used",
@@ -966,6 +970,21 @@ extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 	return ret_list;
 }
 
+/*
+ * get info from the storage, handing chunks of jobacct_job_rec_t * to
+ * chunk_cb in turn
+ * returns SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_g_get_jobs_cond_chunked(
+	void *db_conn, uint32_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	if (slurm_acct_storage_init() < 0)
+		return SLURM_ERROR;
+	return (*(ops.get_jobs_cond_chunked))(db_conn, uid, job_cond,
+					      chunk_cb, arg);
+}
+
 /*
  * expire old info from the storage
  */
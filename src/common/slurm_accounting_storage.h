@@ -644,6 +644,16 @@ extern int jobacct_storage_g_job_suspend(void *db_conn,
 extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 					    slurmdb_job_cond_t *job_cond);
 
+/*
+ * get info from the storage, handing chunks of a bounded number of
+ * jobacct_job_rec_t * to chunk_cb in turn
+ * each List is freed once chunk_cb returns
+ * returns SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_g_get_jobs_cond_chunked(
+	void *db_conn, uint32_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg);
+
 /*
  * expire old info from the storage
  */
@@ -58,6 +58,7 @@
 
 /* PROJECT INCLUDES */
 #include "src/common/assoc_mgr.h"
+#include "src/common/conn_cache.h"
 #include "src/common/fd.h"
 #include "src/common/forward.h"
 #include "src/common/log.h"
@@ -85,6 +86,9 @@ strong_alias(get_unit_type, slurm_get_unit_type);
 /* EXTERNAL VARIABLES */
 
 /* #DEFINES */
+/* Delay range for resending a request shed by a busy slurmctld */
+#define BACKOFF_MIN_USEC	100000
+#define BACKOFF_MAX_USEC	5000000
 
 /* STATIC VARIABLES */
 static int message_timeout = -1;
@@ -2009,22 +2013,30 @@ _send_and_recv_msg(int fd, slurm_msg_t *req,
  * IN fd	- file descriptor to receive msg on
  * IN req	- a slurm_msg struct to be sent by the function
  * IN timeout	- how long to wait in milliseconds
+ * IN cache_conn - return fd to the connection cache rather than close it
+ *		   once the response is received
+ * OUT sent	- set if the request was sent, it may have been processed
+ *		  even if no response was received
  * RET List	- List containing the responses of the children (if any) we
  *		  forwarded the message to. List containing type
  *		  (ret_data_info_t).
  */
 static List
-_send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
+_send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout, bool cache_conn,
+		    bool *sent)
 {
 	List ret_list = NULL;
 	int steps = 0;
 
+	*sent = false;
+
 	if (!req->forward.timeout) {
 		if (!timeout)
 			timeout = slurm_conf.msg_timeout * 1000;
 		req->forward.timeout = timeout;
 	}
 	if (slurm_send_node_msg(fd, req) >= 0) {
+		*sent = true;
 		if (req->forward.cnt > 0) {
 			/* figure out where we are in the tree and set
 			 * the timeout for to wait for our children
@@ -2048,11 +2060,22 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 		ret_list = slurm_receive_msgs(fd, steps, timeout);
 	}
 
-	(void) close(fd);
+	if (cache_conn && ret_list)
+		conn_cache_put(&req->address, fd);
+	else
+		(void) close(fd);
 
 	return ret_list;
 }
 
+/* RET true if a send failed as the peer closed the connection */
+static bool _conn_closed_by_peer(int err)
+{
+	return ((err == SLURM_PROTOCOL_SOCKET_ZERO_BYTES_SENT) ||
+		(err == SLURM_COMMUNICATIONS_SEND_ERROR) ||
+		(err == EPIPE) || (err == ECONNRESET));
+}
+
 /*
  * slurm_send_recv_controller_msg
  * opens a connection to the controller, sends the controller a message,
@@ -2069,7 +2092,7 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 	int fd = -1;
 	int rc = 0;
 	time_t start_time = time(NULL);
-	int retry = 1;
+	int retry = 1, backoff = BACKOFF_MIN_USEC;
 	slurm_conf_t *conf;
 	bool have_backup;
 	uint16_t slurmctld_timeout;
@@ -2144,6 +2167,29 @@ tryagain:
 			} else {
 				retry = 1;
 			}
+		} else if ((rc == 0) &&
+			   (response_msg->msg_type == RESPONSE_SLURM_RC) &&
+			   (((return_code_msg_t *) response_msg->data)->return_code
+			    == SLURMCTLD_COMMUNICATIONS_BACKOFF) &&
+			   (difftime(time(NULL), start_time) <
+			    slurmctld_timeout)) {
+			/*
+			 * The controller shed this request to keep up with
+			 * higher priority traffic, wait and send it again.
+			 */
+			log_flag(NET, "%s: slurmctld is busy, retrying in %d usec",
+				 __func__, backoff);
+			usleep(backoff);
+			backoff = MIN(backoff * 2, BACKOFF_MAX_USEC);
+			slurm_free_return_code_msg(response_msg->data);
+			if ((fd = slurm_open_controller_conn(&ctrl_addr,
+							     &use_backup,
+							     comm_cluster_rec))
+			    < 0) {
+				rc = -1;
+			} else {
+				retry = 1;
+			}
 		}
 
 		if (rc == -1)
@@ -2408,6 +2454,8 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 	ret_data_info_t *ret_data_info = NULL;
 	ListIterator itr;
 	int i;
+	bool cache_conn = conn_cache_enabled(msg->protocol_version);
+	bool reused = false, sent;
 
 	slurm_mutex_lock(&conn_lock);
 
@@ -2417,9 +2465,13 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 	}
 	slurm_mutex_unlock(&conn_lock);
 
+	if (cache_conn && ((fd = conn_cache_get(&msg->address)) >= 0))
+		reused = true;
+
+connect:
 	/* This connect retry logic permits Slurm hierarchical communications
 	 * to better survive slurmd restarts */
-	for (i = 0; i <= conn_timeout; i++) {
+	for (i = 0; !reused && (i <= conn_timeout); i++) {
 		fd = slurm_open_msg_conn(&msg->address);
 		if ((fd >= 0) || (errno != ECONNREFUSED && errno != ETIMEDOUT))
 			break;
@@ -2445,7 +2497,24 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 
 	msg->ret_list = NULL;
 	msg->forward_struct = NULL;
-	if (!(ret_list = _send_and_recv_msgs(fd, msg, timeout))) {
+	if (cache_conn)
+		msg->flags |= SLURM_MSG_KEEP_CONN;
+	if (!(ret_list = _send_and_recv_msgs(fd, msg, timeout, cache_conn,
+					     &sent)) &&
+	    reused && !sent && _conn_closed_by_peer(errno)) {
+		/*
+		 * slurmd closed the idle connection before the message could
+		 * be sent. Once sent it may have been processed, so it is not
+		 * sent again.
+		 */
+		log_flag(NET, "%s: cached connection to %pA closed, reconnecting",
+			 __func__, &msg->address);
+		reused = false;
+		fd = -1;
+		goto connect;
+	}
+	msg->flags &= ~SLURM_MSG_KEEP_CONN;
+	if (!ret_list) {
 		mark_as_failed_forward(&ret_list, name, errno);
 		errno = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
 		return ret_list;
@@ -106,5 +106,12 @@
 #define SLURM_DROP_PRIV		0x0008
 #define USE_BCAST_NETWORK	0x0010
 #define CTLD_QUEUE_PROCESSING	0x0020
+#define SLURM_MSG_KEEP_CONN	0x0040	/* sender may reuse the connection */
+
+/*
+ * Seconds slurmd waits for another message on a connection whose last
+ * message had SLURM_MSG_KEEP_CONN set
+ */
+#define KEEP_CONN_IDLE_SECS	300
 
 #endif
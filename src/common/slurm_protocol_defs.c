@@ -1043,6 +1043,12 @@ extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg)
 	}
 }
 
+extern void slurm_free_job_info_delta_request_msg(
+	job_info_delta_request_msg_t *msg)
+{
+	xfree(msg);
+}
+
 extern void slurm_free_job_step_info_request_msg(job_step_info_request_msg_t *msg)
 {
 	xfree(msg);
@@ -1812,6 +1818,44 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 			xfree(msg->rpc_dump_hostlist[i]);
 		}
 		xfree(msg->rpc_dump_hostlist);
+		for (i = 0; i < msg->job_hash_cnt; i++)
+			xfree(msg->job_hash_name[i]);
+		xfree(msg->job_hash_name);
+		xfree(msg->job_hash_size);
+		xfree(msg->job_hash_records);
+		xfree(msg->job_hash_lookups);
+		xfree(msg->job_hash_probes);
+		xfree(msg->job_hash_probe_max);
+		xfree(msg->job_hash_resizes);
+		for (i = 0; i < msg->rpc_pool_queue_cnt; i++)
+			xfree(msg->rpc_pool_queue_name[i]);
+		xfree(msg->rpc_pool_queue_name);
+		xfree(msg->rpc_pool_queue_depth);
+		xfree(msg->rpc_pool_queue_depth_max);
+		xfree(msg->rpc_pool_queue_count);
+		xfree(msg->rpc_pool_queue_wait_time);
+		xfree(msg->rpc_pool_queue_wait_max);
+		xfree(msg->rpc_pool_queue_rejected);
+		for (i = 0; i < msg->record_pool_cnt; i++)
+			xfree(msg->record_pool_name[i]);
+		xfree(msg->record_pool_name);
+		xfree(msg->record_pool_obj_size);
+		xfree(msg->record_pool_in_use);
+		xfree(msg->record_pool_slabs);
+		xfree(msg->record_pool_allocs);
+		xfree(msg->fwd_hop_usec);
+		xfree(msg->fwd_hop_cnt);
+		xfree(msg->lock_bucket_usec);
+		for (i = 0; i < msg->lock_caller_cnt; i++)
+			xfree(msg->lock_caller[i]);
+		xfree(msg->lock_caller);
+		xfree(msg->lock_type);
+		xfree(msg->lock_level);
+		xfree(msg->lock_cnt);
+		xfree(msg->lock_wait_usec);
+		xfree(msg->lock_hold_usec);
+		xfree(msg->lock_wait_hist);
+		xfree(msg->lock_hold_hist);
 		xfree(msg);
 	}
 }
@@ -4394,6 +4438,11 @@ extern void slurm_free_submit_response_response_msg(submit_response_msg_t * msg)
 	}
 }
 
+extern void slurm_destroy_submit_response_object(void *object)
+{
+	slurm_free_submit_response_response_msg(object);
+}
+
 
 /*
  * slurm_free_ctl_conf - free slurm control information response message
@@ -4440,6 +4489,20 @@ extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr)
 	}
 }
 
+/*
+ * slurm_free_job_info_delta_msg - free the job delta response message
+ * IN msg - pointer to job delta response message
+ * NOTE: buffer is loaded by slurm_load_jobs_delta.
+ */
+extern void slurm_free_job_info_delta_msg(job_info_delta_msg_t *msg)
+{
+	if (msg) {
+		slurm_free_job_info_msg(msg->job_info);
+		xfree(msg->purged_job_ids);
+		xfree(msg);
+	}
+}
+
 static void _free_all_job_info(job_info_msg_t *msg)
 {
 	int i;
@@ -5436,7 +5499,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
 	case RESPONSE_HET_JOB_ALLOCATION:
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
 		FREE_NULL_LIST(data);
 		break;
 	case REQUEST_SET_FS_DAMPENING_FACTOR:
@@ -5451,6 +5516,12 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_BURST_BUFFER_STATUS:
 		slurm_free_bb_status_resp_msg(data);
 		break;
+	case REQUEST_JOB_INFO_DELTA:
+		slurm_free_job_info_delta_request_msg(data);
+		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		slurm_free_job_info_delta_msg(data);
+		break;
 	case REQUEST_CRONTAB:
 		slurm_free_crontab_request_msg(data);
 		break;
@@ -5725,6 +5796,10 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_BURST_BUFFER_STATUS";
 	case RESPONSE_BURST_BUFFER_STATUS:
 		return "RESPONSE_BURST_BUFFER_STATUS";
+	case REQUEST_JOB_INFO_DELTA:
+		return "REQUEST_JOB_INFO_DELTA";
+	case RESPONSE_JOB_INFO_DELTA:
+		return "RESPONSE_JOB_INFO_DELTA";
 
 	case REQUEST_CRONTAB:					/* 2200 */
 		return "REQUEST_CRONTAB";
@@ -5813,6 +5888,10 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_HET_JOB_ALLOC_INFO";
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
 		return "REQUEST_SUBMIT_BATCH_HET_JOB";
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
+		return "REQUEST_SUBMIT_BATCH_JOB_LIST";
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		return "RESPONSE_SUBMIT_BATCH_JOB_LIST";
 
 	case REQUEST_JOB_STEP_CREATE:				/* 5001 */
 		return "REQUEST_JOB_STEP_CREATE";
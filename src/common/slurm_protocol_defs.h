@@ -303,6 +303,8 @@ typedef enum {
 	RESPONSE_CONTROL_STATUS,
 	REQUEST_BURST_BUFFER_STATUS,
 	RESPONSE_BURST_BUFFER_STATUS,
+	REQUEST_JOB_INFO_DELTA,
+	RESPONSE_JOB_INFO_DELTA,
 
 	REQUEST_CRONTAB = 2200,
 	RESPONSE_CRONTAB,
@@ -351,6 +353,8 @@ typedef enum {
 	RESPONSE_HET_JOB_ALLOCATION,
 	REQUEST_HET_JOB_ALLOC_INFO,
 	REQUEST_SUBMIT_BATCH_HET_JOB,
+	REQUEST_SUBMIT_BATCH_JOB_LIST,
+	RESPONSE_SUBMIT_BATCH_JOB_LIST,
 
 	REQUEST_CTLD_MULT_MSG = 4500,
 	RESPONSE_CTLD_MULT_MSG,
@@ -651,6 +655,12 @@ typedef struct job_info_request_msg {
 				 * jobs. */
 } job_info_request_msg_t;
 
+typedef struct job_info_delta_request_msg {
+	time_t epoch;		/* epoch of the client's last response */
+	uint16_t show_flags;
+	uint64_t update_gen;	/* generation of the client's last response */
+} job_info_delta_request_msg_t;
+
 typedef struct job_step_info_request_msg {
 	time_t last_update;
 	slurm_step_id_t step_id;
@@ -1436,6 +1446,8 @@ extern void slurm_free_return_code_msg(return_code_msg_t * msg);
 extern void slurm_free_reroute_msg(reroute_msg_t *msg);
 extern void slurm_free_job_alloc_info_msg(job_alloc_info_msg_t * msg);
 extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg);
+extern void slurm_free_job_info_delta_request_msg(
+	job_info_delta_request_msg_t *msg);
 extern void slurm_free_job_step_info_request_msg(
 		job_step_info_request_msg_t *msg);
 extern void slurm_free_front_end_info_request_msg(
@@ -1550,6 +1562,7 @@ extern void slurm_free_job_step_create_response_msg(
 		job_step_create_response_msg_t * msg);
 extern void slurm_free_submit_response_response_msg(
 		submit_response_msg_t * msg);
+extern void slurm_destroy_submit_response_object(void *object);
 extern void slurm_free_ctl_conf(slurm_ctl_conf_info_msg_t * config_ptr);
 extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr);
 extern void slurm_free_job_step_info_response_msg(
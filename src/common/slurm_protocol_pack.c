@@ -71,6 +71,7 @@
 #include "src/common/xstring.h"
 
 #define _pack_job_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
+#define _pack_job_info_delta_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_job_step_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_burst_buffer_info_resp_msg(msg,buf) _pack_buffer_msg(msg,buf)
 #define _pack_front_end_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
@@ -5962,6 +5963,64 @@ _pack_job_info_list_msg(List job_resp_list, buf_t *buffer,
 	list_iterator_destroy(iter);
 }
 
+/* _pack_submit_response_list_msg
+ * packs a list of submit_response_msg_t structs
+ * IN resp_list - list of job submit responses to pack
+ * IN/OUT buffer - destination of the pack, contains pointers that are
+ *			automatically updated
+ */
+static void
+_pack_submit_response_list_msg(List resp_list, buf_t *buffer,
+			       uint16_t protocol_version)
+{
+	submit_response_msg_t *resp;
+	ListIterator iter;
+	uint16_t cnt = 0;
+
+	if (resp_list)
+		cnt = list_count(resp_list);
+	pack16(cnt, buffer);
+	if (cnt == 0)
+		return;
+
+	iter = list_iterator_create(resp_list);
+	while ((resp = list_next(iter)))
+		_pack_submit_response_msg(resp, buffer, protocol_version);
+	list_iterator_destroy(iter);
+}
+
+static int
+_unpack_submit_response_list_msg(List *resp_list, buf_t *buffer,
+				 uint16_t protocol_version)
+{
+	submit_response_msg_t *resp;
+	uint16_t cnt = 0;
+	int i;
+
+	*resp_list = NULL;
+
+	safe_unpack16(&cnt, buffer);
+	if (cnt == 0)
+		return SLURM_SUCCESS;
+	if (cnt > NO_VAL16)
+		goto unpack_error;
+
+	*resp_list = list_create(slurm_destroy_submit_response_object);
+	for (i = 0; i < cnt; i++) {
+		resp = NULL;
+		if (_unpack_submit_response_msg(&resp, buffer,
+						protocol_version) !=
+		    SLURM_SUCCESS)
+			goto unpack_error;
+		list_append(*resp_list, resp);
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	FREE_NULL_LIST(*resp_list);
+	return SLURM_ERROR;
+}
+
 void _free_job_info_list(void *x)
 {
 	resource_allocation_response_msg_t *job_info_ptr;
@@ -7588,6 +7647,82 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_job_info_delta_request_msg(job_info_delta_request_msg_t *msg,
+					     buf_t *buffer,
+					     uint16_t protocol_version)
+{
+	xassert(msg);
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		pack_time(msg->epoch, buffer);
+		pack64(msg->update_gen, buffer);
+		pack16(msg->show_flags, buffer);
+	}
+}
+
+static int _unpack_job_info_delta_request_msg(
+	job_info_delta_request_msg_t **msg, buf_t *buffer,
+	uint16_t protocol_version)
+{
+	job_info_delta_request_msg_t *req;
+
+	req = xmalloc(sizeof(*req));
+	*msg = req;
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		safe_unpack_time(&req->epoch, buffer);
+		safe_unpack64(&req->update_gen, buffer);
+		safe_unpack16(&req->show_flags, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_info_delta_request_msg(req);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
+/*
+ * NOTE: The response is packed by pack_delta_jobs() in slurmctld/job_mgr.c,
+ *	change both whenever the data format changes
+ */
+static int _unpack_job_info_delta_msg(job_info_delta_msg_t **msg,
+				      buf_t *buffer,
+				      uint16_t protocol_version)
+{
+	job_info_delta_msg_t *delta;
+
+	delta = xmalloc(sizeof(*delta));
+	*msg = delta;
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		safe_unpack_time(&delta->epoch, buffer);
+		safe_unpack64(&delta->update_gen, buffer);
+		safe_unpack16(&delta->flags, buffer);
+		if (_unpack_job_info_msg(&delta->job_info, buffer,
+					 protocol_version))
+			goto unpack_error;
+		safe_unpack32_array(&delta->purged_job_ids,
+				    &delta->purged_cnt, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_info_delta_msg(delta);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_job_info_request_msg(job_info_request_msg_t * msg, buf_t *buffer,
 			   uint16_t protocol_version)
@@ -10162,6 +10297,142 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				     buffer);
 		if (uint32_tmp != msg->rpc_dump_count)
 			goto unpack_error;
+
+		/*
+		 * Appended after the fields above, so 22.05.0 clients can
+		 * ignore them and a 22.05.0 slurmctld need not send them.
+		 */
+		if (msg->parts_packed &&
+		    (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) &&
+		    remaining_buf(buffer)) {
+			safe_unpackstr_array(&msg->job_hash_name,
+					     &msg->job_hash_cnt,
+					     buffer);
+			safe_unpack32_array(&msg->job_hash_size,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->job_hash_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->job_hash_records,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->job_hash_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->job_hash_lookups,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->job_hash_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->job_hash_probes,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->job_hash_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->job_hash_probe_max,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->job_hash_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->job_hash_resizes,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->job_hash_cnt)
+				goto unpack_error;
+
+			safe_unpack32(&msg->rpc_pool_threads, buffer);
+			safe_unpackstr_array(&msg->rpc_pool_queue_name,
+					     &msg->rpc_pool_queue_cnt,
+					     buffer);
+			safe_unpack32_array(&msg->rpc_pool_queue_depth,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_pool_queue_cnt)
+				goto unpack_error;
+			safe_unpack32_array(
+				&msg->rpc_pool_queue_depth_max,
+				&uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_pool_queue_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->rpc_pool_queue_count,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_pool_queue_cnt)
+				goto unpack_error;
+			safe_unpack64_array(
+				&msg->rpc_pool_queue_wait_time,
+				&uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_pool_queue_cnt)
+				goto unpack_error;
+			safe_unpack32_array(
+				&msg->rpc_pool_queue_wait_max,
+				&uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_pool_queue_cnt)
+				goto unpack_error;
+			safe_unpack32_array(
+				&msg->rpc_pool_queue_rejected,
+				&uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_pool_queue_cnt)
+				goto unpack_error;
+
+			safe_unpackstr_array(&msg->record_pool_name,
+					     &msg->record_pool_cnt,
+					     buffer);
+			safe_unpack32_array(&msg->record_pool_obj_size,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->record_pool_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->record_pool_in_use,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->record_pool_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->record_pool_slabs,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->record_pool_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->record_pool_allocs,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->record_pool_cnt)
+				goto unpack_error;
+
+			safe_unpack32_array(&msg->fwd_hop_usec,
+					    &msg->fwd_hop_bucket_cnt,
+					    buffer);
+			safe_unpack32_array(&msg->fwd_hop_cnt,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->fwd_hop_bucket_cnt)
+				goto unpack_error;
+			safe_unpack32(&msg->fwd_failed, buffer);
+			safe_unpack32(&msg->fwd_rerouted, buffer);
+
+			safe_unpack32_array(&msg->lock_bucket_usec,
+					    &msg->lock_bucket_cnt,
+					    buffer);
+			safe_unpackstr_array(&msg->lock_caller,
+					     &msg->lock_caller_cnt,
+					     buffer);
+			safe_unpack16_array(&msg->lock_type,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->lock_caller_cnt)
+				goto unpack_error;
+			safe_unpack16_array(&msg->lock_level,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->lock_caller_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->lock_cnt,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->lock_caller_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_wait_usec,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->lock_caller_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_hold_usec,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->lock_caller_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->lock_wait_hist,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != (msg->lock_caller_cnt *
+					   msg->lock_bucket_cnt))
+				goto unpack_error;
+			safe_unpack32_array(&msg->lock_hold_hist,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != (msg->lock_caller_cnt *
+					   msg->lock_bucket_cnt))
+				goto unpack_error;
+		}
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -10810,6 +11081,7 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
 		_pack_job_desc_list_msg((List) msg->data, buffer,
 					msg->protocol_version);
 		break;
@@ -10896,6 +11168,10 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 					  msg->data, buffer,
 					  msg->protocol_version);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		_pack_submit_response_list_msg((List) msg->data, buffer,
+					       msg->protocol_version);
+		break;
 	case RESPONSE_JOB_ALLOCATION_INFO:
 	case RESPONSE_RESOURCE_ALLOCATION:
 		_pack_resource_allocation_response_msg
@@ -11349,6 +11625,14 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		_pack_bb_status_resp_msg((bb_status_resp_msg_t *)(msg->data),
 					 buffer, msg->protocol_version);
 		break;
+	case REQUEST_JOB_INFO_DELTA:
+		_pack_job_info_delta_request_msg(
+			(job_info_delta_request_msg_t *) msg->data, buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		_pack_job_info_delta_msg((slurm_msg_t *) msg, buffer);
+		break;
 	case REQUEST_CRONTAB:
 		_pack_crontab_request_msg(msg, buffer);
 		break;
@@ -11455,6 +11739,7 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
 		rc = _unpack_job_desc_list_msg((List *) &(msg->data),
 					       buffer, msg->protocol_version);
 		break;
@@ -11545,6 +11830,11 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 						 & (msg->data), buffer,
 						 msg->protocol_version);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		rc = _unpack_submit_response_list_msg((List *) &(msg->data),
+						      buffer,
+						      msg->protocol_version);
+		break;
 	case RESPONSE_JOB_ALLOCATION_INFO:
 	case RESPONSE_RESOURCE_ALLOCATION:
 		rc = _unpack_resource_allocation_response_msg(
@@ -12047,6 +12337,16 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 			(bb_status_resp_msg_t **)&(msg->data), buffer,
 			msg->protocol_version);
 		break;
+	case REQUEST_JOB_INFO_DELTA:
+		rc = _unpack_job_info_delta_request_msg(
+			(job_info_delta_request_msg_t **) &(msg->data), buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		rc = _unpack_job_info_delta_msg(
+			(job_info_delta_msg_t **) &(msg->data), buffer,
+			msg->protocol_version);
+		break;
 	case REQUEST_CRONTAB:
 		rc = _unpack_crontab_request_msg(msg, buffer);
 		break;
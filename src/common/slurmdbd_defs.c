@@ -117,6 +117,8 @@ extern slurmdbd_msg_type_t str_2_slurmdbd_msg_type(char *msg_type)
 		return DBD_GOT_FEDERATIONS;
 	} else if (!xstrcasecmp(msg_type, "Got Jobs")) {
 		return DBD_GOT_JOBS;
+	} else if (!xstrcasecmp(msg_type, "Got Jobs Chunk")) {
+		return DBD_GOT_JOBS_CHUNK;
 	} else if (!xstrcasecmp(msg_type, "Got List")) {
 		return DBD_GOT_LIST;
 	} else if (!xstrcasecmp(msg_type, "Got Problems")) {
@@ -179,6 +181,8 @@ extern slurmdbd_msg_type_t str_2_slurmdbd_msg_type(char *msg_type)
 		return DBD_STEP_START;
 	} else if (!xstrcasecmp(msg_type, "Get Jobs Conditional")) {
 		return DBD_GET_JOBS_COND;
+	} else if (!xstrcasecmp(msg_type, "Get Jobs Conditional Chunked")) {
+		return DBD_GET_JOBS_COND_CHUNKED;
 	} else if (!xstrcasecmp(msg_type, "Get Transactions")) {
 		return DBD_GET_TXN;
 	} else if (!xstrcasecmp(msg_type, "Got Transactions")) {
@@ -432,6 +436,12 @@ extern char *slurmdbd_msg_type_2_str(slurmdbd_msg_type_t msg_type, int get_enum)
 		} else
 			return "Got Jobs";
 		break;
+	case DBD_GOT_JOBS_CHUNK:
+		if (get_enum) {
+			return "DBD_GOT_JOBS_CHUNK";
+		} else
+			return "Got Jobs Chunk";
+		break;
 	case DBD_GOT_LIST:
 		if (get_enum) {
 			return "DBD_GOT_LIST";
@@ -618,6 +628,12 @@ extern char *slurmdbd_msg_type_2_str(slurmdbd_msg_type_t msg_type, int get_enum)
 		} else
 			return "Get Jobs Conditional";
 		break;
+	case DBD_GET_JOBS_COND_CHUNKED:
+		if (get_enum) {
+			return "DBD_GET_JOBS_COND_CHUNKED";
+		} else
+			return "Get Jobs Conditional Chunked";
+		break;
 	case DBD_GET_TXN:
 		if (get_enum) {
 			return "DBD_GET_TXN";
@@ -839,6 +855,7 @@ extern void slurmdbd_free_msg(persist_msg_t *msg)
 	case DBD_GOT_EVENTS:
 	case DBD_GOT_FEDERATIONS:
 	case DBD_GOT_JOBS:
+	case DBD_GOT_JOBS_CHUNK:
 	case DBD_GOT_LIST:
 	case DBD_GOT_PROBS:
 	case DBD_GOT_RES:
@@ -875,6 +892,7 @@ extern void slurmdbd_free_msg(persist_msg_t *msg)
 	case DBD_GET_EVENTS:
 	case DBD_GET_FEDERATIONS:
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_COND_CHUNKED:
 	case DBD_GET_PROBS:
 	case DBD_GET_QOS:
 	case DBD_GET_RESVS:
@@ -1010,6 +1028,7 @@ extern void slurmdbd_free_cond_msg(dbd_cond_msg_t *msg,
 			my_destroy = slurmdb_destroy_federation_cond;
 			break;
 		case DBD_GET_JOBS_COND:
+		case DBD_GET_JOBS_COND_CHUNKED:
 			my_destroy = slurmdb_destroy_job_cond;
 			break;
 		case DBD_GET_QOS:
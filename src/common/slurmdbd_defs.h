@@ -152,6 +152,9 @@ typedef enum {
 	DBD_GOT_FEDERATIONS,	/* Response to DBD_GET_FEDERATIONS 	*/
 	DBD_MODIFY_FEDERATIONS, /* Modify existing federation 		*/
 	DBD_REMOVE_FEDERATIONS, /* Removing existing federation 	*/
+	DBD_GET_JOBS_COND_CHUNKED, /* DBD_GET_JOBS_COND, reply in chunks */
+	DBD_GOT_JOBS_CHUNK,	/* One chunk of DBD_GET_JOBS_COND_CHUNKED
+				 * response, last one is DBD_GOT_JOBS	*/
 
 	SLURM_PERSIST_INIT = 6500, /* So we don't use the
 				    * REQUEST_PERSIST_INIT also used here.
@@ -249,6 +249,7 @@ static void _pack_cond_msg(dbd_cond_msg_t *msg, uint16_t rpc_version,
 		my_function = slurmdb_pack_federation_cond;
 		break;
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_COND_CHUNKED:
 		my_function = slurmdb_pack_job_cond;
 		break;
 	case DBD_GET_QOS:
@@ -315,6 +316,7 @@ static int _unpack_cond_msg(dbd_cond_msg_t **msg, uint16_t rpc_version,
 		my_function = slurmdb_unpack_federation_cond;
 		break;
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_COND_CHUNKED:
 		my_function = slurmdb_unpack_job_cond;
 		break;
 	case DBD_GET_QOS:
@@ -1233,6 +1235,7 @@ extern void slurmdbd_pack_list_msg(dbd_list_msg_t *msg, uint16_t rpc_version,
 		my_function = pack_config_key_pair;
 		break;
 	case DBD_GOT_JOBS:
+	case DBD_GOT_JOBS_CHUNK:
 	case DBD_FIX_RUNAWAY_JOB:
 		my_function = slurmdb_pack_job_rec;
 		break;
@@ -1325,6 +1328,7 @@ extern int slurmdbd_unpack_list_msg(dbd_list_msg_t **msg, uint16_t rpc_version,
 		my_destroy = destroy_config_key_pair;
 		break;
 	case DBD_GOT_JOBS:
+	case DBD_GOT_JOBS_CHUNK:
 	case DBD_FIX_RUNAWAY_JOB:
 		my_function = slurmdb_unpack_job_rec;
 		my_destroy = slurmdb_destroy_job_rec;
@@ -1434,6 +1438,7 @@ extern buf_t *pack_slurmdbd_msg(persist_msg_t *req, uint16_t rpc_version)
 	case DBD_GOT_EVENTS:
 	case DBD_GOT_FEDERATIONS:
 	case DBD_GOT_JOBS:
+	case DBD_GOT_JOBS_CHUNK:
 	case DBD_GOT_LIST:
 	case DBD_GOT_PROBS:
 	case DBD_GOT_RES:
@@ -1476,6 +1481,7 @@ extern buf_t *pack_slurmdbd_msg(persist_msg_t *req, uint16_t rpc_version)
 	case DBD_GET_EVENTS:
 	case DBD_GET_FEDERATIONS:
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_COND_CHUNKED:
 	case DBD_GET_PROBS:
 	case DBD_GET_QOS:
 	case DBD_GET_RESVS:
@@ -1634,6 +1640,7 @@ extern int unpack_slurmdbd_msg(persist_msg_t *resp, uint16_t rpc_version,
 	case DBD_GOT_EVENTS:
 	case DBD_GOT_FEDERATIONS:
 	case DBD_GOT_JOBS:
+	case DBD_GOT_JOBS_CHUNK:
 	case DBD_GOT_LIST:
 	case DBD_GOT_PROBS:
 	case DBD_ADD_QOS:
@@ -1677,6 +1684,7 @@ extern int unpack_slurmdbd_msg(persist_msg_t *resp, uint16_t rpc_version,
 	case DBD_GET_EVENTS:
 	case DBD_GET_FEDERATIONS:
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_COND_CHUNKED:
 	case DBD_GET_PROBS:
 	case DBD_GET_QOS:
 	case DBD_GET_RESVS:
@@ -3386,6 +3386,22 @@ extern List jobacct_storage_p_get_jobs_cond(mysql_conn_t *mysql_conn,
 	return job_list;
 }
 
+/*
+ * get info from the storage in chunks handed to chunk_cb
+ * returns SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_p_get_jobs_cond_chunked(
+	mysql_conn_t *mysql_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	if (check_connection(mysql_conn) != SLURM_SUCCESS)
+		return ESLURM_DB_CONNECTION;
+
+	return as_mysql_jobacct_process_get_jobs_chunked(mysql_conn, uid,
+							 job_cond, chunk_cb,
+							 arg);
+}
+
 /*
  * expire old info from the storage
  */
@@ -45,7 +45,14 @@
 #include "src/common/env.h"
 #include "src/common/slurm_time.h"
 #include "src/common/slurmdbd_defs.h"
+#include "src/common/xhash.h"
 
+/*
+ * Version of job and step archives written with a string dictionary, see
+ * archive_dict_t. 22.05 archives without it keep SLURM_22_05_PROTOCOL_VERSION,
+ * and a SlurmDBD that can't read the dictionary refuses the newer version.
+ */
+#define ARCHIVE_DICT_VERSION ((38 << 8) | 1)
 #define SLURM_20_02_PROTOCOL_VERSION ((35 << 8) | 0)
 #define SLURM_19_05_PROTOCOL_VERSION ((34 << 8) | 0)
 #define SLURM_18_08_PROTOCOL_VERSION ((33 << 8) | 0)
@@ -819,6 +826,131 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 
 static uint32_t high_buffer_size = (1024 * 1024);
 
+/*
+ * Job and step archives write each distinct string once to a dictionary
+ * ahead of the records, which then refer to the strings by index. Most
+ * columns only ever hold a handful of values (account, partition, state, TRES
+ * strings, ...) and numbers are stored as strings, so this makes archive
+ * files several times smaller.
+ */
+typedef struct {
+	uint32_t cnt;
+	xhash_t *hash;	/* archive_dict_str_t by string, only when packing */
+	uint32_t size;	/* allocated length of strs */
+	char **strs;	/* strings by index */
+} archive_dict_t;
+
+typedef struct {
+	uint32_t inx;
+	char *str;
+} archive_dict_str_t;
+
+#define safe_unpack_dict_str(valp, dict, buf) do {		\
+	if (_unpack_dict_str(valp, dict, buf) != SLURM_SUCCESS)	\
+		goto unpack_error;				\
+} while (0)
+
+static void _dict_str_key_id(void *item, const char **key, uint32_t *key_len)
+{
+	archive_dict_str_t *dict_str = (archive_dict_str_t *)item;
+
+	*key = dict_str->str;
+	*key_len = strlen(dict_str->str);
+}
+
+static void _init_archive_dict(archive_dict_t *dict)
+{
+	memset(dict, 0, sizeof(archive_dict_t));
+	dict->hash = xhash_init(_dict_str_key_id, xfree_ptr);
+}
+
+/* Strings in the dictionary aren't owned by it, only the array is freed */
+static void _free_archive_dict_members(archive_dict_t *dict)
+{
+	xhash_free(dict->hash);
+	xfree(dict->strs);
+}
+
+static void _pack_dict_str(char *str, archive_dict_t *dict, buf_t *buffer)
+{
+	archive_dict_str_t *dict_str;
+
+	if (!str) {
+		pack32(NO_VAL, buffer);
+		return;
+	}
+
+	if (!(dict_str = xhash_get_str(dict->hash, str))) {
+		if (dict->cnt >= dict->size) {
+			dict->size = MAX(dict->size * 2, 1024);
+			xrecalloc(dict->strs, dict->size, sizeof(char *));
+		}
+		dict_str = xmalloc(sizeof(archive_dict_str_t));
+		dict_str->inx = dict->cnt++;
+		dict_str->str = dict->strs[dict_str->inx] = str;
+		xhash_add(dict->hash, dict_str);
+	}
+
+	pack32(dict_str->inx, buffer);
+}
+
+static int _unpack_dict_str(char **str, archive_dict_t *dict, buf_t *buffer)
+{
+	uint32_t inx;
+
+	safe_unpack32(&inx, buffer);
+	if (inx == NO_VAL)
+		*str = NULL;
+	else if (inx < dict->cnt)
+		*str = xstrdup(dict->strs[inx]);
+	else
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+/* Pack the dictionary followed by the records packed against it */
+static void _pack_archive_dict(archive_dict_t *dict, buf_t *records,
+			       buf_t *buffer)
+{
+	pack32(dict->cnt, buffer);
+	for (uint32_t i = 0; i < dict->cnt; i++)
+		packstr(dict->strs[i], buffer);
+	packmem_array(get_buf_data(records), get_buf_offset(records), buffer);
+}
+
+/*
+ * The dictionary strings point into buffer, so it has to be kept around until
+ * all the records are unpacked.
+ */
+static int _unpack_archive_dict(archive_dict_t *dict, buf_t *buffer)
+{
+	uint32_t tmp32;
+
+	memset(dict, 0, sizeof(archive_dict_t));
+	safe_unpack32(&dict->cnt, buffer);
+	/* Each string takes at least its 32 bit length */
+	if (dict->cnt > (remaining_buf(buffer) / sizeof(uint32_t)))
+		goto unpack_error;
+	dict->size = dict->cnt;
+	dict->strs = xcalloc(dict->cnt, sizeof(char *));
+	for (uint32_t i = 0; i < dict->cnt; i++) {
+		safe_unpackmem_ptr(&dict->strs[i], &tmp32, buffer);
+		if (!dict->strs[i] || !tmp32 || dict->strs[i][tmp32 - 1])
+			goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	_free_archive_dict_members(dict);
+	dict->cnt = 0;
+	return SLURM_ERROR;
+}
+
 static void _pack_local_event(local_event_t *object, uint16_t rpc_version,
 			      buf_t *buffer)
 {
@@ -870,66 +1002,66 @@ unpack_error:
 }
 
 static void _pack_local_job(local_job_t *object, uint16_t rpc_version,
-			    buf_t *buffer)
+			    archive_dict_t *dict, buf_t *buffer)
 {
-	packstr(object->account, buffer);
-	packstr(object->admin_comment, buffer);
-	packstr(object->alloc_nodes, buffer);
-	packstr(object->associd, buffer);
-	packstr(object->array_jobid, buffer);
-	packstr(object->array_max_tasks, buffer);
-	packstr(object->array_taskid, buffer);
-	packstr(object->array_task_pending, buffer);
-	packstr(object->array_task_str, buffer);
-	packstr(object->script, buffer);
-	packstr(object->blockid, buffer);
-	packstr(object->constraints, buffer);
-	packstr(object->deleted, buffer);
-	packstr(object->derived_ec, buffer);
-	packstr(object->derived_es, buffer);
-	packstr(object->env, buffer);
-	packstr(object->exit_code, buffer);
-	packstr(object->flags, buffer);
-	packstr(object->timelimit, buffer);
-	packstr(object->eligible, buffer);
-	packstr(object->end, buffer);
-	packstr(object->gid, buffer);
-	packstr(object->gres_used, buffer);
-	packstr(object->job_db_inx, buffer);
-	packstr(object->jobid, buffer);
-	packstr(object->kill_requid, buffer);
-	packstr(object->mcs_label, buffer);
-	packstr(object->mod_time, buffer);
-	packstr(object->name, buffer);
-	packstr(object->nodelist, buffer);
-	packstr(object->node_inx, buffer);
-	packstr(object->het_job_id, buffer);
-	packstr(object->het_job_offset, buffer);
-	packstr(object->partition, buffer);
-	packstr(object->priority, buffer);
-	packstr(object->qos, buffer);
-	packstr(object->req_cpus, buffer);
-	packstr(object->req_mem, buffer);
-	packstr(object->resvid, buffer);
-	packstr(object->start, buffer);
-	packstr(object->state, buffer);
-	packstr(object->state_reason_prev, buffer);
-	packstr(object->submit, buffer);
-	packstr(object->suspended, buffer);
-	packstr(object->system_comment, buffer);
-	packstr(object->track_steps, buffer);
-	packstr(object->tres_alloc_str, buffer);
-	packstr(object->tres_req_str, buffer);
-	packstr(object->uid, buffer);
-	packstr(object->wckey, buffer);
-	packstr(object->wckey_id, buffer);
-	packstr(object->work_dir, buffer);
+	_pack_dict_str(object->account, dict, buffer);
+	_pack_dict_str(object->admin_comment, dict, buffer);
+	_pack_dict_str(object->alloc_nodes, dict, buffer);
+	_pack_dict_str(object->associd, dict, buffer);
+	_pack_dict_str(object->array_jobid, dict, buffer);
+	_pack_dict_str(object->array_max_tasks, dict, buffer);
+	_pack_dict_str(object->array_taskid, dict, buffer);
+	_pack_dict_str(object->array_task_pending, dict, buffer);
+	_pack_dict_str(object->array_task_str, dict, buffer);
+	_pack_dict_str(object->script, dict, buffer);
+	_pack_dict_str(object->blockid, dict, buffer);
+	_pack_dict_str(object->constraints, dict, buffer);
+	_pack_dict_str(object->deleted, dict, buffer);
+	_pack_dict_str(object->derived_ec, dict, buffer);
+	_pack_dict_str(object->derived_es, dict, buffer);
+	_pack_dict_str(object->env, dict, buffer);
+	_pack_dict_str(object->exit_code, dict, buffer);
+	_pack_dict_str(object->flags, dict, buffer);
+	_pack_dict_str(object->timelimit, dict, buffer);
+	_pack_dict_str(object->eligible, dict, buffer);
+	_pack_dict_str(object->end, dict, buffer);
+	_pack_dict_str(object->gid, dict, buffer);
+	_pack_dict_str(object->gres_used, dict, buffer);
+	_pack_dict_str(object->job_db_inx, dict, buffer);
+	_pack_dict_str(object->jobid, dict, buffer);
+	_pack_dict_str(object->kill_requid, dict, buffer);
+	_pack_dict_str(object->mcs_label, dict, buffer);
+	_pack_dict_str(object->mod_time, dict, buffer);
+	_pack_dict_str(object->name, dict, buffer);
+	_pack_dict_str(object->nodelist, dict, buffer);
+	_pack_dict_str(object->node_inx, dict, buffer);
+	_pack_dict_str(object->het_job_id, dict, buffer);
+	_pack_dict_str(object->het_job_offset, dict, buffer);
+	_pack_dict_str(object->partition, dict, buffer);
+	_pack_dict_str(object->priority, dict, buffer);
+	_pack_dict_str(object->qos, dict, buffer);
+	_pack_dict_str(object->req_cpus, dict, buffer);
+	_pack_dict_str(object->req_mem, dict, buffer);
+	_pack_dict_str(object->resvid, dict, buffer);
+	_pack_dict_str(object->start, dict, buffer);
+	_pack_dict_str(object->state, dict, buffer);
+	_pack_dict_str(object->state_reason_prev, dict, buffer);
+	_pack_dict_str(object->submit, dict, buffer);
+	_pack_dict_str(object->suspended, dict, buffer);
+	_pack_dict_str(object->system_comment, dict, buffer);
+	_pack_dict_str(object->track_steps, dict, buffer);
+	_pack_dict_str(object->tres_alloc_str, dict, buffer);
+	_pack_dict_str(object->tres_req_str, dict, buffer);
+	_pack_dict_str(object->uid, dict, buffer);
+	_pack_dict_str(object->wckey, dict, buffer);
+	_pack_dict_str(object->wckey_id, dict, buffer);
+	_pack_dict_str(object->work_dir, dict, buffer);
 }
 
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_job(local_job_t *object, uint16_t rpc_version,
-			     buf_t *buffer)
+			     archive_dict_t *dict, buf_t *buffer)
 {
 	uint32_t tmp32;
 	char *tmp_char = NULL;
@@ -955,7 +1087,60 @@ static int _unpack_local_job(local_job_t *object, uint16_t rpc_version,
 	 * and it unpacks in the expected order.
 	 */
 
-	if (rpc_version >= SLURM_21_08_PROTOCOL_VERSION) {
+	if (rpc_version >= ARCHIVE_DICT_VERSION) {
+		safe_unpack_dict_str(&object->account, dict, buffer);
+		safe_unpack_dict_str(&object->admin_comment, dict, buffer);
+		safe_unpack_dict_str(&object->alloc_nodes, dict, buffer);
+		safe_unpack_dict_str(&object->associd, dict, buffer);
+		safe_unpack_dict_str(&object->array_jobid, dict, buffer);
+		safe_unpack_dict_str(&object->array_max_tasks, dict, buffer);
+		safe_unpack_dict_str(&object->array_taskid, dict, buffer);
+		safe_unpack_dict_str(&object->array_task_pending, dict, buffer);
+		safe_unpack_dict_str(&object->array_task_str, dict, buffer);
+		safe_unpack_dict_str(&object->script, dict, buffer);
+		safe_unpack_dict_str(&object->blockid, dict, buffer);
+		safe_unpack_dict_str(&object->constraints, dict, buffer);
+		safe_unpack_dict_str(&object->deleted, dict, buffer);
+		safe_unpack_dict_str(&object->derived_ec, dict, buffer);
+		safe_unpack_dict_str(&object->derived_es, dict, buffer);
+		safe_unpack_dict_str(&object->env, dict, buffer);
+		safe_unpack_dict_str(&object->exit_code, dict, buffer);
+		safe_unpack_dict_str(&object->flags, dict, buffer);
+		safe_unpack_dict_str(&object->timelimit, dict, buffer);
+		safe_unpack_dict_str(&object->eligible, dict, buffer);
+		safe_unpack_dict_str(&object->end, dict, buffer);
+		safe_unpack_dict_str(&object->gid, dict, buffer);
+		safe_unpack_dict_str(&object->gres_used, dict, buffer);
+		safe_unpack_dict_str(&object->job_db_inx, dict, buffer);
+		safe_unpack_dict_str(&object->jobid, dict, buffer);
+		safe_unpack_dict_str(&object->kill_requid, dict, buffer);
+		safe_unpack_dict_str(&object->mcs_label, dict, buffer);
+		safe_unpack_dict_str(&object->mod_time, dict, buffer);
+		safe_unpack_dict_str(&object->name, dict, buffer);
+		safe_unpack_dict_str(&object->nodelist, dict, buffer);
+		safe_unpack_dict_str(&object->node_inx, dict, buffer);
+		safe_unpack_dict_str(&object->het_job_id, dict, buffer);
+		safe_unpack_dict_str(&object->het_job_offset, dict, buffer);
+		safe_unpack_dict_str(&object->partition, dict, buffer);
+		safe_unpack_dict_str(&object->priority, dict, buffer);
+		safe_unpack_dict_str(&object->qos, dict, buffer);
+		safe_unpack_dict_str(&object->req_cpus, dict, buffer);
+		safe_unpack_dict_str(&object->req_mem, dict, buffer);
+		safe_unpack_dict_str(&object->resvid, dict, buffer);
+		safe_unpack_dict_str(&object->start, dict, buffer);
+		safe_unpack_dict_str(&object->state, dict, buffer);
+		safe_unpack_dict_str(&object->state_reason_prev, dict, buffer);
+		safe_unpack_dict_str(&object->submit, dict, buffer);
+		safe_unpack_dict_str(&object->suspended, dict, buffer);
+		safe_unpack_dict_str(&object->system_comment, dict, buffer);
+		safe_unpack_dict_str(&object->track_steps, dict, buffer);
+		safe_unpack_dict_str(&object->tres_alloc_str, dict, buffer);
+		safe_unpack_dict_str(&object->tres_req_str, dict, buffer);
+		safe_unpack_dict_str(&object->uid, dict, buffer);
+		safe_unpack_dict_str(&object->wckey, dict, buffer);
+		safe_unpack_dict_str(&object->wckey_id, dict, buffer);
+		safe_unpack_dict_str(&object->work_dir, dict, buffer);
+	} else if (rpc_version >= SLURM_21_08_PROTOCOL_VERSION) {
 		safe_unpackstr_xmalloc(&object->account, &tmp32, buffer);
 		safe_unpackstr_xmalloc(&object->admin_comment, &tmp32, buffer);
 		safe_unpackstr_xmalloc(&object->alloc_nodes, &tmp32, buffer);
@@ -1558,62 +1743,114 @@ unpack_error:
 }
 
 static void _pack_local_step(local_step_t *object, uint16_t rpc_version,
-			     buf_t *buffer)
+			     archive_dict_t *dict, buf_t *buffer)
 {
-	packstr(object->act_cpufreq, buffer);
-	packstr(object->deleted, buffer);
-	packstr(object->exit_code, buffer);
-	packstr(object->consumed_energy, buffer);
-	packstr(object->job_db_inx, buffer);
-	packstr(object->kill_requid, buffer);
-	packstr(object->name, buffer);
-	packstr(object->nodelist, buffer);
-	packstr(object->nodes, buffer);
-	packstr(object->node_inx, buffer);
-	packstr(object->period_end, buffer);
-	packstr(object->period_start, buffer);
-	packstr(object->period_suspended, buffer);
-	packstr(object->req_cpufreq_min, buffer);
-	packstr(object->req_cpufreq_max, buffer);
-	packstr(object->req_cpufreq_gov, buffer);
-	packstr(object->state, buffer);
-	packstr(object->stepid, buffer);
-	packstr(object->step_het_comp, buffer);
-	packstr(object->submit_line, buffer);
-	packstr(object->sys_sec, buffer);
-	packstr(object->sys_usec, buffer);
-	packstr(object->tasks, buffer);
-	packstr(object->task_dist, buffer);
-	packstr(object->tres_alloc_str, buffer);
-	packstr(object->tres_usage_in_ave, buffer);
-	packstr(object->tres_usage_in_max, buffer);
-	packstr(object->tres_usage_in_max_nodeid, buffer);
-	packstr(object->tres_usage_in_max_taskid, buffer);
-	packstr(object->tres_usage_in_min, buffer);
-	packstr(object->tres_usage_in_min_nodeid, buffer);
-	packstr(object->tres_usage_in_min_taskid, buffer);
-	packstr(object->tres_usage_in_tot, buffer);
-	packstr(object->tres_usage_out_ave, buffer);
-	packstr(object->tres_usage_out_max, buffer);
-	packstr(object->tres_usage_out_max_nodeid, buffer);
-	packstr(object->tres_usage_out_max_taskid, buffer);
-	packstr(object->tres_usage_out_min, buffer);
-	packstr(object->tres_usage_out_min_nodeid, buffer);
-	packstr(object->tres_usage_out_min_taskid, buffer);
-	packstr(object->tres_usage_out_tot, buffer);
-	packstr(object->user_sec, buffer);
-	packstr(object->user_usec, buffer);
+	_pack_dict_str(object->act_cpufreq, dict, buffer);
+	_pack_dict_str(object->deleted, dict, buffer);
+	_pack_dict_str(object->exit_code, dict, buffer);
+	_pack_dict_str(object->consumed_energy, dict, buffer);
+	_pack_dict_str(object->job_db_inx, dict, buffer);
+	_pack_dict_str(object->kill_requid, dict, buffer);
+	_pack_dict_str(object->name, dict, buffer);
+	_pack_dict_str(object->nodelist, dict, buffer);
+	_pack_dict_str(object->nodes, dict, buffer);
+	_pack_dict_str(object->node_inx, dict, buffer);
+	_pack_dict_str(object->period_end, dict, buffer);
+	_pack_dict_str(object->period_start, dict, buffer);
+	_pack_dict_str(object->period_suspended, dict, buffer);
+	_pack_dict_str(object->req_cpufreq_min, dict, buffer);
+	_pack_dict_str(object->req_cpufreq_max, dict, buffer);
+	_pack_dict_str(object->req_cpufreq_gov, dict, buffer);
+	_pack_dict_str(object->state, dict, buffer);
+	_pack_dict_str(object->stepid, dict, buffer);
+	_pack_dict_str(object->step_het_comp, dict, buffer);
+	_pack_dict_str(object->submit_line, dict, buffer);
+	_pack_dict_str(object->sys_sec, dict, buffer);
+	_pack_dict_str(object->sys_usec, dict, buffer);
+	_pack_dict_str(object->tasks, dict, buffer);
+	_pack_dict_str(object->task_dist, dict, buffer);
+	_pack_dict_str(object->tres_alloc_str, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_ave, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_max, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_max_nodeid, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_max_taskid, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_min, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_min_nodeid, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_min_taskid, dict, buffer);
+	_pack_dict_str(object->tres_usage_in_tot, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_ave, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_max, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_max_nodeid, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_max_taskid, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_min, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_min_nodeid, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_min_taskid, dict, buffer);
+	_pack_dict_str(object->tres_usage_out_tot, dict, buffer);
+	_pack_dict_str(object->user_sec, dict, buffer);
+	_pack_dict_str(object->user_usec, dict, buffer);
 }
 
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_step(local_step_t *object, uint16_t rpc_version,
-			      buf_t *buffer)
+			      archive_dict_t *dict, buf_t *buffer)
 {
 	uint32_t tmp32;
 	char *tmp_char;
 
-	if (rpc_version >= SLURM_21_08_PROTOCOL_VERSION) {
+	if (rpc_version >= ARCHIVE_DICT_VERSION) {
+		safe_unpack_dict_str(&object->act_cpufreq, dict, buffer);
+		safe_unpack_dict_str(&object->deleted, dict, buffer);
+		safe_unpack_dict_str(&object->exit_code, dict, buffer);
+		safe_unpack_dict_str(&object->consumed_energy, dict, buffer);
+		safe_unpack_dict_str(&object->job_db_inx, dict, buffer);
+		safe_unpack_dict_str(&object->kill_requid, dict, buffer);
+		safe_unpack_dict_str(&object->name, dict, buffer);
+		safe_unpack_dict_str(&object->nodelist, dict, buffer);
+		safe_unpack_dict_str(&object->nodes, dict, buffer);
+		safe_unpack_dict_str(&object->node_inx, dict, buffer);
+		safe_unpack_dict_str(&object->period_end, dict, buffer);
+		safe_unpack_dict_str(&object->period_start, dict, buffer);
+		safe_unpack_dict_str(&object->period_suspended, dict, buffer);
+		safe_unpack_dict_str(&object->req_cpufreq_min, dict, buffer);
+		safe_unpack_dict_str(&object->req_cpufreq_max, dict, buffer);
+		safe_unpack_dict_str(&object->req_cpufreq_gov, dict, buffer);
+		safe_unpack_dict_str(&object->state, dict, buffer);
+		safe_unpack_dict_str(&object->stepid, dict, buffer);
+		safe_unpack_dict_str(&object->step_het_comp, dict, buffer);
+		safe_unpack_dict_str(&object->submit_line, dict, buffer);
+		safe_unpack_dict_str(&object->sys_sec, dict, buffer);
+		safe_unpack_dict_str(&object->sys_usec, dict, buffer);
+		safe_unpack_dict_str(&object->tasks, dict, buffer);
+		safe_unpack_dict_str(&object->task_dist, dict, buffer);
+		safe_unpack_dict_str(&object->tres_alloc_str, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_ave, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_max, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_max_nodeid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_max_taskid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_min, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_min_nodeid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_min_taskid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_in_tot, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_ave, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_max, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_max_nodeid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_max_taskid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_min, dict, buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_min_nodeid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_min_taskid, dict,
+				     buffer);
+		safe_unpack_dict_str(&object->tres_usage_out_tot, dict, buffer);
+		safe_unpack_dict_str(&object->user_sec, dict, buffer);
+		safe_unpack_dict_str(&object->user_usec, dict, buffer);
+	} else if (rpc_version >= SLURM_21_08_PROTOCOL_VERSION) {
 		safe_unpackstr_xmalloc(&object->act_cpufreq, &tmp32, buffer);
 		safe_unpackstr_xmalloc(&object->deleted, &tmp32, buffer);
 		safe_unpackstr_xmalloc(&object->exit_code, &tmp32, buffer);
@@ -3035,15 +3272,12 @@ static buf_t *_pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 				 time_t *period_start)
 {
 	MYSQL_ROW row;
-	buf_t *buffer;
+	buf_t *buffer, *records;
 	local_job_t job;
+	archive_dict_t dict;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_JOBS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
+	_init_archive_dict(&dict);
+	records = init_buf(high_buffer_size);
 
 	while ((row = mysql_fetch_row(result))) {
 		if (period_start && !*period_start)
@@ -3104,15 +3338,27 @@ static buf_t *_pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 		job.wckey_id = row[JOB_REQ_WCKEYID];
 		job.work_dir = row[JOB_REQ_WORK_DIR];
 
-		_pack_local_job(&job, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_job(&job, ARCHIVE_DICT_VERSION, &dict, records);
 	}
 
+	buffer = init_buf(high_buffer_size + get_buf_offset(records));
+	pack16(ARCHIVE_DICT_VERSION, buffer);
+	pack_time(time(NULL), buffer);
+	pack16(DBD_GOT_JOBS, buffer);
+	packstr(cluster_name, buffer);
+	pack32(cnt, buffer);
+	_pack_archive_dict(&dict, records, buffer);
+
+	_free_archive_dict_members(&dict);
+	free_buf(records);
+
 	return buffer;
 }
 
 /* returns sql statement from archived data or NULL on error */
 static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
-			char *cluster_name, uint32_t rec_cnt)
+			archive_dict_t *dict, char *cluster_name,
+			uint32_t rec_cnt)
 {
 	char *insert = NULL, *format = NULL;
 	int safe_attributes[] = {
@@ -3188,7 +3434,7 @@ static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
 
 	for (i = 0; i < rec_cnt; i++) {
 
-		if (_unpack_local_job(&object, rpc_version, buffer)
+		if (_unpack_local_job(&object, rpc_version, dict, buffer)
 		    != SLURM_SUCCESS) {
 			error("issue unpacking");
 			xfree(insert);
@@ -3426,15 +3672,12 @@ static buf_t *_pack_archive_steps(MYSQL_RES *result, char *cluster_name,
 				  time_t *period_start)
 {
 	MYSQL_ROW row;
-	buf_t *buffer;
+	buf_t *buffer, *records;
 	local_step_t step;
+	archive_dict_t dict;
 
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_STEP_START, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
+	_init_archive_dict(&dict);
+	records = init_buf(high_buffer_size);
 
 	while ((row = mysql_fetch_row(result))) {
 		if (period_start && !*period_start)
@@ -3494,15 +3737,27 @@ static buf_t *_pack_archive_steps(MYSQL_RES *result, char *cluster_name,
 		step.user_sec = row[STEP_REQ_USER_SEC];
 		step.user_usec = row[STEP_REQ_USER_USEC];
 
-		_pack_local_step(&step, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_step(&step, ARCHIVE_DICT_VERSION, &dict, records);
 	}
 
+	buffer = init_buf(high_buffer_size + get_buf_offset(records));
+	pack16(ARCHIVE_DICT_VERSION, buffer);
+	pack_time(time(NULL), buffer);
+	pack16(DBD_STEP_START, buffer);
+	packstr(cluster_name, buffer);
+	pack32(cnt, buffer);
+	_pack_archive_dict(&dict, records, buffer);
+
+	_free_archive_dict_members(&dict);
+	free_buf(records);
+
 	return buffer;
 }
 
 /* returns sql statement from archived data or NULL on error */
 static char *_load_steps(uint16_t rpc_version, buf_t *buffer,
-			 char *cluster_name, uint32_t rec_cnt)
+			 archive_dict_t *dict, char *cluster_name,
+			 uint32_t rec_cnt)
 {
 	char *insert = NULL, *format = NULL;
 	local_step_t object;
@@ -3519,7 +3774,7 @@ static char *_load_steps(uint16_t rpc_version, buf_t *buffer,
 	xstrcat(format, ")");
 	for (i=0; i<rec_cnt; i++) {
 		memset(&object, 0, sizeof(local_step_t));
-		if (_unpack_local_step(&object, rpc_version, buffer)
+		if (_unpack_local_step(&object, rpc_version, dict, buffer)
 		    != SLURM_SUCCESS) {
 			error("issue unpacking");
 			xfree(format);
@@ -4544,6 +4799,7 @@ extern int as_mysql_jobacct_process_archive_load(
 	uint16_t type = 0, ver = 0, period = 0;
 	uint32_t data_size = 0, rec_cnt = 0, tmp32 = 0;
 	uint32_t rec_cnt_total = 0, rec_cnt_left = 0, pass_cnt = 0;
+	archive_dict_t dict = { 0 };
 
 	/* Ensure that the connection is not set in autocommit mode. */
 	xassert(mysql_conn->rollback);
@@ -4563,7 +4819,12 @@ extern int as_mysql_jobacct_process_archive_load(
 			     arch_rec->archive_file);
 			error_code = errno;
 		} else {
+			struct stat stat_buf;
+
+			/* Read the file in one allocation when we can */
 			data_allocated = BUF_SIZE + 1;
+			if (!fstat(state_fd, &stat_buf))
+				data_allocated += stat_buf.st_size;
 			data = xmalloc_nz(data_allocated);
 			while (1) {
 				data_read = read(state_fd, &data[data_size],
@@ -4581,9 +4842,11 @@ extern int as_mysql_jobacct_process_archive_load(
 				data[data_size + data_read] = '\0';
 				if (data_read == 0)	/* eof */
 					break;
-				data_size      += data_read;
-				data_allocated += data_read;
-				xrealloc_nz(data, data_allocated);
+				data_size += data_read;
+				if ((data_size + BUF_SIZE + 1) > data_allocated) {
+					data_allocated = data_size + BUF_SIZE + 1;
+					xrealloc_nz(data, data_allocated);
+				}
 			}
 			close(state_fd);
 		}
@@ -4627,7 +4890,7 @@ extern int as_mysql_jobacct_process_archive_load(
 	 * older versions around here just to support super old
 	 * archive files since they don't get regenerated all the time.
 	 */
-	if (ver > SLURM_PROTOCOL_VERSION) {
+	if ((ver > SLURM_PROTOCOL_VERSION) && (ver != ARCHIVE_DICT_VERSION)) {
 		error("***********************************************");
 		error("Can not recover archive file, incompatible version, "
 		      "got %u need <= %u", ver,
@@ -4647,6 +4910,14 @@ extern int as_mysql_jobacct_process_archive_load(
 		goto got_sql;
 	}
 
+	if ((ver >= ARCHIVE_DICT_VERSION) &&
+	    ((type == DBD_GOT_JOBS) || (type == DBD_STEP_START)) &&
+	    (_unpack_archive_dict(&dict, buffer) != SLURM_SUCCESS)) {
+		error("Couldn't unpack the string dictionary of the archive");
+		error_code = SLURM_ERROR;
+		goto cleanup;
+	}
+
 	rec_cnt_left = rec_cnt;
 	rec_cnt_total = rec_cnt;
 pass:
@@ -4664,13 +4935,14 @@ pass:
 		data = _load_events(ver, buffer, cluster_name, rec_cnt);
 		break;
 	case DBD_GOT_JOBS:
-		data = _load_jobs(ver, buffer, cluster_name, rec_cnt);
+		data = _load_jobs(ver, buffer, &dict, cluster_name, rec_cnt);
 		break;
 	case DBD_GOT_RESVS:
 		data = _load_resvs(ver, buffer, cluster_name, rec_cnt);
 		break;
 	case DBD_STEP_START:
-		data = _load_steps(ver, buffer, cluster_name, rec_cnt);
+		data = _load_steps(ver, buffer, &dict, cluster_name,
+				   rec_cnt);
 		break;
 	case DBD_JOB_SUSPEND:
 		data = _load_suspend(ver, buffer, cluster_name, rec_cnt);
@@ -4719,6 +4991,7 @@ unpack_error:
 
 cleanup:
 	xfree(cluster_name);
+	_free_archive_dict_members(&dict);
 	FREE_NULL_BUFFER(buffer);
 
 	if (error_code)
@@ -50,6 +50,18 @@ typedef struct {
 	bitstr_t *asked_bitmap;
 } local_cluster_t;
 
+/* Number of jobs whose steps and suspended times are read with one query */
+#define JOB_WINDOW_SIZE 1000
+
+typedef struct {
+	slurmdb_job_rec_t *job;
+	bool get_steps;
+	bool get_suspended;
+	bool job_ended;
+	time_t start;		/* job start used to test step node indexes */
+	char *step_extra;	/* condition on the steps of this job */
+} window_job_t;
+
 /* if this changes you will need to edit the corresponding
  * enum below also t1 is job_table */
 char *job_req_inx[] = {
@@ -214,6 +226,7 @@ char *step_req_inx[] = {
 	"t1.tres_usage_out_min_taskid",
 	"t1.tres_usage_out_min_nodeid",
 	"t1.tres_usage_out_tot",
+	"t1.job_db_inx",
 };
 
 enum {
@@ -259,6 +272,7 @@ enum {
 	STEP_REQ_TRES_USAGE_OUT_MIN_TASKID,
 	STEP_REQ_TRES_USAGE_OUT_MIN_NODEID,
 	STEP_REQ_TRES_USAGE_OUT_TOT,
+	STEP_REQ_DB_INX,
 	STEP_REQ_COUNT
 };
 
@@ -464,21 +478,390 @@ static void _destroy_local_cluster(void *object)
 	}
 }
 
+static int _sort_window_job(const void *x, const void *y)
+{
+	const window_job_t *job_x = x, *job_y = y;
+
+	if (job_x->job->db_index < job_y->job->db_index)
+		return -1;
+	return (job_x->job->db_index > job_y->job->db_index);
+}
+
+static void _add_job_suspended(slurmdb_job_rec_t *job, time_t local_start,
+			       time_t local_end)
+{
+	if (!local_start)
+		return;
+
+	if (job->start > local_start)
+		local_start = job->start;
+	if (job->end < local_end)
+		local_end = job->end;
+
+	if ((local_end - local_start) < 1)
+		return;
+
+	job->elapsed -= (local_end - local_start);
+	job->suspended += (local_end - local_start);
+}
+
+static void _add_job_step(slurmdb_job_rec_t *job, MYSQL_ROW step_row,
+			  bool job_ended, slurmdb_job_cond_t *job_cond,
+			  time_t now)
+{
+	slurmdb_step_rec_t *step;
+
+	step = slurmdb_create_step_rec();
+	step->tot_cpu_sec = 0;
+	step->tot_cpu_usec = 0;
+	step->job_ptr = job;
+	if (!job->first_step_ptr)
+		job->first_step_ptr = step;
+	list_append(job->steps, step);
+	step->step_id.job_id = job->jobid;
+	step->step_id.step_id = slurm_atoul(
+		step_row[STEP_REQ_STEPID]);
+	step->step_id.step_het_comp =
+		slurm_atoul(step_row[STEP_REQ_STEP_HET_COMP]);
+	/* info("got %ps", &step->step_id); */
+	step->state = slurm_atoul(step_row[STEP_REQ_STATE]);
+	step->exitcode =
+		slurm_atoul(step_row[STEP_REQ_EXIT_CODE]);
+	step->nnodes = slurm_atoul(step_row[STEP_REQ_NODES]);
+
+	step->ntasks = slurm_atoul(step_row[STEP_REQ_TASKS]);
+	step->task_dist =
+		slurm_atoul(step_row[STEP_REQ_TASKDIST]);
+
+	step->start = slurm_atoul(step_row[STEP_REQ_START]);
+
+	step->end = slurm_atoul(step_row[STEP_REQ_END]);
+	/* if the job has ended end the step also */
+	if (!step->end && job_ended) {
+		step->end = job->end;
+		step->state = job->state;
+	}
+
+	if (job_cond &&
+	    !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC)
+	    && job_cond->usage_start) {
+		if (step->start
+		    && (step->start < job_cond->usage_start))
+			step->start = job_cond->usage_start;
+
+		if (!step->start && step->end)
+			step->start = step->end;
+
+		if (!step->end
+		    || (step->end > job_cond->usage_end))
+			step->end = job_cond->usage_end;
+
+		if (step->start && step->end &&
+		   (step->start > step->end))
+			step->start = step->end = 0;
+	}
+
+	/* figure this out by start stop */
+	step->suspended =
+		slurm_atoul(step_row[STEP_REQ_SUSPENDED]);
+
+	/* fix the suspended number to be correct */
+	if (step->state == JOB_SUSPENDED)
+		step->suspended = now - step->suspended;
+	if (!step->start) {
+		step->elapsed = 0;
+	} else if (!step->end) {
+		step->elapsed = now - step->start;
+	} else {
+		step->elapsed = step->end - step->start;
+	}
+	step->elapsed -= step->suspended;
+
+	if ((int)step->elapsed < 0)
+		step->elapsed = 0;
+
+	step->req_cpufreq_min = slurm_atoul(
+		step_row[STEP_REQ_REQ_CPUFREQ_MIN]);
+	step->req_cpufreq_max = slurm_atoul(
+		step_row[STEP_REQ_REQ_CPUFREQ_MAX]);
+	step->req_cpufreq_gov =	slurm_atoul(
+		step_row[STEP_REQ_REQ_CPUFREQ_GOV]);
+
+	step->stepname = xstrdup(step_row[STEP_REQ_NAME]);
+	step->nodes = xstrdup(step_row[STEP_REQ_NODELIST]);
+	step->requid =
+		slurm_atoul(step_row[STEP_REQ_KILL_REQUID]);
+
+	step->submit_line =
+		xstrdup(step_row[STEP_REQ_SUBMIT_LINE]);
+
+	step->user_cpu_sec = slurm_atoull(
+		step_row[STEP_REQ_USER_SEC]);
+	step->user_cpu_usec = slurm_atoul(
+		step_row[STEP_REQ_USER_USEC]);
+	step->sys_cpu_sec =slurm_atoull(
+		step_row[STEP_REQ_SYS_SEC]);
+	step->sys_cpu_usec = slurm_atoul(
+		step_row[STEP_REQ_SYS_USEC]);
+	step->tot_cpu_sec +=
+		step->user_cpu_sec + step->sys_cpu_sec;
+	step->tot_cpu_usec += step->user_cpu_usec +
+		step->sys_cpu_usec;
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MAX])
+		step->stats.tres_usage_in_max =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID])
+		step->stats.tres_usage_in_max_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID])
+		step->stats.tres_usage_in_max_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_AVE])
+		step->stats.tres_usage_in_ave =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_AVE]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MIN])
+		step->stats.tres_usage_in_min =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID])
+		step->stats.tres_usage_in_min_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID])
+		step->stats.tres_usage_in_min_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_TOT])
+		step->stats.tres_usage_in_tot =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_TOT]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX])
+		step->stats.tres_usage_out_max =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID])
+		step->stats.tres_usage_out_max_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID])
+		step->stats.tres_usage_out_max_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_AVE])
+		step->stats.tres_usage_out_ave =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_AVE]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN])
+		step->stats.tres_usage_out_min =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID])
+		step->stats.tres_usage_out_min_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID])
+		step->stats.tres_usage_out_min_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_TOT])
+		step->stats.tres_usage_out_tot =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_TOT]);
+	step->stats.act_cpufreq =
+		atof(step_row[STEP_REQ_ACT_CPUFREQ]);
+	step->stats.consumed_energy = slurm_atoull(
+		step_row[STEP_REQ_CONSUMED_ENERGY]);
+	step->container = xstrdup(step_row[STEP_REQ_CONTAINER]);
+
+	if (step_row[STEP_REQ_TRES])
+		step->tres_alloc_str =
+			xstrdup(step_row[STEP_REQ_TRES]);
+}
+
+static void _set_job_track_steps(slurmdb_job_rec_t *job)
+{
+	slurmdb_step_rec_t *step = job->first_step_ptr;
+	uint64_t j_cpus, s_cpus;
+
+	if (job->track_steps)
+		return;
+
+	/* If we don't have track_steps we want to see
+	   if we have multiple steps.  If we only have
+	   1 step check the job name against the step
+	   name in most all cases it will be
+	   different.  If it is different print out
+	   the step separate.  It could also be a single
+	   step/allocation where the job was allocated more than
+	   the step requested (eg. CR_Socket).
+	*/
+	if (list_count(job->steps) > 1)
+		job->track_steps = 1;
+	else if (step &&
+		 (xstrcmp(step->stepname, job->jobname) ||
+		  (((j_cpus = slurmdb_find_tres_count_in_string(
+			     job->tres_alloc_str, TRES_CPU))
+		    != INFINITE64) &&
+		   ((s_cpus = slurmdb_find_tres_count_in_string(
+			     step->tres_alloc_str, TRES_CPU))
+		    != INFINITE64) &&
+		  j_cpus != s_cpus)))
+		job->track_steps = 1;
+}
+
+/*
+ * Read the suspended times and the steps of a window of jobs, one query for
+ * each rather than one per job, and add them to the jobs. The rows come
+ * ordered by job_db_inx and are merged with the window sorted the same way.
+ * The window is empty on return.
+ */
+static int _get_window_steps(mysql_conn_t *mysql_conn, char *cluster_name,
+			     char *step_fields, slurmdb_job_cond_t *job_cond,
+			     window_job_t *window, int *win_cnt,
+			     List local_cluster_list,
+			     local_cluster_t **curr_cluster, time_t now)
+{
+	char *query = NULL, *inx_list = NULL, *step_cond = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	uint64_t db_inx;
+	int i, j, cnt = *win_cnt, rc = SLURM_SUCCESS;
+
+	qsort(window, cnt, sizeof(window_job_t), _sort_window_job);
+
+	for (i = 0; i < cnt; i++) {
+		if (!window[i].get_suspended)
+			continue;
+		xstrfmtcat(inx_list, "%s%"PRIu64,
+			   inx_list ? "," : "", window[i].job->db_index);
+	}
+
+	if (inx_list) {
+		/* get the suspended time for these jobs */
+		query = xstrdup_printf(
+			"select job_db_inx, time_start, time_end from "
+			"\"%s_%s\" where "
+			"(time_start < %ld && (time_end >= %ld "
+			"|| time_end = 0)) && job_db_inx in (%s) "
+			"order by job_db_inx, time_start",
+			cluster_name, suspend_table,
+			job_cond->usage_end,
+			job_cond->usage_start,
+			inx_list);
+		xfree(inx_list);
+
+		DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
+		if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+		xfree(query);
+
+		i = 0;
+		while ((row = mysql_fetch_row(result))) {
+			db_inx = slurm_atoull(row[0]);
+			while ((i < cnt) && (window[i].job->db_index < db_inx))
+				i++;
+			for (j = i; (j < cnt) &&
+				     (window[j].job->db_index == db_inx); j++) {
+				if (window[j].get_suspended)
+					_add_job_suspended(
+						window[j].job,
+						slurm_atoul(row[1]),
+						slurm_atoul(row[2]));
+			}
+		}
+		mysql_free_result(result);
+
+		for (i = 0; i < cnt; i++) {
+			if ((int)window[i].job->elapsed < 0)
+				window[i].job->elapsed = 0;
+		}
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (!window[i].get_steps)
+			continue;
+		if (window[i].step_extra)
+			xstrfmtcat(step_cond, "%s(t1.job_db_inx=%"PRIu64"%s)",
+				   step_cond ? " || " : "",
+				   window[i].job->db_index,
+				   window[i].step_extra);
+		else
+			xstrfmtcat(inx_list, "%s%"PRIu64,
+				   inx_list ? "," : "",
+				   window[i].job->db_index);
+	}
+
+	if (!inx_list && !step_cond)
+		goto end_it;
+
+	query =	xstrdup_printf("select %s from \"%s_%s\" as t1 "
+			       "where t1.time_start <= %ld && "
+			       "(!t1.time_end || t1.time_end >= %ld) && (",
+			       step_fields, cluster_name, step_table,
+			       job_cond->usage_end,
+			       job_cond->usage_start);
+	if (inx_list)
+		xstrfmtcat(query, "t1.job_db_inx in (%s)%s", inx_list,
+			   step_cond ? " || " : "");
+	if (step_cond)
+		xstrcat(query, step_cond);
+	xstrcat(query, ") order by t1.job_db_inx, t1.id_step, "
+		"t1.step_het_comp");
+	xfree(inx_list);
+	xfree(step_cond);
+
+	DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
+	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+		rc = SLURM_ERROR;
+		goto end_it;
+	}
+	xfree(query);
+
+	i = 0;
+	while ((row = mysql_fetch_row(result))) {
+		db_inx = slurm_atoull(row[STEP_REQ_DB_INX]);
+		while ((i < cnt) && (window[i].job->db_index < db_inx))
+			i++;
+		for (j = i; (j < cnt) && (window[j].job->db_index == db_inx);
+		     j++) {
+			if (!window[j].get_steps)
+				continue;
+			/* check the bitmap to see if this is one of the steps
+			   we are looking for */
+			if (!good_nodes_from_inx(local_cluster_list,
+						 (void **)curr_cluster,
+						 row[STEP_REQ_NODE_INX],
+						 window[j].start))
+				continue;
+			_add_job_step(window[j].job, row, window[j].job_ended,
+				      job_cond, now);
+		}
+	}
+	mysql_free_result(result);
+
+	for (i = 0; i < cnt; i++) {
+		if (window[i].get_steps)
+			_set_job_track_steps(window[i].job);
+	}
+
+end_it:
+	xfree(query);
+	xfree(inx_list);
+	xfree(step_cond);
+	for (i = 0; i < cnt; i++)
+		xfree(window[i].step_extra);
+	*win_cnt = 0;
+
+	return rc;
+}
+
 static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     slurmdb_user_rec_t *user,
 			     slurmdb_job_cond_t *job_cond,
 			     char *cluster_name,
 			     char *job_fields, char *step_fields,
 			     char *sent_extra,
-			     bool is_admin, int only_pending, List sent_list)
+			     bool is_admin, int only_pending, List sent_list,
+			     slurmdb_job_chunk_f chunk_cb, void *chunk_arg)
 {
 	char *query = NULL;
 	char *extra = xstrdup(sent_extra);
 	slurm_selected_step_t *selected_step = NULL;
-	MYSQL_RES *result = NULL, *step_result = NULL;
-	MYSQL_ROW row, step_row;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
 	slurmdb_job_rec_t *job = NULL;
-	slurmdb_step_rec_t *step = NULL;
+	window_job_t *window = NULL;
+	int win_cnt = 0;
 	time_t now = time(NULL);
 	List job_list = list_create(slurmdb_destroy_job_rec);
 	ListIterator itr = NULL, itr2 = NULL;
@@ -616,6 +999,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 		}
 	}
 
+	window = xcalloc(JOB_WINDOW_SIZE, sizeof(window_job_t));
 	while ((row = mysql_fetch_row(result))) {
 		char *db_inx_char = row[JOB_REQ_DB_INX];
 		bool job_ended = 0;
@@ -641,6 +1025,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 
 		job = slurmdb_create_job_rec();
 		job->state = slurm_atoul(row[JOB_REQ_STATE]);
+		memset(&window[win_cnt], 0, sizeof(window_job_t));
 		if (curr_id == last_id)
 			/* put in reverse so we order by the submit getting
 			   larger which it is given to us in reverse
@@ -743,58 +1128,9 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 
 			job->elapsed = job->end - job->start;
 
-			if (row[JOB_REQ_SUSPENDED]) {
-				MYSQL_RES *result2 = NULL;
-				MYSQL_ROW row2;
-				/* get the suspended time for this job */
-				query = xstrdup_printf(
-					"select time_start, time_end from "
-					"\"%s_%s\" where "
-					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
-					"order by time_start",
-					cluster_name, suspend_table,
-					job_cond->usage_end,
-					job_cond->usage_start,
-					db_inx_char);
-
-				debug4("%d(%s:%d) query\n%s",
-				       mysql_conn->conn, THIS_FILE,
-				       __LINE__, query);
-				if (!(result2 = mysql_db_query_ret(
-					      mysql_conn,
-					      query, 0))) {
-					FREE_NULL_LIST(job_list);
-					job_list = NULL;
-					xfree(query);
-					break;
-				}
-				xfree(query);
-				while ((row2 = mysql_fetch_row(result2))) {
-					time_t local_start =
-						slurm_atoul(row2[0]);
-					time_t local_end =
-						slurm_atoul(row2[1]);
-
-					if (!local_start)
-						continue;
-
-					if (job->start > local_start)
-						local_start = job->start;
-					if (job->end < local_end)
-						local_end = job->end;
-
-					if ((local_end - local_start) < 1)
-						continue;
-
-					job->elapsed -=
-						(local_end - local_start);
-					job->suspended +=
-						(local_end - local_start);
-				}
-				mysql_free_result(result2);
-
-			}
+			/* the suspended time is read with the job window */
+			if (row[JOB_REQ_SUSPENDED])
+				window[win_cnt].get_suspended = true;
 		} else {
 			job->suspended = slurm_atoul(row[JOB_REQ_SUSPENDED]);
 
@@ -887,15 +1223,18 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 					break;
 				}
 				if (set)
-					xstrcat(extra, " || ");
+					xstrcat(window[win_cnt].step_extra,
+						" || ");
 				else
-					xstrcat(extra, " && (");
+					xstrcat(window[win_cnt].step_extra,
+						" && (");
 
 				/*
 				 * The stepid could be negative so use
 				 * %d not %u
 				 */
-				xstrfmtcat(extra, "t1.id_step=%d",
+				xstrfmtcat(window[win_cnt].step_extra,
+					   "t1.id_step=%d",
 					   selected_step->step_id.step_id);
 
 				set = 1;
@@ -903,241 +1242,58 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			}
 			list_iterator_destroy(itr);
 			if (set)
-				xstrcat(extra, ")");
-		}
-
-		query =	xstrdup_printf("select %s from \"%s_%s\" as t1 "
-				       "where t1.job_db_inx=%s && "
-				       "t1.time_start <= %ld && "
-				       "(!t1.time_end || t1.time_end >= %ld)",
-				       step_fields, cluster_name,
-				       step_table, db_inx_char,
-				       job_cond->usage_end,
-				       job_cond->usage_start);
-
-		if (extra) {
-			xstrcat(query, extra);
-			xfree(extra);
+				xstrcat(window[win_cnt].step_extra, ")");
 		}
 
-		DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
-
-		if (!(step_result = mysql_db_query_ret(
-			      mysql_conn, query, 0))) {
-			xfree(query);
-			rc = SLURM_ERROR;
-			mysql_free_result(result);
-			goto end_it;
+		window[win_cnt].get_steps = true;
+	skip_steps:
+		if (window[win_cnt].get_steps ||
+		    window[win_cnt].get_suspended) {
+			window[win_cnt].job = job;
+			window[win_cnt].job_ended = job_ended;
+			window[win_cnt].start = start;
+			win_cnt++;
 		}
-		xfree(query);
-
-		/* Querying the steps in the fashion was faster than
-		   doing only 1 query and then matching the steps up
-		   later with the job.
-		*/
-		while ((step_row = mysql_fetch_row(step_result))) {
-			/* check the bitmap to see if this is one of the steps
-			   we are looking for */
-			if (!good_nodes_from_inx(local_cluster_list,
-						 (void **)&curr_cluster,
-						 step_row[STEP_REQ_NODE_INX],
-						 start))
-				continue;
 
-			step = slurmdb_create_step_rec();
-			step->tot_cpu_sec = 0;
-			step->tot_cpu_usec = 0;
-			step->job_ptr = job;
-			if (!job->first_step_ptr)
-				job->first_step_ptr = step;
-			list_append(job->steps, step);
-			step->step_id.job_id = job->jobid;
-			step->step_id.step_id = slurm_atoul(
-				step_row[STEP_REQ_STEPID]);
-			step->step_id.step_het_comp =
-				slurm_atoul(step_row[STEP_REQ_STEP_HET_COMP]);
-			/* info("got %ps", &step->step_id); */
-			step->state = slurm_atoul(step_row[STEP_REQ_STATE]);
-			step->exitcode =
-				slurm_atoul(step_row[STEP_REQ_EXIT_CODE]);
-			step->nnodes = slurm_atoul(step_row[STEP_REQ_NODES]);
-
-			step->ntasks = slurm_atoul(step_row[STEP_REQ_TASKS]);
-			step->task_dist =
-				slurm_atoul(step_row[STEP_REQ_TASKDIST]);
-
-			step->start = slurm_atoul(step_row[STEP_REQ_START]);
-
-			step->end = slurm_atoul(step_row[STEP_REQ_END]);
-			/* if the job has ended end the step also */
-			if (!step->end && job_ended) {
-				step->end = job->end;
-				step->state = job->state;
-			}
-
-			if (job_cond &&
-			    !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC)
-			    && job_cond->usage_start) {
-				if (step->start
-				    && (step->start < job_cond->usage_start))
-					step->start = job_cond->usage_start;
-
-				if (!step->start && step->end)
-					step->start = step->end;
-
-				if (!step->end
-				    || (step->end > job_cond->usage_end))
-					step->end = job_cond->usage_end;
-
-				if (step->start && step->end &&
-				   (step->start > step->end))
-					step->start = step->end = 0;
-			}
-
-			/* figure this out by start stop */
-			step->suspended =
-				slurm_atoul(step_row[STEP_REQ_SUSPENDED]);
+		if ((win_cnt < JOB_WINDOW_SIZE) &&
+		    (!chunk_cb || (list_count(job_list) < JOB_WINDOW_SIZE)))
+			continue;
 
-			/* fix the suspended number to be correct */
-			if (step->state == JOB_SUSPENDED)
-				step->suspended = now - step->suspended;
-			if (!step->start) {
-				step->elapsed = 0;
-			} else if (!step->end) {
-				step->elapsed = now - step->start;
-			} else {
-				step->elapsed = step->end - step->start;
-			}
-			step->elapsed -= step->suspended;
-
-			if ((int)step->elapsed < 0)
-				step->elapsed = 0;
-
-			step->req_cpufreq_min = slurm_atoul(
-				step_row[STEP_REQ_REQ_CPUFREQ_MIN]);
-			step->req_cpufreq_max = slurm_atoul(
-				step_row[STEP_REQ_REQ_CPUFREQ_MAX]);
-			step->req_cpufreq_gov =	slurm_atoul(
-				step_row[STEP_REQ_REQ_CPUFREQ_GOV]);
-
-			step->stepname = xstrdup(step_row[STEP_REQ_NAME]);
-			step->nodes = xstrdup(step_row[STEP_REQ_NODELIST]);
-			step->requid =
-				slurm_atoul(step_row[STEP_REQ_KILL_REQUID]);
-
-			step->submit_line =
-				xstrdup(step_row[STEP_REQ_SUBMIT_LINE]);
-
-			step->user_cpu_sec = slurm_atoull(
-				step_row[STEP_REQ_USER_SEC]);
-			step->user_cpu_usec = slurm_atoul(
-				step_row[STEP_REQ_USER_USEC]);
-			step->sys_cpu_sec =slurm_atoull(
-				step_row[STEP_REQ_SYS_SEC]);
-			step->sys_cpu_usec = slurm_atoul(
-				step_row[STEP_REQ_SYS_USEC]);
-			step->tot_cpu_sec +=
-				step->user_cpu_sec + step->sys_cpu_sec;
-			step->tot_cpu_usec += step->user_cpu_usec +
-				step->sys_cpu_usec;
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MAX])
-				step->stats.tres_usage_in_max =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID])
-				step->stats.tres_usage_in_max_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID])
-				step->stats.tres_usage_in_max_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_AVE])
-				step->stats.tres_usage_in_ave =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_AVE]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MIN])
-				step->stats.tres_usage_in_min =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID])
-				step->stats.tres_usage_in_min_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID])
-				step->stats.tres_usage_in_min_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_TOT])
-				step->stats.tres_usage_in_tot =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_TOT]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX])
-				step->stats.tres_usage_out_max =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID])
-				step->stats.tres_usage_out_max_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID])
-				step->stats.tres_usage_out_max_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_AVE])
-				step->stats.tres_usage_out_ave =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_AVE]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN])
-				step->stats.tres_usage_out_min =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID])
-				step->stats.tres_usage_out_min_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID])
-				step->stats.tres_usage_out_min_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_TOT])
-				step->stats.tres_usage_out_tot =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_TOT]);
-			step->stats.act_cpufreq =
-				atof(step_row[STEP_REQ_ACT_CPUFREQ]);
-			step->stats.consumed_energy = slurm_atoull(
-				step_row[STEP_REQ_CONSUMED_ENERGY]);
-			step->container = xstrdup(step_row[STEP_REQ_CONTAINER]);
-
-			if (step_row[STEP_REQ_TRES])
-				step->tres_alloc_str =
-					xstrdup(step_row[STEP_REQ_TRES]);
-		}
-		mysql_free_result(step_result);
-
-		if (!job->track_steps) {
-			uint64_t j_cpus, s_cpus;
-			/* If we don't have track_steps we want to see
-			   if we have multiple steps.  If we only have
-			   1 step check the job name against the step
-			   name in most all cases it will be
-			   different.  If it is different print out
-			   the step separate.  It could also be a single
-			   step/allocation where the job was allocated more than
-			   the step requested (eg. CR_Socket).
-			*/
-			if (list_count(job->steps) > 1)
-				job->track_steps = 1;
-			else if (step &&
-				 (xstrcmp(step->stepname, job->jobname) ||
-				  (((j_cpus = slurmdb_find_tres_count_in_string(
-					     job->tres_alloc_str, TRES_CPU))
-				    != INFINITE64) &&
-				   ((s_cpus = slurmdb_find_tres_count_in_string(
-					     step->tres_alloc_str, TRES_CPU))
-				    != INFINITE64) &&
-				  j_cpus != s_cpus)))
-					job->track_steps = 1;
-		}
-	skip_steps:
-		/* need to reset here to make the above test valid */
-		step = NULL;
+		/* A chunk can only be handed off once its window is read */
+		if (win_cnt &&
+		    ((rc = _get_window_steps(mysql_conn, cluster_name,
+					     step_fields, job_cond, window,
+					     &win_cnt, local_cluster_list,
+					     &curr_cluster, now)) !=
+		     SLURM_SUCCESS))
+			break;
+		if (!chunk_cb)
+			continue;
+		if ((rc = (chunk_cb)(job_list, chunk_arg)) != SLURM_SUCCESS)
+			break;
+		list_flush(job_list);
 	}
 	mysql_free_result(result);
 
+	if ((rc == SLURM_SUCCESS) && win_cnt)
+		rc = _get_window_steps(mysql_conn, cluster_name, step_fields,
+				       job_cond, window, &win_cnt,
+				       local_cluster_list, &curr_cluster, now);
+
 end_it:
+	for (int i = 0; i < win_cnt; i++)
+		xfree(window[i].step_extra);
+	xfree(window);
+
 	if (itr2)
 		list_iterator_destroy(itr2);
 
 	FREE_NULL_LIST(local_cluster_list);
 
-	if (rc == SLURM_SUCCESS)
+	if ((rc == SLURM_SUCCESS) && !chunk_cb)
 		list_transfer(sent_list, job_list);
+	else if ((rc == SLURM_SUCCESS) && list_count(job_list))
+		rc = (chunk_cb)(job_list, chunk_arg);
 
 	FREE_NULL_LIST(job_list);
 	return rc;
@@ -1700,23 +1856,53 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 	return set;
 }
 
-extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
-					      uid_t uid,
-					      slurmdb_job_cond_t *job_cond)
+typedef struct {
+	slurmdb_job_chunk_f chunk_cb;
+	void *chunk_arg;
+	assoc_mgr_lock_t *locks;
+} job_chunk_args_t;
+
+/*
+ * Hand a chunk of jobs on without the assoc_mgr locks, sending it may block
+ * on a slow client
+ */
+static int _unlocked_chunk_cb(List job_list, void *arg)
+{
+	job_chunk_args_t *args = arg;
+	int rc;
+
+	assoc_mgr_unlock(args->locks);
+	rc = (args->chunk_cb)(job_list, args->chunk_arg);
+	assoc_mgr_lock(args->locks);
+
+	return rc;
+}
+
+/*
+ * Get the jobs matching job_cond, either all at once in *job_list or in
+ * chunks handed to chunk_cb if set.
+ */
+static int _get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
+		     slurmdb_job_cond_t *job_cond, List *job_list,
+		     slurmdb_job_chunk_f chunk_cb, void *chunk_arg)
 {
 	char *extra = NULL;
 	char *tmp = NULL, *tmp2 = NULL;
 	ListIterator itr = NULL;
 	int is_admin=1;
-	int i;
-	List job_list = NULL;
+	int i, rc = SLURM_SUCCESS;
 	slurmdb_user_rec_t user;
 	int only_pending = 0;
 	List use_cluster_list = NULL;
 	char *cluster_name;
-	bool locked = false;
+	bool locked = false, new_cluster_list = false;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
+	job_chunk_args_t chunk_args = {
+		.chunk_cb = chunk_cb,
+		.chunk_arg = chunk_arg,
+		.locks = &locks,
+	};
 
 	memset(&user, 0, sizeof(slurmdb_user_rec_t));
 	user.uid = uid;
@@ -1735,7 +1921,7 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 		if (!is_admin && !user.name) {
 			debug("User %u has no associations, and is not admin, "
 			      "so not returning any jobs.", user.uid);
-			return NULL;
+			return SLURM_SUCCESS;
 		}
 	}
 
@@ -1757,7 +1943,7 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 		if (reason) {
 			error("User %u is requesting %s, but no job requested, this is not allowed",
 			      user.uid, reason);
-			return NULL;
+			return SLURM_SUCCESS;
 		}
 	}
 
@@ -1785,7 +1971,20 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 	if (job_cond
 	    && job_cond->cluster_list && list_count(job_cond->cluster_list))
 		use_cluster_list = job_cond->cluster_list;
-	else {
+	else if (chunk_cb) {
+		/*
+		 * Chunks may take long to send, so don't keep the
+		 * as_mysql_cluster_list_lock locked, work off a copy.
+		 */
+		new_cluster_list = true;
+		use_cluster_list = list_create(xfree_ptr);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
+		itr = list_iterator_create(as_mysql_cluster_list);
+		while ((cluster_name = list_next(itr)))
+			list_append(use_cluster_list, xstrdup(cluster_name));
+		list_iterator_destroy(itr);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
+	} else {
 		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 		use_cluster_list = list_shallow_copy(as_mysql_cluster_list);
 		locked = true;
@@ -1793,22 +1992,31 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 
 	assoc_mgr_lock(&locks);
 
-	job_list = list_create(slurmdb_destroy_job_rec);
+	if (!chunk_cb)
+		*job_list = list_create(slurmdb_destroy_job_rec);
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
-		int rc;
 		_setup_job_cond_selected_steps(job_cond, cluster_name, &extra);
 		if ((rc = _cluster_get_jobs(mysql_conn, &user, job_cond,
 					    cluster_name, tmp, tmp2, extra,
-					    is_admin, only_pending, job_list))
-		    != SLURM_SUCCESS)
-			error("Problem getting jobs for cluster %s",
-			      cluster_name);
+					    is_admin, only_pending,
+					    chunk_cb ? NULL : *job_list,
+					    chunk_cb ? _unlocked_chunk_cb : NULL,
+					    &chunk_args))
+		    == SLURM_SUCCESS)
+			continue;
+		error("Problem getting jobs for cluster %s", cluster_name);
+		/* Chunks already sent can't be taken back */
+		if (chunk_cb)
+			break;
+		rc = SLURM_SUCCESS;
 	}
 	list_iterator_destroy(itr);
 
 	assoc_mgr_unlock(&locks);
 
+	if (new_cluster_list)
+		FREE_NULL_LIST(use_cluster_list);
 	if (locked) {
 		FREE_NULL_LIST(use_cluster_list);
 		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
@@ -1818,5 +2026,23 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 	xfree(tmp2);
 	xfree(extra);
 
+	return rc;
+}
+
+extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
+					      uid_t uid,
+					      slurmdb_job_cond_t *job_cond)
+{
+	List job_list = NULL;
+
+	(void) _get_jobs(mysql_conn, uid, job_cond, &job_list, NULL, NULL);
+
 	return job_list;
 }
+
+extern int as_mysql_jobacct_process_get_jobs_chunked(
+	mysql_conn_t *mysql_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	return _get_jobs(mysql_conn, uid, job_cond, NULL, chunk_cb, arg);
+}
@@ -60,4 +60,10 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
 					   slurmdb_job_cond_t *job_cond);
 
+/* Same as as_mysql_jobacct_process_get_jobs() but hand the jobs to chunk_cb
+ * a bounded number at a time instead of returning them all */
+extern int as_mysql_jobacct_process_get_jobs_chunked(
+	mysql_conn_t *mysql_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg);
+
 #endif
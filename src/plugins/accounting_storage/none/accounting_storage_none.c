@@ -498,6 +498,17 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	return NULL;
 }
 
+/*
+ * get info from the storage in chunks
+ * returns SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_p_get_jobs_cond_chunked(
+	void *db_conn, uid_t uid, void *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	return SLURM_SUCCESS;
+}
+
 /*
  * expire old info from the storage
  */
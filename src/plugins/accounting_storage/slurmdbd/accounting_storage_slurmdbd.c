@@ -2997,6 +2997,107 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	return my_job_list;
 }
 
+/* Get the whole list with DBD_GET_JOBS_COND and hand it to chunk_cb */
+static int _get_jobs_cond_whole(void *db_conn, uid_t uid,
+				slurmdb_job_cond_t *job_cond,
+				slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	List job_list;
+	int rc = SLURM_SUCCESS;
+
+	if (!(job_list = jobacct_storage_p_get_jobs_cond(db_conn, uid,
+							 job_cond)))
+		return errno ? errno : SLURM_ERROR;
+	if (list_count(job_list))
+		rc = (chunk_cb)(job_list, arg);
+	FREE_NULL_LIST(job_list);
+	return rc;
+}
+
+/*
+ * get info from the storage in chunks handed to chunk_cb
+ * returns SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_p_get_jobs_cond_chunked(
+	void *db_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_chunk_f chunk_cb, void *arg)
+{
+	persist_msg_t req = {0}, resp = {0};
+	dbd_cond_msg_t get_msg = { .cond = job_cond };
+	dbd_list_msg_t *got_msg;
+	int rc, cb_rc = SLURM_SUCCESS;
+	bool got_chunk = false, rejected = false;
+
+	/* The agent and older SlurmDBDs only answer with the whole list */
+	if (running_in_slurmctld() ||
+	    (((slurm_persist_conn_t *) db_conn)->version <
+	     SLURM_22_05_PROTOCOL_VERSION))
+		return _get_jobs_cond_whole(db_conn, uid, job_cond, chunk_cb,
+					    arg);
+
+	req.msg_type = DBD_GET_JOBS_COND_CHUNKED;
+	req.conn = db_conn;
+	req.data = &get_msg;
+	rc = dbd_conn_send_recv_direct(SLURM_PROTOCOL_VERSION, &req, &resp);
+
+	/*
+	 * Every chunk has to be read to keep the connection in step even if
+	 * chunk_cb asked to stop.
+	 */
+	while ((rc == SLURM_SUCCESS) && (resp.msg_type == DBD_GOT_JOBS_CHUNK)) {
+		got_msg = resp.data;
+		got_chunk = true;
+		if ((cb_rc == SLURM_SUCCESS) && got_msg->my_list &&
+		    list_count(got_msg->my_list))
+			cb_rc = (chunk_cb)(got_msg->my_list, arg);
+		slurmdbd_free_list_msg(got_msg);
+		memset(&resp, 0, sizeof(resp));
+		rc = dbd_conn_recv_direct(SLURM_PROTOCOL_VERSION, &req, &resp);
+	}
+
+	if (rc != SLURM_SUCCESS)
+		error("DBD_GET_JOBS_COND_CHUNKED failure: %s",
+		      slurm_strerror(rc));
+	else if (resp.msg_type == PERSIST_RC) {
+		persist_rc_msg_t *msg = resp.data;
+		/*
+		 * A 22.05 SlurmDBD without DBD_GET_JOBS_COND_CHUNKED fails to
+		 * unpack it. Nothing was returned yet, so ask again for the
+		 * whole list.
+		 */
+		if ((rc = msg->rc) == SLURM_SUCCESS)
+			info("%s", msg->comment);
+		else if (!got_chunk &&
+			 (msg->ret_info == DBD_GET_JOBS_COND_CHUNKED)) {
+			debug("%s: DBD_GET_JOBS_COND_CHUNKED rejected (%s), using DBD_GET_JOBS_COND",
+			      __func__, msg->comment);
+			rejected = true;
+		} else
+			error("%s", msg->comment);
+		slurm_persist_free_rc_msg(msg);
+		if (rejected)
+			return _get_jobs_cond_whole(db_conn, uid, job_cond,
+						    chunk_cb, arg);
+	} else if (resp.msg_type != DBD_GOT_JOBS) {
+		error("response type not DBD_GOT_JOBS: %u",
+		      resp.msg_type);
+		rc = SLURM_ERROR;
+	} else {
+		got_msg = resp.data;
+		if ((cb_rc == SLURM_SUCCESS) && got_msg->my_list &&
+		    list_count(got_msg->my_list))
+			cb_rc = (chunk_cb)(got_msg->my_list, arg);
+		slurmdbd_free_list_msg(got_msg);
+	}
+
+	if (rc == SLURM_SUCCESS)
+		rc = cb_rc;
+	else
+		slurm_seterrno(rc);
+
+	return rc;
+}
+
 /*
  * Expire old info from the storage
  * Not applicable for any database
@@ -241,6 +241,28 @@ extern void dbd_conn_close(slurm_persist_conn_t **pc)
 	*pc = NULL;
 }
 
+static int _recv_msg(uint16_t rpc_version, persist_msg_t *req,
+		     persist_msg_t *resp)
+{
+	int rc;
+	buf_t *buffer = slurm_persist_recv_msg(req->conn);
+
+	if (buffer == NULL) {
+		error("Getting response to message type: %s",
+		      slurmdbd_msg_type_2_str(req->msg_type, 1));
+		return SLURM_ERROR;
+	}
+
+	rc = unpack_slurmdbd_msg(resp, rpc_version, buffer);
+	/* check for the rc of the start job message */
+	if (rc == SLURM_SUCCESS && resp->msg_type == DBD_ID_RC)
+		rc = ((dbd_id_rc_msg_t *)resp->data)->return_code;
+
+	free_buf(buffer);
+
+	return rc;
+}
+
 /*
  * Send an RPC to the SlurmDBD and wait for an arbitrary reply message.
  * The RPC will not be queued if an error occurs.
@@ -283,21 +305,27 @@ extern int dbd_conn_send_recv_direct(uint16_t rpc_version,
 		goto end_it;
 	}
 
-	buffer = slurm_persist_recv_msg(use_conn);
-	if (buffer == NULL) {
-		error("Getting response to message type: %s",
-		      slurmdbd_msg_type_2_str(req->msg_type, 1));
-		rc = SLURM_ERROR;
-		goto end_it;
-	}
+	rc = _recv_msg(rpc_version, req, resp);
+end_it:
 
-	rc = unpack_slurmdbd_msg(resp, rpc_version, buffer);
-	/* check for the rc of the start job message */
-	if (rc == SLURM_SUCCESS && resp->msg_type == DBD_ID_RC)
-		rc = ((dbd_id_rc_msg_t *)resp->data)->return_code;
+	log_flag(PROTOCOL, "msg_type:%s protocol_version:%hu return_code:%d response_msg_type:%s",
+		 slurmdbd_msg_type_2_str(req->msg_type, 1),
+		 rpc_version, rc, slurmdbd_msg_type_2_str(resp->msg_type, 1));
 
-	free_buf(buffer);
-end_it:
+	return rc;
+}
+
+extern int dbd_conn_recv_direct(uint16_t rpc_version,
+				persist_msg_t *req,
+				persist_msg_t *resp)
+{
+	int rc;
+
+	xassert(req);
+	xassert(resp);
+	xassert(req->conn);
+
+	rc = _recv_msg(rpc_version, req, resp);
 
 	log_flag(PROTOCOL, "msg_type:%s protocol_version:%hu return_code:%d response_msg_type:%s",
 		 slurmdbd_msg_type_2_str(req->msg_type, 1),
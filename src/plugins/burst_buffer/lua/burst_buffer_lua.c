@@ -1007,6 +1007,7 @@ static void *_start_stage_out(void *x)
 			job_ptr->job_state &= (~JOB_STAGE_OUT);
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
+			job_delta_stamp(job_ptr);
 			log_flag(BURST_BUF, "Stage-out/post-run complete for %pJ",
 				 job_ptr);
 			if (bb_job)
@@ -2919,6 +2920,7 @@ fini:	xfree(data_buf);
 static void _kill_job(job_record_t *job_ptr, bool hold_job)
 {
 	last_job_update = time(NULL);
+	job_delta_stamp(job_ptr);
 	job_ptr->end_time = last_job_update;
 	if (hold_job)
 		job_ptr->priority = 0;
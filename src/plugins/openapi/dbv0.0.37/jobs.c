@@ -64,6 +64,8 @@ typedef struct {
 	List tres_list;
 	List qos_list;
 	List assoc_list;
+	int rc;
+	uint32_t job_cnt;
 } foreach_job_t;
 
 static int _foreach_job(void *x, void *arg)
@@ -85,6 +87,20 @@ static int _foreach_job(void *x, void *arg)
 		return 1;
 }
 
+/* Dump each chunk of jobs as it comes from slurmdb_jobs_get_chunked() */
+static int _foreach_job_chunk(List jobs, void *arg)
+{
+	foreach_job_t *args = arg;
+
+	xassert(args->magic == MAGIC_FOREACH_JOB);
+
+	args->job_cnt += list_count(jobs);
+	if (list_for_each(jobs, _foreach_job, args) < 0)
+		args->rc = ESLURM_DATA_CONV_FAILED;
+
+	return args->rc;
+}
+
 typedef struct {
 	data_t *errors;
 	slurmdb_job_cond_t *job_cond;
@@ -398,21 +414,38 @@ static int _dump_jobs(const char *context_id, http_request_method_t method,
 		.magic = MAGIC_FOREACH_JOB,
 		.jobs = data_set_list(data_key_set(resp, "jobs")),
 	};
-	List jobs = NULL;
+	void *db_conn;
 
-	if (!db_query_list(errors, auth, &jobs, slurmdb_jobs_get, job_cond) &&
-	    !db_query_list(errors, auth, &args.assoc_list,
+	/*
+	 * Jobs are dumped a chunk at a time so only the dumped data and not
+	 * every job record is held at once.
+	 */
+	if (!db_query_list(errors, auth, &args.assoc_list,
 			   slurmdb_associations_get, &assoc_cond) &&
 	    !db_query_list(errors, auth, &args.qos_list, slurmdb_qos_get,
 			   &qos_cond) &&
 	    !db_query_list(errors, auth, &args.tres_list, slurmdb_tres_get,
-			   &tres_cond) &&
-	    (list_for_each(jobs, _foreach_job, &args) < 0))
-		rc = ESLURM_DATA_CONV_FAILED;
+			   &tres_cond)) {
+		int db_rc;
+
+		if (!(db_conn = openapi_get_db_conn(auth)))
+			resp_error(errors, ESLURM_DB_CONNECTION,
+				   "Failed connecting to slurmdbd",
+				   "slurmdb_jobs_get_chunked");
+		else if ((db_rc = slurmdb_jobs_get_chunked(db_conn, job_cond,
+							   _foreach_job_chunk,
+							   &args)) &&
+			 !args.rc)
+			resp_error(errors, db_rc, NULL,
+				   "slurmdb_jobs_get_chunked");
+		else if (!args.job_cnt)
+			resp_error(errors, ESLURM_REST_EMPTY_RESULT,
+				   "Nothing found", "slurmdb_jobs_get_chunked");
+		rc = args.rc;
+	}
 
 	FREE_NULL_LIST(args.tres_list);
 	FREE_NULL_LIST(args.qos_list);
-	FREE_NULL_LIST(jobs);
 
 	return rc;
 }
@@ -58,6 +58,22 @@ typedef enum {
 	URL_TAG_PING,
 } url_tag_t;
 
+/* Set d to a histogram of lock wait or hold times */
+static void _set_lock_hist(data_t *d, stats_info_response_msg_t *resp,
+			   uint32_t *cnt)
+{
+	data_set_list(d);
+
+	for (int i = 0; i < resp->lock_bucket_cnt; i++) {
+		data_t *h = data_set_dict(data_list_append(d));
+
+		if (resp->lock_bucket_usec[i] != NO_VAL)
+			data_set_int(data_key_set(h, "under_usec"),
+				     resp->lock_bucket_usec[i]);
+		data_set_int(data_key_set(h, "count"), cnt[i]);
+	}
+}
+
 static int _op_handler_diag(const char *context_id,
 			    http_request_method_t method, data_t *parameters,
 			    data_t *query, int tag, data_t *p, void *auth)
@@ -143,6 +159,124 @@ static int _op_handler_diag(const char *context_id,
 		     resp->bf_when_last_cycle);
 	data_set_bool(data_key_set(d, "bf_active"), (resp->bf_active != 0));
 
+	if (resp->job_hash_cnt) {
+		data_t *hashes = data_set_list(data_key_set(d, "job_hash"));
+
+		for (int i = 0; i < resp->job_hash_cnt; i++) {
+			data_t *h = data_set_dict(data_list_append(hashes));
+
+			data_set_string(data_key_set(h, "name"),
+					resp->job_hash_name[i]);
+			data_set_int(data_key_set(h, "size"),
+				     resp->job_hash_size[i]);
+			data_set_int(data_key_set(h, "records"),
+				     resp->job_hash_records[i]);
+			data_set_int(data_key_set(h, "lookups"),
+				     resp->job_hash_lookups[i]);
+			data_set_int(data_key_set(h, "probes"),
+				     resp->job_hash_probes[i]);
+			data_set_int(data_key_set(h, "probe_max"),
+				     resp->job_hash_probe_max[i]);
+			data_set_int(data_key_set(h, "resizes"),
+				     resp->job_hash_resizes[i]);
+		}
+	}
+
+	if (resp->rpc_pool_queue_cnt) {
+		data_t *pool = data_set_dict(data_key_set(d, "rpc_pool"));
+		data_t *queues = data_set_list(data_key_set(pool, "queues"));
+
+		data_set_int(data_key_set(pool, "threads"),
+			     resp->rpc_pool_threads);
+
+		for (int i = 0; i < resp->rpc_pool_queue_cnt; i++) {
+			data_t *q = data_set_dict(data_list_append(queues));
+
+			data_set_string(data_key_set(q, "name"),
+					resp->rpc_pool_queue_name[i]);
+			data_set_int(data_key_set(q, "depth"),
+				     resp->rpc_pool_queue_depth[i]);
+			data_set_int(data_key_set(q, "depth_max"),
+				     resp->rpc_pool_queue_depth_max[i]);
+			data_set_int(data_key_set(q, "count"),
+				     resp->rpc_pool_queue_count[i]);
+			data_set_int(data_key_set(q, "wait_time"),
+				     resp->rpc_pool_queue_wait_time[i]);
+			data_set_int(data_key_set(q, "wait_max"),
+				     resp->rpc_pool_queue_wait_max[i]);
+			data_set_int(data_key_set(q, "deferred"),
+				     resp->rpc_pool_queue_rejected[i]);
+		}
+	}
+
+	if (resp->record_pool_cnt) {
+		data_t *pools = data_set_list(data_key_set(d, "record_pools"));
+
+		for (int i = 0; i < resp->record_pool_cnt; i++) {
+			data_t *p = data_set_dict(data_list_append(pools));
+
+			data_set_string(data_key_set(p, "name"),
+					resp->record_pool_name[i]);
+			data_set_int(data_key_set(p, "size"),
+				     resp->record_pool_obj_size[i]);
+			data_set_int(data_key_set(p, "in_use"),
+				     resp->record_pool_in_use[i]);
+			data_set_int(data_key_set(p, "slabs"),
+				     resp->record_pool_slabs[i]);
+			data_set_int(data_key_set(p, "allocs"),
+				     resp->record_pool_allocs[i]);
+		}
+	}
+
+	if (resp->fwd_hop_bucket_cnt) {
+		data_t *fwd = data_set_dict(data_key_set(d, "forwarding"));
+		data_t *hops = data_set_list(data_key_set(fwd, "hops"));
+
+		data_set_int(data_key_set(fwd, "failed"), resp->fwd_failed);
+		data_set_int(data_key_set(fwd, "rerouted"),
+			     resp->fwd_rerouted);
+
+		for (int i = 0; i < resp->fwd_hop_bucket_cnt; i++) {
+			data_t *h = data_set_dict(data_list_append(hops));
+
+			if (resp->fwd_hop_usec[i] != NO_VAL)
+				data_set_int(data_key_set(h, "under_usec"),
+					     resp->fwd_hop_usec[i]);
+			data_set_int(data_key_set(h, "count"),
+				     resp->fwd_hop_cnt[i]);
+		}
+	}
+
+	if (resp->lock_caller_cnt) {
+		static const char *lock_names[] = {
+			"conf", "job", "node", "part", "fed" };
+		data_t *locks = data_set_list(data_key_set(d, "locks"));
+
+		for (int i = 0; i < resp->lock_caller_cnt; i++) {
+			data_t *l = data_set_dict(data_list_append(locks));
+			uint32_t inx = i * resp->lock_bucket_cnt;
+
+			data_set_string(data_key_set(l, "caller"),
+					resp->lock_caller[i]);
+			if (resp->lock_type[i] < ARRAY_SIZE(lock_names))
+				data_set_string(data_key_set(l, "lock"),
+						lock_names[resp->lock_type[i]]);
+			data_set_string(data_key_set(l, "mode"),
+					((resp->lock_level[i] == 2) ?
+					 "write" : "read"));
+			data_set_int(data_key_set(l, "count"),
+				     resp->lock_cnt[i]);
+			data_set_int(data_key_set(l, "wait_time"),
+				     resp->lock_wait_usec[i]);
+			data_set_int(data_key_set(l, "hold_time"),
+				     resp->lock_hold_usec[i]);
+			_set_lock_hist(data_key_set(l, "wait"), resp,
+				       &resp->lock_wait_hist[inx]);
+			_set_lock_hist(data_key_set(l, "hold"), resp,
+				       &resp->lock_hold_hist[inx]);
+		}
+	}
+
 cleanup:
 	if (rc) {
 		data_t *e = data_set_dict(data_list_append(errors));
@@ -2031,6 +2031,7 @@ extern int decay_apply_weighted_factors(job_record_t *job_ptr,
 	    (job_ptr->priority < new_prio)) {
 		job_ptr->priority = new_prio;
 		last_job_update = time(NULL);
+		job_delta_stamp(job_ptr);
 	}
 
 	debug2("priority for job %u is now %u",
@@ -96,6 +96,8 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
 #include "backfill.h"
+#include "bf_plan.h"
+#include "node_space.h"
 
 #define BACKFILL_INTERVAL	30
 #define BACKFILL_RESOLUTION	60
@@ -119,6 +121,7 @@
 #define MAX_BF_MIN_PRIO_RESERVE        INFINITE
 #define MAX_BF_YIELD_INTERVAL          10000000 /* 10 seconds in usec */
 #define MAX_MAX_RPC_CNT                1000
+#define MAX_BF_PARALLEL_THREADS        256
 #define MAX_YIELD_SLEEP                10000000 /* 10 seconds in usec */
 
 #define MAX_BF_MAX_JOB_ASSOC           MAX_BF_MAX_JOB_TEST
@@ -126,17 +129,7 @@
 #define MAX_BF_MAX_JOB_USER_PART       MAX_BF_MAX_JOB_TEST
 #define MAX_BF_MAX_JOB_PART            MAX_BF_MAX_JOB_TEST
 
-typedef struct node_space_map {
-	time_t begin_time;
-	time_t end_time;
-	bitstr_t *avail_bitmap;
-	int next;	/* next record, by time, zero termination */
-} node_space_map_t;
-
-typedef struct node_space_handler {
-	node_space_map_t *node_space;
-	int *node_space_recs;
-} node_space_handler_t;
+#define BF_PLAN_AHEAD                  2 /* jobs planned per thread */
 
 /*
  * HetJob scheduling structures
@@ -212,12 +205,11 @@ static int yield_sleep   = YIELD_SLEEP;
 static List het_job_list = NULL;
 static xhash_t *user_usage_map = NULL; /* look up user usage when no assoc */
 static bitstr_t *planned_bitmap = NULL;
+static int bf_parallel_threads = 1;
+static List plan_list = NULL;	/* will-run results for jobs ahead */
+static uint32_t plan_test_cnt = 0, plan_used_cnt = 0;
 
 /*********************** local functions *********************/
-static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
-			     bitstr_t *res_bitmap,
-			     node_space_map_t *node_space,
-			     int *node_space_recs);
 static void _adjust_hetjob_prio(uint32_t *prio, uint32_t val);
 static int  _attempt_backfill(void);
 static int  _clear_job_estimates(void *x, void *arg);
@@ -256,9 +248,15 @@ static int  _start_job(job_record_t *job_ptr, bitstr_t *avail_bitmap);
 static bool _test_resv_overlap(node_space_map_t *node_space,
 			       bitstr_t *use_bitmap, uint32_t start_time,
 			       uint32_t end_reserve);
+static void _plan_flush(void);
 static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 		       uint32_t min_nodes, uint32_t max_nodes,
 		       uint32_t req_nodes, bitstr_t *exc_core_bitmap);
+static int  _try_sched_planned(job_record_t *job_ptr, part_record_t *part_ptr,
+				bitstr_t **avail_bitmap, uint32_t min_nodes,
+				uint32_t max_nodes, uint32_t req_nodes,
+				bitstr_t *exc_core_bitmap, uint32_t test_flags,
+				List job_queue, node_space_map_t *node_space);
 static int  _yield_locks(int64_t usec);
 static void _bf_map_key_id(void *item, const char **key, uint32_t *key_len);
 static void _bf_map_free(void *item);
@@ -292,23 +290,21 @@ static void _dump_job_test(job_record_t *job_ptr, bitstr_t *avail_bitmap,
 }
 
 /* Log resource allocate table */
-static void _dump_node_space_table(node_space_map_t *node_space_ptr)
+static void _dump_node_space_table(node_space_map_t *node_space)
 {
-	int i = 0;
+	node_space_rec_t *ns;
 	char begin_buf[32], end_buf[32], *node_list;
 
 	info("=========================================");
-	while (1) {
-		slurm_make_time_str(&node_space_ptr[i].begin_time,
+	for (ns = node_space->head; ns; ns = ns->next) {
+		slurm_make_time_str(&ns->begin_time,
 				    begin_buf, sizeof(begin_buf));
-		slurm_make_time_str(&node_space_ptr[i].end_time,
+		slurm_make_time_str(&ns->end_time,
 				    end_buf, sizeof(end_buf));
-		node_list = bitmap2node_name(node_space_ptr[i].avail_bitmap);
+		node_list = bitmap2node_name(ns->avail_bitmap);
 		info("Begin:%s End:%s Nodes:%s",
 		     begin_buf, end_buf, node_list);
 		xfree(node_list);
-		if ((i = node_space_ptr[i].next) == 0)
-			break;
 	}
 	info("=========================================");
 }
@@ -406,6 +402,15 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 	job_feature_t *feat_ptr;
 	job_feature_t *feature_base;
 
+	/*
+	 * cons_tres sets the low byte of node_ptr->sched_weight while testing
+	 * a job with GRES, and every test orders nodes by sched_weight. Such
+	 * jobs are never tested on bf_plan helper threads, and results stored
+	 * for jobs ahead are made stale by the new weights.
+	 */
+	if (job_ptr->gres_list_req)
+		_plan_flush();
+
 	if (has_xand || feat_cnt) {
 		/*
 		 * Cache the feature information and test the individual
@@ -636,6 +641,268 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 	return rc;
 }
 
+/* Drop all results of jobs tested ahead */
+static void _plan_flush(void)
+{
+	if (plan_list)
+		list_flush(plan_list);
+}
+
+static int _plan_find_job(void *x, void *key)
+{
+	bf_plan_t *plan = x, *key_plan = key;
+
+	if ((plan->job_ptr == key_plan->job_ptr) &&
+	    (plan->part_ptr == key_plan->part_ptr))
+		return 1;
+	return 0;
+}
+
+/*
+ * Run a plan's test through _try_sched(), saving the results in the plan
+ * and leaving the job record as it was. Called from the backfill thread and
+ * the bf_plan pool's helpers, each plan being for a different job.
+ */
+static void _plan_eval(bf_plan_t *plan)
+{
+	job_record_t *job_ptr = plan->job_ptr;
+	struct job_details *detail_ptr = job_ptr->details;
+	part_record_t *save_part_ptr = job_ptr->part_ptr;
+	uint32_t save_time_limit = job_ptr->time_limit;
+	uint64_t save_bit_flags = job_ptr->bit_flags;
+	time_t save_start_time = job_ptr->start_time;
+	uint32_t save_total_cpus = job_ptr->total_cpus;
+	bool save_best_switch = job_ptr->best_switch;
+	uint64_t save_pn_min_memory = detail_ptr->pn_min_memory;
+
+	job_ptr->part_ptr = plan->part_ptr;
+	job_ptr->time_limit = plan->time_limit;
+	job_ptr->bit_flags |= BACKFILL_TEST;
+	job_ptr->bit_flags |= plan->test_flags;
+
+	plan->sel_bitmap = bit_copy(plan->avail_bitmap);
+	plan->rc = _try_sched(job_ptr, &plan->sel_bitmap, plan->min_nodes,
+			      plan->max_nodes, plan->req_nodes,
+			      plan->exc_core_bitmap);
+	if (plan->rc != SLURM_SUCCESS)
+		FREE_NULL_BITMAP(plan->sel_bitmap);
+	plan->start_time = job_ptr->start_time;
+	plan->total_cpus = job_ptr->total_cpus;
+	plan->best_switch = job_ptr->best_switch;
+	plan->pn_min_memory = detail_ptr->pn_min_memory;
+
+	job_ptr->part_ptr = save_part_ptr;
+	job_ptr->time_limit = save_time_limit;
+	job_ptr->bit_flags = save_bit_flags;
+	job_ptr->start_time = save_start_time;
+	job_ptr->total_cpus = save_total_cpus;
+	job_ptr->best_switch = save_best_switch;
+	detail_ptr->pn_min_memory = save_pn_min_memory;
+}
+
+/*
+ * Build a plan for a job further down the queue, with the inputs
+ * _attempt_backfill() will give its first test if nothing changes before
+ * the job is reached. Jobs whose inputs depend on more than the job,
+ * partition and node_space (features, reservations, time_min, deadlines,
+ * hetjobs, job array records, burst buffers) are not planned. Neither are
+ * jobs with GRES, see _try_sched().
+ * RET plan or NULL if the job can not be planned
+ */
+static bf_plan_t *_plan_job(job_queue_rec_t *job_queue_rec,
+			    node_space_map_t *node_space)
+{
+	job_record_t *job_ptr = job_queue_rec->job_ptr;
+	part_record_t *part_ptr = job_queue_rec->part_ptr;
+	part_record_t *save_part_ptr = job_ptr->part_ptr;
+	struct job_details *detail_ptr = job_ptr->details;
+	uint32_t min_nodes, max_nodes, req_nodes, qos_flags = 0;
+	uint32_t time_limit, part_time_limit, end_time;
+	bitstr_t *avail_bitmap = NULL, *exc_core_bitmap = NULL;
+	time_t now = time(NULL), start_res = now;
+	bool resv_overlap = false;
+	node_space_rec_t *ns;
+	bf_plan_t *plan = NULL;
+	assoc_mgr_lock_t qos_read_lock =
+		{ NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
+		  NO_LOCK, NO_LOCK, NO_LOCK };
+
+	if (!part_ptr || !part_ptr->node_bitmap ||
+	    !(part_ptr->state_up & PARTITION_SCHED) ||
+	    !detail_ptr || detail_ptr->feature_list || detail_ptr->overcommit ||
+	    job_ptr->gres_list_req ||
+	    !IS_JOB_PENDING(job_ptr) || (job_ptr->priority == 0) ||
+	    job_ptr->het_job_id || job_ptr->array_recs ||
+	    job_ptr->resv_name || job_ptr->resv_list ||
+	    job_queue_rec->resv_ptr || job_ptr->burst_buffer ||
+	    job_ptr->preempt_in_progress || job_ptr->time_min ||
+	    (job_ptr->deadline && (job_ptr->deadline != NO_VAL)))
+		return NULL;
+
+	assoc_mgr_lock(&qos_read_lock);
+	if (job_ptr->qos_ptr)
+		qos_flags = job_ptr->qos_ptr->flags;
+	assoc_mgr_unlock(&qos_read_lock);
+	if (qos_flags & QOS_FLAG_NO_RESERVE)
+		return NULL;
+
+	job_ptr->part_ptr = part_ptr;
+	if (get_node_cnts(job_ptr, qos_flags, part_ptr, &min_nodes,
+			  &req_nodes, &max_nodes) != SLURM_SUCCESS)
+		goto fini;
+
+	if (part_ptr->max_time == INFINITE)
+		part_time_limit = YEAR_MINUTES;
+	else
+		part_time_limit = part_ptr->max_time;
+	if ((job_ptr->time_limit == NO_VAL) ||
+	    (job_ptr->time_limit == INFINITE))
+		time_limit = part_time_limit;
+	else if (part_ptr->max_time == INFINITE)
+		time_limit = job_ptr->time_limit;
+	else
+		time_limit = MIN(job_ptr->time_limit, part_time_limit);
+
+	if (min_nodes) {
+		if (!(ns = node_space_first_fit(node_space, start_res,
+						min_nodes)))
+			goto fini;
+		if ((ns != node_space->head) && (ns->begin_time > start_res))
+			start_res = ns->begin_time;
+	}
+	if ((job_test_resv(job_ptr, &start_res, true, &avail_bitmap,
+			   &exc_core_bitmap, &resv_overlap, false) !=
+	     SLURM_SUCCESS) || resv_overlap)
+		goto fini;
+	end_time = (time_limit * 60) + MAX(start_res, now);
+	if (end_time < now)	/* Overflow 32-bits */
+		end_time = INFINITE;
+
+	bit_and(avail_bitmap, part_ptr->node_bitmap);
+	bit_and(avail_bitmap, up_node_bitmap);
+	bit_and_not(avail_bitmap, bf_ignore_node_bitmap);
+	filter_by_node_owner(job_ptr, avail_bitmap);
+	filter_by_node_mcs(job_ptr, slurm_mcs_get_select(job_ptr),
+			   avail_bitmap);
+	for (ns = node_space_find(node_space, start_res); ns; ns = ns->next) {
+		if (ns->end_time <= start_res)
+			;
+		else if (ns->begin_time <= end_time)
+			bit_and(avail_bitmap, ns->avail_bitmap);
+		else
+			break;
+	}
+	if (detail_ptr->exc_node_bitmap)
+		bit_and_not(avail_bitmap, detail_ptr->exc_node_bitmap);
+	if ((bit_set_count(avail_bitmap) < min_nodes) ||
+	    (detail_ptr->req_node_bitmap &&
+	     !bit_super_set(detail_ptr->req_node_bitmap, avail_bitmap)) ||
+	    job_req_node_filter(job_ptr, avail_bitmap, true))
+		goto fini;
+
+	plan = bf_plan_create(job_ptr, part_ptr, min_nodes, max_nodes,
+			      req_nodes, 0, avail_bitmap, exc_core_bitmap);
+
+fini:
+	job_ptr->part_ptr = save_part_ptr;
+	FREE_NULL_BITMAP(avail_bitmap);
+	FREE_NULL_BITMAP(exc_core_bitmap);
+	return plan;
+}
+
+/*
+ * Add plans for jobs at the head of job_queue not yet planned, skipping any
+ * job which already has a plan in the batch.
+ * IN/OUT plans - batch of plan_cnt plans, room for max_cnt
+ * RET new count of plans in the batch
+ */
+static int _plan_ahead(List job_queue, node_space_map_t *node_space,
+		       bf_plan_t **plans, int plan_cnt, int max_cnt)
+{
+	ListIterator job_iterator;
+	job_queue_rec_t *job_queue_rec;
+	bf_plan_t key, *plan;
+	int i, scan_cnt = 0;
+
+	job_iterator = list_iterator_create(job_queue);
+	while ((plan_cnt < max_cnt) && (scan_cnt++ < (max_cnt * 4)) &&
+	       (job_queue_rec = list_next(job_iterator))) {
+		for (i = 0; i < plan_cnt; i++) {
+			if (plans[i]->job_ptr == job_queue_rec->job_ptr)
+				break;
+		}
+		if (i < plan_cnt)
+			continue;
+		key.job_ptr = job_queue_rec->job_ptr;
+		key.part_ptr = job_queue_rec->part_ptr;
+		if (list_find_first(plan_list, _plan_find_job, &key))
+			continue;
+		if ((plan = _plan_job(job_queue_rec, node_space)))
+			plans[plan_cnt++] = plan;
+	}
+	list_iterator_destroy(job_iterator);
+
+	return plan_cnt;
+}
+
+/*
+ * Test a job as _try_sched() would, using the result of an identical test
+ * made while an earlier job was tested if there is one. Otherwise jobs
+ * further down the queue are tested along with this one on the bf_plan
+ * pool and their results kept for when they are reached. Results are only
+ * reused while no job has been started and the locks have not been yielded.
+ */
+static int _try_sched_planned(job_record_t *job_ptr, part_record_t *part_ptr,
+			      bitstr_t **avail_bitmap, uint32_t min_nodes,
+			      uint32_t max_nodes, uint32_t req_nodes,
+			      bitstr_t *exc_core_bitmap, uint32_t test_flags,
+			      List job_queue, node_space_map_t *node_space)
+{
+	bf_plan_t *plan, *ahead, **plans;
+	int i, plan_cnt, max_cnt = bf_parallel_threads * BF_PLAN_AHEAD;
+	int rc;
+
+	/* Test jobs with GRES alone, see _try_sched() */
+	if (job_ptr->gres_list_req)
+		return _try_sched(job_ptr, avail_bitmap, min_nodes, max_nodes,
+				  req_nodes, exc_core_bitmap);
+
+	plan = bf_plan_create(job_ptr, part_ptr, min_nodes, max_nodes,
+			      req_nodes, test_flags, *avail_bitmap,
+			      exc_core_bitmap);
+	ahead = list_remove_first(plan_list, _plan_find_job, plan);
+	if (ahead && bf_plan_match(ahead, plan)) {
+		bf_plan_free(plan);
+		plan = ahead;
+		plan_used_cnt++;
+	} else {
+		bf_plan_free(ahead);
+		plans = xcalloc(max_cnt, sizeof(bf_plan_t *));
+		plans[0] = plan;
+		plan_cnt = _plan_ahead(job_queue, node_space, plans, 1,
+				       max_cnt);
+		bf_plan_pool_run(plans, plan_cnt, _plan_eval);
+		plan_test_cnt += plan_cnt;
+		for (i = 1; i < plan_cnt; i++)
+			list_append(plan_list, plans[i]);
+		xfree(plans);
+	}
+
+	job_ptr->start_time = plan->start_time;
+	job_ptr->total_cpus = plan->total_cpus;
+	job_ptr->best_switch = plan->best_switch;
+	job_ptr->details->pn_min_memory = plan->pn_min_memory;
+	rc = plan->rc;
+	if (rc == SLURM_SUCCESS) {
+		FREE_NULL_BITMAP(*avail_bitmap);
+		*avail_bitmap = plan->sel_bitmap;
+		plan->sel_bitmap = NULL;
+	}
+	bf_plan_free(plan);
+
+	return rc;
+}
+
 /* Terminate backfill_agent */
 extern void stop_backfill_agent(void)
 {
@@ -740,6 +1007,24 @@ static void _load_config(void)
 		bf_node_space_size = max_backfill_job_cnt;
 	}
 
+	if ((tmp_ptr = xstrcasestr(sched_params, "bf_parallel_threads="))) {
+		bf_parallel_threads = atoi(tmp_ptr + 20);
+		if ((bf_parallel_threads < 1) ||
+		    (bf_parallel_threads > MAX_BF_PARALLEL_THREADS)) {
+			error("Invalid SchedulerParameters bf_parallel_threads: %d",
+			      bf_parallel_threads);
+			bf_parallel_threads = 1;
+		}
+	} else {
+		bf_parallel_threads = 1;
+	}
+	if ((bf_parallel_threads > 1) &&
+	    xstrcmp(slurm_conf.select_type, "select/cons_res") &&
+	    xstrcmp(slurm_conf.select_type, "select/cons_tres")) {
+		error("SchedulerParameters bf_parallel_threads requires select/cons_res or select/cons_tres, ignored");
+		bf_parallel_threads = 1;
+	}
+
 	if ((tmp_ptr = xstrcasestr(sched_params, "bf_resolution="))) {
 		backfill_resolution = atoi(tmp_ptr + 14);
 		if (backfill_resolution < 1 ||
@@ -1023,6 +1308,7 @@ extern void *backfill_agent(void *args)
 	}
 #endif
 	_load_config();
+	bf_plan_pool_init(bf_parallel_threads, all_locks);
 	last_backfill_time = time(NULL);
 	planned_bitmap = bit_alloc(node_record_count);
 	het_job_list = list_create(_het_job_map_del);
@@ -1046,8 +1332,10 @@ extern void *backfill_agent(void *args)
 			load_config = false;
 		}
 		slurm_mutex_unlock(&config_lock);
-		if (load_config)
+		if (load_config) {
 			_load_config();
+			bf_plan_pool_init(bf_parallel_threads, all_locks);
+		}
 		now = time(NULL);
 		wait_time = difftime(now, last_backfill_time);
 		if ((wait_time < backfill_interval) ||
@@ -1075,6 +1363,7 @@ extern void *backfill_agent(void *args)
 
 		short_sleep = false;
 	}
+	bf_plan_pool_fini();
 	FREE_NULL_LIST(het_job_list);
 	xhash_free(user_usage_map); /* May have been init'ed if used */
 	FREE_NULL_BITMAP(planned_bitmap);
@@ -1128,6 +1417,8 @@ static int _yield_locks(int64_t usec)
 		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
 	}
 	lock_slurmctld(all_locks);
+	/* Anything may have changed while the locks were released */
+	_plan_flush();
 	slurm_mutex_lock(&config_lock);
 	if (config_flag)
 		load_config = true;
@@ -1363,9 +1654,7 @@ static int _foreach_het_job_details(void *x, void *arg)
 static int _bf_reserve_running(void *x, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *) x;
-	node_space_handler_t *ns_h = (node_space_handler_t *) arg;
-	node_space_map_t *node_space = ns_h->node_space;
-	int *ns_recs_ptr = ns_h->node_space_recs;
+	node_space_map_t *node_space = (node_space_map_t *) arg;
 	time_t start_time = job_ptr->start_time;
 	time_t end_time = job_ptr->end_time;
 
@@ -1377,7 +1666,7 @@ static int _bf_reserve_running(void *x, void *arg)
 	if (slurm_job_preempt_mode(job_ptr) != PREEMPT_MODE_OFF)
 		return SLURM_SUCCESS;
 
-	if (*ns_recs_ptr >= bf_node_space_size)
+	if (node_space->rec_cnt >= bf_node_space_size)
 		return SLURM_ERROR;
 
 	bitstr_t *tmp_bitmap = bit_copy(job_ptr->node_bitmap);
@@ -1385,8 +1674,7 @@ static int _bf_reserve_running(void *x, void *arg)
 	bit_not(tmp_bitmap);
 	end_time = (end_time / backfill_resolution) * backfill_resolution;
 
-	_add_reservation(start_time, end_time, tmp_bitmap, node_space,
-			 ns_recs_ptr);
+	node_space_add_resv(node_space, start_time, end_time, tmp_bitmap);
 
 	FREE_NULL_BITMAP(tmp_bitmap);
 
@@ -1634,7 +1922,7 @@ static int _attempt_backfill(void)
 	DEF_TIMERS;
 	List job_queue;
 	job_queue_rec_t *job_queue_rec;
-	int bb, i, j, node_space_recs, mcs_select = 0;
+	int bb, j, mcs_select = 0;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
@@ -1647,6 +1935,7 @@ static int _attempt_backfill(void)
 	time_t now, sched_start, later_start, start_res, resv_end, window_end;
 	time_t het_job_time, orig_sched_start, orig_start_time = (time_t) 0;
 	node_space_map_t *node_space;
+	node_space_rec_t *ns, *fit;
 	struct timeval bf_time1, bf_time2;
 	int rc = 0, error_code;
 	int job_test_count = 0, test_time_count = 0, pend_time;
@@ -1721,27 +2010,15 @@ static int _attempt_backfill(void)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_when_last_cycle = now;
 
-	node_space = xmalloc(sizeof(node_space_map_t) *
-			     (bf_node_space_size + 1));
-	node_space[0].begin_time = sched_start;
 	window_end = sched_start + backfill_window;
-	node_space[0].end_time = window_end;
-
-	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
+	tmp_bitmap = bit_copy(avail_node_bitmap);
 	/* Make "resuming" nodes available to be scheduled in backfill */
-	bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
-
-	node_space[0].next = 0;
-	node_space_recs = 1;
+	bit_or(tmp_bitmap, rs_node_bitmap);
+	node_space = node_space_create(sched_start, window_end, tmp_bitmap);
+	tmp_bitmap = NULL;
 
-	if (bf_running_job_reserve) {
-		node_space_handler_t node_space_handler;
-		node_space_handler.node_space = node_space;
-		node_space_handler.node_space_recs = &node_space_recs;
-
-		list_for_each(job_list, _bf_reserve_running,
-			      &node_space_handler);
-	}
+	if (bf_running_job_reserve)
+		list_for_each(job_list, _bf_reserve_running, node_space);
 
 	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 		_dump_node_space_table(node_space);
@@ -1758,6 +2035,14 @@ static int _attempt_backfill(void)
 	/* Ignore nodes that have been set as available during this cycle. */
 	bit_clear_all(bf_ignore_node_bitmap);
 
+	/*
+	 * Jobs ahead are only tested in parallel when this can not have side
+	 * effects on other jobs, which preemption would
+	 */
+	if ((bf_parallel_threads > 1) && !slurm_preemption_enabled())
+		plan_list = list_create(bf_plan_free);
+	plan_test_cnt = plan_used_cnt = 0;
+
 	while (1) {
 		uint32_t bf_job_priority, prio_reserve;
 		bool get_boot_time = false;
@@ -1894,11 +2179,13 @@ static int _attempt_backfill(void)
 				assoc_mgr_unlock(&locks);
 				job_fail_qos(job_ptr, __func__);
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -2210,6 +2497,23 @@ next_task:
 		start_res = MAX(later_start, het_job_time);
 		resv_end = 0;
 		later_start = 0;
+		/*
+		 * Skip ahead to the first time enough nodes are free at all,
+		 * rather than testing each earlier record in turn
+		 */
+		if (min_nodes && !job_no_reserve) {
+			fit = node_space_first_fit(node_space, start_res,
+						   min_nodes);
+			if (!fit) {
+				/* Job can not start within the window */
+				_set_job_time_limit(job_ptr, orig_time_limit);
+				job_ptr->start_time = orig_start_time;
+				continue;
+			}
+			if ((fit != node_space->head) &&
+			    (fit->begin_time > start_res))
+				start_res = fit->begin_time;
+		}
 		/* Determine impact of any advance reservations */
 		j = job_test_resv(job_ptr, &start_res, true, &avail_bitmap,
 				  &exc_core_bitmap, &resv_overlap, false);
@@ -2235,17 +2539,15 @@ next_task:
 		filter_by_node_owner(job_ptr, avail_bitmap);
 		filter_by_node_mcs(job_ptr, mcs_select, avail_bitmap);
 		tmp_bitmap = bit_copy(avail_bitmap);
-		for (j = 0; ; ) {
-			if ((node_space[j].end_time > start_res) &&
-			     node_space[j].next && (later_start == 0)) {
-				int tmp = node_space[j].next;
+		for (ns = node_space_find(node_space, start_res); ns;
+		     ns = ns->next) {
+			if ((ns->end_time > start_res) &&
+			     ns->next && (later_start == 0)) {
 				bitstr_t *next_bitmap = bit_copy(tmp_bitmap);
 				bitstr_t *current_bitmap =
 					bit_copy(avail_bitmap);
-				bit_and(next_bitmap,
-					node_space[tmp].avail_bitmap);
-				bit_and(current_bitmap,
-					node_space[j].avail_bitmap);
+				bit_and(next_bitmap, ns->next->avail_bitmap);
+				bit_and(current_bitmap, ns->avail_bitmap);
 				/*
 				 * Normally later_start is set at the end of the
 				 * first backfill reservation when the select
@@ -2258,18 +2560,15 @@ next_task:
 				 * be useless and would impact performance.
 				 */
 				if (!bit_super_set(next_bitmap, current_bitmap))
-					later_start = node_space[j].end_time;
+					later_start = ns->end_time;
 				FREE_NULL_BITMAP(next_bitmap);
 				FREE_NULL_BITMAP(current_bitmap);
 			}
-			if (node_space[j].end_time <= start_res)
+			if (ns->end_time <= start_res)
 				;
-			else if (node_space[j].begin_time <= end_time) {
-				bit_and(avail_bitmap,
-					node_space[j].avail_bitmap);
-			} else
-				break;
-			if ((j = node_space[j].next) == 0)
+			else if (ns->begin_time <= end_time)
+				bit_and(avail_bitmap, ns->avail_bitmap);
+			else
 				break;
 		}
 		FREE_NULL_BITMAP(tmp_bitmap);
@@ -2383,21 +2682,24 @@ next_task:
 			orig_end_time = end_time;
 			end_time += boot_time;
 
-			for (j = 0; ; ) {
-				if (node_space[j].end_time <= start_res)
+			for (ns = node_space_find(node_space, start_res); ns;
+			     ns = ns->next) {
+				if (ns->end_time <= start_res)
 					;
-				else if (node_space[j].begin_time <= end_time) {
-					if (node_space[j].begin_time >
-					    orig_end_time)
+				else if (ns->begin_time <= end_time) {
+					if (ns->begin_time > orig_end_time)
 						bit_and(avail_bitmap,
-						node_space[j].avail_bitmap);
+							ns->avail_bitmap);
 				} else
 					break;
-				if ((j = node_space[j].next) == 0)
-					break;
 			}
 		}
-		if (test_fini != 1) {
+		if ((test_fini == -1) && plan_list) {
+			j = _try_sched_planned(job_ptr, part_ptr, &avail_bitmap,
+					       min_nodes, max_nodes, req_nodes,
+					       exc_core_bitmap, job_no_reserve,
+					       job_queue, node_space);
+		} else if (test_fini != 1) {
 			/* Either active_bitmap was NULL or not usable by the
 			 * job. Test using avail_bitmap instead */
 			j = _try_sched(job_ptr, &avail_bitmap, min_nodes,
@@ -2425,6 +2727,7 @@ next_task:
 		if (start_res > job_ptr->start_time) {
 			job_ptr->start_time = start_res;
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 		}
 		/*
 		 * avail_bitmap at this point contains a bitmap of nodes
@@ -2458,6 +2761,7 @@ next_task:
 				     job_reason_string(job_ptr->state_reason),
 				     job_ptr->priority);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			_set_job_time_limit(job_ptr, orig_time_limit);
 			later_start = 0;
 			if (bb == -1)
@@ -2798,7 +3102,7 @@ skip_start:
 		bit_not(avail_bitmap);
 		if ((!bf_one_resv_per_job || !orig_start_time) &&
 		    !(job_ptr->bit_flags & JOB_MAGNETIC)) {
-			if (node_space_recs >= bf_node_space_size) {
+			if (node_space->rec_cnt >= bf_node_space_size) {
 				log_flag(BACKFILL, "table size limit of %u reached",
 					 bf_node_space_size);
 				if ((max_backfill_job_per_part != 0) &&
@@ -2823,8 +3127,8 @@ skip_start:
 				_set_job_time_limit(job_ptr, orig_time_limit);
 				break;
 			}
-			_add_reservation(start_time, end_reserve, avail_bitmap,
-					 node_space, &node_space_recs);
+			node_space_add_resv(node_space, start_time,
+					    end_reserve, avail_bitmap);
 		}
 		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 			_dump_node_space_table(node_space);
@@ -2877,16 +3181,16 @@ skip_start:
 	FREE_NULL_BITMAP(exc_core_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
 
-	for (i = 0; ; ) {
-		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
-		if ((i = node_space[i].next) == 0)
-			break;
-	}
-	xfree(node_space);
+	gettimeofday(&bf_time2, NULL);
+	_do_diag_stats(&bf_time1, &bf_time2, node_space->rec_cnt);
+	node_space_destroy(node_space);
 	FREE_NULL_LIST(job_queue);
+	if (plan_list) {
+		log_flag(BACKFILL, "bf_parallel_threads: %u tests run, %u results of jobs tested ahead used",
+			 plan_test_cnt, plan_used_cnt);
+		FREE_NULL_LIST(plan_list);
+	}
 
-	gettimeofday(&bf_time2, NULL);
-	_do_diag_stats(&bf_time1, &bf_time2, node_space_recs);
 	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL) {
 		END_TIMER;
 		info("completed testing %u(%d) jobs, %s",
@@ -2913,6 +3217,9 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 	bool is_job_array_head = false;
 	static uint32_t fail_jobid = 0;
 
+	/* Results for jobs ahead assumed this job was not running */
+	_plan_flush();
+
 	if (job_ptr->details->exc_node_bitmap) {
 		orig_exc_nodes = bit_copy(job_ptr->details->exc_node_bitmap);
 		bit_or(job_ptr->details->exc_node_bitmap, resv_bitmap);
@@ -2942,6 +3249,7 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 	if (rc == SLURM_SUCCESS) {
 		/* job initiated */
 		last_job_update = time(NULL);
+		job_delta_stamp(job_ptr);
 		info("Started %pJ in %s on %s",
 		     job_ptr, job_ptr->part_ptr->name, job_ptr->nodes);
 		power_g_job_start(job_ptr);
@@ -2983,25 +3291,23 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 static uint32_t _get_job_max_tl(job_record_t *job_ptr, time_t now,
 				node_space_map_t *node_space)
 {
-	int32_t j;
+	node_space_rec_t *ns;
 	time_t comp_time = 0;
 	uint32_t max_tl = NO_VAL;
 
 	if (job_ptr->time_min == 0)
 		return max_tl;
 
-	for (j = 0; ; ) {
-		if ((node_space[j].begin_time != now) && // No current conflicts
-		    (node_space[j].begin_time < job_ptr->end_time) &&
-		    (!bit_super_set(job_ptr->node_bitmap,
-				    node_space[j].avail_bitmap))) {
+	/* Records are in time order, so the first conflict is the earliest */
+	for (ns = node_space->head; ns; ns = ns->next) {
+		if (ns->begin_time >= job_ptr->end_time)
+			break;
+		if ((ns->begin_time != now) && // No current conflicts
+		    (!bit_super_set(job_ptr->node_bitmap, ns->avail_bitmap))) {
 			/* Job overlaps pending job's resource reservation */
-			if ((comp_time == 0) ||
-			    (comp_time > node_space[j].begin_time))
-				comp_time = node_space[j].begin_time;
-		}
-		if ((j = node_space[j].next) == 0)
+			comp_time = ns->begin_time;
 			break;
+		}
 	}
 
 	if (comp_time != 0)
@@ -3019,23 +3325,22 @@ static uint32_t _get_job_max_tl(job_record_t *job_ptr, time_t now,
 static void _reset_job_time_limit(job_record_t *job_ptr, time_t now,
 				  node_space_map_t *node_space)
 {
-	int32_t j, resv_delay;
+	node_space_rec_t *ns;
+	int32_t resv_delay;
 	uint32_t orig_time_limit = job_ptr->time_limit;
 	uint32_t new_time_limit;
 
-	for (j = 0; ; ) {
-		if ((node_space[j].begin_time != now) && // No current conflicts
-		    (node_space[j].begin_time < job_ptr->end_time) &&
-		    (!bit_super_set(job_ptr->node_bitmap,
-				    node_space[j].avail_bitmap))) {
+	for (ns = node_space->head; ns; ns = ns->next) {
+		if (ns->begin_time >= job_ptr->end_time)
+			break;
+		if ((ns->begin_time != now) && // No current conflicts
+		    (!bit_super_set(job_ptr->node_bitmap, ns->avail_bitmap))) {
 			/* Job overlaps pending job's resource reservation */
-			resv_delay = difftime(node_space[j].begin_time, now);
+			resv_delay = difftime(ns->begin_time, now);
 			resv_delay /= 60;	/* seconds to minutes */
 			if (resv_delay < job_ptr->time_limit)
 				job_ptr->time_limit = resv_delay;
 		}
-		if ((j = node_space[j].next) == 0)
-			break;
 	}
 	new_time_limit = MAX(job_ptr->time_min, job_ptr->time_limit);
 	acct_policy_alter_job(job_ptr, new_time_limit);
@@ -3066,98 +3371,6 @@ static bool _more_work (time_t last_backfill_time)
 	return rc;
 }
 
-/* Create a reservation for a job in the future */
-static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
-			     bitstr_t *res_bitmap,
-			     node_space_map_t *node_space,
-			     int *node_space_recs)
-{
-	bool placed = false;
-	int i, j;
-
-#if 0
-	info("add job start:%u end:%u", start_time, end_reserve);
-	for (j = 0; ; ) {
-		info("node start:%u end:%u",
-		     (uint32_t) node_space[j].begin_time,
-		     (uint32_t) node_space[j].end_time);
-		if ((j = node_space[j].next) == 0)
-			break;
-	}
-#endif
-
-	start_time = MAX(start_time, node_space[0].begin_time);
-	for (j = 0; ; ) {
-		if (node_space[j].end_time > start_time) {
-			/* insert start entry record */
-			i = *node_space_recs;
-			node_space[i].begin_time = start_time;
-			node_space[i].end_time = node_space[j].end_time;
-			node_space[j].end_time = start_time;
-			node_space[i].avail_bitmap =
-				bit_copy(node_space[j].avail_bitmap);
-			node_space[i].next = node_space[j].next;
-			node_space[j].next = i;
-			(*node_space_recs)++;
-			placed = true;
-		}
-		if (node_space[j].end_time == start_time) {
-			/* no need to insert new start entry record */
-			placed = true;
-		}
-		if (placed == true) {
-			while ((j = node_space[j].next)) {
-				if (end_reserve < node_space[j].end_time) {
-					/* insert end entry record */
-					i = *node_space_recs;
-					node_space[i].begin_time = end_reserve;
-					node_space[i].end_time = node_space[j].
-								 end_time;
-					node_space[j].end_time = end_reserve;
-					node_space[i].avail_bitmap =
-						bit_copy(node_space[j].
-							 avail_bitmap);
-					node_space[i].next = node_space[j].next;
-					node_space[j].next = i;
-					(*node_space_recs)++;
-					break;
-				}
-				if (end_reserve == node_space[j].end_time) {
-					break;
-				}
-			}
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
-			break;
-	}
-
-	for (j = 0; ; ) {
-		if ((node_space[j].begin_time >= start_time) &&
-		    (node_space[j].end_time <= end_reserve))
-			bit_and(node_space[j].avail_bitmap, res_bitmap);
-		if ((node_space[j].begin_time >= end_reserve) ||
-		    ((j = node_space[j].next) == 0))
-			break;
-	}
-
-	/* Drop records with identical bitmaps (up to one record).
-	 * This can significantly improve performance of the backfill tests. */
-	for (i = 0; ; ) {
-		if ((j = node_space[i].next) == 0)
-			break;
-		if (!bit_equal(node_space[i].avail_bitmap,
-			       node_space[j].avail_bitmap)) {
-			i = j;
-			continue;
-		}
-		node_space[i].end_time = node_space[j].end_time;
-		node_space[i].next = node_space[j].next;
-		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
-		break;
-	}
-}
-
 /*
  * Determine if the resource specification for a new job overlaps with a
  *	reservation that the backfill scheduler has made for a job to be
@@ -3170,20 +3383,14 @@ static bool _test_resv_overlap(node_space_map_t *node_space,
 			       bitstr_t *use_bitmap, uint32_t start_time,
 			       uint32_t end_reserve)
 {
-	bool overlap = false;
-	int j;
+	node_space_rec_t *ns;
 
-	for (j=0; ; ) {
-		if ((node_space[j].end_time   > start_time) &&
-		    (node_space[j].begin_time < end_reserve) &&
-		    (!bit_super_set(use_bitmap, node_space[j].avail_bitmap))) {
-			overlap = true;
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
-			break;
+	for (ns = node_space_find(node_space, start_time);
+	     ns && (ns->begin_time < end_reserve); ns = ns->next) {
+		if (!bit_super_set(use_bitmap, ns->avail_bitmap))
+			return true;
 	}
-	return overlap;
+	return false;
 }
 
 /*
@@ -3638,6 +3845,7 @@ static void _het_job_kill_now(het_job_map_t *map)
 		job_ptr->end_time   = now;
 		job_ptr->job_state  = JOB_PENDING | JOB_COMPLETING;
 		last_job_update     = now;
+		job_delta_stamp(job_ptr);
 		build_cg_bitmap(job_ptr);
 		job_completion_logger(job_ptr, false);
 		deallocate_nodes(job_ptr, false, false, false);
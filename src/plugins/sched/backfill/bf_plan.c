@@ -0,0 +1,228 @@
+/*****************************************************************************\
+ * bf_plan.c - parallel evaluation of backfill job tests
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "config.h"
+
+#include <pthread.h>
+
+#include "src/common/macros.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+
+#include "src/plugins/sched/backfill/bf_plan.h"
+
+/*
+ * The backfill thread hands a batch of plans to the pool and works through
+ * it alongside the helpers, then waits for the helpers' last plans. Helpers
+ * sleep between batches. Only one batch is ever in progress.
+ */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *pool_threads = NULL;
+static int pool_thread_cnt = 0;
+static bool pool_shutdown = false;
+static slurmctld_lock_t pool_locks;
+
+static bf_plan_t **work_plans = NULL;
+static int work_cnt = 0;
+static int work_next = 0;
+static int work_busy = 0;
+static bf_plan_eval_f work_eval = NULL;
+
+static void *_pool_helper(void *arg)
+{
+	bf_plan_t *plan;
+
+	slurm_mutex_lock(&pool_mutex);
+	while (!pool_shutdown) {
+		if (work_next >= work_cnt) {
+			slurm_cond_wait(&pool_work_cond, &pool_mutex);
+			continue;
+		}
+		plan = work_plans[work_next++];
+		work_busy++;
+		slurm_mutex_unlock(&pool_mutex);
+
+		borrow_slurmctld_locks(pool_locks);
+		work_eval(plan);
+		return_slurmctld_locks(pool_locks);
+
+		slurm_mutex_lock(&pool_mutex);
+		if (!--work_busy && (work_next >= work_cnt))
+			slurm_cond_signal(&pool_done_cond);
+	}
+	slurm_mutex_unlock(&pool_mutex);
+
+	return NULL;
+}
+
+extern void bf_plan_pool_init(int thread_cnt, slurmctld_lock_t locks)
+{
+	int i;
+
+	if (thread_cnt <= 1)
+		thread_cnt = 0;
+	else
+		thread_cnt--;	/* The backfill thread is one of them */
+	if (thread_cnt == pool_thread_cnt)
+		return;
+
+	bf_plan_pool_fini();
+	if (!thread_cnt)
+		return;
+
+	pool_locks = locks;
+	pool_shutdown = false;
+	pool_thread_cnt = thread_cnt;
+	pool_threads = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 0; i < thread_cnt; i++)
+		slurm_thread_create(&pool_threads[i], _pool_helper, NULL);
+	debug("%s: started %d helper threads", __func__, thread_cnt);
+}
+
+extern void bf_plan_pool_fini(void)
+{
+	int i;
+
+	if (!pool_thread_cnt)
+		return;
+
+	slurm_mutex_lock(&pool_mutex);
+	pool_shutdown = true;
+	slurm_cond_broadcast(&pool_work_cond);
+	slurm_mutex_unlock(&pool_mutex);
+
+	for (i = 0; i < pool_thread_cnt; i++)
+		pthread_join(pool_threads[i], NULL);
+	xfree(pool_threads);
+	pool_thread_cnt = 0;
+}
+
+extern void bf_plan_pool_run(bf_plan_t **plans, int plan_cnt,
+			     bf_plan_eval_f eval)
+{
+	bf_plan_t *plan;
+
+	if (!pool_thread_cnt || (plan_cnt == 1)) {
+		for (int i = 0; i < plan_cnt; i++)
+			eval(plans[i]);
+		return;
+	}
+
+	slurm_mutex_lock(&pool_mutex);
+	work_plans = plans;
+	work_cnt = plan_cnt;
+	work_next = 0;
+	work_eval = eval;
+	slurm_cond_broadcast(&pool_work_cond);
+
+	while (work_next < work_cnt) {
+		plan = work_plans[work_next++];
+		slurm_mutex_unlock(&pool_mutex);
+		eval(plan);
+		slurm_mutex_lock(&pool_mutex);
+	}
+	while (work_busy)
+		slurm_cond_wait(&pool_done_cond, &pool_mutex);
+
+	work_plans = NULL;
+	work_cnt = work_next = 0;
+	work_eval = NULL;
+	slurm_mutex_unlock(&pool_mutex);
+}
+
+extern bf_plan_t *bf_plan_create(job_record_t *job_ptr,
+				 part_record_t *part_ptr, uint32_t min_nodes,
+				 uint32_t max_nodes, uint32_t req_nodes,
+				 uint32_t test_flags, bitstr_t *avail_bitmap,
+				 bitstr_t *exc_core_bitmap)
+{
+	bf_plan_t *plan = xmalloc(sizeof(*plan));
+
+	plan->job_ptr = job_ptr;
+	plan->part_ptr = part_ptr;
+	plan->min_nodes = min_nodes;
+	plan->max_nodes = max_nodes;
+	plan->req_nodes = req_nodes;
+	plan->time_limit = job_ptr->time_limit;
+	plan->test_flags = test_flags;
+	if (job_ptr->details) {
+		plan->share_res = job_ptr->details->share_res;
+		plan->whole_node = job_ptr->details->whole_node;
+	}
+	plan->avail_bitmap = bit_copy(avail_bitmap);
+	if (exc_core_bitmap)
+		plan->exc_core_bitmap = bit_copy(exc_core_bitmap);
+	plan->rc = SLURM_ERROR;
+
+	return plan;
+}
+
+extern void bf_plan_free(void *x)
+{
+	bf_plan_t *plan = x;
+
+	if (!plan)
+		return;
+
+	FREE_NULL_BITMAP(plan->avail_bitmap);
+	FREE_NULL_BITMAP(plan->exc_core_bitmap);
+	FREE_NULL_BITMAP(plan->sel_bitmap);
+	xfree(plan);
+}
+
+extern bool bf_plan_match(bf_plan_t *plan1, bf_plan_t *plan2)
+{
+	if ((plan1->job_ptr != plan2->job_ptr) ||
+	    (plan1->part_ptr != plan2->part_ptr) ||
+	    (plan1->min_nodes != plan2->min_nodes) ||
+	    (plan1->max_nodes != plan2->max_nodes) ||
+	    (plan1->req_nodes != plan2->req_nodes) ||
+	    (plan1->time_limit != plan2->time_limit) ||
+	    (plan1->test_flags != plan2->test_flags) ||
+	    (plan1->share_res != plan2->share_res) ||
+	    (plan1->whole_node != plan2->whole_node))
+		return false;
+
+	if (!bit_equal(plan1->avail_bitmap, plan2->avail_bitmap))
+		return false;
+
+	if (!plan1->exc_core_bitmap || !plan2->exc_core_bitmap)
+		return (plan1->exc_core_bitmap == plan2->exc_core_bitmap);
+
+	return (bit_equal(plan1->exc_core_bitmap, plan2->exc_core_bitmap) == 1);
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************\
+ * bf_plan.h - parallel evaluation of backfill job tests
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+
+#ifndef _BACKFILL_BF_PLAN_H
+#define _BACKFILL_BF_PLAN_H
+
+#include "src/common/bitstring.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/slurmctld.h"
+
+/*
+ * One will-run test of a job against a fixed set of nodes. The inputs are
+ * filled in by bf_plan_create(), the results by the evaluation function.
+ * A result may only be used for a later test of the job if bf_plan_match()
+ * finds that test's inputs identical and the select plugin's state has not
+ * changed in between.
+ */
+typedef struct {
+	/* Inputs */
+	job_record_t *job_ptr;
+	part_record_t *part_ptr;
+	uint32_t min_nodes;
+	uint32_t max_nodes;
+	uint32_t req_nodes;
+	uint32_t time_limit;
+	uint32_t test_flags;		/* TEST_NOW_ONLY or 0 */
+	uint16_t share_res;
+	uint16_t whole_node;
+	bitstr_t *avail_bitmap;		/* nodes the job may use */
+	bitstr_t *exc_core_bitmap;	/* cores the job may not use */
+
+	/* Results */
+	int rc;
+	time_t start_time;
+	bitstr_t *sel_bitmap;		/* nodes selected, NULL on failure */
+	uint32_t total_cpus;
+	bool best_switch;
+	uint64_t pn_min_memory;
+} bf_plan_t;
+
+typedef void (*bf_plan_eval_f)(bf_plan_t *plan);
+
+/*
+ * Start or resize the pool of threads helping the backfill thread evaluate
+ * plans. thread_cnt counts the backfill thread itself, so a value of 1 or
+ * less stops all helpers.
+ * IN locks - slurmctld locks held by the backfill thread while plans are
+ *	evaluated, helpers run under these on its behalf
+ */
+extern void bf_plan_pool_init(int thread_cnt, slurmctld_lock_t locks);
+
+extern void bf_plan_pool_fini(void);
+
+/*
+ * Evaluate plans concurrently on the backfill thread and the pool's helpers,
+ * returning once all are done. Each plan must be for a different job.
+ */
+extern void bf_plan_pool_run(bf_plan_t **plans, int plan_cnt,
+			     bf_plan_eval_f eval);
+
+/*
+ * Copy a job's test inputs into a new plan. avail_bitmap and exc_core_bitmap
+ * are copied, the caller keeps its own.
+ */
+extern bf_plan_t *bf_plan_create(job_record_t *job_ptr,
+				 part_record_t *part_ptr, uint32_t min_nodes,
+				 uint32_t max_nodes, uint32_t req_nodes,
+				 uint32_t test_flags, bitstr_t *avail_bitmap,
+				 bitstr_t *exc_core_bitmap);
+
+/* Free a plan, usable as a ListDelF */
+extern void bf_plan_free(void *x);
+
+/* Return true if two plans test the same job with identical inputs */
+extern bool bf_plan_match(bf_plan_t *plan1, bf_plan_t *plan2);
+
+#endif
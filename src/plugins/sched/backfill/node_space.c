@@ -0,0 +1,341 @@
+/*****************************************************************************\
+ * node_space.c - time indexed map of resources available to backfill
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "config.h"
+
+#include "src/common/macros.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+
+#include "src/plugins/sched/backfill/node_space.h"
+
+/*
+ * Records are kept both in a list by time, for walking a range, and in a
+ * treap keyed on begin_time, for lookup by time. Each tree node also holds
+ * the largest avail_cnt in its subtree so node_space_first_fit() can skip
+ * over subtrees with too few nodes. Splitting a record shares its bitmap
+ * with the new record; a bitmap is only copied when a reservation changes
+ * one of the records sharing it.
+ */
+
+/* xorshift32, only needs to spread the treap priorities */
+static uint32_t _next_priority(node_space_map_t *map)
+{
+	uint32_t x = map->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return (map->seed = x);
+}
+
+static void _update(node_space_rec_t *rec)
+{
+	rec->max_avail_cnt = rec->avail_cnt;
+	if (rec->left && (rec->left->max_avail_cnt > rec->max_avail_cnt))
+		rec->max_avail_cnt = rec->left->max_avail_cnt;
+	if (rec->right && (rec->right->max_avail_cnt > rec->max_avail_cnt))
+		rec->max_avail_cnt = rec->right->max_avail_cnt;
+}
+
+/* Rebuild max_avail_cnt for a whole subtree, children first */
+static void _update_all(node_space_rec_t *t)
+{
+	if (!t)
+		return;
+
+	_update_all(t->left);
+	_update_all(t->right);
+	_update(t);
+}
+
+/* Split tree t into records beginning before key (l) and the rest (r) */
+static void _split(node_space_rec_t *t, time_t key, node_space_rec_t **l,
+		   node_space_rec_t **r)
+{
+	if (!t) {
+		*l = *r = NULL;
+		return;
+	}
+
+	if (t->begin_time < key) {
+		_split(t->right, key, &t->right, r);
+		*l = t;
+	} else {
+		_split(t->left, key, l, &t->left);
+		*r = t;
+	}
+	_update(t);
+}
+
+/* Join trees l and r, where every record in l begins before those in r */
+static node_space_rec_t *_merge(node_space_rec_t *l, node_space_rec_t *r)
+{
+	if (!l)
+		return r;
+	if (!r)
+		return l;
+
+	if (l->priority > r->priority) {
+		l->right = _merge(l->right, r);
+		_update(l);
+		return l;
+	}
+
+	r->left = _merge(l, r->left);
+	_update(r);
+	return r;
+}
+
+static void _tree_insert(node_space_map_t *map, node_space_rec_t *rec)
+{
+	node_space_rec_t *l, *r;
+
+	_split(map->root, rec->begin_time, &l, &r);
+	map->root = _merge(_merge(l, rec), r);
+}
+
+static void _tree_remove(node_space_map_t *map, node_space_rec_t *rec)
+{
+	node_space_rec_t *l, *m, *r;
+
+	_split(map->root, rec->begin_time, &l, &m);
+	_split(m, rec->begin_time + 1, &m, &r);
+	xassert(m == rec);
+	map->root = _merge(l, r);
+}
+
+static node_space_rec_t *_rec_alloc(node_space_map_t *map, time_t begin_time,
+				    time_t end_time)
+{
+	node_space_rec_t *rec = xmalloc(sizeof(*rec));
+
+	rec->begin_time = begin_time;
+	rec->end_time = end_time;
+	rec->priority = _next_priority(map);
+	map->rec_cnt++;
+
+	return rec;
+}
+
+static void _rec_free(node_space_map_t *map, node_space_rec_t *rec)
+{
+	if (!--(*rec->bitmap_refs)) {
+		FREE_NULL_BITMAP(rec->avail_bitmap);
+		xfree(rec->bitmap_refs);
+	}
+	map->rec_cnt--;
+	xfree(rec);
+}
+
+/*
+ * Split rec at when and return the new record beginning there, which shares
+ * rec's bitmap.
+ */
+static node_space_rec_t *_rec_split(node_space_map_t *map,
+				    node_space_rec_t *rec, time_t when)
+{
+	node_space_rec_t *new = _rec_alloc(map, when, rec->end_time);
+
+	new->avail_bitmap = rec->avail_bitmap;
+	new->avail_cnt = rec->avail_cnt;
+	new->bitmap_refs = rec->bitmap_refs;
+	(*new->bitmap_refs)++;
+	rec->end_time = when;
+
+	new->prev = rec;
+	new->next = rec->next;
+	if (rec->next)
+		rec->next->prev = new;
+	rec->next = new;
+
+	_update(new);
+	_tree_insert(map, new);
+
+	return new;
+}
+
+/* Merge rec->next into rec */
+static void _rec_merge_next(node_space_map_t *map, node_space_rec_t *rec)
+{
+	node_space_rec_t *next = rec->next;
+
+	rec->end_time = next->end_time;
+	rec->next = next->next;
+	if (rec->next)
+		rec->next->prev = rec;
+
+	_tree_remove(map, next);
+	_rec_free(map, next);
+}
+
+static bool _rec_same(node_space_rec_t *rec1, node_space_rec_t *rec2)
+{
+	if (rec1->avail_bitmap == rec2->avail_bitmap)
+		return true;
+	if (rec1->avail_cnt != rec2->avail_cnt)
+		return false;
+	return bit_equal(rec1->avail_bitmap, rec2->avail_bitmap);
+}
+
+/* rec's nodes &= res_bitmap, copying the bitmap first if it is shared */
+static void _rec_and(node_space_rec_t *rec, bitstr_t *res_bitmap)
+{
+	if (bit_super_set(rec->avail_bitmap, res_bitmap))
+		return;		/* no change */
+
+	if (*rec->bitmap_refs > 1) {
+		(*rec->bitmap_refs)--;
+		rec->avail_bitmap = bit_copy(rec->avail_bitmap);
+		rec->bitmap_refs = xmalloc(sizeof(*rec->bitmap_refs));
+		*rec->bitmap_refs = 1;
+	}
+	rec->avail_cnt = bit_and_count(rec->avail_bitmap, res_bitmap);
+}
+
+static node_space_rec_t *_first_fit(node_space_rec_t *t, time_t when,
+				    int node_cnt)
+{
+	node_space_rec_t *rec;
+
+	if (!t || (t->max_avail_cnt < node_cnt))
+		return NULL;
+
+	/* Records in the left subtree end no later than this one begins */
+	if (t->end_time > when) {
+		if ((rec = _first_fit(t->left, when, node_cnt)))
+			return rec;
+		if (t->avail_cnt >= node_cnt)
+			return t;
+	}
+
+	return _first_fit(t->right, when, node_cnt);
+}
+
+extern node_space_map_t *node_space_create(time_t begin_time, time_t end_time,
+					   bitstr_t *avail_bitmap)
+{
+	node_space_map_t *map = xmalloc(sizeof(*map));
+	node_space_rec_t *rec;
+
+	map->seed = 0x9e3779b9;
+	rec = _rec_alloc(map, begin_time, end_time);
+	rec->avail_bitmap = avail_bitmap;
+	rec->avail_cnt = bit_set_count(avail_bitmap);
+	rec->bitmap_refs = xmalloc(sizeof(*rec->bitmap_refs));
+	*rec->bitmap_refs = 1;
+	_update(rec);
+	map->head = map->root = rec;
+
+	return map;
+}
+
+extern void node_space_destroy(node_space_map_t *map)
+{
+	node_space_rec_t *rec, *next;
+
+	if (!map)
+		return;
+
+	for (rec = map->head; rec; rec = next) {
+		next = rec->next;
+		_rec_free(map, rec);
+	}
+	xfree(map);
+}
+
+extern void node_space_add_resv(node_space_map_t *map, time_t start_time,
+				time_t end_time, bitstr_t *res_bitmap)
+{
+	node_space_rec_t *first, *rec, *l, *m, *r;
+
+	start_time = MAX(start_time, map->head->begin_time);
+	if ((start_time >= end_time) ||
+	    !(first = node_space_find(map, start_time)))
+		return;
+
+	if (first->begin_time < start_time)
+		first = _rec_split(map, first, start_time);
+	if ((rec = node_space_find(map, end_time)) &&
+	    (rec->begin_time < end_time))
+		(void) _rec_split(map, rec, end_time);
+
+	/* Detach the changed records so their subtree maxima can be rebuilt */
+	_split(map->root, start_time, &l, &m);
+	_split(m, end_time, &m, &r);
+	for (rec = first; rec && (rec->begin_time < end_time); rec = rec->next)
+		_rec_and(rec, res_bitmap);
+	_update_all(m);
+	map->root = _merge(_merge(l, m), r);
+
+	/*
+	 * Merge neighbors left with identical bitmaps, including those at
+	 * either end of the reservation. Fewer records speed up later scans.
+	 */
+	rec = first->prev ? first->prev : first;
+	while (rec->next && (rec->begin_time < end_time)) {
+		if (_rec_same(rec, rec->next))
+			_rec_merge_next(map, rec);
+		else
+			rec = rec->next;
+	}
+}
+
+extern node_space_rec_t *node_space_find(node_space_map_t *map, time_t when)
+{
+	node_space_rec_t *t = map->root, *found = NULL;
+
+	while (t) {
+		if (t->begin_time <= when) {
+			found = t;
+			t = t->right;
+		} else
+			t = t->left;
+	}
+
+	if (!found)
+		return map->head;
+	if (found->end_time > when)
+		return found;
+	return NULL;	/* records have no gaps, so this is past the end */
+}
+
+extern node_space_rec_t *node_space_first_fit(node_space_map_t *map,
+					      time_t when, int node_cnt)
+{
+	return _first_fit(map->root, when, node_cnt);
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************\
+ * node_space.h - time indexed map of resources available to backfill
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _BACKFILL_NODE_SPACE_H
+#define _BACKFILL_NODE_SPACE_H
+
+#include <time.h>
+
+#include "src/common/bitstring.h"
+
+/*
+ * One interval of the map. Records cover the map's time window without gaps
+ * or overlap. avail_bitmap may be shared with neighboring records and must
+ * not be modified directly, use node_space_add_resv().
+ */
+typedef struct node_space_rec node_space_rec_t;
+struct node_space_rec {
+	time_t begin_time;
+	time_t end_time;
+	bitstr_t *avail_bitmap;	/* nodes available, read only */
+	int avail_cnt;		/* bits set in avail_bitmap */
+	node_space_rec_t *next;	/* next record by time, NULL terminated */
+
+	/* Private to node_space.c */
+	node_space_rec_t *prev;
+	node_space_rec_t *left;		/* tree ordered by begin_time */
+	node_space_rec_t *right;
+	uint32_t priority;		/* treap heap order */
+	int max_avail_cnt;		/* largest avail_cnt in this subtree */
+	int *bitmap_refs;		/* records sharing avail_bitmap */
+};
+
+typedef struct {
+	node_space_rec_t *head;	/* first record by time */
+	node_space_rec_t *root;	/* record tree, for lookup by time */
+	int rec_cnt;		/* records in the map */
+	uint32_t seed;		/* treap priority generator state */
+} node_space_map_t;
+
+/*
+ * Create a map with a single record.
+ * IN begin_time, end_time - time window covered by the map
+ * IN avail_bitmap - nodes available over the window, the map takes ownership
+ */
+extern node_space_map_t *node_space_create(time_t begin_time, time_t end_time,
+					   bitstr_t *avail_bitmap);
+
+extern void node_space_destroy(node_space_map_t *map);
+
+/*
+ * Remove nodes from availability between start_time and end_time, splitting
+ * records at those times as needed and merging neighboring records left
+ * with identical bitmaps.
+ * IN res_bitmap - nodes left available (i.e. NOT reserved) over the interval
+ */
+extern void node_space_add_resv(node_space_map_t *map, time_t start_time,
+				time_t end_time, bitstr_t *res_bitmap);
+
+/*
+ * Return the record covering when, the first record if when precedes the
+ * map or NULL if when is at or after the end of the map.
+ */
+extern node_space_rec_t *node_space_find(node_space_map_t *map, time_t when);
+
+/*
+ * Return the earliest record ending after when with at least node_cnt nodes
+ * available, or NULL if there is none. No job needing node_cnt nodes can
+ * start in the map before this record's begin_time.
+ */
+extern node_space_rec_t *node_space_first_fit(node_space_map_t *map,
+					      time_t when, int node_cnt);
+
+#endif
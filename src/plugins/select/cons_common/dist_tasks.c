@@ -34,6 +34,10 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
 
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+
 #include "cons_common.h"
 #include "dist_tasks.h"
 
@@ -60,8 +64,6 @@ static uint32_t comb_counts[MAX_BOARDS][MAX_BOARDS] =
  {7,21,35,35,21,7,1,0},
  {8,28,56,70,56,28,8,1}};
 
-static int *sockets_core_cnt = NULL;
-
 /*
  * Generate all combinations of k integers from the
  * set of integers 0 to n-1.
@@ -117,11 +119,11 @@ static int _cmp_int_descend(const void *a, const void *b)
 }
 
 
-/* qsort compare function for board combination socket list
- * NOTE: sockets_core_cnt is a global symbol in this module */
-static int _cmp_sock(const void *a, const void *b)
+/* qsort_r compare function for board combination socket list */
+static int _cmp_sock(const void *a, const void *b, void *sockets_core_cnt)
 {
-	return (sockets_core_cnt[*(int*)b] - sockets_core_cnt[*(int*)a]);
+	int *core_cnt = (int *) sockets_core_cnt;
+	return (core_cnt[*(int*)b] - core_cnt[*(int*)a]);
 }
 
 /* Enable detailed logging of cr_dist() node and core bitmaps */
@@ -482,6 +484,7 @@ static void _block_sync_core_bitmap(job_record_t *job_ptr,
 	int sock_per_comb;
 	int *boards_core_cnt;
 	int *sort_brds_core_cnt;
+	int *sockets_core_cnt;
 	int *board_combs;
 	int *socket_list;
 	int *elig_brd_combs;
@@ -699,8 +702,9 @@ static void _block_sync_core_bitmap(job_record_t *job_ptr,
 			 * Sort this socket list in descending order of
 			 * available core count
 			 */
-			qsort(&socket_list[elig_idx*sock_per_comb],
-			      sock_per_comb, sizeof (int), _cmp_sock);
+			qsort_r(&socket_list[elig_idx*sock_per_comb],
+				sock_per_comb, sizeof (int), _cmp_sock,
+				sockets_core_cnt);
 			/*
 			 * Determine minimum number of sockets required for
 			 * the allocation from this socket list
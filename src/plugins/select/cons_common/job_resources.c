@@ -63,11 +63,15 @@ static bitstr_t *_create_core_bitmap(int node_inx)
 
 		xassert(!node_inx);
 
+		/*
+		 * Sum into a local first, backfill may test jobs on several
+		 * threads at once
+		 */
 		if (sys_core_size == NO_VAL) {
-			sys_core_size = 0;
+			uint32_t core_size = 0;
 			for (int i = 0; i < select_node_cnt; i++)
-				sys_core_size +=
-					select_node_record[i].tot_cores;
+				core_size += select_node_record[i].tot_cores;
+			sys_core_size = core_size;
 		}
 		return bit_alloc(sys_core_size);
 	}
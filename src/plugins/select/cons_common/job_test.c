@@ -226,15 +226,19 @@ static uint16_t _get_job_node_req(job_record_t *job_ptr)
 
 static void _set_gpu_defaults(job_record_t *job_ptr)
 {
+	/* Backfill may test jobs from several threads at once */
+	static pthread_mutex_t last_part_mutex = PTHREAD_MUTEX_INITIALIZER;
 	static part_record_t *last_part_ptr = NULL;
 	static uint64_t last_cpu_per_gpu = NO_VAL64;
 	static uint64_t last_mem_per_gpu = NO_VAL64;
 	uint64_t cpu_per_gpu, mem_per_gpu;
+	uint64_t part_cpu_per_gpu, part_mem_per_gpu;
 
 	xassert(is_cons_tres);
 	if (!job_ptr->gres_list_req)
 		return;
 
+	slurm_mutex_lock(&last_part_mutex);
 	if (job_ptr->part_ptr != last_part_ptr) {
 		/* Cache data from last partition referenced */
 		last_part_ptr = job_ptr->part_ptr;
@@ -243,16 +247,20 @@ static void _set_gpu_defaults(job_record_t *job_ptr)
 		last_mem_per_gpu = common_get_def_mem_per_gpu(
 			last_part_ptr->job_defaults_list);
 	}
-	if ((last_cpu_per_gpu != NO_VAL64) &&
+	part_cpu_per_gpu = last_cpu_per_gpu;
+	part_mem_per_gpu = last_mem_per_gpu;
+	slurm_mutex_unlock(&last_part_mutex);
+
+	if ((part_cpu_per_gpu != NO_VAL64) &&
 	    (job_ptr->details->orig_cpus_per_task == NO_VAL16))
-		cpu_per_gpu = last_cpu_per_gpu;
+		cpu_per_gpu = part_cpu_per_gpu;
 	else if ((def_cpu_per_gpu != NO_VAL64) &&
 		 (job_ptr->details->orig_cpus_per_task == NO_VAL16))
 		cpu_per_gpu = def_cpu_per_gpu;
 	else
 		cpu_per_gpu = 0;
-	if (last_mem_per_gpu != NO_VAL64)
-		mem_per_gpu = last_mem_per_gpu;
+	if (part_mem_per_gpu != NO_VAL64)
+		mem_per_gpu = part_mem_per_gpu;
 	else if (def_mem_per_gpu != NO_VAL64)
 		mem_per_gpu = def_mem_per_gpu;
 	else
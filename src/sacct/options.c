@@ -59,6 +59,7 @@
 #define OPT_LONG_ENV       0x108
 #define OPT_LONG_JSON      0x109
 #define OPT_LONG_YAML      0x110
+#define OPT_LONG_STREAM    0x111
 
 #define JOB_HASH_SIZE 1000
 
@@ -449,6 +450,9 @@ sacct [<OPTION>]                                                            \n \
                    Select jobs eligible after this time.  Default is        \n\
                    00:00:00 of the current day, unless '-s' is set then     \n\
                    the default is 'now'.                                    \n\
+     --stream:                                                              \n\
+                   Print jobs in chunks as they are received instead of     \n\
+                   collecting and sorting all of them first.                \n\
      -T, --truncate:                                                        \n\
                    Truncate time.  So if a job started before --starttime   \n\
                    the start time would be truncated to --starttime.        \n\
@@ -614,7 +618,8 @@ static void _remove_duplicate_fed_jobs(List jobs)
 	xfree(hash_job);
 }
 
-extern int get_data(void)
+/* Remove duplicates, sort and aggregate the step statistics of jobs */
+static void _process_jobs(void)
 {
 	slurmdb_job_rec_t *job = NULL;
 	slurmdb_step_rec_t *step = NULL;
@@ -624,16 +629,6 @@ extern int get_data(void)
 	int cnt;
 	char *tmp_usage;
 
-	if (params.opt_completion) {
-		jobs = slurmdb_jobcomp_jobs_get(job_cond);
-		return SLURM_SUCCESS;
-	} else {
-		jobs = slurmdb_jobs_get(acct_db_conn, job_cond);
-	}
-
-	if (!jobs)
-		return SLURM_ERROR;
-
 	/*
 	 * Remove duplicate federated jobs. The db will remove duplicates for
 	 * one cluster but not when jobs for multiple clusters are requested.
@@ -687,6 +682,39 @@ extern int get_data(void)
 		list_iterator_destroy(itr_step);
 	}
 	list_iterator_destroy(itr);
+}
+
+/* With --stream print each chunk of jobs as it comes from the database */
+static int _list_chunk(List job_list, void *arg)
+{
+	jobs = job_list;
+	_process_jobs();
+	do_list();
+	jobs = NULL;
+
+	return SLURM_SUCCESS;
+}
+
+extern int get_data(void)
+{
+	slurmdb_job_cond_t *job_cond = params.job_cond;
+
+	if (params.opt_completion) {
+		jobs = slurmdb_jobcomp_jobs_get(job_cond);
+		return SLURM_SUCCESS;
+	} else if (params.opt_stream) {
+		if (slurmdb_jobs_get_chunked(acct_db_conn, job_cond,
+					     _list_chunk, NULL))
+			return SLURM_ERROR;
+		return SLURM_SUCCESS;
+	} else {
+		jobs = slurmdb_jobs_get(acct_db_conn, job_cond);
+	}
+
+	if (!jobs)
+		return SLURM_ERROR;
+
+	_process_jobs();
 
 	return SLURM_SUCCESS;
 }
@@ -754,6 +782,7 @@ extern void parse_command_line(int argc, char **argv)
                 {"reason",         required_argument, 0,    'R'},
                 {"state",          required_argument, 0,    's'},
                 {"starttime",      required_argument, 0,    'S'},
+                {"stream",         no_argument,       0,    OPT_LONG_STREAM},
                 {"truncate",       no_argument,       0,    'T'},
                 {"uid",            required_argument, 0,    'u'},
 		{"use-local-uid",  no_argument,       0,    OPT_LONG_LOCAL_UID},
@@ -929,6 +958,9 @@ extern void parse_command_line(int argc, char **argv)
 		case OPT_LONG_NOCONVERT:
 			params.convert_flags |= CONVERT_NUM_UNIT_NO;
 			break;
+		case OPT_LONG_STREAM:
+			params.opt_stream = true;
+			break;
 		case OPT_LONG_UNITS:
 		{
 			int type = get_unit_type(*optarg);
@@ -208,6 +208,7 @@ typedef struct {
 	int opt_help;		/* --help */
 	bool opt_local;		/* --local */
 	int opt_noheader;	/* can only be cleared */
+	bool opt_stream;	/* --stream */
 	int opt_uid;		/* running persons uid */
 	int units;		/* --units*/
 	bool use_local_uid;	/* --use-local-uid */
@@ -58,6 +58,9 @@ struct sdiag_parameters params;
 stats_info_response_msg_t *buf;
 uint32_t *rpc_type_ave_time = NULL, *rpc_user_ave_time = NULL;
 
+/* Indexed by lock_type in stats_info_response_msg_t */
+static const char *lock_type_names[] = { "conf", "job", "node", "part", "fed" };
+
 static int  _print_stats(void);
 static void _sort_rpc(void);
 
@@ -193,6 +196,98 @@ static int _print_stats(void)
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
 	}
 
+	if (buf->job_hash_cnt)
+		printf("\nJob hash table statistics\n");
+	for (i = 0; i < buf->job_hash_cnt; i++) {
+		printf("\t%-16s size:%-8u records:%-8u load:%3u%% "
+		       "lookups:%-10"PRIu64" mean_probes:%-6.2f "
+		       "max_probes:%-4u resizes:%u\n",
+		       buf->job_hash_name[i], buf->job_hash_size[i],
+		       buf->job_hash_records[i],
+		       (buf->job_hash_size[i] ?
+			((buf->job_hash_records[i] * 100) /
+			 buf->job_hash_size[i]) : 0),
+		       buf->job_hash_lookups[i],
+		       (buf->job_hash_lookups[i] ?
+			((double) buf->job_hash_probes[i] /
+			 buf->job_hash_lookups[i]) : 0.0),
+		       buf->job_hash_probe_max[i], buf->job_hash_resizes[i]);
+	}
+
+	if (buf->rpc_pool_queue_cnt)
+		printf("\nRPC worker pool statistics (threads: %u)\n",
+		       buf->rpc_pool_threads);
+	for (i = 0; i < buf->rpc_pool_queue_cnt; i++) {
+		printf("\t%-8s depth:%-6u max_depth:%-6u count:%-10u "
+		       "ave_wait:%-10"PRIu64" max_wait:%-10u deferred:%u\n",
+		       buf->rpc_pool_queue_name[i], buf->rpc_pool_queue_depth[i],
+		       buf->rpc_pool_queue_depth_max[i],
+		       buf->rpc_pool_queue_count[i],
+		       (buf->rpc_pool_queue_count[i] ?
+			(buf->rpc_pool_queue_wait_time[i] /
+			 buf->rpc_pool_queue_count[i]) : 0),
+		       buf->rpc_pool_queue_wait_max[i],
+		       buf->rpc_pool_queue_rejected[i]);
+	}
+
+	if (buf->record_pool_cnt)
+		printf("\nRecord pool statistics\n");
+	for (i = 0; i < buf->record_pool_cnt; i++) {
+		printf("\t%-12s size:%-6u in_use:%-8u slabs:%-6u "
+		       "allocs:%"PRIu64"\n",
+		       buf->record_pool_name[i], buf->record_pool_obj_size[i],
+		       buf->record_pool_in_use[i], buf->record_pool_slabs[i],
+		       buf->record_pool_allocs[i]);
+	}
+
+	if (buf->fwd_hop_bucket_cnt) {
+		printf("\nMessage forwarding statistics\n");
+		printf("\tFailed hosts: %u\n", buf->fwd_failed);
+		printf("\tRerouted branches: %u\n", buf->fwd_rerouted);
+	}
+	for (i = 0; i < buf->fwd_hop_bucket_cnt; i++) {
+		if (buf->fwd_hop_usec[i] == NO_VAL)
+			printf("\tHops over %u usec: %u\n",
+			       (i ? buf->fwd_hop_usec[i - 1] : 0),
+			       buf->fwd_hop_cnt[i]);
+		else
+			printf("\tHops under %u usec: %u\n",
+			       buf->fwd_hop_usec[i], buf->fwd_hop_cnt[i]);
+	}
+
+	if (buf->lock_caller_cnt) {
+		printf("\nLock statistics by caller (histogram buckets:");
+		for (i = 0; i < buf->lock_bucket_cnt; i++) {
+			if (buf->lock_bucket_usec[i] == NO_VAL)
+				printf(" >=%u",
+				       (i ? buf->lock_bucket_usec[i - 1] : 0));
+			else
+				printf(" <%u", buf->lock_bucket_usec[i]);
+		}
+		printf(" usec)\n");
+	}
+	for (i = 0; i < buf->lock_caller_cnt; i++) {
+		uint32_t *wait = &buf->lock_wait_hist[i * buf->lock_bucket_cnt];
+		uint32_t *hold = &buf->lock_hold_hist[i * buf->lock_bucket_cnt];
+
+		printf("\t%-32s %-4s %-5s count:%-8u ave_wait:%-8"PRIu64" "
+		       "ave_hold:%-8"PRIu64,
+		       buf->lock_caller[i],
+		       ((buf->lock_type[i] < ARRAY_SIZE(lock_type_names)) ?
+			lock_type_names[buf->lock_type[i]] : "?"),
+		       ((buf->lock_level[i] == 2) ? "write" : "read"),
+		       buf->lock_cnt[i],
+		       (buf->lock_cnt[i] ?
+			(buf->lock_wait_usec[i] / buf->lock_cnt[i]) : 0),
+		       (buf->lock_cnt[i] ?
+			(buf->lock_hold_usec[i] / buf->lock_cnt[i]) : 0));
+		for (int j = 0; j < buf->lock_bucket_cnt; j++)
+			printf("%s%u", (j ? "," : " wait:"), wait[j]);
+		for (int j = 0; j < buf->lock_bucket_cnt; j++)
+			printf("%s%u", (j ? "," : " hold:"), hold[j]);
+		printf("\n");
+	}
+
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
 
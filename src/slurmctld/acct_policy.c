@@ -2566,6 +2566,7 @@ static int _qos_job_time_out(job_record_t *job_ptr,
 	switch (tres_usage) {
 	case TRES_USAGE_CUR_EXCEEDS_LIMIT:
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		info("%pJ timed out, the job is at or exceeds QOS %s's group max tres(%s) minutes of %"PRIu64" with %"PRIu64"",
 		     job_ptr, qos_ptr->name,
 		     assoc_mgr_tres_name_array[tres_pos],
@@ -2591,6 +2592,7 @@ static int _qos_job_time_out(job_record_t *job_ptr,
 
 		if (wall_mins >= qos_ptr->grp_wall) {
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			info("%pJ timed out, the job is at or exceeds QOS %s's group wall limit of %u with %u",
 			     job_ptr, qos_ptr->name,
 			     qos_ptr->grp_wall, wall_mins);
@@ -2610,6 +2612,7 @@ static int _qos_job_time_out(job_record_t *job_ptr,
 		break;
 	case TRES_USAGE_REQ_EXCEEDS_LIMIT:
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		info("%pJ timed out, the job is at or exceeds QOS %s's max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 		     job_ptr, qos_ptr->name,
 		     assoc_mgr_tres_name_array[tres_pos],
@@ -4251,6 +4254,7 @@ extern int acct_policy_update_pending_job(job_record_t *job_ptr)
 
 	if (update_accounting) {
 		last_job_update = time(NULL);
+		job_delta_stamp(job_ptr);
 		debug("limits changed for %pJ: updating accounting", job_ptr);
 		/* Update job record in accounting to reflect changes */
 		jobacct_storage_job_start_direct(acct_db_conn, job_ptr);
@@ -4347,6 +4351,7 @@ extern bool acct_policy_job_time_out(job_record_t *job_ptr)
 		switch (tres_usage) {
 		case TRES_USAGE_CUR_EXCEEDS_LIMIT:
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			info("%pJ timed out, the job is at or exceeds assoc %u(%s/%s/%s) group max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 			     job_ptr, assoc->id, assoc->acct,
 			     assoc->user, assoc->partition,
@@ -4388,6 +4393,7 @@ extern bool acct_policy_job_time_out(job_record_t *job_ptr)
 			break;
 		case TRES_USAGE_REQ_EXCEEDS_LIMIT:
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			info("%pJ timed out, the job is at or exceeds assoc %u(%s/%s/%s) max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 			     job_ptr, assoc->id, assoc->acct,
 			     assoc->user, assoc->partition,
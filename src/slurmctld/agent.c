@@ -78,6 +78,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "src/common/conn_cache.h"
 #include "src/common/env.h"
 #include "src/common/fd.h"
 #include "src/common/forward.h"
@@ -109,6 +110,7 @@
 #define DUMP_RPC_COUNT 		25
 #define HOSTLIST_MAX_SIZE 	80
 #define MAIL_PROG_TIMEOUT 120*1000
+#define NODE_CONN_CACHE_MAX	65536	/* limit of node_conn_cache */
 
 typedef enum {
 	DSH_NEW,        /* Request not yet started */
@@ -1408,6 +1410,25 @@ static void *_agent_init(void *arg)
 
 extern void agent_init(void)
 {
+	char *tmp_ptr, *end_ptr = NULL;
+	long max_conns;
+
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "node_conn_cache="))) {
+		tmp_ptr += strlen("node_conn_cache=");
+		errno = 0;
+		max_conns = strtol(tmp_ptr, &end_ptr, 10);
+		if (errno || (end_ptr == tmp_ptr) ||
+		    ((*end_ptr != '\0') && (*end_ptr != ',')) ||
+		    (max_conns < 0) || (max_conns > NODE_CONN_CACHE_MAX)) {
+			error("Invalid SlurmctldParameters node_conn_cache=%.*s, must be 0 to %d, node connections are not cached",
+			      (int) strcspn(tmp_ptr, ","), tmp_ptr,
+			      NODE_CONN_CACHE_MAX);
+		} else {
+			conn_cache_init(max_conns);
+		}
+	}
+
 	slurm_mutex_lock(&pending_mutex);
 	if (pending_thread_running) {
 		error("%s: thread already running", __func__);
@@ -59,6 +59,7 @@
 #include "slurm/slurm_errno.h"
 
 #include "src/common/assoc_mgr.h"
+#include "src/common/conn_cache.h"
 #include "src/common/daemonize.h"
 #include "src/common/fd.h"
 #include "src/common/gres.h"
@@ -101,6 +102,7 @@
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/heartbeat.h"
+#include "src/slurmctld/info_snapshot.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
 #include "src/slurmctld/licenses.h"
@@ -112,6 +114,7 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_pool.h"
 #include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
@@ -245,7 +248,6 @@ static void *       _purge_files_thread(void *no_data);
 static void         _remove_assoc(slurmdb_assoc_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
 static void         _run_primary_prog(bool primary_on);
-static void *       _service_connection(void *arg);
 static void         _set_work_dir(void);
 static int          _shutdown_backup_controller(void);
 static void *       _slurmctld_background(void *no_data);
@@ -260,7 +262,7 @@ static void         _update_nice(void);
 static void         _update_qos(slurmdb_qos_rec_t *rec);
 inline static void  _usage(char *prog_name);
 static bool         _verify_clustername(void);
-static bool         _wait_for_server_thread(void);
+static void         _wait_for_server_thread_decr(void);
 static void *       _wait_primary_prog(void *arg);
 
 /* main - slurmctld main function, start various threads and process RPCs */
@@ -656,6 +658,7 @@ int main(int argc, char **argv)
 				      slurm_conf.slurm_conf,
 				      slurm_strerror(error_code));
 			}
+			lock_stats_config();
 			unlock_slurmctld(config_write_lock);
 			select_g_select_nodeinfo_set_all();
 
@@ -863,8 +866,11 @@ int main(int argc, char **argv)
 		error("Left %d agent threads active", cnt);
 
 	/* Purge our local data structures */
+	rpc_pool_fini();
+	conn_cache_fini();
 	configless_clear();
 	power_save_fini();
+	info_snapshot_fini();
 	job_fini();
 	part_fini();	/* part_fini() must precede node_fini() */
 	node_fini();
@@ -1004,6 +1010,7 @@ static void _reconfigure_slurm(void)
 	else {
 		_update_cred_key();
 		set_slurmctld_state_loc();
+		lock_stats_config();
 	}
 
 	gs_reconfig();
@@ -1100,11 +1107,11 @@ static void _sig_handler(int signal)
 }
 
 /*
- * _slurmctld_rpc_mgr - Read incoming RPCs and create pthread for each
+ * _slurmctld_rpc_mgr - Accept incoming RPCs and hand them to the worker pool
  */
 static void *_slurmctld_rpc_mgr(void *no_data)
 {
-	int *newsockfd;
+	int newsockfd;
 	struct pollfd *fds;
 	slurm_addr_t cli_addr, srv_addr;
 	int fd_next = 0, i, nports;
@@ -1149,6 +1156,7 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	unlock_slurmctld(config_read_lock);
 
 	rpc_queue_init();
+	rpc_pool_init(max_server_threads);
 
 	/*
 	 * Prepare to catch SIGUSR1 to interrupt accept().
@@ -1161,13 +1169,14 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	xsignal_unblock(sigarray);
 
 	/*
-	 * Process incoming RPCs until told to shutdown
+	 * Process incoming RPCs until told to shutdown. Connections cost the
+	 * pool a file descriptor and no thread until read, so accept() is
+	 * only held back once out of file descriptors.
 	 */
-	while (_wait_for_server_thread()) {
+	while (!slurmctld_config.shutdown_time) {
 		if (poll(fds, nports, -1) == -1) {
 			if (errno != EINTR)
 				error("slurm_accept_msg_conn poll: %m");
-			server_thread_decr();
 			continue;
 		}
 
@@ -1180,27 +1189,24 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		}
 		fd_next = (i + 1) % nports;
 
-		newsockfd = xmalloc(sizeof(*newsockfd));
-		if ((*newsockfd = slurm_accept_msg_conn(fds[i].fd, &cli_addr))
+		if ((newsockfd = slurm_accept_msg_conn(fds[i].fd, &cli_addr))
 		    == SLURM_ERROR) {
-			if (errno != EINTR)
+			if ((errno == EMFILE) || (errno == ENFILE)) {
+				error("slurm_accept_msg_conn: %m");
+				_wait_for_server_thread_decr();
+			} else if (errno != EINTR)
 				error("slurm_accept_msg_conn: %m");
-			server_thread_decr();
-			xfree(newsockfd);
 			continue;
 		}
-		fd_set_close_on_exec(*newsockfd);
+		fd_set_close_on_exec(newsockfd);
+		server_thread_incr();
 
 		log_flag(PROTOCOL, "%s: accept() connection from %pA",
 			 __func__, &cli_addr);
 
-		if (slurmctld_config.shutdown_time) {
+		if (slurmctld_config.shutdown_time)
 			slurmctld_diag_stats.proc_req_raw++;
-			_service_connection(newsockfd);
-		} else {
-			slurm_thread_create_detached(NULL, _service_connection,
-						     newsockfd);
-		}
+		rpc_pool_add_conn(newsockfd);
 	}
 
 	debug3("%s shutting down", __func__);
@@ -1216,96 +1222,19 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 }
 
 /*
- * _service_connection - service the RPC
- * IN/OUT arg - really just the connection's file descriptor, freed
- *	upon completion
- * RET - NULL
+ * Wait up to a second for an RPC in progress to finish and close its
+ * connection, or for shutdown
  */
-static void *_service_connection(void *arg)
+static void _wait_for_server_thread_decr(void)
 {
-	int fd = *((int *) arg);
-	slurm_msg_t *msg = xmalloc(sizeof *msg);
-	xfree(arg);
-
-#if HAVE_SYS_PRCTL_H
-	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
-		error("%s: cannot set my name to %s %m", __func__, "srvcn");
-	}
-#endif
-	slurm_msg_t_init(msg);
-	msg->flags |= SLURM_MSG_KEEP_BUFFER;
-	/*
-	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
-	 * possibility for slurmctld_req() to close accepted connection.
-	 */
-	if (slurm_receive_msg(fd, msg, 0)) {
-		slurm_addr_t cli_addr;
-		(void) slurm_get_peer_addr(fd, &cli_addr);
-		error("slurm_receive_msg [%pA]: %m", &cli_addr);
-		/* close the new socket */
-		close(fd);
-		goto cleanup;
-	}
-
-	if (rpc_enqueue(msg)) {
-		server_thread_decr();
-		return NULL;
-	}
-
-	/* process the request */
-	slurmctld_req(msg);
-
-	if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
-		error("close(%d): %m", msg->conn_fd);
-
-cleanup:
-	slurm_free_msg(msg);
-	server_thread_decr();
-
-	return NULL;
-}
-
-/* Increment slurmctld_config.server_thread_count and don't return
- * until its value is no larger than MAX_SERVER_THREADS,
- * RET true unless shutdown in progress */
-static bool _wait_for_server_thread(void)
-{
-	bool print_it = true;
-	bool rc = true;
+	struct timespec ts = {0, 0};
 
+	ts.tv_sec = time(NULL) + 1;
 	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
-	while (1) {
-		if (slurmctld_config.shutdown_time) {
-			rc = false;
-			break;
-		}
-		if (slurmctld_config.server_thread_count < max_server_threads) {
-			slurmctld_config.server_thread_count++;
-			break;
-		} else {
-			/* wait for state change and retry,
-			 * just a delay and not an error.
-			 * This can happen when the epilog completes
-			 * on a bunch of nodes at the same time, which
-			 * can easily happen for highly parallel jobs. */
-			if (print_it) {
-				static time_t last_print_time = 0;
-				time_t now = time(NULL);
-				if (difftime(now, last_print_time) > 2) {
-					verbose("server_thread_count over "
-						"limit (%d), waiting",
-						slurmctld_config.
-						server_thread_count);
-					last_print_time = now;
-				}
-				print_it = false;
-			}
-			slurm_cond_wait(&slurmctld_config.thread_count_cond,
-					&slurmctld_config.thread_count_lock);
-		}
-	}
+	if (!slurmctld_config.shutdown_time)
+		slurm_cond_timedwait(&slurmctld_config.thread_count_cond,
+				     &slurmctld_config.thread_count_lock, &ts);
 	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
-	return rc;
 }
 
 /* Decrement slurmctld thread count (as applies to thread limit) */
@@ -3422,6 +3351,8 @@ static void *_purge_files_thread(void *no_data)
 	 */
 	slurm_mutex_lock(&purge_thread_lock);
 	while (!slurmctld_config.shutdown_time) {
+		bool purged = false;
+
 		slurm_cond_wait(&purge_thread_cond, &purge_thread_lock);
 		debug2("%s: starting, %d jobs to purge", __func__,
 		       list_count(purge_files_list));
@@ -3436,7 +3367,12 @@ static void *_purge_files_thread(void *no_data)
 			       __func__, *job_id);
 			delete_job_desc_files(*job_id);
 			xfree(job_id);
+			purged = true;
 		}
+
+		/* Files shared by the purged jobs may now be unused */
+		if (purged)
+			purge_shared_job_files();
 	}
 	slurm_mutex_unlock(&purge_thread_lock);
 	return NULL;
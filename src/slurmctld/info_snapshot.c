@@ -0,0 +1,199 @@
+/*****************************************************************************\
+ *  info_snapshot.c
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <pthread.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/xmalloc.h"
+
+#include "src/slurmctld/info_snapshot.h"
+
+/* Distinct show_flags/protocol combinations cached per type */
+#define INFO_SNAPSHOT_VARIANTS 8
+
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static info_snapshot_t *snapshots[INFO_SNAPSHOT_TYPES][INFO_SNAPSHOT_VARIANTS];
+static time_t last_used[INFO_SNAPSHOT_TYPES][INFO_SNAPSHOT_VARIANTS];
+
+static char *_type_str(info_snapshot_type_t type)
+{
+	switch (type) {
+	case INFO_SNAPSHOT_JOBS:
+		return "jobs";
+	case INFO_SNAPSHOT_NODES:
+		return "nodes";
+	case INFO_SNAPSHOT_PARTS:
+		return "partitions";
+	default:
+		return "unknown";
+	}
+}
+
+static void _free_snapshot(info_snapshot_t *snapshot)
+{
+	xfree(snapshot->dump);
+	xfree(snapshot);
+}
+
+/* Drop the cache's reference. Caller must hold snapshot_lock. */
+static void _unlink_snapshot(info_snapshot_t *snapshot)
+{
+	if (--snapshot->ref_cnt == 0)
+		_free_snapshot(snapshot);
+}
+
+/*
+ * Pending jobs are packed with expected start and end times of at least the
+ * time of the dump, so a job dump is only what a new one would be during the
+ * second it was packed.
+ */
+static bool _is_current(info_snapshot_t *snapshot, uint64_t gen0,
+			uint64_t gen1)
+{
+	if ((snapshot->gen[0] != gen0) || (snapshot->gen[1] != gen1))
+		return false;
+	if ((snapshot->type == INFO_SNAPSHOT_JOBS) &&
+	    (snapshot->build_time != time(NULL)))
+		return false;
+	return true;
+}
+
+extern info_snapshot_t *info_snapshot_get(info_snapshot_type_t type,
+					  uint32_t key,
+					  uint16_t protocol_version,
+					  uint64_t gen0, uint64_t gen1)
+{
+	info_snapshot_t *snapshot, *found = NULL;
+
+	xassert(type < INFO_SNAPSHOT_TYPES);
+
+	slurm_mutex_lock(&snapshot_lock);
+	for (int i = 0; i < INFO_SNAPSHOT_VARIANTS; i++) {
+		if (!(snapshot = snapshots[type][i]) ||
+		    (snapshot->key != key) ||
+		    (snapshot->protocol_version != protocol_version))
+			continue;
+		if (_is_current(snapshot, gen0, gen1)) {
+			snapshot->ref_cnt++;
+			last_used[type][i] = time(NULL);
+			found = snapshot;
+		}
+		break;
+	}
+	slurm_mutex_unlock(&snapshot_lock);
+
+	if (found)
+		log_flag(PROTOCOL, "%s: reusing %s snapshot key=0x%x size=%d",
+			 __func__, _type_str(type), key, found->dump_size);
+
+	return found;
+}
+
+extern info_snapshot_t *info_snapshot_add(info_snapshot_type_t type,
+					  uint32_t key,
+					  uint16_t protocol_version,
+					  uint64_t gen0, uint64_t gen1,
+					  char *dump, int dump_size)
+{
+	info_snapshot_t *snapshot = xmalloc(sizeof(*snapshot));
+	int inx = -1;
+
+	xassert(type < INFO_SNAPSHOT_TYPES);
+
+	snapshot->type = type;
+	snapshot->key = key;
+	snapshot->protocol_version = protocol_version;
+	snapshot->gen[0] = gen0;
+	snapshot->gen[1] = gen1;
+	snapshot->build_time = time(NULL);
+	snapshot->ref_cnt = 2;	/* cache and caller */
+	snapshot->dump = dump;
+	snapshot->dump_size = dump_size;
+
+	slurm_mutex_lock(&snapshot_lock);
+	/* Replace the same variant, else an empty slot, else the oldest one */
+	for (int i = 0; i < INFO_SNAPSHOT_VARIANTS; i++) {
+		info_snapshot_t *old = snapshots[type][i];
+
+		if (old && (old->key == key) &&
+		    (old->protocol_version == protocol_version)) {
+			inx = i;
+			break;
+		}
+		if (!old) {
+			if ((inx == -1) || snapshots[type][inx])
+				inx = i;
+		} else if ((inx == -1) ||
+			   (snapshots[type][inx] &&
+			    (last_used[type][i] < last_used[type][inx]))) {
+			inx = i;
+		}
+	}
+	if (snapshots[type][inx])
+		_unlink_snapshot(snapshots[type][inx]);
+	snapshots[type][inx] = snapshot;
+	last_used[type][inx] = snapshot->build_time;
+	slurm_mutex_unlock(&snapshot_lock);
+
+	return snapshot;
+}
+
+extern void info_snapshot_release(info_snapshot_t *snapshot)
+{
+	if (!snapshot)
+		return;
+
+	slurm_mutex_lock(&snapshot_lock);
+	_unlink_snapshot(snapshot);
+	slurm_mutex_unlock(&snapshot_lock);
+}
+
+extern void info_snapshot_fini(void)
+{
+	slurm_mutex_lock(&snapshot_lock);
+	for (int t = 0; t < INFO_SNAPSHOT_TYPES; t++) {
+		for (int i = 0; i < INFO_SNAPSHOT_VARIANTS; i++) {
+			if (!snapshots[t][i])
+				continue;
+			_unlink_snapshot(snapshots[t][i]);
+			snapshots[t][i] = NULL;
+		}
+	}
+	slurm_mutex_unlock(&snapshot_lock);
+}
@@ -0,0 +1,99 @@
+/*****************************************************************************\
+ * info_snapshot.h
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _INFO_SNAPSHOT_H_
+#define _INFO_SNAPSHOT_H_
+
+#include <time.h>
+
+#include "slurm/slurm.h"
+
+typedef enum {
+	INFO_SNAPSHOT_JOBS,
+	INFO_SNAPSHOT_NODES,
+	INFO_SNAPSHOT_PARTS,
+	INFO_SNAPSHOT_TYPES		/* count of types, must be last */
+} info_snapshot_type_t;
+
+/* Set in the key of snapshots packed for an operator */
+#define INFO_SNAPSHOT_PRIVILEGED SLURM_BIT(31)
+
+/*
+ * A packed RESPONSE_*_INFO message body shared between all requests with the
+ * same key (show_flags plus INFO_SNAPSHOT_PRIVILEGED) and protocol version.
+ * Snapshots are immutable once added; readers hold a reference while sending.
+ */
+typedef struct {
+	info_snapshot_type_t type;
+	uint32_t key;
+	uint16_t protocol_version;
+	uint64_t gen[2];	/* lock_write_gen() of the state in the dump */
+	time_t build_time;	/* when the dump was packed */
+	int ref_cnt;
+	char *dump;
+	int dump_size;
+} info_snapshot_t;
+
+/*
+ * Find a snapshot still reflecting the state as of gen0 and gen1, the
+ * lock_write_gen() values of the locks the dump was packed under, and take a
+ * reference on it. Job dumps include times relative to when they were packed
+ * and are only reused during that second. Does not need any slurmctld locks.
+ * RET snapshot to pass to info_snapshot_release() or NULL if none matches
+ */
+extern info_snapshot_t *info_snapshot_get(info_snapshot_type_t type,
+					  uint32_t key,
+					  uint16_t protocol_version,
+					  uint64_t gen0, uint64_t gen1);
+
+/*
+ * Record a dump packed for a request with the given key. Must be called while
+ * still holding the slurmctld locks used to pack it, so gen[] matches the
+ * dump contents. The snapshot takes ownership of dump.
+ * RET referenced snapshot to pass to info_snapshot_release()
+ */
+extern info_snapshot_t *info_snapshot_add(info_snapshot_type_t type,
+					  uint32_t key,
+					  uint16_t protocol_version,
+					  uint64_t gen0, uint64_t gen1,
+					  char *dump, int dump_size);
+
+/* Drop a reference from info_snapshot_get() or info_snapshot_add() */
+extern void info_snapshot_release(info_snapshot_t *snapshot);
+
+/* Free all cached snapshots not currently referenced */
+extern void info_snapshot_fini(void);
+
+#endif
@@ -0,0 +1,162 @@
+/*****************************************************************************\
+ * job_delta.c - job generations for delta job info requests
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/slurmctld/job_delta.h"
+
+typedef struct {
+	uint32_t job_id;
+	uint64_t update_gen;		/* job delta generation of the purge */
+} job_delta_purge_t;
+
+/*
+ * Generations are only taken with the job write lock, but job_delta_get()
+ * may start a new epoch with only the job read lock, so job_delta_mutex
+ * protects these.
+ */
+static pthread_mutex_t job_delta_mutex = PTHREAD_MUTEX_INITIALIZER;
+static time_t job_delta_epoch = 0;	/* start of generation sequence */
+static uint64_t job_delta_floor = 0;	/* oldest generation with complete
+					 * purge history */
+static uint64_t job_delta_gen = 0;	/* latest generation */
+static time_t job_delta_part_update = 0; /* last_part_update of the epoch */
+static job_delta_purge_t *job_delta_purged = NULL; /* ring, oldest first */
+static uint32_t job_delta_purged_cnt = 0;
+static uint32_t job_delta_purged_head = 0;
+
+/*
+ * job_delta_stamp - note a change to a job so that delta job info requests
+ *	send it again. Call wherever last_job_update is set for the job.
+ */
+extern void job_delta_stamp(job_record_t *job_ptr)
+{
+	slurm_mutex_lock(&job_delta_mutex);
+	job_ptr->update_gen = ++job_delta_gen;
+	slurm_mutex_unlock(&job_delta_mutex);
+}
+
+extern void job_delta_purge(job_record_t *job_ptr)
+{
+	job_delta_purge_t *purge;
+
+	if (!job_ptr->update_gen || (job_ptr->job_id == NO_VAL))
+		return;	/* never sent in a delta or already recorded */
+
+	slurm_mutex_lock(&job_delta_mutex);
+	if (!job_delta_purged)
+		job_delta_purged = xcalloc(JOB_DELTA_PURGE_MAX,
+					   sizeof(job_delta_purge_t));
+	if (job_delta_purged_cnt == JOB_DELTA_PURGE_MAX) {
+		/* Forget the oldest, older clients get a full response */
+		purge = &job_delta_purged[job_delta_purged_head];
+		job_delta_floor = purge->update_gen;
+		job_delta_purged_head = (job_delta_purged_head + 1) %
+					JOB_DELTA_PURGE_MAX;
+		job_delta_purged_cnt--;
+	}
+	purge = &job_delta_purged[(job_delta_purged_head +
+				   job_delta_purged_cnt) % JOB_DELTA_PURGE_MAX];
+	purge->job_id = job_ptr->job_id;
+	purge->update_gen = ++job_delta_gen;
+	job_delta_purged_cnt++;
+	slurm_mutex_unlock(&job_delta_mutex);
+}
+
+/* NOTE: Call with job_delta_mutex */
+static void _epoch_check(time_t part_update)
+{
+	if (job_delta_epoch && (job_delta_part_update == part_update))
+		return;
+
+	job_delta_epoch = MAX(time(NULL), job_delta_epoch + 1);
+	job_delta_part_update = part_update;
+	job_delta_floor = job_delta_gen;
+	job_delta_purged_cnt = 0;
+}
+
+extern int job_delta_get(time_t part_update, time_t *epoch,
+			 uint64_t *update_gen, bool *full,
+			 uint32_t **purged_ids, uint32_t *purged_cnt)
+{
+	uint32_t i, inx;
+
+	*full = false;
+	*purged_ids = NULL;
+	*purged_cnt = 0;
+
+	slurm_mutex_lock(&job_delta_mutex);
+	_epoch_check(part_update);
+
+	if ((*epoch != job_delta_epoch) ||
+	    (*update_gen < job_delta_floor) ||
+	    (*update_gen > job_delta_gen)) {
+		*full = true;
+	} else if (*update_gen == job_delta_gen) {
+		slurm_mutex_unlock(&job_delta_mutex);
+		return SLURM_NO_CHANGE_IN_DATA;
+	} else {
+		/* purge history is in generation order, newest last */
+		for (i = job_delta_purged_cnt; i > 0; i--) {
+			inx = (job_delta_purged_head + i - 1) %
+			      JOB_DELTA_PURGE_MAX;
+			if (job_delta_purged[inx].update_gen <= *update_gen)
+				break;
+		}
+		*purged_cnt = job_delta_purged_cnt - i;
+		if (*purged_cnt)
+			*purged_ids = xcalloc(*purged_cnt, sizeof(uint32_t));
+		for (inx = 0; i < job_delta_purged_cnt; i++) {
+			(*purged_ids)[inx++] = job_delta_purged[
+				(job_delta_purged_head + i) %
+				JOB_DELTA_PURGE_MAX].job_id;
+		}
+	}
+
+	*epoch = job_delta_epoch;
+	*update_gen = job_delta_gen;
+	slurm_mutex_unlock(&job_delta_mutex);
+
+	return SLURM_SUCCESS;
+}
+
+extern void job_delta_fini(void)
+{
+	slurm_mutex_lock(&job_delta_mutex);
+	xfree(job_delta_purged);
+	job_delta_purged_cnt = 0;
+	job_delta_purged_head = 0;
+	slurm_mutex_unlock(&job_delta_mutex);
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************\
+ * job_delta.h - job generations for delta job info requests
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _JOB_DELTA_H_
+#define _JOB_DELTA_H_
+
+#include "src/slurmctld/slurmctld.h"
+
+#define JOB_DELTA_PURGE_MAX	100000	/* purged job_ids kept for delta RPC */
+
+/*
+ * Every change to a job takes the next job delta generation, see
+ * job_delta_stamp() in slurmctld.h. A client that loaded jobs at some
+ * generation only needs the jobs with a later generation and the job_ids
+ * purged since then. Generations start again from a new epoch when the
+ * purge history no longer reaches back to the client's generation or when
+ * partitions change, which can change the jobs a user may see without
+ * changing the jobs.
+ */
+
+/*
+ * job_delta_purge - record a purged job for delta job info requests
+ * NOTE: Call with job write lock
+ */
+extern void job_delta_purge(job_record_t *job_ptr);
+
+/*
+ * job_delta_get - find what a client needs to bring its jobs up to date
+ * IN part_update - last_part_update, a change starts a new epoch
+ * IN/OUT epoch - client's epoch, set to the current epoch
+ * IN/OUT update_gen - client's generation, set to the current generation
+ * OUT full - set if the client must load all jobs again
+ * OUT purged_ids - job_ids purged since the client's generation, unless full
+ *	is set, must be xfreed by the caller
+ * OUT purged_cnt - count of purged_ids
+ * RET SLURM_SUCCESS or SLURM_NO_CHANGE_IN_DATA
+ * NOTE: Call with job read lock, so that no generation is taken until the
+ *	caller has packed the jobs changed since the client's generation
+ */
+extern int job_delta_get(time_t part_update, time_t *epoch,
+			 uint64_t *update_gen, bool *full,
+			 uint32_t **purged_ids, uint32_t *purged_cnt);
+
+/* Free the purge history */
+extern void job_delta_fini(void);
+
+#endif /* !_JOB_DELTA_H_ */
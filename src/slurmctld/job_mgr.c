@@ -72,6 +72,7 @@
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
 #include "src/common/power.h"
+#include "src/common/slab.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_jobcomp.h"
@@ -94,6 +95,7 @@
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/gres_ctld.h"
+#include "src/slurmctld/job_delta.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
 #include "src/slurmctld/licenses.h"
@@ -118,12 +120,15 @@
 #define TOP_PRIORITY 0xffff0000	/* large, but leave headroom for higher */
 #define PURGE_OLD_JOB_IN_SEC 2592000 /* 30 days in seconds */
 
-#define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
-#define JOB_ARRAY_HASH_INX(_job_id, _task_id)		\
-	((_job_id + _task_id) % hash_table_size)
+#define JOB_INDEX_MIN_SIZE	1024	/* initial slots in a job index */
+#define JOB_INDEX_INIT_MAX_SIZE	(1 << 17) /* larger indexes grow on demand */
+#define JOB_INDEX_MAX_LOAD	70	/* grow beyond this load (percent) */
+#define JOB_INDEX_MIGRATE_SLOTS	16	/* slots rehashed per index update */
 
 /* No need to change we always pack SLURM_PROTOCOL_VERSION */
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
+/* Job records framed by their job ID and length, written since the journal */
+#define JOB_STATE_FRAMED_VERSION "PROTOCOL_VERSION_FRAMED"
 #define JOB_CKPT_VERSION      "PROTOCOL_VERSION"
 
 typedef enum {
@@ -132,6 +137,38 @@ typedef enum {
 	JOB_HASH_ARRAY_TASK,
 } job_hash_type_t;
 
+typedef struct {
+	uint64_t key;
+	job_record_t *job_ptr;		/* NULL if slot is empty */
+} job_index_slot_t;
+
+typedef struct {
+	char *name;
+	job_index_slot_t *slots;	/* current table */
+	uint32_t size;			/* slots in current table, power of 2 */
+	uint32_t count;			/* entries in current table */
+	job_index_slot_t *old_slots;	/* table being migrated, if any */
+	uint32_t old_size;
+	uint32_t old_count;
+	uint32_t migrate_pos;		/* next old slot to migrate */
+
+	/*
+	 * Statistics, reset by sdiag. Lookups run concurrently under the job
+	 * read lock, so these are only accessed with relaxed atomics.
+	 */
+	uint64_t lookups;
+	uint64_t probes;
+	uint32_t probe_max;
+	uint32_t resizes;
+} job_index_t;
+
+typedef struct {
+	uint32_t job_id;
+	uint32_t seq;			/* position in the journal */
+	uint32_t offset;		/* of the framed job state record */
+	bool purged;
+} job_journal_rec_t;
+
 typedef struct {
 	int resp_array_cnt;
 	int resp_array_size;
@@ -150,6 +187,9 @@ typedef struct {
 	slurmdb_user_rec_t user_rec;
 	bool privileged;
 	part_record_t **allowed_parts;
+	uint64_t update_gen;		/* delta: pack jobs changed after this */
+	uint32_t *hidden_ids;		/* delta: changed jobs not visible */
+	uint32_t hidden_cnt;
 } _foreach_pack_job_info_t;
 
 typedef struct {
@@ -157,6 +197,11 @@ typedef struct {
 	int rc;
 } job_overlap_args_t;
 
+typedef struct {
+	job_desc_msg_t *job_desc;	/* job being submitted */
+	char *dir_name;			/* its staged script and environment */
+} job_stage_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -168,12 +213,31 @@ static int      bf_min_age_reserve = 0;
 static uint32_t delay_boot = 0;
 static uint32_t highest_prio = 0;
 static uint32_t lowest_prio  = TOP_PRIORITY;
-static int      hash_table_size = 0;
 static int      job_count = 0;		/* job's in the system */
 static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
-static struct   job_record **job_hash = NULL;
-static struct   job_record **job_array_hash_j = NULL;
-static struct   job_record **job_array_hash_t = NULL;
+static job_index_t job_index;		/* by job_id */
+static job_index_t job_array_index_j;	/* by array_job_id */
+static job_index_t job_array_index_t;	/* by array_job_id and task_id */
+
+/*
+ * Job state journal, see dump_all_job_state(). Only the state save thread
+ * uses these and each job's save_hash, except for the purged job IDs which
+ * job_journal_mutex protects.
+ */
+static pthread_mutex_t job_journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *job_journal_purged = NULL; /* journaled jobs since purged */
+static uint32_t job_journal_purged_cnt = 0;
+static uint32_t job_journal_purged_size = 0;
+static time_t job_journal_snapshot = 0;	/* snapshot the journal follows,
+					 * 0 if the next save is a snapshot */
+static uint32_t job_journal_size = 0;	/* bytes in the journal */
+static uint32_t job_snapshot_size = 0;	/* bytes in the last snapshot */
+/* Batch job files written by stage_job_desc_files(), see job_stage_t */
+static pthread_mutex_t job_stage_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List job_stage_list = NULL;
+/* Record pools, created with the first job record */
+static slab_pool_t *job_details_pool = NULL;
+static slab_pool_t *job_record_pool = NULL;
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
 static uint32_t max_array_size = NO_VAL;
@@ -212,6 +276,7 @@ static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
 			char **err_msg, uint16_t protocol_version);
 static void _job_timed_out(job_record_t *job_ptr, bool preempted);
 static void _kill_dependent(job_record_t *job_ptr);
+static void _job_journal_purge(job_record_t *job_ptr);
 static void _list_delete_job(void *job_entry);
 static int  _list_find_job_old(void *job_entry, void *key);
 static int  _load_job_details(job_record_t *job_ptr, buf_t *buffer,
@@ -268,8 +333,8 @@ static bool _validate_min_mem_partition(job_desc_msg_t *job_desc_msg,
 					List part_list);
 static bool _valid_pn_min_mem(job_desc_msg_t * job_desc_msg,
 			      part_record_t *part_ptr);
-static int  _write_data_array_to_file(char *file_name, char **data,
-				      uint32_t size);
+static int  _write_job_desc_files(job_desc_msg_t *job_desc, char *dir_name,
+				  char *shared_dir);
 
 static char *_get_mail_user(const char *user_name, uid_t user_id)
 {
@@ -596,12 +661,21 @@ static job_array_resp_msg_t *_resp_array_xlate(resp_array_struct_t *resp,
  *    = 1 - simple job OR job array with one task
  *    > 1 - job array create with the task count as num_jobs
  * RET pointer to the record or NULL if error
- * NOTE: allocates memory that should be xfreed with _list_delete_job
+ * NOTE: allocates memory that should be freed with _list_delete_job
  */
 static job_record_t *_create_job_record(uint32_t num_jobs)
 {
-	job_record_t *job_ptr = xmalloc(sizeof(*job_ptr));
-	struct job_details *detail_ptr = xmalloc(sizeof(*detail_ptr));
+	job_record_t *job_ptr;
+	struct job_details *detail_ptr;
+
+	if (!job_record_pool) {
+		job_record_pool = slab_pool_create("job_record",
+						   sizeof(job_record_t));
+		job_details_pool = slab_pool_create("job_details",
+						    sizeof(struct job_details));
+	}
+	job_ptr = slab_alloc(job_record_pool);
+	detail_ptr = slab_alloc(job_details_pool);
 
 	if ((job_count + num_jobs) >= slurm_conf.max_job_cnt) {
 		error("%s: MaxJobCount limit from slurm.conf reached (%u)",
@@ -610,6 +684,7 @@ static job_record_t *_create_job_record(uint32_t num_jobs)
 
 	job_count += num_jobs;
 	last_job_update = time(NULL);
+	job_delta_stamp(job_ptr);
 
 	job_ptr->magic = JOB_MAGIC;
 	job_ptr->array_task_id = NO_VAL;
@@ -684,7 +759,9 @@ static void _delete_job_details(job_record_t *job_entry)
 	xfree(job_entry->details->work_dir);
 	xfree(job_entry->details->x11_magic_cookie);
 	xfree(job_entry->details->x11_target);
-	xfree(job_entry->details);	/* Must be last */
+	/* Must be last */
+	slab_free(job_details_pool, job_entry->details);
+	job_entry->details = NULL;
 }
 
 /*
@@ -801,10 +878,200 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	return qos_ptr;
 }
 
+/* Record a purged job so the next journal entry removes it */
+static void _job_journal_purge(job_record_t *job_ptr)
+{
+	if (!job_ptr->save_hash)
+		return;	/* not in the journal or the snapshot it follows */
+
+	slurm_mutex_lock(&job_journal_mutex);
+	if (job_journal_purged_cnt == job_journal_purged_size) {
+		job_journal_purged_size = MAX(1024,
+					      job_journal_purged_size * 2);
+		xrecalloc(job_journal_purged, job_journal_purged_size,
+			  sizeof(uint32_t));
+	}
+	job_journal_purged[job_journal_purged_cnt++] = job_ptr->job_id;
+	slurm_mutex_unlock(&job_journal_mutex);
+}
+
+/*
+ * Pack a removal record for each job purged since the last save
+ * IN buffer - journal entry, or NULL to just forget the purged jobs
+ * RET count of records packed
+ */
+static uint32_t _pack_job_journal_purged(buf_t *buffer)
+{
+	uint32_t i, cnt;
+
+	slurm_mutex_lock(&job_journal_mutex);
+	cnt = job_journal_purged_cnt;
+	for (i = 0; buffer && (i < cnt); i++) {
+		pack32(job_journal_purged[i], buffer);
+		packmem(NULL, 0, buffer);
+	}
+	job_journal_purged_cnt = 0;
+	slurm_mutex_unlock(&job_journal_mutex);
+
+	return buffer ? cnt : 0;
+}
+
+/* FNV-1a over 64-bit words, any change to a packed record changes it */
+static uint64_t _job_state_hash(const char *data, uint32_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL, word;
+	uint32_t i;
+
+	for (i = 0; (i + sizeof(word)) <= size; i += sizeof(word)) {
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ULL;
+		hash ^= hash >> 29;
+	}
+	for ( ; i < size; i++)
+		hash = (hash ^ (uint8_t) data[i]) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+/*
+ * Pack a job's state framed by its job ID and length, so that recovery can
+ * skip records replaced in the journal.
+ * IN hash - set the job's save_hash
+ * RET true if hash is set and the job state changed since it was last saved
+ */
+static bool _dump_job_state_rec(job_record_t *job_ptr, buf_t *buffer,
+				bool hash)
+{
+	uint32_t len_offset, start, end;
+	uint64_t save_hash;
+
+	pack32(job_ptr->job_id, buffer);
+	len_offset = get_buf_offset(buffer);
+	pack32(0, buffer);
+	start = get_buf_offset(buffer);
+	_dump_job_state(job_ptr, buffer);
+	end = get_buf_offset(buffer);
+	set_buf_offset(buffer, len_offset);
+	pack32(end - start, buffer);
+	set_buf_offset(buffer, end);
+
+	if (!hash)
+		return false;
+	save_hash = _job_state_hash(get_buf_data(buffer) + start, end - start);
+	if (!save_hash)
+		save_hash = 1;	/* 0 means not journaled */
+	if (save_hash == job_ptr->save_hash)
+		return false;
+	job_ptr->save_hash = save_hash;
+	return true;
+}
+
+static int _write_job_state_file(char *file, int flags, buf_t *buffer)
+{
+	int error_code = SLURM_SUCCESS, fd, pos = 0, nwrite, amount, rc;
+	char *data = get_buf_data(buffer);
+
+	fd = open(file, (flags | O_WRONLY | O_CLOEXEC), 0600);
+	if (fd < 0) {
+		error("Can't save state, open file %s error %m", file);
+		return errno;
+	}
+
+	nwrite = get_buf_offset(buffer);
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if ((amount < 0) && (errno != EINTR)) {
+			error("Error writing file %s, %m", file);
+			error_code = errno;
+			break;
+		}
+		nwrite -= amount;
+		pos    += amount;
+	}
+
+	rc = fsync_and_close(fd, "job journal");
+	if (rc && !error_code)
+		error_code = rc;
+
+	return error_code;
+}
+
+/*
+ * Append an entry of changed and purged job state records to the job state
+ * journal. On failure the next save writes a snapshot.
+ */
+static int _append_job_journal(char *journal_file, buf_t *journal_buf)
+{
+	uint32_t size = get_buf_offset(journal_buf);
+	int error_code;
+
+	/* set entry length, so that an incomplete entry can be detected */
+	set_buf_offset(journal_buf, 0);
+	pack32(size - sizeof(uint32_t), journal_buf);
+	set_buf_offset(journal_buf, size);
+
+	lock_state_files();
+	error_code = _write_job_state_file(journal_file, O_APPEND,
+					   journal_buf);
+	unlock_state_files();
+
+	if (error_code)
+		job_journal_snapshot = 0;
+	else
+		job_journal_size += size;
+
+	return error_code;
+}
+
+/*
+ * Start an empty journal following the snapshot just written, or remove
+ * the journal if it is not configured.
+ * NOTE: Call with lock_state_files()
+ */
+static void _reset_job_journal(char *journal_file, bool journal,
+			       time_t snapshot_time, uint32_t snapshot_size)
+{
+	char *new_file;
+	buf_t *buffer;
+
+	job_journal_snapshot = 0;
+	job_snapshot_size = snapshot_size;
+	if (!journal) {
+		(void) unlink(journal_file);
+		return;
+	}
+
+	buffer = init_buf(BUF_SIZE);
+	packstr(JOB_STATE_FRAMED_VERSION, buffer);
+	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack_time(snapshot_time, buffer);
+	pack32(snapshot_size, buffer);
+
+	new_file = xstrdup_printf("%s.new", journal_file);
+	if (_write_job_state_file(new_file, (O_CREAT | O_TRUNC), buffer)) {
+		(void) unlink(new_file);
+		(void) unlink(journal_file);
+	} else if (rename(new_file, journal_file)) {
+		error("Can't rename %s to %s: %m", new_file, journal_file);
+		(void) unlink(new_file);
+	} else {
+		job_journal_snapshot = snapshot_time;
+		job_journal_size = get_buf_offset(buffer);
+	}
+	xfree(new_file);
+	free_buf(buffer);
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
  *	Changes here should be reflected in load_last_job_id() and
  *	load_all_job_state().
+ *
+ *	With SlurmctldParameters=job_state_journal, only the jobs whose state
+ *	changed or that were purged since the last save are appended to
+ *	job_state.journal, until the journal grows to half the size of the
+ *	job_state snapshot. The next save then writes a new snapshot and
+ *	starts an empty journal.
  * RET 0 or error code
  */
 int dump_all_job_state(void)
@@ -812,16 +1079,18 @@ int dump_all_job_state(void)
 	/* Save high-water mark to avoid buffer growth with copies */
 	static int high_buffer_size = (1024 * 1024);
 	int error_code = SLURM_SUCCESS, log_fd;
-	char *old_file, *new_file, *reg_file;
+	char *old_file, *new_file, *reg_file, *journal_file;
 	struct stat stat_buf;
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	ListIterator job_iterator;
 	job_record_t *job_ptr;
-	buf_t *buffer = init_buf(high_buffer_size);
+	buf_t *buffer = NULL, *journal_buf = NULL;
 	time_t now = time(NULL);
 	time_t last_state_file_time;
+	uint32_t journal_cnt = 0, snapshot_size;
+	bool journal;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -844,8 +1113,48 @@ int dump_all_job_state(void)
 		}
 	}
 
+	lock_slurmctld(job_read_lock);
+	journal = xstrcasestr(slurm_conf.slurmctld_params,
+			      "job_state_journal");
+	if (journal && job_journal_snapshot &&
+	    (job_journal_size < (job_snapshot_size / 2))) {
+		/* buffer only holds one job record at a time */
+		buffer = init_buf(BUF_SIZE);
+		journal_buf = init_buf(BUF_SIZE);
+		pack32(0, journal_buf);	/* entry length, set when written */
+		pack_time(now, journal_buf);
+		pack32(job_id_sequence, journal_buf);
+		journal_cnt = _pack_job_journal_purged(journal_buf);
+
+		job_iterator = list_iterator_create(job_list);
+		while ((job_ptr = list_next(job_iterator))) {
+			set_buf_offset(buffer, 0);
+			if (!_dump_job_state_rec(job_ptr, buffer, true))
+				continue;
+			packmem_array(get_buf_data(buffer),
+				      get_buf_offset(buffer), journal_buf);
+			journal_cnt++;
+		}
+		list_iterator_destroy(job_iterator);
+		journal_file = xstrdup_printf("%s/job_state.journal",
+					      slurm_conf.state_save_location);
+		unlock_slurmctld(job_read_lock);
+
+		if (journal_cnt)
+			error_code = _append_job_journal(journal_file,
+							 journal_buf);
+		debug3("%s: journaled %u job records", __func__, journal_cnt);
+		xfree(journal_file);
+		free_buf(journal_buf);
+		free_buf(buffer);
+		END_TIMER2("dump_all_job_state");
+		return error_code;
+	}
+	(void) _pack_job_journal_purged(NULL);
+
 	/* write header: version, time */
-	packstr(JOB_STATE_VERSION, buffer);
+	buffer = init_buf(high_buffer_size);
+	packstr(JOB_STATE_FRAMED_VERSION, buffer);
 	pack16(SLURM_PROTOCOL_VERSION, buffer);
 	pack_time(now, buffer);
 
@@ -860,13 +1169,13 @@ int dump_all_job_state(void)
 	       job_id_sequence);
 
 	/* write individual job records */
-	lock_slurmctld(job_read_lock);
 	pack_time(slurmctld_diag_stats.bf_when_last_cycle, buffer);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
-		_dump_job_state(job_ptr, buffer);
+		(void) _dump_job_state_rec(job_ptr, buffer, journal);
 	}
 	list_iterator_destroy(job_iterator);
+	snapshot_size = get_buf_offset(buffer);
 
 
 	/* write the buffer to file */
@@ -876,6 +1185,8 @@ int dump_all_job_state(void)
 	xstrcat(reg_file, "/job_state");
 	new_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(new_file, "/job_state.new");
+	journal_file = xstrdup(slurm_conf.state_save_location);
+	xstrcat(journal_file, "/job_state.journal");
 	unlock_slurmctld(job_read_lock);
 
 	if (stat(reg_file, &stat_buf) == 0) {
@@ -921,9 +1232,10 @@ int dump_all_job_state(void)
 		if (rc && !error_code)
 			error_code = rc;
 	}
-	if (error_code)
+	if (error_code) {
 		(void) unlink(new_file);
-	else {			/* file shuffle */
+		job_journal_snapshot = 0;
+	} else {		/* file shuffle */
 		(void) unlink(old_file);
 		if (link(reg_file, old_file))
 			debug4("unable to create link for %s -> %s: %m",
@@ -934,10 +1246,12 @@ int dump_all_job_state(void)
 			       new_file, reg_file);
 		(void) unlink(new_file);
 		last_file_write_time = now;
+		_reset_job_journal(journal_file, journal, now, snapshot_size);
 	}
 	xfree(old_file);
 	xfree(reg_file);
 	xfree(new_file);
+	xfree(journal_file);
 	unlock_state_files();
 
 	free_buf(buffer);
@@ -1042,6 +1356,7 @@ extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
+			job_delta_stamp(job_ptr);
 		}
 	}
 
@@ -1061,6 +1376,7 @@ extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
+			job_delta_stamp(job_ptr);
 		}
 	}
 }
@@ -1136,7 +1452,8 @@ static time_t _get_last_job_state_write_time(void)
 		return buf_time;
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	if (!xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION) ||
+	    !xstrcmp(ver_str, JOB_STATE_VERSION))
 		safe_unpack16(&protocol_version, buffer);
 	safe_unpack_time(&buf_time, buffer);
 
@@ -1146,6 +1463,177 @@ unpack_error:
 	return buf_time;
 }
 
+static int _cmp_job_journal_rec(const void *x, const void *y)
+{
+	const job_journal_rec_t *rec1 = x, *rec2 = y;
+
+	if (rec1->job_id != rec2->job_id)
+		return (rec1->job_id < rec2->job_id) ? -1 : 1;
+	if (rec1->seq != rec2->seq)
+		return (rec1->seq < rec2->seq) ? -1 : 1;
+	return 0;
+}
+
+static int _cmp_job_journal_id(const void *key, const void *x)
+{
+	uint32_t job_id = *(const uint32_t *) key;
+	const job_journal_rec_t *rec = x;
+
+	if (job_id != rec->job_id)
+		return (job_id < rec->job_id) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Open the job state journal, if it follows the job state snapshot loaded
+ * RET the journal positioned after its header or NULL
+ */
+static buf_t *_open_job_journal(time_t snapshot_time, uint32_t snapshot_size,
+				uint16_t protocol_version)
+{
+	char *journal_file, *ver_str = NULL;
+	uint32_t ver_str_len, journal_snapshot_size = 0;
+	uint16_t journal_protocol_version = NO_VAL16;
+	time_t journal_snapshot_time = 0;
+	buf_t *buffer;
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	if (!(buffer = create_mmap_buf(journal_file))) {
+		xfree(journal_file);
+		return NULL;
+	}
+
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (!xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION))
+		safe_unpack16(&journal_protocol_version, buffer);
+	safe_unpack_time(&journal_snapshot_time, buffer);
+	safe_unpack32(&journal_snapshot_size, buffer);
+
+	if ((journal_protocol_version != protocol_version) ||
+	    (journal_snapshot_time != snapshot_time) ||
+	    (journal_snapshot_size != snapshot_size)) {
+		info("Ignoring job state journal %s, it does not follow the job state file",
+		     journal_file);
+		free_buf(buffer);
+		buffer = NULL;
+	}
+	xfree(ver_str);
+	xfree(journal_file);
+	return buffer;
+
+unpack_error:
+	error("Invalid job state journal %s", journal_file);
+	xfree(ver_str);
+	xfree(journal_file);
+	free_buf(buffer);
+	return NULL;
+}
+
+/*
+ * Index the job state records of each complete entry in the journal,
+ * keeping only the last record for each job.
+ * OUT recs_ptr - records sorted by job ID, xfree() when done
+ * OUT last_job_id - job_id_sequence as of the last entry, if any
+ * RET count of records
+ */
+static uint32_t _read_job_journal(buf_t *journal, job_journal_rec_t **recs_ptr,
+				  uint32_t *last_job_id)
+{
+	job_journal_rec_t *recs = NULL;
+	uint32_t rec_cnt = 0, rec_size = 0, entry_cnt = 0, i, j;
+	uint32_t entry_len, entry_end, job_id, job_id_seq, len;
+	uint32_t rec_offset, entry_rec_cnt = 0;
+	time_t entry_time;
+	char *data;
+
+	while (remaining_buf(journal) > 0) {
+		entry_rec_cnt = rec_cnt;
+		safe_unpack32(&entry_len, journal);
+		if (entry_len > remaining_buf(journal)) {
+			error("Incomplete job state journal entry ignored");
+			break;
+		}
+		entry_end = get_buf_offset(journal) + entry_len;
+		safe_unpack_time(&entry_time, journal);
+		safe_unpack32(&job_id_seq, journal);
+		while (get_buf_offset(journal) < entry_end) {
+			rec_offset = get_buf_offset(journal);
+			safe_unpack32(&job_id, journal);
+			safe_unpackmem_ptr(&data, &len, journal);
+			if (get_buf_offset(journal) > entry_end)
+				goto unpack_error;
+			if (rec_cnt == rec_size) {
+				rec_size = MAX(1024, rec_size * 2);
+				xrecalloc(recs, rec_size, sizeof(*recs));
+			}
+			recs[rec_cnt].job_id = job_id;
+			recs[rec_cnt].seq = rec_cnt;
+			recs[rec_cnt].offset = rec_offset;
+			recs[rec_cnt].purged = (len == 0);
+			rec_cnt++;
+		}
+		*last_job_id = job_id_seq;
+		entry_cnt++;
+	}
+	goto fini;
+
+unpack_error:
+	error("Invalid job state journal entry ignored");
+	rec_cnt = entry_rec_cnt;
+
+fini:
+	/* Later entries replace earlier ones for the same job */
+	if (rec_cnt)
+		qsort(recs, rec_cnt, sizeof(*recs), _cmp_job_journal_rec);
+	for (i = 0, j = 0; i < rec_cnt; i++) {
+		if (((i + 1) < rec_cnt) && (recs[i + 1].job_id == recs[i].job_id))
+			continue;
+		recs[j++] = recs[i];
+	}
+	rec_cnt = j;
+
+	debug("%s: %u journal entries for %u jobs", __func__, entry_cnt,
+	      rec_cnt);
+	*recs_ptr = recs;
+	return rec_cnt;
+}
+
+/*
+ * Load a job state record framed by its job ID and length, unless recs
+ * holds a later record for the job
+ * RET SLURM_SUCCESS, ESLURM_ALREADY_DONE if replaced, or SLURM_ERROR
+ */
+static int _load_job_state_rec(buf_t *buffer, uint16_t protocol_version,
+			       job_journal_rec_t *recs, uint32_t rec_cnt)
+{
+	uint32_t job_id, len, end;
+	char *data;
+
+	safe_unpack32(&job_id, buffer);
+	safe_unpackmem_ptr(&data, &len, buffer);
+	if (!len)
+		goto unpack_error;
+	end = get_buf_offset(buffer);
+
+	if (rec_cnt && bsearch(&job_id, recs, rec_cnt, sizeof(*recs),
+			       _cmp_job_journal_id))
+		return ESLURM_ALREADY_DONE;
+
+	set_buf_offset(buffer, end - len);
+	if (_load_job_state(buffer, protocol_version) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+	if (get_buf_offset(buffer) != end) {
+		error("Job state record size mismatch for JobId=%u", job_id);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
 /*
  * load_all_job_state - load the job state from file, recover from last
  *	checkpoint. Execute this after loading the configuration file data.
@@ -1157,12 +1645,14 @@ extern int load_all_job_state(void)
 	int error_code = SLURM_SUCCESS;
 	int job_cnt = 0;
 	char *state_file = NULL;
-	buf_t *buffer;
-	time_t buf_time;
-	uint32_t saved_job_id;
+	buf_t *buffer, *journal = NULL;
+	time_t buf_time, snapshot_time;
+	uint32_t saved_job_id, i, journal_rec_cnt = 0;
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	job_journal_rec_t *journal_recs = NULL;
+	bool framed;
 
 	/* read the file */
 	lock_state_files();
@@ -1179,7 +1669,8 @@ extern int load_all_job_state(void)
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
 	debug3("Version string in job_state header is %s", ver_str);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	framed = !xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION);
+	if (framed || !xstrcmp(ver_str, JOB_STATE_VERSION))
 		safe_unpack16(&protocol_version, buffer);
 	xfree(ver_str);
 
@@ -1193,12 +1684,29 @@ extern int load_all_job_state(void)
 		return EFAULT;
 	}
 
-	safe_unpack_time(&buf_time, buffer);
+	safe_unpack_time(&snapshot_time, buffer);
 	safe_unpack32(&saved_job_id, buffer);
 	if (saved_job_id <= slurm_conf.max_job_id)
 		job_id_sequence = MAX(saved_job_id, job_id_sequence);
 	debug3("Job id in job_state header is %u", saved_job_id);
 
+	/*
+	 * Only files with framed job state records have a journal. Files
+	 * written before the journal existed hold the records back to back.
+	 */
+	if (framed) {
+		lock_state_files();
+		journal = _open_job_journal(snapshot_time, size_buf(buffer),
+					    protocol_version);
+		unlock_state_files();
+	}
+	if (journal) {
+		journal_rec_cnt = _read_job_journal(journal, &journal_recs,
+						    &saved_job_id);
+		if (saved_job_id <= slurm_conf.max_job_id)
+			job_id_sequence = MAX(saved_job_id, job_id_sequence);
+	}
+
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
 		safe_unpack_time(&buf_time, buffer); /* bf_when_last_cycle */
 		if (!slurmctld_diag_stats.bf_when_last_cycle)
@@ -1213,13 +1721,35 @@ extern int load_all_job_state(void)
 	 * into the _load_job_state function than any other option.
 	 */
 	while (remaining_buf(buffer) > 0) {
-		error_code = _load_job_state(buffer, protocol_version);
+		if (framed)
+			error_code = _load_job_state_rec(buffer,
+							 protocol_version,
+							 journal_recs,
+							 journal_rec_cnt);
+		else
+			error_code = _load_job_state(buffer, protocol_version);
+		if (error_code == ESLURM_ALREADY_DONE)
+			continue;
+		if (error_code != SLURM_SUCCESS)
+			goto unpack_error;
+		job_cnt++;
+	}
+
+	/* Then the latest state of jobs changed since the snapshot */
+	for (i = 0; i < journal_rec_cnt; i++) {
+		if (journal_recs[i].purged)
+			continue;
+		set_buf_offset(journal, journal_recs[i].offset);
+		error_code = _load_job_state_rec(journal, protocol_version,
+						 NULL, 0);
 		if (error_code != SLURM_SUCCESS)
 			goto unpack_error;
 		job_cnt++;
 	}
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
+	xfree(journal_recs);
+	free_buf(journal);
 	free_buf(buffer);
 	info("Recovered information about %d jobs", job_cnt);
 	return error_code;
@@ -1229,6 +1759,8 @@ unpack_error:
 		fatal("Incomplete job state save file, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
 	error("Incomplete job state save file");
 	info("Recovered information about %d jobs", job_cnt);
+	xfree(journal_recs);
+	free_buf(journal);
 	free_buf(buffer);
 	return SLURM_ERROR;
 }
@@ -1241,11 +1773,12 @@ unpack_error:
 extern int load_last_job_id( void )
 {
 	char *state_file = NULL;
-	buf_t *buffer;
+	buf_t *buffer, *journal = NULL;
 	time_t buf_time;
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	bool framed;
 
 	/* read the file */
 	lock_state_files();
@@ -1260,7 +1793,8 @@ extern int load_last_job_id( void )
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
 	debug3("Version string in job_state header is %s", ver_str);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	framed = !xstrcmp(ver_str, JOB_STATE_FRAMED_VERSION);
+	if (framed || !xstrcmp(ver_str, JOB_STATE_VERSION))
 		safe_unpack16(&protocol_version, buffer);
 	xfree(ver_str);
 
@@ -1278,6 +1812,24 @@ extern int load_last_job_id( void )
 	safe_unpack32( &job_id_sequence, buffer);
 	debug3("Job ID in job_state header is %u", job_id_sequence);
 
+	/* Jobs may have been submitted since, see the journal */
+	if (framed) {
+		lock_state_files();
+		journal = _open_job_journal(buf_time, size_buf(buffer),
+					    protocol_version);
+		unlock_state_files();
+	}
+	if (journal) {
+		job_journal_rec_t *journal_recs = NULL;
+		uint32_t journal_job_id = 0;
+
+		(void) _read_job_journal(journal, &journal_recs,
+					 &journal_job_id);
+		xfree(journal_recs);
+		job_id_sequence = MAX(job_id_sequence, journal_job_id);
+		free_buf(journal);
+	}
+
 	/* Ignore the state for individual jobs stored here */
 
 	xfree(ver_str);
@@ -2822,124 +3374,396 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-/* _add_job_hash - add a job hash entry for given job record, job_id must
- *	already be set
- * IN job_ptr - pointer to job record
- * Globals: hash table updated
+/*
+ * Job record indexes
+ *
+ * Each index is an open-addressed (linear probing) hash table of
+ * job_index_slot_t, sized to a power of two. When the load factor passes
+ * JOB_INDEX_MAX_LOAD a table of twice the size is allocated and entries are
+ * migrated from the old table JOB_INDEX_MIGRATE_SLOTS at a time on every
+ * following insert or delete, so no single operation pays for a full rehash.
+ * Until migration completes lookups consult the new table first, then the old
+ * one. Deletes use backward shift so no tombstones are needed and the old
+ * table remains a valid probe sequence while it is being drained.
  */
-static void _add_job_hash(job_record_t *job_ptr)
+/* Mix the key so sequential job IDs spread across the low order bits */
+static uint64_t _job_index_hash(uint64_t key)
 {
-	int inx;
-
-	inx = JOB_HASH_INX(job_ptr->job_id);
-	job_ptr->job_next = job_hash[inx];
-	job_hash[inx] = job_ptr;
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return key;
 }
 
-/* _remove_job_hash - remove a job hash entry for given job record, job_id must
- *	already be set
- * IN job_ptr - pointer to job record
- * IN type - which hash to work with
- * Globals: hash table updated
- */
-static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
+static void _job_index_init(job_index_t *index, char *name, uint32_t size)
 {
-	job_record_t *job_ptr, **job_pptr;
+	uint32_t slots = JOB_INDEX_MIN_SIZE;
 
-	xassert(job_entry);
+	while ((slots < size) && (slots < JOB_INDEX_INIT_MAX_SIZE))
+		slots <<= 1;
 
-	switch (type) {
-	case JOB_HASH_JOB:
-		job_pptr = &job_hash[JOB_HASH_INX(job_entry->job_id)];
-		break;
-	case JOB_HASH_ARRAY_JOB:
-		job_pptr = &job_array_hash_j[
-			JOB_HASH_INX(job_entry->array_job_id)];
-		break;
-	case JOB_HASH_ARRAY_TASK:
-		job_pptr = &job_array_hash_t[
-			JOB_ARRAY_HASH_INX(job_entry->array_job_id,
-					   job_entry->array_task_id)];
-		break;
-	default:
-		fatal("%s: unknown job_hash_type_t %d", __func__, type);
-		return;
-	}
+	memset(index, 0, sizeof(job_index_t));
+	index->name = name;
+	index->size = slots;
+	index->slots = xcalloc(slots, sizeof(job_index_slot_t));
+}
 
-	while ((job_pptr != NULL) && (*job_pptr != NULL) &&
-	       ((job_ptr = *job_pptr) != job_entry)) {
-		xassert(job_ptr->magic == JOB_MAGIC);
-		switch (type) {
-		case JOB_HASH_JOB:
-			job_pptr = &job_ptr->job_next;
-			break;
-		case JOB_HASH_ARRAY_JOB:
-			job_pptr = &job_ptr->job_array_next_j;
-			break;
-		case JOB_HASH_ARRAY_TASK:
-			job_pptr = &job_ptr->job_array_next_t;
-			break;
-		}
-	}
+static void _job_index_fini(job_index_t *index)
+{
+	xfree(index->slots);
+	xfree(index->old_slots);
+	index->size = index->count = 0;
+	index->old_size = index->old_count = 0;
+}
 
-	if (job_pptr == NULL || *job_pptr == NULL) {
-		if (job_entry->job_id == NO_VAL)
-			return;
+/* Find the slot holding key in a single table, NULL if not present */
+static job_index_slot_t *_job_index_probe(job_index_slot_t *slots,
+					  uint32_t size, uint64_t key,
+					  uint32_t *probes)
+{
+	uint32_t mask = size - 1;
+	uint32_t inx = _job_index_hash(key) & mask;
 
-		switch (type) {
-		case JOB_HASH_JOB:
-			error("%s: Could not find hash entry for JobId=%u",
-			      __func__, job_entry->job_id);
-			break;
-		case JOB_HASH_ARRAY_JOB:
-			error("%s: job array hash error %u", __func__,
-			      job_entry->array_job_id);
-			break;
-		case JOB_HASH_ARRAY_TASK:
-			error("%s: job array, task ID hash error %u_%u",
-			      __func__,
-			      job_entry->array_job_id,
-			      job_entry->array_task_id);
-			break;
-		}
-		return;
+	while (slots[inx].job_ptr) {
+		(*probes)++;
+		if (slots[inx].key == key)
+			return &slots[inx];
+		inx = (inx + 1) & mask;
 	}
+	(*probes)++;
 
-	switch (type) {
-	case JOB_HASH_JOB:
-		*job_pptr = job_entry->job_next;
-		job_entry->job_next = NULL;
-		break;
-	case JOB_HASH_ARRAY_JOB:
-		*job_pptr = job_entry->job_array_next_j;
-		job_entry->job_array_next_j = NULL;
-		break;
-	case JOB_HASH_ARRAY_TASK:
-		*job_pptr = job_entry->job_array_next_t;
-		job_entry->job_array_next_t = NULL;
-		break;
-	}
+	return NULL;
 }
 
-/* _add_job_array_hash - add a job hash entry for given job record,
- *	array_job_id and array_task_id must already be set
+static job_index_slot_t *_job_index_find(job_index_t *index, uint64_t key)
+{
+	job_index_slot_t *slot = NULL;
+	uint32_t probes = 0, probe_max;
+
+	if (!index->slots)
+		return NULL;
+
+	slot = _job_index_probe(index->slots, index->size, key, &probes);
+	if (!slot && index->old_slots)
+		slot = _job_index_probe(index->old_slots, index->old_size, key,
+					&probes);
+
+	__atomic_fetch_add(&index->lookups, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&index->probes, probes, __ATOMIC_RELAXED);
+	probe_max = __atomic_load_n(&index->probe_max, __ATOMIC_RELAXED);
+	while ((probes > probe_max) &&
+	       !__atomic_compare_exchange_n(&index->probe_max, &probe_max,
+					    probes, true, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
+
+	return slot;
+}
+
+/* Place an entry known to be absent from the table */
+static void _job_index_place(job_index_slot_t *slots, uint32_t size,
+			     uint64_t key, job_record_t *job_ptr)
+{
+	uint32_t mask = size - 1;
+	uint32_t inx = _job_index_hash(key) & mask;
+
+	while (slots[inx].job_ptr)
+		inx = (inx + 1) & mask;
+	slots[inx].key = key;
+	slots[inx].job_ptr = job_ptr;
+}
+
+/* Clear slot inx, shifting back later members of its probe sequence */
+static void _job_index_clear(job_index_slot_t *slots, uint32_t size,
+			     uint32_t inx)
+{
+	uint32_t mask = size - 1;
+	uint32_t next = inx, home;
+
+	while (true) {
+		next = (next + 1) & mask;
+		if (!slots[next].job_ptr)
+			break;
+		home = _job_index_hash(slots[next].key) & mask;
+		/* Skip entries whose home lies cyclically in (inx, next] */
+		if ((inx <= next) ?
+		    ((inx < home) && (home <= next)) :
+		    ((inx < home) || (home <= next)))
+			continue;
+		slots[inx] = slots[next];
+		inx = next;
+	}
+	slots[inx].key = 0;
+	slots[inx].job_ptr = NULL;
+}
+
+/* Move up to cnt slots worth of entries from the old table to the new one */
+static void _job_index_migrate(job_index_t *index, uint32_t cnt)
+{
+	job_index_slot_t *slot;
+
+	while (index->old_slots && cnt--) {
+		slot = &index->old_slots[index->migrate_pos];
+		/* Backward shift may refill this slot, drain it fully */
+		while (slot->job_ptr) {
+			_job_index_place(index->slots, index->size,
+					 slot->key, slot->job_ptr);
+			index->count++;
+			index->old_count--;
+			_job_index_clear(index->old_slots, index->old_size,
+					 index->migrate_pos);
+		}
+		if ((++index->migrate_pos >= index->old_size) ||
+		    !index->old_count) {
+			xfree(index->old_slots);
+			index->old_size = 0;
+			index->migrate_pos = 0;
+		}
+	}
+}
+
+static void _job_index_grow(job_index_t *index)
+{
+	/* Finish any migration still in progress before starting another */
+	if (index->old_slots)
+		_job_index_migrate(index, index->old_size);
+
+	debug("%s: growing %s index from %u to %u slots",
+	      __func__, index->name, index->size, index->size << 1);
+
+	index->old_slots = index->slots;
+	index->old_size = index->size;
+	index->old_count = index->count;
+	index->migrate_pos = 0;
+
+	index->size <<= 1;
+	index->slots = xcalloc(index->size, sizeof(job_index_slot_t));
+	index->count = 0;
+	index->resizes++;
+}
+
+static void _job_index_insert(job_index_t *index, uint64_t key,
+			      job_record_t *job_ptr)
+{
+	if (((uint64_t) (index->count + index->old_count + 1) * 100) >
+	    ((uint64_t) index->size * JOB_INDEX_MAX_LOAD))
+		_job_index_grow(index);
+	else
+		_job_index_migrate(index, JOB_INDEX_MIGRATE_SLOTS);
+
+	_job_index_place(index->slots, index->size, key, job_ptr);
+	index->count++;
+}
+
+/* Remove the entry at slot, which must have been returned by _job_index_find */
+static void _job_index_remove(job_index_t *index, job_index_slot_t *slot)
+{
+	if ((slot >= index->slots) && (slot < (index->slots + index->size))) {
+		_job_index_clear(index->slots, index->size,
+				 slot - index->slots);
+		index->count--;
+	} else {
+		xassert(index->old_slots);
+		_job_index_clear(index->old_slots, index->old_size,
+				 slot - index->old_slots);
+		index->old_count--;
+	}
+
+	_job_index_migrate(index, JOB_INDEX_MIGRATE_SLOTS);
+}
+
+static uint64_t _job_array_task_key(uint32_t array_job_id,
+				    uint32_t array_task_id)
+{
+	return (((uint64_t) array_job_id) << 32) | array_task_id;
+}
+
+/*
+ * Return the first record of the list of individual job array task records
+ * belonging to array_job_id, linked through job_array_next_j. The META record
+ * holding still pending tasks is not part of this list.
+ */
+static job_record_t *_find_job_array_tasks(uint32_t array_job_id)
+{
+	job_index_slot_t *slot = _job_index_find(&job_array_index_j,
+						 array_job_id);
+
+	return slot ? slot->job_ptr : NULL;
+}
+
+/* _add_job_hash - add a job hash entry for given job record, job_id must
+ *	already be set
+ * IN job_ptr - pointer to job record
+ * Globals: hash table updated
+ */
+static void _add_job_hash(job_record_t *job_ptr)
+{
+	job_index_slot_t *slot;
+
+	if ((slot = _job_index_find(&job_index, job_ptr->job_id))) {
+		error("%s: duplicate hash entry for JobId=%u",
+		      __func__, job_ptr->job_id);
+		slot->job_ptr = job_ptr;
+		return;
+	}
+	_job_index_insert(&job_index, job_ptr->job_id, job_ptr);
+}
+
+/* _remove_job_hash - remove a job hash entry for given job record, job_id must
+ *	already be set
+ * IN job_ptr - pointer to job record
+ * IN type - which hash to work with
+ * Globals: hash table updated
+ */
+static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
+{
+	job_index_slot_t *slot;
+
+	xassert(job_entry);
+
+	switch (type) {
+	case JOB_HASH_JOB:
+		slot = _job_index_find(&job_index, job_entry->job_id);
+		if (slot && (slot->job_ptr == job_entry)) {
+			_job_index_remove(&job_index, slot);
+			return;
+		}
+		if (job_entry->job_id == NO_VAL)
+			return;
+		error("%s: Could not find hash entry for JobId=%u",
+		      __func__, job_entry->job_id);
+		break;
+	case JOB_HASH_ARRAY_JOB:
+		slot = _job_index_find(&job_array_index_j,
+				       job_entry->array_job_id);
+		if (!slot) {
+			error("%s: job array hash error %u", __func__,
+			      job_entry->array_job_id);
+			return;
+		}
+		if (job_entry->job_array_prev_j) {
+			job_entry->job_array_prev_j->job_array_next_j =
+				job_entry->job_array_next_j;
+		} else if (slot->job_ptr == job_entry) {
+			slot->job_ptr = job_entry->job_array_next_j;
+		} else {
+			error("%s: job array hash error %u", __func__,
+			      job_entry->array_job_id);
+			return;
+		}
+		if (job_entry->job_array_next_j) {
+			job_entry->job_array_next_j->job_array_prev_j =
+				job_entry->job_array_prev_j;
+		}
+		job_entry->job_array_next_j = NULL;
+		job_entry->job_array_prev_j = NULL;
+		if (!slot->job_ptr)
+			_job_index_remove(&job_array_index_j, slot);
+		break;
+	case JOB_HASH_ARRAY_TASK:
+		slot = _job_index_find(&job_array_index_t,
+				       _job_array_task_key(
+					       job_entry->array_job_id,
+					       job_entry->array_task_id));
+		if (slot && (slot->job_ptr == job_entry)) {
+			_job_index_remove(&job_array_index_t, slot);
+			return;
+		}
+		error("%s: job array, task ID hash error %u_%u",
+		      __func__,
+		      job_entry->array_job_id,
+		      job_entry->array_task_id);
+		break;
+	default:
+		fatal("%s: unknown job_hash_type_t %d", __func__, type);
+		return;
+	}
+}
+
+/* _add_job_array_hash - add a job hash entry for given job record,
+ *	array_job_id and array_task_id must already be set
  * IN job_ptr - pointer to job record
  * Globals: hash table updated
  */
 void _add_job_array_hash(job_record_t *job_ptr)
 {
-	int inx;
+	job_index_slot_t *slot;
+	uint64_t key;
 
 	if (job_ptr->array_task_id == NO_VAL)
 		return;	/* Not a job array */
 
-	inx = JOB_HASH_INX(job_ptr->array_job_id);
-	job_ptr->job_array_next_j = job_array_hash_j[inx];
-	job_array_hash_j[inx] = job_ptr;
+	job_ptr->job_array_prev_j = NULL;
+	if ((slot = _job_index_find(&job_array_index_j,
+				    job_ptr->array_job_id))) {
+		job_ptr->job_array_next_j = slot->job_ptr;
+		slot->job_ptr->job_array_prev_j = job_ptr;
+		slot->job_ptr = job_ptr;
+	} else {
+		job_ptr->job_array_next_j = NULL;
+		_job_index_insert(&job_array_index_j, job_ptr->array_job_id,
+				  job_ptr);
+	}
 
-	inx = JOB_ARRAY_HASH_INX(job_ptr->array_job_id,job_ptr->array_task_id);
-	job_ptr->job_array_next_t = job_array_hash_t[inx];
-	job_array_hash_t[inx] = job_ptr;
+	key = _job_array_task_key(job_ptr->array_job_id,
+				  job_ptr->array_task_id);
+	if ((slot = _job_index_find(&job_array_index_t, key))) {
+		error("%s: duplicate hash entry for %u_%u", __func__,
+		      job_ptr->array_job_id, job_ptr->array_task_id);
+		slot->job_ptr = job_ptr;
+		return;
+	}
+	_job_index_insert(&job_array_index_t, key, job_ptr);
+}
+
+/* Pack job index statistics for sdiag */
+extern void pack_job_hash_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	job_index_t *indexes[] = {
+		&job_index, &job_array_index_j, &job_array_index_t
+	};
+	uint32_t cnt = ARRAY_SIZE(indexes);
+	char *name[ARRAY_SIZE(indexes)];
+	uint32_t size[ARRAY_SIZE(indexes)], records[ARRAY_SIZE(indexes)];
+	uint32_t probe_max[ARRAY_SIZE(indexes)], resizes[ARRAY_SIZE(indexes)];
+	uint64_t lookups[ARRAY_SIZE(indexes)], probes[ARRAY_SIZE(indexes)];
+
+	for (int i = 0; i < cnt; i++) {
+		name[i] = indexes[i]->name;
+		size[i] = indexes[i]->size + indexes[i]->old_size;
+		records[i] = indexes[i]->count + indexes[i]->old_count;
+		lookups[i] = __atomic_load_n(&indexes[i]->lookups,
+					     __ATOMIC_RELAXED);
+		probes[i] = __atomic_load_n(&indexes[i]->probes,
+					    __ATOMIC_RELAXED);
+		probe_max[i] = __atomic_load_n(&indexes[i]->probe_max,
+					       __ATOMIC_RELAXED);
+		resizes[i] = indexes[i]->resizes;
+	}
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		packstr_array(name, cnt, buffer);
+		pack32_array(size, cnt, buffer);
+		pack32_array(records, cnt, buffer);
+		pack64_array(lookups, cnt, buffer);
+		pack64_array(probes, cnt, buffer);
+		pack32_array(probe_max, cnt, buffer);
+		pack32_array(resizes, cnt, buffer);
+	}
+}
+
+/* Reset job index lookup statistics */
+extern void reset_job_hash_stats(void)
+{
+	job_index_t *indexes[] = {
+		&job_index, &job_array_index_j, &job_array_index_t
+	};
+
+	for (int i = 0; i < ARRAY_SIZE(indexes); i++) {
+		__atomic_store_n(&indexes[i]->lookups, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&indexes[i]->probes, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&indexes[i]->probe_max, 0, __ATOMIC_RELAXED);
+	}
 }
 
 /* For the job array data structure, build the string representation of the
@@ -2983,7 +3807,6 @@ extern void build_array_str(job_record_t *job_ptr)
 extern bool test_job_array_complete(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -2994,8 +3817,7 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = _find_job_array_tasks(array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (!IS_JOB_COMPLETE(job_ptr))
@@ -3010,7 +3832,6 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 extern bool test_job_array_completed(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3019,8 +3840,7 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = _find_job_array_tasks(array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (!IS_JOB_COMPLETED(job_ptr))
@@ -3038,7 +3858,6 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 extern bool _test_job_array_purged(uint32_t array_job_id)
 {
 	job_record_t *job_ptr, *head_job_ptr;
-	int inx;
 
 	head_job_ptr = find_job_record(array_job_id);
 	if (head_job_ptr) {
@@ -3047,8 +3866,7 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = _find_job_array_tasks(array_job_id);
 	while (job_ptr) {
 		if ((job_ptr->array_job_id == array_job_id) &&
 		    (job_ptr != head_job_ptr)) {
@@ -3063,7 +3881,6 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 extern bool test_job_array_finished(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3072,8 +3889,7 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = _find_job_array_tasks(array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (!IS_JOB_FINISHED(job_ptr))
@@ -3089,7 +3905,6 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 extern bool test_job_array_pending(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3100,8 +3915,7 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = _find_job_array_tasks(array_job_id);
 	while (job_ptr) {
 		if (job_ptr->array_job_id == array_job_id) {
 			if (IS_JOB_PENDING(job_ptr))
@@ -3117,10 +3931,9 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 extern int num_pending_job_array_tasks(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int count = 0, inx;
+	int count = 0;
 
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
+	job_ptr = _find_job_array_tasks(array_job_id);
 	while (job_ptr) {
 		if ((job_ptr->array_job_id == array_job_id) &&
 		    IS_JOB_PENDING(job_ptr))
@@ -3156,8 +3969,7 @@ extern job_record_t *find_job_array_rec(uint32_t array_job_id,
 		    (job_ptr->array_job_id == array_job_id))
 			return job_ptr;
 
-		inx = JOB_HASH_INX(array_job_id);
-		job_ptr = job_array_hash_j[inx];
+		job_ptr = _find_job_array_tasks(array_job_id);
 		while (job_ptr) {
 			if (job_ptr->array_job_id == array_job_id) {
 				match_job_ptr = job_ptr;
@@ -3169,15 +3981,14 @@ extern job_record_t *find_job_array_rec(uint32_t array_job_id,
 		}
 		return match_job_ptr;
 	} else {		/* Find specific task ID */
-		inx = JOB_ARRAY_HASH_INX(array_job_id, array_task_id);
-		job_ptr = job_array_hash_t[inx];
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == array_job_id) &&
-			    (job_ptr->array_task_id == array_task_id)) {
-				return job_ptr;
-			}
-			job_ptr = job_ptr->job_array_next_t;
-		}
+		job_index_slot_t *slot;
+
+		slot = _job_index_find(&job_array_index_t,
+				       _job_array_task_key(array_job_id,
+							   array_task_id));
+		if (slot)
+			return slot->job_ptr;
+
 		/* Look for job record with all of the pending tasks */
 		job_ptr = find_job_record(array_job_id);
 		if (job_ptr && job_ptr->array_recs &&
@@ -3204,12 +4015,7 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
 	job_record_t *het_job_leader, *het_job;
 	ListIterator iter;
 
-	het_job_leader = job_hash[JOB_HASH_INX(job_id)];
-	while (het_job_leader) {
-		if (het_job_leader->job_id == job_id)
-			break;
-		het_job_leader = het_job_leader->job_next;
-	}
+	het_job_leader = find_job_record(job_id);
 	if (!het_job_leader)
 		return NULL;
 	if (het_job_leader->het_job_offset == het_job_id)
@@ -3239,16 +4045,9 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
  */
 extern job_record_t *find_job_record(uint32_t job_id)
 {
-	job_record_t *job_ptr;
+	job_index_slot_t *slot = _job_index_find(&job_index, job_id);
 
-	job_ptr = job_hash[JOB_HASH_INX(job_id)];
-	while (job_ptr) {
-		if (job_ptr->job_id == job_id)
-			return job_ptr;
-		job_ptr = job_ptr->job_next;
-	}
-
-	return NULL;
+	return slot ? slot->job_ptr : NULL;
 }
 
 /* rebuild a job's partition name list based upon the contents of its
@@ -3264,6 +4063,7 @@ static void _rebuild_part_name_list(job_record_t *job_ptr)
 	if (!job_ptr->part_ptr_list) {
 		job_ptr->partition = xstrdup(job_ptr->part_ptr->name);
 		last_job_update = time(NULL);
+		job_delta_stamp(job_ptr);
 		return;
 	}
 
@@ -3288,6 +4088,7 @@ static void _rebuild_part_name_list(job_record_t *job_ptr)
 	}
 	list_iterator_destroy(part_iterator);
 	last_job_update = time(NULL);
+	job_delta_stamp(job_ptr);
 }
 
 /*
@@ -3493,6 +4294,7 @@ extern int kill_job_by_part_name(char *part_name)
 		}
 		if (IS_JOB_RUNNING(job_ptr) || suspended) {
 			kill_job_cnt++;
+			job_delta_stamp(job_ptr);
 			info("Killing %pJ on defunct partition %s",
 			     job_ptr, part_name);
 			job_ptr->job_state = JOB_NODE_FAIL | JOB_COMPLETING;
@@ -3511,6 +4313,7 @@ extern int kill_job_by_part_name(char *part_name)
 						 false);
 		} else if (pending) {
 			kill_job_cnt++;
+			job_delta_stamp(job_ptr);
 			info("Killing %pJ on defunct partition %s",
 			     job_ptr, part_name);
 			job_ptr->job_state	= JOB_CANCELLED;
@@ -3578,6 +4381,7 @@ extern int kill_job_by_front_end_name(char *node_name)
 		}
 		if (IS_JOB_COMPLETING(job_ptr)) {
 			kill_job_cnt++;
+			job_delta_stamp(job_ptr);
 			while ((i = bit_ffs(job_ptr->node_bitmap_cg)) >= 0) {
 				bit_clear(job_ptr->node_bitmap_cg, i);
 				if (job_ptr->node_cnt)
@@ -3600,6 +4404,7 @@ extern int kill_job_by_front_end_name(char *node_name)
 			}
 		} else if (IS_JOB_RUNNING(job_ptr) || suspended) {
 			kill_job_cnt++;
+			job_delta_stamp(job_ptr);
 			if (job_ptr->batch_flag && job_ptr->details &&
 			    slurm_conf.job_requeue &&
 			    (job_ptr->details->requeue > 0)) {
@@ -3834,6 +4639,7 @@ extern int kill_running_job_by_node_name(char *node_name)
 			if (!bit_test(job_ptr->node_bitmap_cg, node_inx))
 				continue;
 			kill_job_cnt++;
+			job_delta_stamp(job_ptr);
 			bit_clear(job_ptr->node_bitmap_cg, node_inx);
 			job_update_tres_cnt(job_ptr, node_inx);
 			if (job_ptr->node_cnt)
@@ -3852,6 +4658,7 @@ extern int kill_running_job_by_node_name(char *node_name)
 			}
 		} else if (IS_JOB_RUNNING(job_ptr) || suspended) {
 			kill_job_cnt++;
+			job_delta_stamp(job_ptr);
 			if ((job_ptr->details) &&
 			    (job_ptr->kill_on_node_fail == 0) &&
 			    (job_ptr->node_cnt > 1) &&
@@ -4268,27 +5075,23 @@ void init_job_conf(void)
 }
 
 /*
- * rehash_jobs - Create or rebuild the job hash table.
+ * rehash_jobs - Create the job hash tables.
  */
 extern void rehash_jobs(void)
 {
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
 
-	if (job_hash == NULL) {
-		hash_table_size = slurm_conf.max_job_cnt;
-		job_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
-		job_array_hash_j = xcalloc(hash_table_size,
-					   sizeof(job_record_t *));
-		job_array_hash_t = xcalloc(hash_table_size,
-					   sizeof(job_record_t *));
-	} else if (hash_table_size < (slurm_conf.max_job_cnt / 2)) {
-		/* If the MaxJobCount grows by too much, the hash table will
-		 * be ineffective without rebuilding. We don't presently bother
-		 * to rebuild the hash table, but cut MaxJobCount back as
-		 * needed. */
-		error ("MaxJobCount reset too high, restart slurmctld");
-		slurm_conf.max_job_cnt = hash_table_size;
+	/*
+	 * The indexes grow incrementally as records are added, so a later
+	 * increase of MaxJobCount needs no rebuild.
+	 */
+	if (!job_index.slots) {
+		_job_index_init(&job_index, "job_id", slurm_conf.max_job_cnt);
+		_job_index_init(&job_array_index_j, "array_job_id",
+				slurm_conf.max_job_cnt);
+		_job_index_init(&job_array_index_t, "array_task_id",
+				slurm_conf.max_job_cnt);
 	}
 }
 
@@ -4390,9 +5193,11 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	memcpy(job_ptr_pend->limit_set.tres, job_ptr->limit_set.tres,
 	       sizeof(uint16_t) * slurmctld_tres_cnt);
 
-	_add_job_hash(job_ptr);		/* Sets job_next */
-	_add_job_hash(job_ptr_pend);	/* Sets job_next */
-	_add_job_array_hash(job_ptr);
+	_add_job_hash(job_ptr);
+	_add_job_hash(job_ptr_pend);
+	_add_job_array_hash(job_ptr);	/* Sets job_array_next_j/prev_j */
+	job_ptr_pend->job_array_next_j = NULL;
+	job_ptr_pend->job_array_prev_j = NULL;
 	job_ptr_pend->job_resrcs = NULL;
 
 	job_ptr_pend->licenses = xstrdup(job_ptr->licenses);
@@ -5050,6 +5855,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	error_code = _select_nodes_parts(job_ptr, no_alloc, NULL, err_msg);
 	if (!test_only) {
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 	}
 
 	if (held_user)
@@ -5173,6 +5979,7 @@ static int _job_fail(job_record_t *job_ptr, uint32_t job_state)
 		} else
 			job_ptr->end_time       = now;
 		last_job_update                 = now;
+		job_delta_stamp(job_ptr);
 		job_ptr->job_state = job_state | JOB_COMPLETING;
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_LAUNCH;
@@ -5252,6 +6059,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 	/* let node select plugin do any state-dependent signaling actions */
 	select_g_job_signal(job_ptr, signal);
 	last_job_update = now;
+	job_delta_stamp(job_ptr);
 
 	/*
 	 * Handle jobs submitted through scrontab.
@@ -5285,6 +6093,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 
 	if (IS_JOB_CONFIGURING(job_ptr) && (signal == SIGKILL)) {
 		last_job_update         = now;
+		job_delta_stamp(job_ptr);
 		job_ptr->end_time       = now;
 		job_ptr->job_state      = JOB_CANCELLED | JOB_COMPLETING;
 		if (flags & KILL_FED_REQUEUE)
@@ -5334,6 +6143,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 		job_term_state = JOB_CANCELLED;
 	if (IS_JOB_SUSPENDED(job_ptr) && (signal == SIGKILL)) {
 		last_job_update         = now;
+		job_delta_stamp(job_ptr);
 		job_ptr->end_time       = job_ptr->suspend_time;
 		job_ptr->tot_sus_time  += difftime(now, job_ptr->suspend_time);
 		job_ptr->job_state      = job_term_state | JOB_COMPLETING;
@@ -5370,6 +6180,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 			job_ptr->time_last_active	= now;
 			job_ptr->end_time		= now;
 			last_job_update			= now;
+			job_delta_stamp(job_ptr);
 			job_ptr->job_state = job_term_state | JOB_COMPLETING;
 			if (flags & KILL_FED_REQUEUE)
 				job_ptr->job_state |= JOB_REQUEUE;
@@ -5589,7 +6400,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 		}
 
 		/* Signal all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = _find_job_array_tasks(job_id);
 		if (!job_ptr && !job_ptr_done) {
 			info("%s(3): invalid JobId=%u", __func__, job_id);
 			return ESLURM_INVALID_JOB_ID;
@@ -5642,7 +6453,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 	/* Find some job record and validate the user signaling the job */
 	job_ptr = find_job_record(job_id);
 	if (job_ptr == NULL) {
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = _find_job_array_tasks(job_id);
 		while (job_ptr) {
 			if (job_ptr->array_job_id == job_id)
 				break;
@@ -5692,6 +6503,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 						       task_id_bitmap);
 			if (!new_task_count) {
 				last_job_update		= now;
+				job_delta_stamp(job_ptr);
 				job_ptr->job_state	= JOB_CANCELLED;
 				job_ptr->start_time	= now;
 				job_ptr->end_time	= now;
@@ -6033,6 +6845,7 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 	}
 
 	last_job_update = now;
+	job_delta_stamp(job_ptr);
 	job_ptr->time_last_active = now;   /* Timer for resending kill RPC */
 	if (job_comp_flag) {	/* job was running */
 		build_cg_bitmap(job_ptr);
@@ -7470,13 +8283,66 @@ extern int validate_job_create_req(job_desc_msg_t * job_desc, uid_t submit_uid,
 	return SLURM_SUCCESS;
 }
 
+/* Remove a staging directory and the files in it */
+static void _remove_stage_dir(char *dir_name)
+{
+	char *file_name;
+
+	file_name = xstrdup_printf("%s/environment", dir_name);
+	(void) unlink(file_name);
+	xfree(file_name);
+	file_name = xstrdup_printf("%s/script", dir_name);
+	(void) unlink(file_name);
+	xfree(file_name);
+	if (rmdir(dir_name))
+		error("rmdir(%s): %m", dir_name);
+}
+
+static void _job_stage_free(void *x)
+{
+	job_stage_t *stage = x;
+
+	xfree(stage->dir_name);
+	xfree(stage);
+}
+
+static int _job_stage_find(void *x, void *key)
+{
+	job_stage_t *stage = x;
+
+	return (stage->job_desc == key);
+}
+
+/*
+ * Remove the record of the files staged for job_desc
+ * RET the staging directory, xfree() it, or NULL if nothing was staged
+ */
+static char *_job_stage_remove(job_desc_msg_t *job_desc)
+{
+	job_stage_t *stage = NULL;
+	char *dir_name = NULL;
+
+	slurm_mutex_lock(&job_stage_mutex);
+	if (job_stage_list)
+		stage = list_remove_first(job_stage_list, _job_stage_find,
+					  job_desc);
+	slurm_mutex_unlock(&job_stage_mutex);
+
+	if (stage) {
+		dir_name = stage->dir_name;
+		stage->dir_name = NULL;
+		_job_stage_free(stage);
+	}
+	return dir_name;
+}
+
 /* _copy_job_desc_to_file - copy the job script and environment from the RPC
  *	structure into a file */
 static int
 _copy_job_desc_to_file(job_desc_msg_t * job_desc, uint32_t job_id)
 {
 	int error_code = 0, hash;
-	char *dir_name, *file_name;
+	char *dir_name, *shared_dir, *stage_dir;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -7497,35 +8363,131 @@ _copy_job_desc_to_file(job_desc_msg_t * job_desc, uint32_t job_id)
 
 	/* Create job_id specific directory */
 	xstrfmtcat(dir_name, "/job.%u", job_id);
+	stage_dir = _job_stage_remove(job_desc);
 	if (mkdir(dir_name, 0700)) {
 		if (!slurmctld_primary && (errno == EEXIST)) {
 			error("Apparent duplicate JobId=%u. Two primary slurmctld daemons might currently be active",
 			      job_id);
 		}
 		error("mkdir(%s) error %m", dir_name);
+		if (stage_dir) {
+			_remove_stage_dir(stage_dir);
+			xfree(stage_dir);
+		}
 		xfree(dir_name);
 		return ESLURM_WRITING_TO_FILE;
 	}
-
-	/* Create environment file, and write data to it */
-	file_name = xstrdup_printf("%s/environment", dir_name);
-	error_code = _write_data_array_to_file(file_name,
-					       job_desc->environment,
-					       job_desc->env_size);
-	xfree(file_name);
-
-	if (error_code == 0) {
-		/* Create script file */
-		file_name = xstrdup_printf("%s/script", dir_name);
-		error_code = write_data_to_file(file_name, job_desc->script);
-		xfree(file_name);
+	if (stage_dir) {
+		/* Replace the new empty directory with the staged files */
+		if (!rename(stage_dir, dir_name)) {
+			xfree(stage_dir);
+			xfree(dir_name);
+			END_TIMER2("_copy_job_desc_to_file");
+			return SLURM_SUCCESS;
+		}
+		debug("%s: rename(%s, %s): %m", __func__, stage_dir, dir_name);
+		_remove_stage_dir(stage_dir);
+		xfree(stage_dir);
 	}
 
+	/* Create environment and script files, and write data to them */
+	shared_dir = xstrdup_printf("%s/job_files",
+				    slurm_conf.state_save_location);
+	error_code = _write_job_desc_files(job_desc, dir_name, shared_dir);
+	xfree(shared_dir);
+
 	xfree(dir_name);
 	END_TIMER2("_copy_job_desc_to_file");
 	return error_code;
 }
 
+extern void stage_job_desc_files(job_desc_msg_t *job_desc)
+{
+	slurmctld_lock_t config_read_lock = { .conf = READ_LOCK };
+	char *dir_name, *shared_dir;
+	int error_code;
+	job_stage_t *stage;
+
+	if (!job_desc->script || !job_desc->environment ||
+	    !job_desc->env_size)
+		return;
+
+	lock_slurmctld(config_read_lock);
+	dir_name = xstrdup_printf("%s/job.stage.%d.XXXXXX",
+				  slurm_conf.state_save_location,
+				  (int) getpid());
+	shared_dir = xstrdup_printf("%s/job_files",
+				    slurm_conf.state_save_location);
+	unlock_slurmctld(config_read_lock);
+
+	if (!mkdtemp(dir_name)) {
+		debug("%s: mkdtemp(%s): %m", __func__, dir_name);
+		xfree(dir_name);
+		xfree(shared_dir);
+		return;
+	}
+
+	error_code = _write_job_desc_files(job_desc, dir_name, shared_dir);
+	xfree(shared_dir);
+
+	if (error_code != SLURM_SUCCESS) {
+		_remove_stage_dir(dir_name);
+		xfree(dir_name);
+		return;
+	}
+
+	stage = xmalloc(sizeof(*stage));
+	stage->job_desc = job_desc;
+	stage->dir_name = dir_name;
+	slurm_mutex_lock(&job_stage_mutex);
+	if (!job_stage_list)
+		job_stage_list = list_create(_job_stage_free);
+	list_append(job_stage_list, stage);
+	slurm_mutex_unlock(&job_stage_mutex);
+}
+
+extern void unstage_job_desc_files(job_desc_msg_t *job_desc)
+{
+	char *dir_name;
+
+	if (!(dir_name = _job_stage_remove(job_desc)))
+		return;
+
+	_remove_stage_dir(dir_name);
+	xfree(dir_name);
+}
+
+/*
+ * Remove directories left by stage_job_desc_files() in an earlier slurmctld
+ * process, those of this process may still be in use.
+ */
+static void _remove_old_stage_dirs(void)
+{
+	char *prefix = xstrdup_printf("job.stage.%d.", (int) getpid());
+	char *dir_name;
+	struct dirent *dir_ent;
+	DIR *f_dir;
+
+	if (!(f_dir = opendir(slurm_conf.state_save_location))) {
+		error("opendir(%s): %m", slurm_conf.state_save_location);
+		xfree(prefix);
+		return;
+	}
+	while ((dir_ent = readdir(f_dir))) {
+		if (xstrncmp(dir_ent->d_name, "job.stage.", 10) ||
+		    !xstrncmp(dir_ent->d_name, prefix, strlen(prefix)))
+			continue;
+		dir_name = xstrdup_printf("%s/%s",
+					  slurm_conf.state_save_location,
+					  dir_ent->d_name);
+		info("Purged staged files %s", dir_name);
+		_remove_stage_dir(dir_name);
+		xfree(dir_name);
+	}
+	closedir(f_dir);
+	xfree(prefix);
+}
+
 /* Return true of the specified job ID already has a batch directory so
  * that a different job ID can be created. This is to help limit damage from
  * split-brain, where two slurmctld daemons are running as primary. */
@@ -7549,48 +8511,30 @@ static bool _dup_job_file_test(uint32_t job_id)
 }
 
 /*
- * Create file with specified name and write the supplied data array to it
- * IN file_name - file to create and write to
- * IN data - array of pointers to strings (e.g. env)
- * IN size - number of elements in data
+ * Create file with specified name and mode and write len bytes of data to it
  */
-static int
-_write_data_array_to_file(char *file_name, char **data, uint32_t size)
+static int _write_file(char *file_name, const char *data, size_t len,
+		       mode_t mode)
 {
-	int fd, i, pos, nwrite, amount;
+	int fd, amount;
+	size_t pos = 0;
 
-	fd = creat(file_name, 0600);
+	fd = creat(file_name, mode);
 	if (fd < 0) {
 		error("Error creating file %s, %m", file_name);
 		return ESLURM_WRITING_TO_FILE;
 	}
 
-	amount = write(fd, &size, sizeof(uint32_t));
-	if (amount < sizeof(uint32_t)) {
-		error("Error writing file %s, %m", file_name);
-		close(fd);
-		return ESLURM_WRITING_TO_FILE;
-	}
-
-	if (data == NULL) {
-		close(fd);
-		return SLURM_SUCCESS;
-	}
-
-	for (i = 0; i < size; i++) {
-		nwrite = strlen(data[i]) + 1;
-		pos = 0;
-		while (nwrite > 0) {
-			amount = write(fd, &data[i][pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m",
-				      file_name);
-				close(fd);
-				return ESLURM_WRITING_TO_FILE;
-			}
-			nwrite -= amount;
-			pos    += amount;
+	while (pos < len) {
+		amount = write(fd, &data[pos], len - pos);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", file_name);
+			close(fd);
+			return ESLURM_WRITING_TO_FILE;
 		}
+		pos += amount;
 	}
 
 	close(fd);
@@ -7604,35 +8548,211 @@ _write_data_array_to_file(char *file_name, char **data, uint32_t size)
  */
 extern int write_data_to_file(char *file_name, char *data)
 {
-	int fd, pos, nwrite, amount;
-
 	if (data == NULL) {
 		(void) unlink(file_name);
 		return SLURM_SUCCESS;
 	}
 
-	fd = creat(file_name, 0700);
-	if (fd < 0) {
-		error("Error creating file %s, %m", file_name);
-		return ESLURM_WRITING_TO_FILE;
+	return _write_file(file_name, data, strlen(data) + 1, 0700);
+}
+
+/*
+ * Return the contents of an environment file: the number of strings followed
+ * by the strings with their terminating NUL, see _read_data_array_from_file().
+ * OUT len - length of the contents
+ * RET contents, must be xfreed
+ */
+static char *_job_env_data(char **data, uint32_t size, size_t *len)
+{
+	char *buffer;
+	size_t pos = sizeof(uint32_t), nwrite;
+	int i;
+
+	for (i = 0; i < size; i++)
+		pos += strlen(data[i]) + 1;
+	buffer = xmalloc_nz(pos);
+	*len = pos;
+
+	memcpy(buffer, &size, sizeof(uint32_t));
+	pos = sizeof(uint32_t);
+	for (i = 0; i < size; i++) {
+		nwrite = strlen(data[i]) + 1;
+		memcpy(&buffer[pos], data[i], nwrite);
+		pos += nwrite;
 	}
 
-	nwrite = strlen(data) + 1;
-	pos = 0;
-	while (nwrite > 0) {
-		amount = write(fd, &data[pos], nwrite);
-		if ((amount < 0) && (errno != EINTR)) {
-			error("Error writing file %s, %m", file_name);
-			close(fd);
-			return ESLURM_WRITING_TO_FILE;
+	return buffer;
+}
+
+/* FNV-1a hash of a job file, used to name shared job files */
+static uint64_t _job_file_hash(const char *data, size_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/* Return true if the file contains exactly the len bytes of data */
+static bool _job_file_match(char *file_name, const char *data, size_t len)
+{
+	char buffer[BUF_SIZE];
+	struct stat sbuf;
+	size_t pos = 0;
+	int fd, amount;
+	bool match = false;
+
+	if ((fd = open(file_name, O_RDONLY | O_CLOEXEC)) < 0)
+		return false;
+
+	if (!fstat(fd, &sbuf) && (sbuf.st_size == len)) {
+		match = true;
+		while (match && (pos < len)) {
+			amount = read(fd, buffer, MIN(sizeof(buffer),
+						      len - pos));
+			if ((amount < 0) && (errno == EINTR))
+				continue;
+			if ((amount <= 0) ||
+			    memcmp(buffer, &data[pos], amount))
+				match = false;
+			pos += amount;
 		}
-		nwrite -= amount;
-		pos    += amount;
 	}
+
 	close(fd);
+	return match;
+}
+
+/*
+ * Write a script or environment file of a job. Jobs with identical files
+ * share one copy: every copy written is also linked into shared_dir under
+ * the hash of its contents, later jobs with the same contents link to that
+ * entry instead of writing their own. The link count of an entry is the
+ * number of jobs using it plus one, purge_shared_job_files() removes entries
+ * no job uses.
+ * IN file_name - file to create
+ * IN shared_dir - the job_files directory of StateSaveLocation
+ * IN kind - file name prefix of the entry in shared_dir
+ * IN data - contents of the file
+ * IN len - length of the contents
+ * IN mode - mode of a newly written file
+ */
+static int _write_job_file(char *file_name, char *shared_dir, char *kind,
+			   const char *data, size_t len, mode_t mode)
+{
+	char *shared_name;
+	int error_code, link_errno;
+
+	shared_name = xstrdup_printf("%s/%s.%016"PRIx64, shared_dir, kind,
+				     _job_file_hash(data, len));
+	if (!link(shared_name, file_name)) {
+		if (_job_file_match(file_name, data, len)) {
+			xfree(shared_name);
+			return SLURM_SUCCESS;
+		}
+		/* Different contents with the same hash, write a copy */
+		(void) unlink(file_name);
+		xfree(shared_name);
+		return _write_file(file_name, data, len, mode);
+	}
+	link_errno = errno;
+
+	if ((error_code = _write_file(file_name, data, len, mode))) {
+		xfree(shared_name);
+		return error_code;
+	}
+
+	/*
+	 * Share this copy if there is no entry or the entry has the maximum
+	 * number of links. Other errors (e.g. no hard link support) leave the
+	 * copy private.
+	 */
+	if (link_errno == EMLINK)
+		(void) unlink(shared_name);
+	if ((link_errno == ENOENT) || (link_errno == EMLINK)) {
+		if (link(file_name, shared_name) && (errno == ENOENT) &&
+		    !mkdir(shared_dir, 0700))
+			(void) link(file_name, shared_name);
+	} else {
+		debug("%s: link(%s, %s): %s", __func__, shared_name, file_name,
+		      strerror(link_errno));
+	}
+
+	xfree(shared_name);
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Write the environment and script files of a batch job into dir_name
+ * IN job_desc - job with the environment and script to write
+ * IN dir_name - existing directory to write the files into
+ * IN shared_dir - the job_files directory of StateSaveLocation
+ */
+static int _write_job_desc_files(job_desc_msg_t *job_desc, char *dir_name,
+				 char *shared_dir)
+{
+	char *file_name, *data;
+	size_t len;
+	int error_code;
+
+	data = _job_env_data(job_desc->environment, job_desc->env_size, &len);
+	file_name = xstrdup_printf("%s/environment", dir_name);
+	error_code = _write_job_file(file_name, shared_dir, "environment",
+				     data, len, 0600);
+	xfree(file_name);
+	xfree(data);
+
+	if ((error_code == SLURM_SUCCESS) && job_desc->script) {
+		file_name = xstrdup_printf("%s/script", dir_name);
+		error_code = _write_job_file(file_name, shared_dir, "script",
+					     job_desc->script,
+					     strlen(job_desc->script) + 1,
+					     0700);
+		xfree(file_name);
+	}
+
+	return error_code;
+}
+
+extern void purge_shared_job_files(void)
+{
+	char *dir_name;
+	struct dirent *dir_ent;
+	struct stat sbuf;
+	DIR *f_dir;
+	int purge_cnt = 0;
+
+	dir_name = xstrdup_printf("%s/job_files",
+				  slurm_conf.state_save_location);
+	if (!(f_dir = opendir(dir_name))) {
+		if (errno != ENOENT)
+			error("opendir(%s): %m", dir_name);
+		xfree(dir_name);
+		return;
+	}
+
+	while ((dir_ent = readdir(f_dir))) {
+		if (fstatat(dirfd(f_dir), dir_ent->d_name, &sbuf,
+			    AT_SYMLINK_NOFOLLOW) ||
+		    !S_ISREG(sbuf.st_mode) || (sbuf.st_nlink > 1))
+			continue;
+		if (unlinkat(dirfd(f_dir), dir_ent->d_name, 0))
+			error("unlink(%s/%s): %m", dir_name, dir_ent->d_name);
+		else
+			purge_cnt++;
+	}
+	closedir(f_dir);
+
+	if (purge_cnt)
+		debug2("%s: removed %d unused files from %s",
+		       __func__, purge_cnt, dir_name);
+	xfree(dir_name);
+}
+
 /*
  * get_job_env - return the environment variables and their count for a
  *	given job
@@ -8566,6 +9686,7 @@ extern void job_config_fini(job_record_t *job_ptr)
 	time_t now = time(NULL);
 
 	last_job_update = now;
+	job_delta_stamp(job_ptr);
 	job_ptr->job_state &= ~JOB_CONFIGURING;
 	if (IS_JOB_POWER_UP_NODE(job_ptr)) {
 		info("Resetting %pJ start time for node power up", job_ptr);
@@ -8733,6 +9854,7 @@ void job_time_limit(void)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			set_job_prio(job_ptr);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 		}
 
 		/* Don't enforce time limits for configuring hetjobs */
@@ -8811,6 +9933,7 @@ void job_time_limit(void)
 				over_run = now - (over_time_limit  * 60);
 			if (job_ptr->end_time <= over_run) {
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 				info("Time limit exhausted for %pJ", job_ptr);
 				_job_timed_out(job_ptr, false);
 				job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8823,6 +9946,7 @@ void job_time_limit(void)
 		    !(job_ptr->resv_ptr->flags & RESERVE_FLAG_FLEX) &&
 		    (job_ptr->resv_ptr->end_time + resv_over_run) < time(NULL)){
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			info("Reservation ended for %pJ", job_ptr);
 			_job_timed_out(job_ptr, false);
 			job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8841,6 +9965,7 @@ void job_time_limit(void)
 
 		if (job_ptr->state_reason == FAIL_TIMEOUT) {
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			_job_timed_out(job_ptr, false);
 			xfree(job_ptr->state_desc);
 			goto time_check;
@@ -9334,6 +10459,8 @@ static void _list_delete_job(void *job_entry)
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
 	_delete_job_common(job_ptr);
+	job_delta_purge(job_ptr);
+	_job_journal_purge(job_ptr);
 
 	if (job_ptr->array_recs) {
 		job_array_size = MAX(1, job_ptr->array_recs->task_cnt);
@@ -9425,7 +10552,7 @@ static void _list_delete_job(void *job_entry)
 		job_count -= job_array_size;
 	}
 	job_ptr->job_id = 0;
-	xfree(job_ptr);
+	slab_free(job_record_pool, job_ptr);
 }
 
 
@@ -9677,10 +10804,8 @@ static int _build_allowed_parts(_foreach_pack_job_info_t *pack_info)
  * NOTE: change _unpack_job_info_msg() in common/slurm_protocol_pack.c
  *	whenever the data format changes
  */
-static buf_t *_pack_init_job_info(uint16_t protocol_version)
+static void _pack_job_info_hdr(buf_t *buffer, uint16_t protocol_version)
 {
-	buf_t *buffer = init_buf(BUF_SIZE);
-
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
@@ -9691,10 +10816,39 @@ static buf_t *_pack_init_job_info(uint16_t protocol_version)
 		pack32(0, buffer);
 		pack_time(time(NULL), buffer);
 	}
+}
+
+static buf_t *_pack_init_job_info(uint16_t protocol_version)
+{
+	buf_t *buffer = init_buf(BUF_SIZE);
+
+	_pack_job_info_hdr(buffer, protocol_version);
 
 	return buffer;
 }
 
+static int _pack_delta_job(void *object, void *arg)
+{
+	job_record_t *job_ptr = (job_record_t *) object;
+	_foreach_pack_job_info_t *pack_info = (_foreach_pack_job_info_t *)arg;
+	uint32_t jobs_packed = *pack_info->jobs_packed;
+
+	if (job_ptr->update_gen <= pack_info->update_gen)
+		return SLURM_SUCCESS;
+
+	(void) _pack_job(job_ptr, pack_info);
+
+	/* The client may have seen it before it was hidden */
+	if (pack_info->update_gen && (*pack_info->jobs_packed == jobs_packed)) {
+		xrecalloc(pack_info->hidden_ids, pack_info->hidden_cnt + 1,
+			  sizeof(uint32_t));
+		pack_info->hidden_ids[pack_info->hidden_cnt++] =
+			job_ptr->job_id;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -9808,6 +10962,96 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	xfree(pack_info.allowed_parts);
 }
 
+/*
+ * pack_delta_jobs - dump the jobs created, modified or purged since the
+ *	job delta generation supplied by the client
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN req - client's job delta epoch, generation and show_flags
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS or SLURM_NO_CHANGE_IN_DATA (buffer not set)
+ * global: job_list - global list of job records
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern int pack_delta_jobs(char **buffer_ptr, int *buffer_size,
+			   job_info_delta_request_msg_t *req, uid_t uid,
+			   uint16_t protocol_version)
+{
+	uint32_t jobs_packed = 0, hdr_offset, tmp_offset;
+	uint32_t purged_cnt = 0, *purged_ids = NULL;
+	uint16_t flags = 0;
+	time_t epoch = req->epoch;
+	uint64_t update_gen = req->update_gen;
+	bool full;
+	_foreach_pack_job_info_t pack_info = {0};
+	buf_t *buffer;
+	assoc_mgr_lock_t locks = { .user = READ_LOCK, .qos = READ_LOCK };
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	if (job_delta_get(last_part_update, &epoch, &update_gen, &full,
+			  &purged_ids, &purged_cnt) == SLURM_NO_CHANGE_IN_DATA)
+		return SLURM_NO_CHANGE_IN_DATA;
+	if (full)
+		flags |= JOB_DELTA_FULL;
+	else
+		pack_info.update_gen = req->update_gen;
+
+	buffer = init_buf(BUF_SIZE);
+	pack_time(epoch, buffer);
+	pack64(update_gen, buffer);
+	pack16(flags, buffer);
+
+	hdr_offset = get_buf_offset(buffer);
+	_pack_job_info_hdr(buffer, protocol_version);
+
+	/* write individual job records */
+	assoc_mgr_lock(&locks);
+	pack_info.buffer           = buffer;
+	pack_info.filter_uid       = NO_VAL;
+	pack_info.jobs_packed      = &jobs_packed;
+	pack_info.protocol_version = protocol_version;
+	pack_info.show_flags       = req->show_flags;
+	pack_info.uid              = uid;
+	pack_info.has_qos_lock = true;
+	pack_info.user_rec.uid = uid;
+	if (!(pack_info.show_flags & SHOW_ALL))
+		_build_allowed_parts(&pack_info);
+
+	assoc_mgr_fill_in_user(acct_db_conn, &pack_info.user_rec,
+			       accounting_enforce, NULL, true);
+	pack_info.privileged = validate_operator_user_rec(&pack_info.user_rec);
+	list_for_each(job_list, _pack_delta_job, &pack_info);
+	assoc_mgr_unlock(&locks);
+
+	/* jobs the client may have seen before they were hidden */
+	if (pack_info.hidden_cnt) {
+		xrecalloc(purged_ids, purged_cnt + pack_info.hidden_cnt,
+			  sizeof(uint32_t));
+		memcpy(purged_ids + purged_cnt, pack_info.hidden_ids,
+		       pack_info.hidden_cnt * sizeof(uint32_t));
+		purged_cnt += pack_info.hidden_cnt;
+	}
+
+	/* put the real record count in the job info header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, hdr_offset);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	pack32_array(purged_ids, purged_cnt, buffer);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+	xfree(pack_info.allowed_parts);
+	xfree(pack_info.hidden_ids);
+	xfree(purged_ids);
+
+	return SLURM_SUCCESS;
+}
+
 static int _pack_het_job(job_record_t *job_ptr, uint16_t show_flags,
 			 buf_t *buffer, uint16_t protocol_version, uid_t uid)
 {
@@ -9897,7 +11141,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			}
 		}
 
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = _find_job_array_tasks(job_id);
 		while (job_ptr) {
 			if ((job_ptr->job_id == job_id) && packed_head) {
 				;	/* Already packed */
@@ -11047,6 +12291,7 @@ extern void unlink_job_record(job_record_t *job_ptr)
 	*job_id = job_ptr->job_id;
 	list_enqueue(purge_files_list, job_id);
 
+	job_delta_purge(job_ptr);
 	job_ptr->job_id = NO_VAL;
 
 	last_job_update = time(NULL);
@@ -11218,6 +12463,7 @@ void reset_job_bitmaps(void)
 			error("select_g_select_nodeinfo_set(%pJ): %m",
 			      job_ptr);
 		}
+		job_delta_stamp(job_ptr);
 	}
 	list_iterator_destroy(job_iterator);
 
@@ -11806,6 +13052,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 		    (job_specs->burst_buffer[0] == '\0')) {
 			xfree(job_ptr->burst_buffer);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 		} else {
 			error_code = ESLURM_NOT_SUPPORTED;
 		}
@@ -11906,6 +13153,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 	if (detail_ptr)
 		mc_ptr = detail_ptr->mc_ptr;
 	last_job_update = now;
+	job_delta_stamp(job_ptr);
 
 	/*
 	 * Check to see if the new requested job_specs exceeds any
@@ -14230,7 +15478,7 @@ extern int update_job_str(slurm_msg_t *msg, uid_t uid)
 		}
 
 		/* Update all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = _find_job_array_tasks(job_id);
 		if (!job_ptr && !job_ptr_done) {
 			info("%s: invalid JobId=%u", __func__, job_id);
 			rc = ESLURM_INVALID_JOB_ID;
@@ -15058,6 +16306,7 @@ extern int job_alloc_info_ptr(uint32_t uid, job_record_t *job_ptr)
 	    (prolog == 0) && job_ptr->node_bitmap &&
 	    (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
 		last_job_update = time(NULL);
+		job_delta_stamp(job_ptr);
 		set_job_alias_list(job_ptr);
 	}
 
@@ -15104,6 +16353,8 @@ int sync_job_files(void)
 	_validate_job_files(batch_dirs);
 	_remove_defunct_batch_dirs(batch_dirs);
 	FREE_NULL_LIST(batch_dirs);
+	_remove_old_stage_dirs();
+	purge_shared_job_files();
 	return SLURM_SUCCESS;
 }
 
@@ -15208,7 +16459,7 @@ static void _validate_job_files(List batch_dirs)
 		}
 		if (job_ptr && job_ptr->array_recs) { /* Update all tasks */
 			array_job_id = job_ptr->array_job_id;
-			job_ptr = job_array_hash_j[JOB_HASH_INX(array_job_id)];
+			job_ptr = _find_job_array_tasks(array_job_id);
 			while (job_ptr) {
 				if (job_ptr->array_job_id == array_job_id)
 					job_ptr->bit_flags |= HAS_STATE_DIR;
@@ -15608,10 +16859,19 @@ void batch_requeue_fini(job_record_t *job_ptr)
 void job_fini (void)
 {
 	FREE_NULL_LIST(job_list);
-	xfree(job_hash);
-	xfree(job_array_hash_j);
-	xfree(job_array_hash_t);
+	step_pool_fini();
+	slab_pool_destroy(job_record_pool);
+	job_record_pool = NULL;
+	slab_pool_destroy(job_details_pool);
+	job_details_pool = NULL;
+	_job_index_fini(&job_index);
+	_job_index_fini(&job_array_index_j);
+	_job_index_fini(&job_array_index_t);
+	job_delta_fini();
 	FREE_NULL_LIST(purge_files_list);
+	slurm_mutex_lock(&job_stage_mutex);
+	FREE_NULL_LIST(job_stage_list);
+	slurm_mutex_unlock(&job_stage_mutex);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
 }
@@ -15932,6 +17192,7 @@ extern int job_node_ready(uint32_t job_id, int *ready)
 	    job_ptr->node_bitmap &&
 	    (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
 		last_job_update = time(NULL);
+		job_delta_stamp(job_ptr);
 		set_job_alias_list(job_ptr);
 	}
 
@@ -16184,6 +17445,7 @@ static int _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp)
 		}
 	}
 	last_job_update = last_node_update = now;
+	job_delta_stamp(job_ptr);
 	return rc;
 }
 
@@ -16244,6 +17506,7 @@ static int _resume_job_nodes(job_record_t *job_ptr, bool indf_susp)
 		node_ptr->node_state = NODE_STATE_ALLOCATED | node_flags;
 	}
 	last_job_update = last_node_update = time(NULL);
+	job_delta_stamp(job_ptr);
 	return rc;
 }
 
@@ -16567,7 +17830,7 @@ extern int job_suspend2(suspend_msg_t *sus_ptr, uid_t uid,
 		}
 
 		/* Suspend all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = _find_job_array_tasks(job_id);
 		if (!job_ptr && !job_ptr_done) {
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
@@ -16728,6 +17991,7 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 	}
 
 	last_job_update = now;
+	job_delta_stamp(job_ptr);
 
 	/*
 	 * In the job is in the process of completing
@@ -17032,7 +18296,7 @@ extern int job_requeue2(uid_t uid, requeue_msg_t *req_ptr, slurm_msg_t *msg,
 		}
 
 		/* Requeue all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
+		job_ptr = _find_job_array_tasks(job_id);
 		if (!job_ptr && !job_ptr_done) {
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
@@ -17248,6 +18512,7 @@ static int _set_top(List top_job_list, uid_t uid)
 		job_ptr->priority = next_prio;
 		job_ptr->details->nice -= delta_nice;
 		job_ptr->bit_flags &= (~TOP_PRIO_TMP);
+		job_delta_stamp(job_ptr);
 	}
 	list_iterator_destroy(iter);
 	FREE_NULL_LIST(prio_list);
@@ -17266,6 +18531,7 @@ static int _set_top(List top_job_list, uid_t uid)
 			job_ptr->priority = next_prio;
 			job_ptr->details->nice += delta_nice;
 			job_ptr->bit_flags &= (~TOP_PRIO_TMP);
+			job_delta_stamp(job_ptr);
 			total_delta -= delta_nice;
 			if (--other_job_cnt == 0)
 				break;	/* Count will match list size anyway */
@@ -17552,6 +18818,7 @@ extern int update_job_wckey(char *module, job_record_t *job_ptr,
 	}
 
 	last_job_update = time(NULL);
+	job_delta_stamp(job_ptr);
 
 	return SLURM_SUCCESS;
 }
@@ -18115,6 +19382,7 @@ static void _kill_dependent(job_record_t *job_ptr)
 	job_ptr->end_time = now;
 	job_completion_logger(job_ptr, false);
 	last_job_update = now;
+	job_delta_stamp(job_ptr);
 	srun_allocate_abort(job_ptr);
 }
 
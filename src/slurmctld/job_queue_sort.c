@@ -0,0 +1,222 @@
+/*****************************************************************************\
+ * job_queue_sort.c - sort job queue records by precomputed keys
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <string.h>
+
+#include "src/common/xmalloc.h"
+#include "src/slurmctld/job_queue_sort.h"
+
+/*
+ * Sort keys copied out of the job, details and partition records, so that
+ * compares touch one small array rather than three records per job.
+ */
+typedef struct {
+	bool has_resv;
+	uint16_t priority_tier;
+	uint32_t priority;
+	time_t submit_time;
+	uint32_t job_id;
+	uint32_t array_task_id;
+	job_queue_rec_t *rec;
+} sort_key_t;
+
+static void _set_key(sort_key_t *key, job_queue_rec_t *rec)
+{
+	job_record_t *job_ptr = rec->job_ptr;
+
+	key->rec = rec;
+	key->has_resv = (job_ptr->resv_id != 0) || rec->resv_ptr;
+	key->priority_tier = rec->part_ptr ? rec->part_ptr->priority_tier : 0;
+	if (job_ptr->part_ptr_list && job_ptr->priority_array)
+		key->priority = rec->priority;
+	else
+		key->priority = job_ptr->priority;
+	key->submit_time = job_ptr->details ?
+			   job_ptr->details->submit_time : 0;
+	if (rec->array_task_id == NO_VAL)
+		key->job_id = rec->job_id;
+	else
+		key->job_id = job_ptr->array_job_id;
+	key->array_task_id = rec->array_task_id;
+}
+
+/* Return true if key1 belongs after key2 in the queue */
+static bool _after(sort_key_t *key1, sort_key_t *key2)
+{
+	if (key1->has_resv != key2->has_resv)
+		return key2->has_resv;
+	if (key1->priority_tier != key2->priority_tier)
+		return (key1->priority_tier < key2->priority_tier);
+	if (key1->priority != key2->priority)
+		return (key1->priority < key2->priority);
+	if (key1->submit_time != key2->submit_time)
+		return (key1->submit_time > key2->submit_time);
+	if (key1->job_id != key2->job_id)
+		return (key1->job_id > key2->job_id);
+	return (key1->array_task_id > key2->array_task_id);
+}
+
+/* Merge the ordered arrays a and b into dst */
+static void _merge(sort_key_t *a, int a_cnt, sort_key_t *b, int b_cnt,
+		   sort_key_t *dst)
+{
+	int i = 0, j = 0, k = 0;
+
+	if (a_cnt && b_cnt && _after(&a[a_cnt - 1], &b[0])) {
+		while ((i < a_cnt) && (j < b_cnt)) {
+			if (_after(&a[i], &b[j]))
+				dst[k++] = b[j++];
+			else
+				dst[k++] = a[i++];
+		}
+	}
+	if (i < a_cnt) {
+		memcpy(&dst[k], &a[i], (a_cnt - i) * sizeof(sort_key_t));
+		k += a_cnt - i;
+	}
+	if (j < b_cnt)
+		memcpy(&dst[k], &b[j], (b_cnt - j) * sizeof(sort_key_t));
+}
+
+/*
+ * Natural merge sort: find the runs already in order, then merge them
+ * pairwise. tmp must have room for key_cnt keys.
+ * RET the array holding the sorted keys, either keys or tmp
+ */
+static sort_key_t *_sort_keys(sort_key_t *keys, sort_key_t *tmp, int key_cnt)
+{
+	sort_key_t *swap;
+	int i, r, run_cnt = 0, *runs;
+
+	runs = xcalloc(key_cnt + 1, sizeof(int));
+	runs[run_cnt++] = 0;
+	for (i = 1; i < key_cnt; i++) {
+		if (_after(&keys[i - 1], &keys[i]))
+			runs[run_cnt++] = i;
+	}
+	runs[run_cnt] = key_cnt;
+
+	while (run_cnt > 1) {
+		for (r = 0, i = 0; r < run_cnt; r += 2, i++) {
+			int lo = runs[r], mid = runs[r + 1];
+			int hi = ((r + 1) < run_cnt) ? runs[r + 2] : mid;
+
+			_merge(&keys[lo], (mid - lo), &keys[mid], (hi - mid),
+			       &tmp[lo]);
+			runs[i] = lo;
+		}
+		runs[i] = key_cnt;
+		run_cnt = i;
+		swap = keys;
+		keys = tmp;
+		tmp = swap;
+	}
+	xfree(runs);
+
+	return keys;
+}
+
+extern void job_queue_sort_recs(job_queue_rec_t **recs, int rec_cnt)
+{
+	sort_key_t *keys, *kept, *moved, *sorted;
+	uint32_t max_rank = 0, *offset;
+	int i, r, kept_cnt = 0, moved_cnt = 0;
+
+	if (rec_cnt < 1)
+		return;
+
+	/* Place records in the order of the last sort, new jobs last */
+	for (i = 0; i < rec_cnt; i++)
+		max_rank = MAX(max_rank, recs[i]->job_ptr->queue_rank);
+	offset = xcalloc(max_rank + 2, sizeof(uint32_t));
+	for (i = 0; i < rec_cnt; i++) {
+		r = recs[i]->job_ptr->queue_rank;
+		offset[(r ? r : (max_rank + 1)) - 1]++;
+	}
+	for (i = 0, r = 0; i <= max_rank; i++) {
+		uint32_t cnt = offset[i];
+		offset[i] = r;
+		r += cnt;
+	}
+	keys = xcalloc(rec_cnt, sizeof(sort_key_t));
+	for (i = 0; i < rec_cnt; i++) {
+		r = recs[i]->job_ptr->queue_rank;
+		_set_key(&keys[offset[(r ? r : (max_rank + 1)) - 1]++],
+			 recs[i]);
+	}
+	xfree(offset);
+
+	/*
+	 * Set aside records out of order with a neighbour: new jobs and jobs
+	 * whose priority changed. If a record fits between the last two kept,
+	 * the last kept one was out of place instead. The rest stay in order.
+	 */
+	kept = xcalloc(rec_cnt, sizeof(sort_key_t));
+	moved = xcalloc(rec_cnt, sizeof(sort_key_t));
+	for (i = 0; i < rec_cnt; i++) {
+		bool before_next = ((i + 1) == rec_cnt) ||
+				   !_after(&keys[i], &keys[i + 1]);
+
+		if (kept_cnt && _after(&kept[kept_cnt - 1], &keys[i]) &&
+		    before_next && ((kept_cnt == 1) ||
+				    !_after(&kept[kept_cnt - 2], &keys[i])))
+			moved[moved_cnt++] = kept[--kept_cnt];
+		if ((kept_cnt && _after(&kept[kept_cnt - 1], &keys[i])) ||
+		    !before_next)
+			moved[moved_cnt++] = keys[i];
+		else
+			kept[kept_cnt++] = keys[i];
+	}
+
+	if (moved_cnt > (rec_cnt / 4)) {
+		/* Too much changed, sort everything */
+		sorted = _sort_keys(keys, kept, rec_cnt);
+	} else {
+		sorted = _sort_keys(moved, keys, moved_cnt);
+		_merge(kept, kept_cnt, sorted, moved_cnt,
+		       (sorted == keys) ? moved : keys);
+		sorted = (sorted == keys) ? moved : keys;
+	}
+
+	/* A job in several partitions keeps the rank of its first record */
+	for (i = rec_cnt - 1; i >= 0; i--) {
+		recs[i] = sorted[i].rec;
+		recs[i]->job_ptr->queue_rank = i + 1;
+	}
+
+	xfree(keys);
+	xfree(kept);
+	xfree(moved);
+}
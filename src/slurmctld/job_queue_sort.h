@@ -0,0 +1,59 @@
+/*****************************************************************************\
+ * job_queue_sort.h - sort job queue records by precomputed keys
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _JOB_QUEUE_SORT_H_
+#define _JOB_QUEUE_SORT_H_
+
+#include "src/slurmctld/job_scheduler.h"
+
+/*
+ * Sort job queue records in the same order as sort_job_queue2() without
+ * preemption or bf_hetjob_prio: jobs that can use a reservation first, then
+ * by decreasing partition priority tier, decreasing priority, increasing
+ * submit time, job ID and array task ID.
+ *
+ * The records are first put back in the order of the previous sort, using
+ * each job's queue_rank. Records now out of order with their neighbours (new
+ * jobs, jobs whose priority changed and the other partitions of multiple
+ * partition jobs) are set aside, sorted and merged back in. Between passes
+ * that is a small part of the queue, so a sort costs little more than a few
+ * compares per record. queue_rank is updated for the next sort.
+ *
+ * IN/OUT recs - array of job queue records to sort
+ * IN rec_cnt - number of records
+ */
+extern void job_queue_sort_recs(job_queue_rec_t **recs, int rec_cnt);
+
+#endif /* !_JOB_QUEUE_SORT_H_ */
@@ -82,6 +82,7 @@
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/gres_ctld.h"
 #include "src/slurmctld/locks.h"
+#include "src/slurmctld/job_queue_sort.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
@@ -314,6 +315,7 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 		job_ptr->state_reason = WAIT_NO_REASON;
 		xfree(job_ptr->state_desc);
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 	}
 #endif
 
@@ -330,6 +332,7 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 			job_ptr->state_reason = WAIT_HELD;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 		}
 		sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 			     job_ptr,
@@ -595,6 +598,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 				job_ptr->state_reason_prev_db =
 					job_ptr->state_reason;
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 		}
 		if (!_job_runnable_test1(job_ptr, clear_start))
 			continue;
@@ -611,6 +615,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 					job_ptr->state_reason = reason;
 					xfree(job_ptr->state_desc);
 					last_job_update = now;
+					job_delta_stamp(job_ptr);
 				}
 				/* priority_array index matches part_ptr_list
 				 * position: increment inx */
@@ -913,6 +918,7 @@ extern bool deadline_ok(job_record_t *job_ptr, char *func)
 	}
 	if (fail_job) {
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		job_ptr->job_state = JOB_DEADLINE;
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_DEADLINE;
@@ -1376,6 +1382,7 @@ static int _schedule(bool full_queue)
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 				continue;
 			}
 			if (!_job_runnable_test1(job_ptr, false))
@@ -1422,6 +1429,7 @@ next_part:
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 				continue;
 			}
 			if ((job_ptr->array_task_id != array_task_id) &&
@@ -1576,6 +1584,7 @@ next_task:
 					     job_ptr->priority);
 			}
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 
 			continue;
 		} else if (wait_on_resv &&
@@ -1604,11 +1613,13 @@ next_task:
 				sched_debug("%pJ has invalid QOS", job_ptr);
 				job_fail_qos(job_ptr, __func__);
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_delta_stamp(job_ptr);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -1666,6 +1677,7 @@ next_task:
 			xfree(job_ptr->state_desc);
 			job_ptr->state_desc = xstrdup("Nodes required for job are DOWN, DRAINED or reserved for jobs in higher priority partitions");
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1679,6 +1691,7 @@ next_task:
 			job_ptr->state_reason = WAIT_LICENSES;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1696,6 +1709,7 @@ next_task:
 			 * very rare. */
 			sched_info("%pJ has invalid account", job_ptr);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			job_ptr->state_reason = FAIL_ACCOUNT;
 			xfree(job_ptr->state_desc);
 			continue;
@@ -1779,6 +1793,7 @@ skip_start:
 			job_ptr->state_reason = WAIT_FED_JOB_LOCK;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1789,6 +1804,7 @@ skip_start:
 			/* job initiated */
 			sched_debug3("%pJ initiated", job_ptr);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 
 			/* Clear assumed rejected array status */
 			reject_array_job = NULL;
@@ -1834,6 +1850,7 @@ skip_start:
 			sched_info("schedule: %pJ non-runnable: %s",
 				   job_ptr, slurm_strerror(error_code));
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			job_ptr->job_state = JOB_PENDING;
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 			xfree(job_ptr->state_desc);
@@ -1946,7 +1963,24 @@ out:
  */
 extern void sort_job_queue(List job_queue)
 {
-	list_sort(job_queue, sort_job_queue2);
+	job_queue_rec_t **recs;
+	int i, rec_cnt;
+
+	/* Preemption and bf_hetjob_prio order jobs pairwise, not by key */
+	if (bf_hetjob_prio || slurm_preemption_enabled()) {
+		list_sort(job_queue, sort_job_queue2);
+		return;
+	}
+
+	if ((rec_cnt = list_count(job_queue)) < 2)
+		return;
+	recs = xcalloc(rec_cnt, sizeof(job_queue_rec_t *));
+	for (i = 0; i < rec_cnt; i++)
+		recs[i] = list_pop(job_queue);
+	job_queue_sort_recs(recs, rec_cnt);
+	for (i = 0; i < rec_cnt; i++)
+		list_append(job_queue, recs[i]);
+	xfree(recs);
 }
 
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
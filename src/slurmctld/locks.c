@@ -39,14 +39,48 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
 
+#define LOCK_STATS_TABLE_SIZE 2048	/* power of 2 */
+#define LOCK_TYPES 5
+
+typedef struct {
+	const char *key;	/* caller's __func__, NULL if unused */
+	lock_stats_t stats;
+} lock_stats_rec_t;
+
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static pthread_mutex_t lock_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool lock_stats_enabled = false;
+static lock_stats_rec_t *lock_stats_table = NULL;
+static uint32_t lock_stats_used = 0;
+static const uint32_t lock_stats_usec[LOCK_STATS_BUCKETS] = {
+	10, 100, 1000, 10000, 100000, 1000000, NO_VAL };
+
+/*
+ * Function which took each lock now held by this thread, NULL if lock
+ * statistics were not being recorded at the time. Kept per lock type as
+ * callers may take further locks while holding others.
+ */
+static __thread const char *lock_caller[LOCK_TYPES];
+static __thread struct timeval lock_taken[LOCK_TYPES];
+static __thread uint32_t lock_wait[LOCK_TYPES];
+
+/*
+ * Advanced each time a write lock is taken, so a reader can tell whether the
+ * data behind a lock may have changed since it last looked
+ */
+static uint64_t lock_gen[LOCK_TYPES];
+
 static pthread_rwlock_t slurmctld_locks[5] = {
 	PTHREAD_RWLOCK_INITIALIZER,
 	PTHREAD_RWLOCK_INITIALIZER,
@@ -108,35 +142,143 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level)
 }
 #endif
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld(slurmctld_lock_t lock_levels)
+static uint32_t _delta_usec(struct timeval *start, struct timeval *end)
 {
-	xassert(_store_locks(lock_levels));
+	int64_t usec = ((int64_t) (end->tv_sec - start->tv_sec) * 1000000) +
+		       (end->tv_usec - start->tv_usec);
+
+	if (usec < 0)
+		return 0;
+	if (usec >= NO_VAL)
+		return NO_VAL - 1;
+	return usec;
+}
 
-	if (lock_levels.conf == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[CONF_LOCK]);
-	else if (lock_levels.conf == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[CONF_LOCK]);
+static int _lock_stats_bucket(uint32_t usec)
+{
+	int i;
+
+	for (i = 0; i < (LOCK_STATS_BUCKETS - 1); i++) {
+		if (usec < lock_stats_usec[i])
+			break;
+	}
 
-	if (lock_levels.job == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[JOB_LOCK]);
-	else if (lock_levels.job == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[JOB_LOCK]);
+	return i;
+}
+
+/*
+ * Find or add the record of caller taking the lock type at level.
+ * lock_stats_mutex must be locked.
+ * RET record or NULL if the table is full
+ */
+static lock_stats_t *_lock_stats_find(const char *caller,
+				      lock_datatype_t type, lock_level_t level)
+{
+	uint64_t hash = ((uintptr_t) caller) + (type * 2) + level;
+	uint32_t inx;
+	lock_stats_rec_t *rec;
+
+	hash *= 0x9e3779b97f4a7c15ULL;
+	for (inx = hash >> 53; ; inx = (inx + 1) % LOCK_STATS_TABLE_SIZE) {
+		rec = &lock_stats_table[inx];
+		if (!rec->key)
+			break;
+		if ((rec->key == caller) && (rec->stats.type == type) &&
+		    (rec->stats.level == level))
+			return &rec->stats;
+	}
+
+	/* Keep the table sparse enough for short probes */
+	if (lock_stats_used >= ((LOCK_STATS_TABLE_SIZE * 3) / 4))
+		return NULL;
+	lock_stats_used++;
+	rec->key = caller;
+	rec->stats.caller = xstrdup(caller);
+	rec->stats.type = type;
+	rec->stats.level = level;
+
+	return &rec->stats;
+}
+
+/* Take one lock, noting how long we waited for it if recording statistics */
+static void _lock(lock_datatype_t type, lock_level_t level,
+		  const char *caller)
+{
+	struct timeval start;
+
+	if (level == NO_LOCK)
+		return;
+
+	if (caller)
+		gettimeofday(&start, NULL);
+
+	if (level == READ_LOCK)
+		slurm_rwlock_rdlock(&slurmctld_locks[type]);
+	else if (level == WRITE_LOCK) {
+		slurm_rwlock_wrlock(&slurmctld_locks[type]);
+		__atomic_fetch_add(&lock_gen[type], 1, __ATOMIC_RELAXED);
+	}
+
+	lock_caller[type] = caller;
+	if (caller) {
+		gettimeofday(&lock_taken[type], NULL);
+		lock_wait[type] = _delta_usec(&start, &lock_taken[type]);
+	}
+}
+
+/* Record the wait and hold times of the locks about to be released */
+static void _lock_stats_record(slurmctld_lock_t lock_levels)
+{
+	lock_level_t *levels = (lock_level_t *) &lock_levels;
+	struct timeval now;
+	lock_stats_t *stats;
+	uint32_t hold;
+	bool found = false;
+
+	for (int i = 0; i < LOCK_TYPES; i++) {
+		if ((levels[i] != NO_LOCK) && lock_caller[i]) {
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+		return;
+
+	gettimeofday(&now, NULL);
+
+	slurm_mutex_lock(&lock_stats_mutex);
+	for (int i = 0; i < LOCK_TYPES; i++) {
+		if ((levels[i] == NO_LOCK) || !lock_caller[i])
+			continue;
+		stats = _lock_stats_find(lock_caller[i], i, levels[i]);
+		lock_caller[i] = NULL;
+		if (!stats)
+			continue;
+		hold = _delta_usec(&lock_taken[i], &now);
+		stats->cnt++;
+		stats->wait_usec += lock_wait[i];
+		stats->hold_usec += hold;
+		stats->wait_cnt[_lock_stats_bucket(lock_wait[i])]++;
+		stats->hold_cnt[_lock_stats_bucket(hold)]++;
+	}
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
 
-	if (lock_levels.node == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[NODE_LOCK]);
-	else if (lock_levels.node == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[NODE_LOCK]);
+/* lock_slurmctld - Issue the required lock requests in a well defined order */
+extern void lock_slurmctld_caller(slurmctld_lock_t lock_levels,
+				  const char *caller)
+{
+	xassert(_store_locks(lock_levels));
 
-	if (lock_levels.part == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[PART_LOCK]);
-	else if (lock_levels.part == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[PART_LOCK]);
+	/* Unlocked read, a change only matters to later lock requests */
+	if (!lock_stats_enabled)
+		caller = NULL;
 
-	if (lock_levels.fed == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[FED_LOCK]);
-	else if (lock_levels.fed == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[FED_LOCK]);
+	_lock(CONF_LOCK, lock_levels.conf, caller);
+	_lock(JOB_LOCK, lock_levels.job, caller);
+	_lock(NODE_LOCK, lock_levels.node, caller);
+	_lock(PART_LOCK, lock_levels.part, caller);
+	_lock(FED_LOCK, lock_levels.fed, caller);
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
@@ -145,6 +287,8 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 {
 	xassert(_clear_locks(lock_levels));
 
+	_lock_stats_record(lock_levels);
+
 	if (lock_levels.fed)
 		slurm_rwlock_unlock(&slurmctld_locks[FED_LOCK]);
 
@@ -161,6 +305,27 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 		slurm_rwlock_unlock(&slurmctld_locks[CONF_LOCK]);
 }
 
+extern uint64_t lock_write_gen(lock_datatype_t datatype)
+{
+	return __atomic_load_n(&lock_gen[datatype], __ATOMIC_RELAXED);
+}
+
+/*
+ * borrow_slurmctld_locks - Run a helper thread under locks held by the thread
+ *	which handed it work, which must not release them until the helper
+ *	calls return_slurmctld_locks(). Nothing is locked, only the lock
+ *	checks of development builds are satisfied.
+ */
+extern void borrow_slurmctld_locks(slurmctld_lock_t lock_levels)
+{
+	xassert(_store_locks(lock_levels));
+}
+
+extern void return_slurmctld_locks(slurmctld_lock_t lock_levels)
+{
+	xassert(_clear_locks(lock_levels));
+}
+
 /*
  * _report_lock_set - report whether the read or write lock is set
  */
@@ -205,6 +370,80 @@ int report_locks_set(void)
 }
 
 
+extern void lock_stats_config(void)
+{
+	bool enable = xstrcasestr(slurm_conf.slurmctld_params, "lock_stats");
+
+	slurm_mutex_lock(&lock_stats_mutex);
+	/* Kept once allocated, threads may still record into it */
+	if (enable && !lock_stats_table)
+		lock_stats_table = xcalloc(LOCK_STATS_TABLE_SIZE,
+					   sizeof(*lock_stats_table));
+	lock_stats_enabled = enable;
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
+
+static int _lock_stats_sort(const void *x, const void *y)
+{
+	const lock_stats_t *stats1 = x;
+	const lock_stats_t *stats2 = y;
+
+	if (stats1->wait_usec > stats2->wait_usec)
+		return -1;
+	if (stats1->wait_usec < stats2->wait_usec)
+		return 1;
+	return 0;
+}
+
+extern uint32_t lock_stats_get(lock_stats_t **stats, uint32_t *bucket_usec)
+{
+	uint32_t cnt = 0;
+
+	memcpy(bucket_usec, lock_stats_usec, sizeof(lock_stats_usec));
+	*stats = NULL;
+
+	slurm_mutex_lock(&lock_stats_mutex);
+	if (lock_stats_used)
+		*stats = xcalloc(lock_stats_used, sizeof(lock_stats_t));
+	for (int i = 0; lock_stats_table && (i < LOCK_STATS_TABLE_SIZE); i++) {
+		lock_stats_t *rec = &lock_stats_table[i].stats;
+
+		if (!lock_stats_table[i].key || !rec->cnt)
+			continue;
+		(*stats)[cnt] = *rec;
+		(*stats)[cnt].caller = xstrdup(rec->caller);
+		cnt++;
+	}
+	slurm_mutex_unlock(&lock_stats_mutex);
+
+	if (cnt)
+		qsort(*stats, cnt, sizeof(lock_stats_t), _lock_stats_sort);
+
+	return cnt;
+}
+
+extern void lock_stats_free(lock_stats_t *stats, uint32_t cnt)
+{
+	for (int i = 0; i < cnt; i++)
+		xfree(stats[i].caller);
+	xfree(stats);
+}
+
+extern void lock_stats_reset(void)
+{
+	slurm_mutex_lock(&lock_stats_mutex);
+	for (int i = 0; lock_stats_table && (i < LOCK_STATS_TABLE_SIZE); i++) {
+		lock_stats_t *rec = &lock_stats_table[i].stats;
+
+		rec->cnt = 0;
+		rec->wait_usec = 0;
+		rec->hold_usec = 0;
+		memset(rec->wait_cnt, 0, sizeof(rec->wait_cnt));
+		memset(rec->hold_cnt, 0, sizeof(rec->hold_cnt));
+	}
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files(void)
 {
@@ -92,6 +92,7 @@
 #define _SLURMCTLD_LOCKS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /* levels of locking required for each data structure */
 typedef enum {
@@ -117,19 +118,76 @@ typedef enum {
 	FED_LOCK,
 }	lock_datatype_t;
 
+#define LOCK_STATS_BUCKETS 7
+
+/*
+ * Wait and hold times of one lock type at one level, taken by one function.
+ * Recorded with SlurmctldParameters=lock_stats.
+ */
+typedef struct {
+	char *caller;		/* function which called lock_slurmctld() */
+	lock_datatype_t type;
+	lock_level_t level;
+	uint32_t cnt;		/* times the lock was taken */
+	uint64_t wait_usec;	/* total time waiting for the lock */
+	uint64_t hold_usec;	/* total time the lock was held */
+	uint32_t wait_cnt[LOCK_STATS_BUCKETS];	/* wait time histogram */
+	uint32_t hold_cnt[LOCK_STATS_BUCKETS];	/* hold time histogram */
+} lock_stats_t;
+
 #ifndef NDEBUG
 extern bool verify_lock(lock_datatype_t datatype, lock_level_t level);
 #endif
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld (slurmctld_lock_t lock_levels);
+/*
+ * lock_slurmctld - Issue the required lock requests in a well defined order.
+ *	With SlurmctldParameters=lock_stats, the time spent waiting for and
+ *	holding each lock is recorded for the calling function.
+ */
+#define lock_slurmctld(lock_levels) \
+	lock_slurmctld_caller(lock_levels, __func__)
+extern void lock_slurmctld_caller(slurmctld_lock_t lock_levels,
+				  const char *caller);
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
 extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
+/*
+ * lock_write_gen - Generation of the data protected by a lock type, advanced
+ *	each time a write lock on it is taken. Unchanged between two calls
+ *	means nothing could have modified the data in between. Does not need
+ *	any locks.
+ */
+extern uint64_t lock_write_gen(lock_datatype_t datatype);
+
+/*
+ * borrow_slurmctld_locks - Run a helper thread under locks held by the thread
+ *	which handed it work, which must keep them until the helper calls
+ *	return_slurmctld_locks(). Nothing is locked or unlocked.
+ */
+extern void borrow_slurmctld_locks(slurmctld_lock_t lock_levels);
+extern void return_slurmctld_locks(slurmctld_lock_t lock_levels);
+
 extern int report_locks_set(void);
 
+/* Start or stop recording lock statistics as set by SlurmctldParameters */
+extern void lock_stats_config(void);
+
+/*
+ * Get the lock statistics recorded, in order of decreasing total wait time
+ * OUT stats - xmalloc'd array, free with lock_stats_free()
+ * OUT bucket_usec - histogram bucket upper bounds, the last is NO_VAL (no
+ *	limit), LOCK_STATS_BUCKETS entries
+ * RET number of entries in stats
+ */
+extern uint32_t lock_stats_get(lock_stats_t **stats, uint32_t *bucket_usec);
+
+extern void lock_stats_free(lock_stats_t *stats, uint32_t cnt);
+
+/* Clear the lock statistics recorded */
+extern void lock_stats_reset(void);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
@@ -99,6 +99,12 @@ typedef enum {
 	FEATURE_MODE_PEND, /* Print any pending change message */
 } feature_mode_t;
 
+/* Node features reported by queued registrations, applied by value */
+typedef struct {
+	char *features;
+	bitstr_t *node_bitmap;
+} reg_features_t;
+
 /* Global variables */
 bitstr_t *avail_node_bitmap = NULL;	/* bitmap of available nodes */
 bitstr_t *bf_ignore_node_bitmap = NULL; /* bitmap of nodes to ignore during a
@@ -112,6 +118,9 @@ bitstr_t *share_node_bitmap = NULL;  	/* bitmap of sharable nodes */
 bitstr_t *up_node_bitmap    = NULL;  	/* bitmap of non-down nodes */
 bitstr_t *rs_node_bitmap    = NULL; 	/* bitmap of resuming nodes */
 
+static List reg_active_list = NULL;	/* reg_features_t, active features */
+static List reg_avail_list = NULL;	/* reg_features_t, avail features */
+
 static void 	_dump_node_state(node_record_t *dump_node_ptr, buf_t *buffer);
 static void	_drain_node(node_record_t *node_ptr, char *reason,
 			    uint32_t reason_uid);
@@ -2033,6 +2042,69 @@ static int _update_node_avail_features(char *node_names, char *avail_features,
 	return SLURM_SUCCESS;
 }
 
+static void _reg_features_free(void *x)
+{
+	reg_features_t *reg_features = (reg_features_t *) x;
+
+	xfree(reg_features->features);
+	FREE_NULL_BITMAP(reg_features->node_bitmap);
+	xfree(reg_features);
+}
+
+/*
+ * Defer the features update of a node from a queued registration until the
+ * end of the batch, so nodes reporting the same features are updated
+ * together. A later registration of the node replaces an earlier one.
+ */
+static void _reg_features_defer(List *reg_list, char *features, int node_inx)
+{
+	reg_features_t *reg_features, *match = NULL;
+	ListIterator iter;
+
+	if (!*reg_list)
+		*reg_list = list_create(_reg_features_free);
+
+	iter = list_iterator_create(*reg_list);
+	while ((reg_features = list_next(iter))) {
+		if (!xstrcmp(reg_features->features, features))
+			match = reg_features;
+		else
+			bit_clear(reg_features->node_bitmap, node_inx);
+	}
+	list_iterator_destroy(iter);
+
+	if (!match) {
+		match = xmalloc(sizeof(*match));
+		match->features = xstrdup(features);
+		match->node_bitmap = bit_alloc(node_record_count);
+		list_append(*reg_list, match);
+	}
+	bit_set(match->node_bitmap, node_inx);
+}
+
+static void _reg_features_apply(List *reg_list,
+				int (*update)(char *node_names, char *features,
+					      int mode))
+{
+	reg_features_t *reg_features;
+	char *node_names;
+
+	if (!*reg_list)
+		return;
+
+	while ((reg_features = list_pop(*reg_list))) {
+		if (bit_ffs(reg_features->node_bitmap) != -1) {
+			node_names = bitmap2node_name(
+				reg_features->node_bitmap);
+			(void) update(node_names, reg_features->features,
+				      FEATURE_MODE_COMB);
+			xfree(node_names);
+		}
+		_reg_features_free(reg_features);
+	}
+	(void) update(NULL, NULL, FEATURE_MODE_PEND);
+}
+
 /*
  * _update_node_gres - Update generic resources associated with nodes
  *	build new config list records as needed
@@ -2536,9 +2608,13 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 					reg_msg->features_avail,
 					orig_features, orig_features,
 					node_inx);
-		(void) _update_node_avail_features(node_ptr->name,
-						   node_ptr->features,
-						   FEATURE_MODE_IND);
+		if (slurm_msg->flags & CTLD_QUEUE_PROCESSING)
+			_reg_features_defer(&reg_avail_list,
+					    node_ptr->features, node_inx);
+		else if (xstrcmp(node_ptr->features, config_ptr->feature))
+			(void) _update_node_avail_features(node_ptr->name,
+							   node_ptr->features,
+							   FEATURE_MODE_IND);
 	}
 	if (reg_msg->features_active) {
 		char *tmp_feature;
@@ -2549,9 +2625,13 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 						node_inx);
 		xfree(node_ptr->features_act);
 		node_ptr->features_act = tmp_feature;
-		(void) _update_node_active_features(node_ptr->name,
-						    node_ptr->features_act,
-						    FEATURE_MODE_IND);
+		if (slurm_msg->flags & CTLD_QUEUE_PROCESSING)
+			_reg_features_defer(&reg_active_list,
+					    node_ptr->features_act, node_inx);
+		else
+			(void) _update_node_active_features(
+				node_ptr->name, node_ptr->features_act,
+				FEATURE_MODE_IND);
 	}
 	xfree(orig_features);
 	xfree(orig_features_act);
@@ -2950,6 +3030,47 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 	return error_code;
 }
 
+/*
+ * validate_node_specs_batch_end - apply the node features reported by a
+ *	batch of queued registrations, once for each distinct value
+ * NOTE: Node write lock must still be held from validate_node_specs()
+ */
+extern void validate_node_specs_batch_end(void)
+{
+	config_record_t *config_ptr;
+	reg_features_t *reg_features;
+	ListIterator iter;
+	int i, i_first, i_last;
+
+	xassert(verify_lock(NODE_LOCK, WRITE_LOCK));
+
+	if (reg_avail_list) {
+		/* Skip nodes whose config record has these features already */
+		iter = list_iterator_create(reg_avail_list);
+		while ((reg_features = list_next(iter))) {
+			i_first = bit_ffs(reg_features->node_bitmap);
+			if (i_first >= 0)
+				i_last = bit_fls(reg_features->node_bitmap);
+			else
+				i_last = -2;
+			for (i = i_first; i <= i_last; i++) {
+				if (!bit_test(reg_features->node_bitmap, i))
+					continue;
+				config_ptr =
+					node_record_table_ptr[i].config_ptr;
+				if (!xstrcmp(config_ptr->feature,
+					     reg_features->features))
+					bit_clear(reg_features->node_bitmap,
+						  i);
+			}
+		}
+		list_iterator_destroy(iter);
+	}
+
+	_reg_features_apply(&reg_avail_list, _update_node_avail_features);
+	_reg_features_apply(&reg_active_list, _update_node_active_features);
+}
+
 static front_end_record_t * _front_end_reg(
 		slurm_node_registration_status_msg_t *reg_msg)
 {
@@ -4023,6 +4144,7 @@ void make_node_idle(node_record_t *node_ptr, job_record_t *job_ptr)
 	if (node_bitmap && (bit_test(node_bitmap, inx))) {
 		/* Not a replay */
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		bit_clear(node_bitmap, inx);
 
 		if (!IS_JOB_FINISHED(job_ptr))
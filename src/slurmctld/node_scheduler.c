@@ -2362,6 +2362,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			return ESLURM_BURST_BUFFER_WAIT; /* Fatal BB event */
 		xfree(job_ptr->state_desc);
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		if (bb == 0)
 			job_ptr->state_reason = WAIT_BURST_BUFFER_STAGING;
 		else
@@ -2526,6 +2527,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			job_ptr->state_reason = WAIT_PART_NODE_LIMIT;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 
 		/* Non-fatal errors for job below */
 		} else if (error_code == ESLURM_NODE_NOT_AVAIL) {
@@ -2565,6 +2567,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			}
 			xfree(unavail_node);
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 		} else if (error_code == ESLURM_RESERVATION_MAINT) {
 			error_code = ESLURM_RESERVATION_BUSY;	/* All reserved */
 			job_ptr->state_reason = WAIT_NODE_NOT_AVAIL;
@@ -2642,6 +2645,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->priority = 0;
 		job_ptr->state_reason = WAIT_HELD;
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		goto cleanup;
 	}
 	if (select_g_job_begin(job_ptr) != SLURM_SUCCESS) {
@@ -2657,6 +2661,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		goto cleanup;
 	}
 
@@ -2680,6 +2685,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
 		last_job_update = now;
+		job_delta_stamp(job_ptr);
 		goto cleanup;
 	}
 
@@ -2708,6 +2714,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			job_ptr->state_reason = WAIT_RESOURCES;
 			job_ptr->job_state = JOB_PENDING;
 			last_job_update = now;
+			job_delta_stamp(job_ptr);
 			goto cleanup;
 		}
 	}
@@ -1031,6 +1031,23 @@ extern bool part_is_visible(part_record_t *part_ptr, uid_t uid)
 	return true;
 }
 
+static int _find_restricted_part(void *x, void *arg)
+{
+	part_record_t *part_ptr = x;
+
+	if ((part_ptr->flags & PART_FLAG_HIDDEN) || part_ptr->allow_groups)
+		return 1;
+	return 0;
+}
+
+/* every partition is visible to every user */
+extern bool part_all_visible(void)
+{
+	xassert(verify_lock(PART_LOCK, READ_LOCK));
+
+	return !list_find_first(part_list, _find_restricted_part, NULL);
+}
+
 /* partition is visible to the user */
 extern bool part_is_visible_user_rec(part_record_t *part_ptr,
 				     slurmdb_user_rec_t *user)
@@ -2097,6 +2114,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_delta_stamp(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2121,6 +2139,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_delta_stamp(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2152,6 +2171,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_delta_stamp(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2188,6 +2208,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_delta_stamp(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2207,6 +2228,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_delta_stamp(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2233,6 +2255,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_delta_stamp(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
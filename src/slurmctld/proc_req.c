@@ -90,6 +90,7 @@
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
+#include "src/slurmctld/info_snapshot.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
@@ -114,6 +115,12 @@ static uint32_t rpc_user_id[RPC_USER_SIZE] = { 0 };
 static uint32_t rpc_user_cnt[RPC_USER_SIZE] = { 0 };
 static uint64_t rpc_user_time[RPC_USER_SIZE] = { 0 };
 
+/*
+ * Jobs of a REQUEST_SUBMIT_BATCH_JOB_LIST validated or created before the job
+ * lock is released to let other RPCs in
+ */
+#define SUBMIT_LIST_LOCK_JOBS 100
+
 static char *slurmd_config_files[] = {
 	"slurm.conf", "acct_gather.conf", "cgroup.conf",
 	"cgroup_allowed_devices_file.conf", "cli_filter.lua",
@@ -1539,6 +1546,62 @@ static void _slurm_rpc_dump_conf(slurm_msg_t * msg)
 	}
 }
 
+/*
+ * Build the info snapshot key for a request: dumps only differ between
+ * requests by show_flags and whether the requester is an operator.
+ */
+static uint32_t _info_snapshot_key(slurm_msg_t *msg, uint16_t show_flags)
+{
+	uint32_t key = show_flags;
+
+	if (validate_operator(msg->auth_uid))
+		key |= INFO_SNAPSHOT_PRIVILEGED;
+
+	return key;
+}
+
+/*
+ * Can a dump packed for this request be sent to any other request with the
+ * same key? Not if it was filtered by the requesting user's identity.
+ * NOTE: READ lock_slurmctld config and partition before entry
+ */
+static bool _info_snapshot_shareable(uint32_t key, uint16_t private_flag)
+{
+	if (key & INFO_SNAPSHOT_PRIVILEGED)
+		return true;
+	if (slurm_conf.private_data & private_flag)
+		return false;
+	return ((key & SHOW_ALL) || part_all_visible());
+}
+
+/*
+ * Reply with a cached dump if one still matches the current state, without
+ * taking any slurmctld locks.
+ * RET true if a response was sent
+ */
+static bool _send_info_snapshot(slurm_msg_t *msg, info_snapshot_type_t type,
+				uint32_t key, uint16_t msg_type,
+				lock_datatype_t lock0, lock_datatype_t lock1)
+{
+	info_snapshot_t *snapshot;
+	slurm_msg_t response_msg;
+
+	if (!(snapshot = info_snapshot_get(type, key, msg->protocol_version,
+					   lock_write_gen(lock0),
+					   lock_write_gen(lock1))))
+		return false;
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = msg_type;
+	response_msg.data = snapshot->dump;
+	response_msg.data_size = snapshot->dump_size;
+
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	info_snapshot_release(snapshot);
+
+	return true;
+}
+
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
 static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 {
@@ -1548,11 +1611,22 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	slurm_msg_t response_msg;
 	job_info_request_msg_t *job_info_request_msg =
 		(job_info_request_msg_t *) msg->data;
+	info_snapshot_t *snapshot = NULL;
+	uint32_t key = _info_snapshot_key(msg,
+					  job_info_request_msg->show_flags);
 	/* Locks: Read config job part */
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
 
 	START_TIMER;
+	if (!job_info_request_msg->job_ids &&
+	    ((job_info_request_msg->last_update - 1) < last_job_update) &&
+	    _send_info_snapshot(msg, INFO_SNAPSHOT_JOBS, key,
+				RESPONSE_JOB_INFO, JOB_LOCK, PART_LOCK)) {
+		END_TIMER2("_slurm_rpc_dump_jobs");
+		return;
+	}
+
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(job_read_lock);
 
@@ -1573,6 +1647,13 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 				      job_info_request_msg->show_flags,
 				      msg->auth_uid, NO_VAL,
 				      msg->protocol_version);
+			if (_info_snapshot_shareable(key, PRIVATE_DATA_JOBS))
+				snapshot = info_snapshot_add(
+					INFO_SNAPSHOT_JOBS, key,
+					msg->protocol_version,
+					lock_write_gen(JOB_LOCK),
+					lock_write_gen(PART_LOCK),
+					dump, dump_size);
 		}
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(job_read_lock);
@@ -1588,10 +1669,54 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 
 		/* send message */
 		slurm_send_node_msg(msg->conn_fd, &response_msg);
-		xfree(dump);
+		if (snapshot)
+			info_snapshot_release(snapshot);
+		else
+			xfree(dump);
 	}
 }
 
+/*
+ * _slurm_rpc_dump_jobs_delta - process RPC for job state information changed
+ *	since a job delta generation
+ */
+static void _slurm_rpc_dump_jobs_delta(slurm_msg_t *msg)
+{
+	DEF_TIMERS;
+	char *dump = NULL;
+	int dump_size = 0, rc;
+	slurm_msg_t response_msg;
+	job_info_delta_request_msg_t *req =
+		(job_info_delta_request_msg_t *) msg->data;
+	/* Locks: Read config job part */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
+
+	START_TIMER;
+	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
+		lock_slurmctld(job_read_lock);
+	rc = pack_delta_jobs(&dump, &dump_size, req, msg->auth_uid,
+			     msg->protocol_version);
+	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
+		unlock_slurmctld(job_read_lock);
+	END_TIMER2(__func__);
+
+	if (rc == SLURM_NO_CHANGE_IN_DATA) {
+		debug3("%s, no change", __func__);
+		slurm_send_rc_msg(msg, rc);
+		return;
+	}
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_JOB_INFO_DELTA;
+	response_msg.data = dump;
+	response_msg.data_size = dump_size;
+
+	/* send message */
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	xfree(dump);
+}
+
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
 static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 {
@@ -1812,6 +1937,8 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	slurm_msg_t response_msg;
 	node_info_request_msg_t *node_req_msg =
 		(node_info_request_msg_t *) msg->data;
+	info_snapshot_t *snapshot = NULL;
+	uint32_t key = _info_snapshot_key(msg, node_req_msg->show_flags);
 	/* Locks: Read config, write node (reset allocated CPU count in some
 	 * select plugins), read part (for part_is_visible) */
 	slurmctld_lock_t node_write_lock = {
@@ -1819,13 +1946,20 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 
 	START_TIMER;
 	if ((slurm_conf.private_data & PRIVATE_DATA_NODES) &&
-	    (!validate_operator(msg->auth_uid))) {
+	    !(key & INFO_SNAPSHOT_PRIVILEGED)) {
 		error("Security violation, REQUEST_NODE_INFO RPC from uid=%u",
 		      msg->auth_uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
 		return;
 	}
 
+	if (((node_req_msg->last_update - 1) < last_node_update) &&
+	    _send_info_snapshot(msg, INFO_SNAPSHOT_NODES, key,
+				RESPONSE_NODE_INFO, NODE_LOCK, PART_LOCK)) {
+		END_TIMER2("_slurm_rpc_dump_nodes");
+		return;
+	}
+
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(node_write_lock);
 
@@ -1839,6 +1973,12 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	} else {
 		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
 			      msg->auth_uid, msg->protocol_version);
+		if (_info_snapshot_shareable(key, PRIVATE_DATA_NODES))
+			snapshot = info_snapshot_add(INFO_SNAPSHOT_NODES, key,
+						     msg->protocol_version,
+						     lock_write_gen(NODE_LOCK),
+						     lock_write_gen(PART_LOCK),
+						     dump, dump_size);
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(node_write_lock);
 		END_TIMER2("_slurm_rpc_dump_nodes");
@@ -1853,7 +1993,10 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 
 		/* send message */
 		slurm_send_node_msg(msg->conn_fd, &response_msg);
-		xfree(dump);
+		if (snapshot)
+			info_snapshot_release(snapshot);
+		else
+			xfree(dump);
 	}
 }
 
@@ -1916,19 +2059,30 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 	part_info_request_msg_t *part_req_msg =
 		(part_info_request_msg_t *) msg->data;
 
+	info_snapshot_t *snapshot = NULL;
+	uint32_t key = _info_snapshot_key(msg, part_req_msg->show_flags);
+
 	/* Locks: Read configuration and partition */
 	slurmctld_lock_t part_read_lock = {
 		READ_LOCK, NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK };
 
 	START_TIMER;
 	if ((slurm_conf.private_data & PRIVATE_DATA_PARTITIONS) &&
-	    !validate_operator(msg->auth_uid)) {
+	    !(key & INFO_SNAPSHOT_PRIVILEGED)) {
 		debug2("Security violation, PARTITION_INFO RPC from uid=%u",
 		       msg->auth_uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
 		return;
 	}
 
+	if (((part_req_msg->last_update - 1) < last_part_update) &&
+	    _send_info_snapshot(msg, INFO_SNAPSHOT_PARTS, key,
+				RESPONSE_PARTITION_INFO, PART_LOCK,
+				CONF_LOCK)) {
+		END_TIMER2("_slurm_rpc_dump_partitions");
+		return;
+	}
+
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(part_read_lock);
 
@@ -1940,6 +2094,12 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 	} else {
 		pack_all_part(&dump, &dump_size, part_req_msg->show_flags,
 			      msg->auth_uid, msg->protocol_version);
+		if (_info_snapshot_shareable(key, PRIVATE_DATA_PARTITIONS))
+			snapshot = info_snapshot_add(INFO_SNAPSHOT_PARTS, key,
+						     msg->protocol_version,
+						     lock_write_gen(PART_LOCK),
+						     lock_write_gen(CONF_LOCK),
+						     dump, dump_size);
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(part_read_lock);
 		END_TIMER2("_slurm_rpc_dump_partitions");
@@ -1953,7 +2113,10 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 
 		/* send message */
 		slurm_send_node_msg(msg->conn_fd, &response_msg);
-		xfree(dump);
+		if (snapshot)
+			info_snapshot_release(snapshot);
+		else
+			xfree(dump);
 	}
 }
 
@@ -3668,6 +3831,8 @@ static void _slurm_rpc_submit_batch_job(slurm_msg_t *msg)
 	}
 
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING)) {
+		/* Write the script before the job write lock is taken */
+		stage_job_desc_files(job_desc_msg);
 		_throttle_start(&active_rpc_cnt);
 		lock_slurmctld(job_write_lock);
 	}
@@ -3704,6 +3869,7 @@ static void _slurm_rpc_submit_batch_job(slurm_msg_t *msg)
 		unlock_slurmctld(job_write_lock);
 		_throttle_fini(&active_rpc_cnt);
 	}
+	unstage_job_desc_files(job_desc_msg);
 
 send_msg:
 	END_TIMER2("_slurm_rpc_submit_batch_job");
@@ -3751,6 +3917,201 @@ send_msg:
 	xfree(job_submit_user_msg);
 }
 
+/*
+ * _slurm_rpc_submit_batch_job_list - process RPC to submit independent batch
+ *	jobs. The jobs are validated under one job read lock and created under
+ *	one job write lock, each job is accepted or rejected on its own.
+ */
+static void _slurm_rpc_submit_batch_job_list(slurm_msg_t *msg)
+{
+	static int active_rpc_cnt = 0;
+	ListIterator iter;
+	int error_code = SLURM_SUCCESS, i = 0, job_cnt = 0, submit_cnt = 0;
+	int locked_cnt;
+	DEF_TIMERS;
+	uint32_t job_id;
+	job_record_t *job_ptr;
+	slurm_msg_t response_msg;
+	submit_response_msg_t *resp, **resp_array;
+	job_desc_msg_t *job_desc_msg, **job_desc_array;
+	/* Locks: Read config, read job, read node, read partition */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
+	/* Locks: Read config, write job, write node, read partition, read
+	 * federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	List job_req_list = (List) msg->data, resp_list;
+	gid_t gid = auth_g_get_gid(msg->auth_cred);
+	char *err_msg = NULL;
+	bool reject_job;
+
+	START_TIMER;
+	if (job_req_list)
+		job_cnt = list_count(job_req_list);
+	if (!job_cnt) {
+		info("REQUEST_SUBMIT_BATCH_JOB_LIST from uid=%u with empty job list",
+		     msg->auth_uid);
+		slurm_send_rc_msg(msg, SLURM_ERROR);
+		return;
+	}
+	if (slurmctld_config.submissions_disabled) {
+		info("Submissions disabled on system");
+		slurm_send_rc_msg(msg, ESLURM_SUBMISSIONS_DISABLED);
+		return;
+	}
+
+	/*
+	 * Each job gets a response, rejected until it has a job_id. The
+	 * error_code of a response is only final once the job is rejected or
+	 * created.
+	 */
+	resp_list = list_create(slurm_destroy_submit_response_object);
+	resp_array = xcalloc(job_cnt, sizeof(submit_response_msg_t *));
+	job_desc_array = xcalloc(job_cnt, sizeof(job_desc_msg_t *));
+	iter = list_iterator_create(job_req_list);
+	while ((job_desc_msg = list_next(iter))) {
+		resp = xmalloc(sizeof(submit_response_msg_t));
+		resp->step_id = SLURM_BATCH_SCRIPT;
+		list_append(resp_list, resp);
+		resp_array[i] = resp;
+		job_desc_array[i++] = job_desc_msg;
+
+		if ((resp->error_code =
+		     _valid_id("REQUEST_SUBMIT_BATCH_JOB_LIST", job_desc_msg,
+			       msg->auth_uid, gid)))
+			continue;
+
+		_set_hostname(msg, &job_desc_msg->alloc_node);
+
+		if ((job_desc_msg->alloc_node == NULL) ||
+		    (job_desc_msg->alloc_node[0] == '\0')) {
+			error("REQUEST_SUBMIT_BATCH_JOB_LIST lacks alloc_node from uid=%u",
+			      msg->auth_uid);
+			resp->error_code = ESLURM_INVALID_NODE_NAME;
+			continue;
+		}
+
+		dump_job_desc(job_desc_msg);
+	}
+	list_iterator_destroy(iter);
+
+	/* Validate the individual requests */
+	lock_slurmctld(job_read_lock);     /* Locks for job_submit plugin use */
+	for (i = 0, locked_cnt = 0; i < job_cnt; i++) {
+		if (resp_array[i]->error_code)
+			continue;
+		if (++locked_cnt > SUBMIT_LIST_LOCK_JOBS) {
+			unlock_slurmctld(job_read_lock);
+			lock_slurmctld(job_read_lock);
+			locked_cnt = 1;
+		}
+		if (fed_mgr_fed_rec) {
+			/* Siblings are sent one job per message */
+			resp_array[i]->error_code = ESLURM_NOT_SUPPORTED;
+			continue;
+		}
+		job_desc_array[i]->het_job_offset = NO_VAL;
+		resp_array[i]->error_code =
+			validate_job_create_req(
+				job_desc_array[i], msg->auth_uid,
+				&resp_array[i]->job_submit_user_msg);
+	}
+	unlock_slurmctld(job_read_lock);
+
+	/* Write the scripts before the job write lock is taken */
+	for (i = 0; i < job_cnt; i++) {
+		if (!resp_array[i]->error_code)
+			stage_job_desc_files(job_desc_array[i]);
+	}
+
+	/* Create new job allocations */
+	_throttle_start(&active_rpc_cnt);
+	lock_slurmctld(job_write_lock);
+	START_TIMER;	/* Restart after we have locks */
+	for (i = 0, locked_cnt = 0; i < job_cnt; i++) {
+		job_desc_msg = job_desc_array[i];
+		resp = resp_array[i];
+		if (resp->error_code)
+			continue;
+
+		if (++locked_cnt > SUBMIT_LIST_LOCK_JOBS) {
+			unlock_slurmctld(job_write_lock);
+			lock_slurmctld(job_write_lock);
+			locked_cnt = 1;
+		}
+
+		job_id = 0;
+		job_ptr = NULL;
+		reject_job = false;
+		if (fed_mgr_fed_rec) {
+			/* Federation was set up after validation */
+			error_code = ESLURM_NOT_SUPPORTED;
+			reject_job = true;
+		} else {
+			job_desc_msg->het_job_offset = NO_VAL;
+			error_code = job_allocate(job_desc_msg,
+						  job_desc_msg->immediate,
+						  false, NULL, 0,
+						  msg->auth_uid, false,
+						  &job_ptr, &err_msg,
+						  msg->protocol_version);
+			if (!job_ptr ||
+			    (error_code && job_ptr->job_state == JOB_FAILED))
+				reject_job = true;
+			else
+				job_id = job_ptr->job_id;
+
+			if (job_desc_msg->immediate &&
+			    (error_code != SLURM_SUCCESS)) {
+				error_code = ESLURM_CAN_NOT_START_IMMEDIATELY;
+				reject_job = true;
+			}
+		}
+
+		resp->error_code = error_code;
+		if (reject_job) {
+			info("%s: %s", __func__, slurm_strerror(error_code));
+			/* Add the job submit message to the error message */
+			if (err_msg && resp->job_submit_user_msg)
+				xstrfmtcat(resp->job_submit_user_msg, "\n%s",
+					   err_msg);
+			else if (err_msg) {
+				resp->job_submit_user_msg = err_msg;
+				err_msg = NULL;
+			}
+		} else {
+			debug("%s: JobId=%u", __func__, job_id);
+			resp->job_id = job_id;
+			submit_cnt++;
+		}
+		xfree(err_msg);
+	}
+	unlock_slurmctld(job_write_lock);
+	_throttle_fini(&active_rpc_cnt);
+
+	for (i = 0; i < job_cnt; i++)
+		unstage_job_desc_files(job_desc_array[i]);
+	xfree(job_desc_array);
+	xfree(resp_array);
+
+	END_TIMER2("_slurm_rpc_submit_batch_job_list");
+	info("%s: %d of %d jobs submitted %s",
+	     __func__, submit_cnt, job_cnt, TIME_STR);
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_SUBMIT_BATCH_JOB_LIST;
+	response_msg.data = resp_list;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	FREE_NULL_LIST(resp_list);
+
+	if (submit_cnt) {
+		schedule_job_save();	/* Has own locks */
+		schedule_node_save();	/* Has own locks */
+		queue_job_scheduler();
+	}
+}
+
 /* _slurm_rpc_submit_batch_het_job - process RPC to submit a batch hetjob */
 static void _slurm_rpc_submit_batch_het_job(slurm_msg_t *msg)
 {
@@ -5490,11 +5851,13 @@ static void _slurm_rpc_dump_stats(slurm_msg_t *msg)
 		_clear_rpc_stats();
 		pack_all_stat(0, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(0, &dump, &dump_size, msg->protocol_version);
+		pack_extra_stat(0, &dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 	} else {
 		pack_all_stat(1, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(1, &dump, &dump_size, msg->protocol_version);
+		pack_extra_stat(1, &dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 	}
@@ -6155,9 +6518,22 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_BUILD_INFO,
 		.func = _slurm_rpc_dump_conf,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_JOB_INFO,
 		.func = _slurm_rpc_dump_jobs,
+		.rpc_class = RPC_CLASS_QUERY,
+		.queue_enabled = true,
+		.locks = {
+			.conf = READ_LOCK,
+			.job = READ_LOCK,
+			.part = READ_LOCK,
+			.fed = READ_LOCK,
+		},
+	},{
+		.msg_type = REQUEST_JOB_INFO_DELTA,
+		.func = _slurm_rpc_dump_jobs_delta,
+		.rpc_class = RPC_CLASS_QUERY,
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
@@ -6168,6 +6544,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_JOB_USER_INFO,
 		.func = _slurm_rpc_dump_jobs_user,
+		.rpc_class = RPC_CLASS_QUERY,
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
@@ -6178,6 +6555,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_JOB_INFO_SINGLE,
 		.func = _slurm_rpc_dump_job_single,
+		.rpc_class = RPC_CLASS_QUERY,
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
@@ -6188,18 +6566,22 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_BATCH_SCRIPT,
 		.func = _slurm_rpc_dump_batch_script,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_SHARE_INFO,
 		.func = _slurm_rpc_get_shares,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_PRIORITY_FACTORS,
 		.func = _slurm_rpc_get_priority_factors,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_JOB_END_TIME,
 		.func = _slurm_rpc_end_time,
 	},{
 		.msg_type = REQUEST_FED_INFO,
 		.func = _slurm_rpc_get_fed,
+		.rpc_class = RPC_CLASS_QUERY,
 		.queue_enabled = true,
 		.locks = {
 			.fed = READ_LOCK,
@@ -6207,9 +6589,11 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_FRONT_END_INFO,
 		.func = _slurm_rpc_dump_front_end,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_NODE_INFO,
 		.func = _slurm_rpc_dump_nodes,
+		.rpc_class = RPC_CLASS_QUERY,
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
@@ -6219,9 +6603,11 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_NODE_INFO_SINGLE,
 		.func = _slurm_rpc_dump_node_single,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_PARTITION_INFO,
 		.func = _slurm_rpc_dump_partitions,
+		.rpc_class = RPC_CLASS_QUERY,
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
@@ -6230,6 +6616,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = MESSAGE_EPILOG_COMPLETE,
 		.func = _slurm_rpc_epilog_complete,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_CANCEL_JOB_STEP,
 		.func = _slurm_rpc_job_step_kill,
@@ -6239,6 +6626,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_COMPLETE_PROLOG,
 		.func = _slurm_rpc_complete_prolog,
+		.rpc_class = RPC_CLASS_NODE,
 		.queue_enabled = true,
 		.locks = {
 			.job = WRITE_LOCK,
@@ -6246,6 +6634,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_COMPLETE_BATCH_SCRIPT,
 		.func = _slurm_rpc_complete_batch_script,
+		.rpc_class = RPC_CLASS_NODE,
 		.queue_enabled = true,
 		.locks = {
 			.job = WRITE_LOCK,
@@ -6263,22 +6652,30 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_JOB_STEP_INFO,
 		.func = _slurm_rpc_job_step_get_info,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_JOB_WILL_RUN,
 		.func = _slurm_rpc_job_will_run,
 	},{
 		.msg_type = REQUEST_SIB_JOB_LOCK,
 		.func = _slurm_rpc_sib_job_lock,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_SIB_JOB_UNLOCK,
 		.func = _slurm_rpc_sib_job_unlock,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_CTLD_MULT_MSG,
 		.func = _proc_multi_msg,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = MESSAGE_NODE_REGISTRATION_STATUS,
 		.func = _slurm_rpc_node_registration,
+		.rpc_class = RPC_CLASS_NODE,
 		.queue_enabled = true,
+#ifndef HAVE_FRONT_END
+		.batch_end_func = validate_node_specs_batch_end,
+#endif
 		.locks = {
 			.conf = READ_LOCK,
 			.job = WRITE_LOCK,
@@ -6304,18 +6701,22 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_PING,
 		.func = _slurm_rpc_ping,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_RECONFIGURE,
 		.func = _slurm_rpc_reconfigure_controller,
 	},{
 		.msg_type = REQUEST_CONTROL,
 		.func = _slurm_rpc_shutdown_controller,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_TAKEOVER,
 		.func = _slurm_rpc_takeover,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_SHUTDOWN,
 		.func = _slurm_rpc_shutdown_controller,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_SUBMIT_BATCH_JOB,
 		.func = _slurm_rpc_submit_batch_job,
@@ -6330,6 +6731,9 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_SUBMIT_BATCH_HET_JOB,
 		.func = _slurm_rpc_submit_batch_het_job,
+	},{
+		.msg_type = REQUEST_SUBMIT_BATCH_JOB_LIST,
+		.func = _slurm_rpc_submit_batch_job_list,
 	},{
 		.msg_type = REQUEST_UPDATE_FRONT_END,
 		.func = _slurm_rpc_update_front_end,
@@ -6360,6 +6764,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_RESERVATION_INFO,
 		.func = _slurm_rpc_resv_show,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_NODE_REGISTRATION_STATUS,
 		.func = _slurm_rpc_node_registration_status,
@@ -6381,9 +6786,11 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_BURST_BUFFER_INFO,
 		.func = _slurm_rpc_burst_buffer_info,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_STEP_COMPLETE,
 		.func = _slurm_rpc_step_complete,
+		.rpc_class = RPC_CLASS_NODE,
 		.queue_enabled = true,
 		.locks = {
 			.job = WRITE_LOCK,
@@ -6399,12 +6806,14 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_CONFIG,
 		.func = _slurm_rpc_config_request,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_TRIGGER_SET,
 		.func = _slurm_rpc_trigger_set,
 	},{
 		.msg_type = REQUEST_TRIGGER_GET,
 		.func = _slurm_rpc_trigger_get,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_TRIGGER_CLEAR,
 		.func = _slurm_rpc_trigger_clear,
@@ -6426,42 +6835,52 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = ACCOUNTING_UPDATE_MSG,
 		.func = _slurm_rpc_accounting_update_msg,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = ACCOUNTING_FIRST_REG,
 		.func = _slurm_rpc_accounting_first_reg,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = ACCOUNTING_REGISTER_CTLD,
 		.func = _slurm_rpc_accounting_register_ctld,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_TOPO_INFO,
 		.func = _slurm_rpc_get_topo,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_REBOOT_NODES,
 		.func = _slurm_rpc_reboot_nodes,
 	},{
 		.msg_type = REQUEST_STATS_INFO,
 		.func = _slurm_rpc_dump_stats,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_LICENSE_INFO,
 		.func = _slurm_rpc_dump_licenses,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_KILL_JOB,
 		.func = _slurm_rpc_kill_job,
 	},{
 		.msg_type = REQUEST_ASSOC_MGR_INFO,
 		.func = _slurm_rpc_assoc_mgr_info,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_PERSIST_INIT,
 		.func = _slurm_rpc_persist_init,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_SET_FS_DAMPENING_FACTOR,
 		.func = _slurm_rpc_set_fs_dampening_factor,
 	},{
 		.msg_type = REQUEST_CONTROL_STATUS,
 		.func = slurm_rpc_control_status,
+		.rpc_class = RPC_CLASS_NODE,
 	},{
 		.msg_type = REQUEST_BURST_BUFFER_STATUS,
 		.func = _slurm_rpc_burst_buffer_status,
+		.rpc_class = RPC_CLASS_QUERY,
 	},{
 		.msg_type = REQUEST_CRONTAB,
 		.func = _slurm_rpc_request_crontab,
@@ -6474,6 +6893,19 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	}
 };
 
+extern slurmctld_rpc_t *find_rpc(uint16_t msg_type)
+{
+	for (int i = 0; slurmctld_rpcs[i].msg_type; i++) {
+		if (slurmctld_rpcs[i].msg_type != msg_type)
+			continue;
+
+		xassert(slurmctld_rpcs[i].func);
+		return &slurmctld_rpcs[i];
+	}
+
+	return NULL;
+}
+
 /*
  * slurmctld_req  - Process an individual RPC request
  * IN/OUT msg - the request message, data associated with the message is freed
@@ -6515,16 +6947,7 @@ void slurmctld_req(slurm_msg_t *msg)
 	debug2("Processing RPC: %s from UID=%u",
 	       rpc_num2string(msg->msg_type), msg->auth_uid);
 
-	for (int i = 0; slurmctld_rpcs[i].msg_type; i++) {
-		if (slurmctld_rpcs[i].msg_type != msg->msg_type)
-			continue;
-
-		xassert(slurmctld_rpcs[i].func);
-		this_rpc = &slurmctld_rpcs[i];
-		break;
-	}
-
-	if (this_rpc) {
+	if ((this_rpc = find_rpc(msg->msg_type))) {
 		(*(this_rpc->func))(msg);
 		END_TIMER;
 		record_rpc_stats(msg, DELTA_TIMER);
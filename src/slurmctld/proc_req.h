@@ -45,10 +45,22 @@
 
 #include "src/slurmctld/locks.h"
 
+/*
+ * Dispatch classes for the RPC worker pool. Node traffic is serviced first,
+ * queries last. Entries not tagged in slurmctld_rpcs[] are RPC_CLASS_DEFAULT.
+ */
+typedef enum {
+	RPC_CLASS_DEFAULT,	/* job submission, control and admin requests */
+	RPC_CLASS_NODE,		/* slurmd/slurmstepd and controller traffic */
+	RPC_CLASS_QUERY,	/* read-only information requests */
+	RPC_CLASS_COUNT
+} rpc_class_t;
+
 typedef struct {
 	uint16_t msg_type;
 	void (*func)(slurm_msg_t *msg);
 	slurmctld_lock_t locks;
+	rpc_class_t rpc_class;
 
 	/* Queue structual elements */
 	char *msg_name; /* automatically derived from msg_type */
@@ -56,6 +68,9 @@ typedef struct {
 	bool queue_enabled;
 	bool shutdown;
 
+	/* Called with locks still held after each batch of queued messages */
+	void (*batch_end_func)(void);
+
 	pthread_t thread;
 	pthread_cond_t cond;
 	pthread_mutex_t mutex;
@@ -65,6 +80,11 @@ typedef struct {
 
 extern slurmctld_rpc_t slurmctld_rpcs[];
 
+/*
+ * Return the slurmctld_rpcs[] entry handling msg_type, or NULL if unknown.
+ */
+extern slurmctld_rpc_t *find_rpc(uint16_t msg_type);
+
 /*
  * slurmctld_req  - Process an individual RPC request
  * IN/OUT msg - the request message, data associated with the message is freed
@@ -0,0 +1,637 @@
+/*****************************************************************************\
+ *  rpc_pool.c
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#if HAVE_SYS_PRCTL_H
+#include <sys/prctl.h>
+#endif
+
+#include "src/common/fd.h"
+#include "src/common/forward.h"
+#include "src/common/list.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/rpc_pool.h"
+#include "src/slurmctld/rpc_queue.h"
+
+#define RPC_POOL_THREADS_DEFAULT 64
+/* Serve a lower priority queue once its oldest entry has waited this long */
+#define RPC_POOL_STARVE_USEC 1000000
+/* Connections the reader handles per epoll_wait() */
+#define RPC_POOL_READ_EVENTS 64
+/* Same limit as slurm_msg_recvfrom_timeout() */
+#define RPC_POOL_MAX_MSG_SIZE (1024 * 1024 * 1024)
+
+/* Queues in the order workers service them */
+enum {
+	POOL_QUEUE_NODE,
+	POOL_QUEUE_DEFAULT,
+	POOL_QUEUE_QUERY,
+	POOL_QUEUE_CNT
+};
+
+static const int class_queue[RPC_CLASS_COUNT] = {
+	[RPC_CLASS_DEFAULT] = POOL_QUEUE_DEFAULT,
+	[RPC_CLASS_NODE] = POOL_QUEUE_NODE,
+	[RPC_CLASS_QUERY] = POOL_QUEUE_QUERY,
+};
+
+typedef struct {
+	slurm_msg_t *msg;
+	struct timeval queued;
+} rpc_work_t;
+
+/* Connection whose request is still being read */
+typedef struct {
+	char *buf;		/* message, once its length is known */
+	int fd;
+	uint32_t got;		/* bytes read of msg_len or buf */
+	uint32_t msg_len;	/* network byte order until fully read */
+	time_t start;
+} rpc_conn_t;
+
+typedef struct {
+	char *name;
+	List work;
+
+	uint32_t count;		/* entries dequeued */
+	uint32_t depth_max;
+	uint32_t rejected;	/* entries refused by admission control */
+	uint64_t wait_time;	/* total usec spent queued */
+	uint32_t wait_max;	/* usec */
+} rpc_pool_queue_t;
+
+static rpc_pool_queue_t queues[POOL_QUEUE_CNT] = {
+	[POOL_QUEUE_NODE] = { .name = "node" },
+	[POOL_QUEUE_DEFAULT] = { .name = "default" },
+	[POOL_QUEUE_QUERY] = { .name = "query" },
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *pool_threads = NULL;
+static uint32_t pool_thread_cnt = 0;
+static uint32_t query_depth_max = 0;
+static bool pool_shutdown = false;
+
+static pthread_mutex_t read_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List read_conns = NULL;	/* rpc_conn_t being read, oldest first */
+static int read_epoll_fd = -1;
+static pthread_t read_thread = 0;
+static bool read_shutdown = false;
+
+static uint32_t _usec_since(struct timeval *start, struct timeval *now)
+{
+	int64_t usec = ((int64_t) (now->tv_sec - start->tv_sec) *
+			USEC_IN_SEC) + (now->tv_usec - start->tv_usec);
+
+	if (usec < 0)
+		return 0;
+	if (usec > UINT32_MAX)
+		return UINT32_MAX;
+	return usec;
+}
+
+/*
+ * Add work to a queue.
+ * RET false if admission control refused the request
+ */
+static bool _enqueue(rpc_work_t *work, int inx)
+{
+	rpc_pool_queue_t *q = &queues[inx];
+	uint32_t depth;
+
+	slurm_mutex_lock(&pool_mutex);
+	if (pool_shutdown) {
+		slurm_mutex_unlock(&pool_mutex);
+		return false;
+	}
+	depth = list_count(q->work);
+	/*
+	 * Only shed queries from clients that know to retry them. Older
+	 * clients would report SLURMCTLD_COMMUNICATIONS_BACKOFF as an error.
+	 */
+	if ((inx == POOL_QUEUE_QUERY) && query_depth_max &&
+	    (depth >= query_depth_max) &&
+	    (work->msg->protocol_version >= SLURM_22_05_PROTOCOL_VERSION)) {
+		q->rejected++;
+		slurm_mutex_unlock(&pool_mutex);
+		return false;
+	}
+
+	gettimeofday(&work->queued, NULL);
+	list_append(q->work, work);
+	if (++depth > q->depth_max)
+		q->depth_max = depth;
+	slurm_cond_signal(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+
+	return true;
+}
+
+/*
+ * Take the next work item, blocking until one is available.
+ * Queues are serviced in priority order, except that a queue whose oldest
+ * entry has waited RPC_POOL_STARVE_USEC is serviced ahead of the others.
+ * RET work to do, or NULL once shutting down and all queues are empty
+ */
+static rpc_work_t *_dequeue(void)
+{
+	rpc_work_t *work = NULL, *head;
+	struct timeval now;
+	int inx, pick;
+	uint32_t wait;
+
+	slurm_mutex_lock(&pool_mutex);
+	while (true) {
+		gettimeofday(&now, NULL);
+		pick = -1;
+		for (inx = 0; inx < POOL_QUEUE_CNT; inx++) {
+			if (!(head = list_peek(queues[inx].work)))
+				continue;
+			if (pick == -1)
+				pick = inx;
+			if (_usec_since(&head->queued, &now) >=
+			    RPC_POOL_STARVE_USEC) {
+				pick = inx;
+				break;
+			}
+		}
+
+		if (pick != -1)
+			break;
+		if (pool_shutdown)
+			goto fini;
+		slurm_cond_wait(&pool_cond, &pool_mutex);
+	}
+
+	work = list_dequeue(queues[pick].work);
+	wait = _usec_since(&work->queued, &now);
+	queues[pick].count++;
+	queues[pick].wait_time += wait;
+	if (wait > queues[pick].wait_max)
+		queues[pick].wait_max = wait;
+
+fini:
+	slurm_mutex_unlock(&pool_mutex);
+	return work;
+}
+
+static void _finish(slurm_msg_t *msg)
+{
+	if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
+		error("close(%d): %m", msg->conn_fd);
+	slurm_free_msg(msg);
+	server_thread_decr();
+}
+
+static void _conn_free(rpc_conn_t *conn)
+{
+	xfree(conn->buf);
+	xfree(conn);
+}
+
+/*
+ * Read whatever is available on a connection without blocking.
+ * RET SLURM_SUCCESS once the whole request is read, EAGAIN if more is still
+ *     to come, or an error code if the connection must be dropped
+ */
+static int _read_conn(rpc_conn_t *conn)
+{
+	ssize_t len;
+
+	while (true) {
+		if (!conn->buf)
+			len = read(conn->fd, ((char *) &conn->msg_len) +
+				   conn->got, sizeof(conn->msg_len) - conn->got);
+		else
+			len = read(conn->fd, conn->buf + conn->got,
+				   conn->msg_len - conn->got);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return EAGAIN;
+			return errno;
+		}
+		if (len == 0)
+			return SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+
+		conn->got += len;
+		if (conn->buf) {
+			if (conn->got == conn->msg_len)
+				return SLURM_SUCCESS;
+		} else if (conn->got == sizeof(conn->msg_len)) {
+			conn->msg_len = ntohl(conn->msg_len);
+			if (!conn->msg_len ||
+			    (conn->msg_len > RPC_POOL_MAX_MSG_SIZE))
+				return SLURM_PROTOCOL_INSANE_MSG_LENGTH;
+			if (!(conn->buf = try_xmalloc(conn->msg_len)))
+				return ENOMEM;
+			conn->got = 0;
+		}
+	}
+}
+
+/*
+ * Queue a fully read request by class. Only the header is unpacked here;
+ * authentication and the body are left to the pool worker.
+ */
+static void _queue_conn(rpc_conn_t *conn)
+{
+	slurm_msg_t *msg = xmalloc(sizeof(*msg));
+	slurmctld_rpc_t *rpc;
+	rpc_work_t *work;
+	header_t header;
+	int inx = POOL_QUEUE_DEFAULT;
+
+	slurm_msg_t_init(msg);
+	msg->flags |= SLURM_MSG_KEEP_BUFFER;
+	msg->conn_fd = conn->fd;
+	msg->buffer = create_buf(conn->buf, conn->msg_len);
+	conn->buf = NULL;
+	_conn_free(conn);
+
+	fd_set_blocking(msg->conn_fd);
+	log_flag_hex(NET_RAW, get_buf_data(msg->buffer),
+		     size_buf(msg->buffer), "%s: read", __func__);
+
+	if (unpack_header(&header, msg->buffer)) {
+		slurm_addr_t cli_addr;
+		(void) slurm_get_peer_addr(msg->conn_fd, &cli_addr);
+		error("slurm_receive_msg [%pA]: %s", &cli_addr,
+		      slurm_strerror(SLURM_COMMUNICATIONS_RECEIVE_ERROR));
+		_finish(msg);
+		return;
+	}
+	msg->msg_type = header.msg_type;
+	msg->protocol_version = header.version;
+	if ((rpc = find_rpc(msg->msg_type)))
+		inx = class_queue[rpc->rpc_class];
+	destroy_forward(&header.forward);
+	FREE_NULL_LIST(header.ret_list);
+	set_buf_offset(msg->buffer, 0);
+
+	work = xmalloc(sizeof(*work));
+	work->msg = msg;
+	if (!_enqueue(work, inx)) {
+		log_flag(PROTOCOL, "%s: deferring %s, %s queue full",
+			 __func__, rpc_num2string(msg->msg_type),
+			 queues[inx].name);
+		slurm_send_rc_msg(msg, SLURMCTLD_COMMUNICATIONS_BACKOFF);
+		_finish(msg);
+		xfree(work);
+	}
+}
+
+/* Stop reading a connection, call with read_mutex locked */
+static void _conn_remove(rpc_conn_t *conn)
+{
+	if (epoll_ctl(read_epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL) < 0)
+		error("%s: epoll_ctl(%d): %m", __func__, conn->fd);
+	list_delete_ptr(read_conns, conn);
+}
+
+/* Close a connection whose request could not be read */
+static void _conn_drop(rpc_conn_t *conn, int rc)
+{
+	slurm_addr_t cli_addr;
+
+	(void) slurm_get_peer_addr(conn->fd, &cli_addr);
+	error("slurm_receive_msg [%pA]: %s", &cli_addr, slurm_strerror(rc));
+	if (close(conn->fd) < 0)
+		error("close(%d): %m", conn->fd);
+	_conn_free(conn);
+	server_thread_decr();
+}
+
+/*
+ * Drop connections that did not send a whole request within MessageTimeout.
+ * Call with read_mutex locked.
+ */
+static void _expire_conns(time_t now)
+{
+	rpc_conn_t *conn;
+
+	while ((conn = list_peek(read_conns)) &&
+	       ((now - conn->start) >= slurm_conf.msg_timeout)) {
+		_conn_remove(conn);
+		_conn_drop(conn, SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT);
+	}
+}
+
+/*
+ * Read requests from all new connections with one thread, so slow or idle
+ * clients hold neither a thread nor a worker.
+ */
+static void *_reader(void *arg)
+{
+	struct epoll_event events[RPC_POOL_READ_EVENTS];
+	rpc_conn_t *done[RPC_POOL_READ_EVENTS];
+	int done_rc[RPC_POOL_READ_EVENTS];
+	int cnt, done_cnt, rc;
+	bool fini;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "rpcread", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "rpcread");
+	}
+#endif
+
+	do {
+		cnt = epoll_wait(read_epoll_fd, events, RPC_POOL_READ_EVENTS,
+				 MSEC_IN_SEC);
+		if ((cnt < 0) && (errno != EINTR))
+			error("%s: epoll_wait: %m", __func__);
+
+		done_cnt = 0;
+		for (int i = 0; i < cnt; i++) {
+			rpc_conn_t *conn = events[i].data.ptr;
+
+			if ((rc = _read_conn(conn)) == EAGAIN)
+				continue;
+			done[done_cnt] = conn;
+			done_rc[done_cnt++] = rc;
+		}
+
+		slurm_mutex_lock(&read_mutex);
+		for (int i = 0; i < done_cnt; i++)
+			_conn_remove(done[i]);
+		_expire_conns(time(NULL));
+		fini = read_shutdown;
+		slurm_mutex_unlock(&read_mutex);
+
+		for (int i = 0; i < done_cnt; i++) {
+			if (done_rc[i] == SLURM_SUCCESS)
+				_queue_conn(done[i]);
+			else
+				_conn_drop(done[i], done_rc[i]);
+		}
+	} while (!fini);
+
+	return NULL;
+}
+
+static void _process(rpc_work_t *work)
+{
+	slurm_msg_t *msg = work->msg;
+	buf_t *buffer = msg->buffer;
+
+	xfree(work);
+
+	msg->buffer = NULL;
+	if (slurm_unpack_received_msg(msg, msg->conn_fd, buffer)) {
+		slurm_addr_t cli_addr;
+		(void) slurm_get_peer_addr(msg->conn_fd, &cli_addr);
+		error("slurm_receive_msg [%pA]: %m", &cli_addr);
+		free_buf(buffer);
+		_finish(msg);
+		return;
+	}
+	msg->buffer = buffer;
+
+	if (rpc_enqueue(msg)) {
+		server_thread_decr();
+		return;
+	}
+
+	/* process the request */
+	slurmctld_req(msg);
+	_finish(msg);
+}
+
+static void *_pool_worker(void *arg)
+{
+	rpc_work_t *work;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "rpcpool", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "rpcpool");
+	}
+#endif
+
+	while ((work = _dequeue()))
+		_process(work);
+
+	return NULL;
+}
+
+/*
+ * Read a SlurmctldParameters option
+ * RET value of "name", or def_val if unset or not a number from min to max
+ */
+static uint32_t _get_param(char *name, uint32_t def_val, uint32_t min,
+			   uint32_t max)
+{
+	char *tmp_ptr, *end_ptr = NULL;
+	long val;
+
+	if (!(tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params, name)))
+		return def_val;
+
+	tmp_ptr += strlen(name);
+	errno = 0;
+	val = strtol(tmp_ptr, &end_ptr, 10);
+	if (errno || (end_ptr == tmp_ptr) ||
+	    ((*end_ptr != '\0') && (*end_ptr != ',')) ||
+	    (val < min) || (val > max)) {
+		error("Invalid SlurmctldParameters %s%.*s, using default of %u",
+		      name, (int) strcspn(tmp_ptr, ","), tmp_ptr, def_val);
+		return def_val;
+	}
+
+	return val;
+}
+
+extern void rpc_pool_init(uint32_t max_in_flight)
+{
+	if (pool_threads)
+		return;
+
+	pool_thread_cnt = _get_param("rpc_pool_threads=",
+				     RPC_POOL_THREADS_DEFAULT, 1, INFINITE16);
+	if (pool_thread_cnt > max_in_flight)
+		pool_thread_cnt = max_in_flight;
+
+	query_depth_max = _get_param("rpc_pool_query_depth=",
+				     (max_in_flight / 4), 0, INFINITE);
+
+	debug("%s: starting %u threads, query queue depth limit %u",
+	      __func__, pool_thread_cnt, query_depth_max);
+
+	for (int i = 0; i < POOL_QUEUE_CNT; i++)
+		queues[i].work = list_create(NULL);
+
+	pool_shutdown = false;
+	pool_threads = xcalloc(pool_thread_cnt, sizeof(*pool_threads));
+	for (int i = 0; i < pool_thread_cnt; i++)
+		slurm_thread_create(&pool_threads[i], _pool_worker, NULL);
+
+	if ((read_epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+		fatal("%s: epoll_create1: %m", __func__);
+	read_conns = list_create(NULL);
+	read_shutdown = false;
+	slurm_thread_create(&read_thread, _reader, NULL);
+}
+
+extern void rpc_pool_fini(void)
+{
+	rpc_conn_t *conn;
+
+	if (!pool_threads)
+		return;
+
+	slurm_mutex_lock(&read_mutex);
+	read_shutdown = true;
+	slurm_mutex_unlock(&read_mutex);
+	pthread_join(read_thread, NULL);
+	read_thread = 0;
+
+	/* Requests not fully read by now are dropped */
+	slurm_mutex_lock(&read_mutex);
+	while ((conn = list_peek(read_conns))) {
+		_conn_remove(conn);
+		_conn_drop(conn, SLURM_COMMUNICATIONS_SHUTDOWN_ERROR);
+	}
+	FREE_NULL_LIST(read_conns);
+	close(read_epoll_fd);
+	read_epoll_fd = -1;
+	slurm_mutex_unlock(&read_mutex);
+
+	slurm_mutex_lock(&pool_mutex);
+	pool_shutdown = true;
+	slurm_cond_broadcast(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+
+	for (int i = 0; i < pool_thread_cnt; i++)
+		pthread_join(pool_threads[i], NULL);
+	xfree(pool_threads);
+
+	for (int i = 0; i < POOL_QUEUE_CNT; i++)
+		FREE_NULL_LIST(queues[i].work);
+}
+
+extern void rpc_pool_add_conn(int fd)
+{
+	rpc_conn_t *conn = xmalloc(sizeof(*conn));
+	struct epoll_event ev = { .events = EPOLLIN };
+
+	xassert(pool_threads);
+
+	conn->fd = fd;
+	conn->start = time(NULL);
+	fd_set_nonblocking(fd);
+
+	/*
+	 * Add to read_conns first, the reader may finish reading the request
+	 * before epoll_ctl() returns.
+	 */
+	slurm_mutex_lock(&read_mutex);
+	ev.data.ptr = conn;
+	if (!read_shutdown) {
+		list_append(read_conns, conn);
+		if (!epoll_ctl(read_epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+			slurm_mutex_unlock(&read_mutex);
+			return;
+		}
+		error("%s: epoll_ctl(%d): %m", __func__, fd);
+		list_delete_ptr(read_conns, conn);
+	}
+	slurm_mutex_unlock(&read_mutex);
+
+	close(fd);
+	_conn_free(conn);
+	server_thread_decr();
+}
+
+extern void pack_rpc_pool_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	char *name[POOL_QUEUE_CNT];
+	uint32_t depth[POOL_QUEUE_CNT], depth_max[POOL_QUEUE_CNT];
+	uint32_t count[POOL_QUEUE_CNT], rejected[POOL_QUEUE_CNT];
+	uint32_t wait_max[POOL_QUEUE_CNT];
+	uint64_t wait_time[POOL_QUEUE_CNT];
+
+	slurm_mutex_lock(&pool_mutex);
+	for (int i = 0; i < POOL_QUEUE_CNT; i++) {
+		name[i] = queues[i].name;
+		depth[i] = queues[i].work ? list_count(queues[i].work) : 0;
+		depth_max[i] = queues[i].depth_max;
+		count[i] = queues[i].count;
+		rejected[i] = queues[i].rejected;
+		wait_time[i] = queues[i].wait_time;
+		wait_max[i] = queues[i].wait_max;
+	}
+	slurm_mutex_unlock(&pool_mutex);
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		pack32(pool_thread_cnt, buffer);
+		packstr_array(name, POOL_QUEUE_CNT, buffer);
+		pack32_array(depth, POOL_QUEUE_CNT, buffer);
+		pack32_array(depth_max, POOL_QUEUE_CNT, buffer);
+		pack32_array(count, POOL_QUEUE_CNT, buffer);
+		pack64_array(wait_time, POOL_QUEUE_CNT, buffer);
+		pack32_array(wait_max, POOL_QUEUE_CNT, buffer);
+		pack32_array(rejected, POOL_QUEUE_CNT, buffer);
+	}
+}
+
+extern void reset_rpc_pool_stats(void)
+{
+	slurm_mutex_lock(&pool_mutex);
+	for (int i = 0; i < POOL_QUEUE_CNT; i++) {
+		queues[i].count = 0;
+		queues[i].depth_max = 0;
+		queues[i].rejected = 0;
+		queues[i].wait_time = 0;
+		queues[i].wait_max = 0;
+	}
+	slurm_mutex_unlock(&pool_mutex);
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************\
+ * rpc_pool.h
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _RPC_POOL_H_
+#define _RPC_POOL_H_
+
+#include "src/common/pack.h"
+
+/*
+ * Start the RPC worker pool.
+ * IN max_in_flight - limit on connections queued or being processed
+ */
+extern void rpc_pool_init(uint32_t max_in_flight);
+
+/* Wait for queued work to drain, then stop the worker threads */
+extern void rpc_pool_fini(void);
+
+/*
+ * Read the request from a newly accepted connection on the pool's reader
+ * thread, then queue it by class to be processed by a pool worker.
+ * server_thread_decr() is called when done.
+ */
+extern void rpc_pool_add_conn(int fd);
+
+/* Pack per-queue depth and wait time statistics for sdiag */
+extern void pack_rpc_pool_stats(buf_t *buffer, uint16_t protocol_version);
+
+/* Reset per-queue statistics */
+extern void reset_rpc_pool_stats(void);
+
+#endif
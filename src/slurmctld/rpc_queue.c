@@ -84,6 +84,8 @@ static void *_rpc_queue_worker(void *arg)
 		msg = list_dequeue(q->work);
 
 		if (!msg) {
+			if (processed && q->batch_end_func)
+				q->batch_end_func();
 			unlock_slurmctld(q->locks);
 
 			log_flag(PROTOCOL, "%s(%s): sleeping after processing %d",
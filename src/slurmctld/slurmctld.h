@@ -757,9 +757,8 @@ struct job_record {
 	List het_job_list;		/* List of job pointers to all
 					 * components */
 	uint32_t job_id;		/* job ID */
-	job_record_t *job_next;		/* next entry with same hash index */
-	job_record_t *job_array_next_j;	/* job array linked list by job_id */
-	job_record_t *job_array_next_t;	/* job array linked list by task_id */
+	job_record_t *job_array_next_j;	/* next task record of this array */
+	job_record_t *job_array_prev_j;	/* previous task record of this array */
 	job_record_t *job_preempt_comp; /* het job preempt component */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint32_t job_state;		/* state of the job */
@@ -829,6 +828,8 @@ struct job_record {
 					 * this job, confirm the
 					 * value before use */
 	void *qos_blocking_ptr;		/* internal use only, DON'T PACK */
+	uint32_t queue_rank;		/* position in last sorted job queue,
+					 * 0 if none, DON'T PACK */
 	uint8_t reboot;			/* node reboot requested before start */
 	uint16_t restart_cnt;		/* count of restarts */
 	time_t resize_time;		/* time of latest size change */
@@ -840,6 +841,9 @@ struct job_record {
 	struct slurmctld_resv *resv_ptr;/* reservation structure pointer */
 	uint32_t requid;	    	/* requester user ID */
 	char *resp_host;		/* host for srun communications */
+	uint64_t save_hash;		/* fingerprint of the job state last
+					 * saved, 0 if not journaled,
+					 * state save thread only */
 	char *sched_nodes;		/* list of nodes scheduled for job */
 	dynamic_plugin_data_t *select_jobinfo;/* opaque data, BlueGene */
 	char *selinux_context;		/* SELinux context */
@@ -893,6 +897,8 @@ struct job_record {
 					 * assoc_mgr */
 	char *tres_alloc_str;           /* simple tres string for job */
 	char *tres_fmt_alloc_str;       /* formatted tres string for job */
+	uint64_t update_gen;		/* job delta generation of the last
+					 * change, see job_delta_stamp() */
 	uint32_t user_id;		/* user the job runs as */
 	char *user_name;		/* string version of user */
 	uint16_t wait_all_nodes;	/* if set, wait for all nodes to boot
@@ -1192,6 +1198,9 @@ extern void delete_step_records(job_record_t *job_ptr);
 /* free_step_record - delete a step record's data structures */
 extern void free_step_record(void *x);
 
+/* step_pool_fini - release step record memory, all steps must be freed */
+extern void step_pool_fini(void);
+
 /*
  * Copy a job's dependency list
  * IN depend_list_src - a job's depend_lst
@@ -1415,6 +1424,28 @@ extern int job_fail_qos(job_record_t *job_ptr, const char *func_name);
  */
 extern void delete_job_desc_files(uint32_t job_id);
 
+/*
+ * purge_shared_job_files - remove script and environment files which are no
+ *	longer used by any job from the job_files directory of
+ *	SlurmStateSaveLocation
+ */
+extern void purge_shared_job_files(void);
+
+/*
+ * stage_job_desc_files - write the script and environment of a batch job
+ *	being submitted to a staging directory in SlurmStateSaveLocation,
+ *	recorded for this job_desc until it is used or unstaged. Once the
+ *	job is created with the job write lock held, the directory is renamed
+ *	rather than the files written.
+ *	Nothing is staged on failure, the files are then written as before.
+ * NOTE: Call without slurmctld locks, and call unstage_job_desc_files()
+ *	once the job is created or rejected.
+ */
+extern void stage_job_desc_files(job_desc_msg_t *job_desc);
+
+/* Remove files staged by stage_job_desc_files() but not used for a job */
+extern void unstage_job_desc_files(job_desc_msg_t *job_desc);
+
 /*
  * job_alloc_info - get details about an existing job allocation
  * IN uid - job issuing the code
@@ -1974,6 +2005,30 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 			   uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			   uint16_t protocol_version);
 
+/*
+ * job_delta_stamp - note a change to a job so that delta job info requests
+ *	send it again. Call wherever last_job_update is set for the job.
+ * NOTE: Call with job write lock
+ */
+extern void job_delta_stamp(job_record_t *job_ptr);
+
+/*
+ * pack_delta_jobs - dump the jobs created, modified or purged since the
+ *	job delta generation supplied by the client
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN req - client's job delta epoch, generation and show_flags
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS or SLURM_NO_CHANGE_IN_DATA (buffer not set)
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ * NOTE: change _unpack_job_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ */
+extern int pack_delta_jobs(char **buffer_ptr, int *buffer_size,
+			   job_info_delta_request_msg_t *req, uid_t uid,
+			   uint16_t protocol_version);
+
 /*
  * pack_all_node - dump all configuration and node information for all nodes
  *	in machine independent form (for network transmission)
@@ -1991,10 +2046,17 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
 			   uint16_t protocol_version);
 
+/* Pack job_id, array_job_id and array task index statistics */
+extern void pack_job_hash_stats(buf_t *buffer, uint16_t protocol_version);
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version);
 
+/* Append the statistics added after the RPC statistics */
+extern void pack_extra_stat(int resp, char **buffer_ptr, int *buffer_size,
+			    uint16_t protocol_version);
+
 /*
  * pack_ctld_job_step_info_response_msg - packs job step info
  * IN step_id - specific id or NO_VAL/NO_VAL for all
@@ -2092,6 +2154,13 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 /* part_is_visible - should user be able to see this partition */
 extern bool part_is_visible(part_record_t *part_ptr, uid_t uid);
 
+/*
+ * part_all_visible - true if every partition is visible to every user, so
+ *	partition filtering does not depend on the requesting user
+ * NOTE: READ lock_slurmctld partition before entry
+ */
+extern bool part_all_visible(void);
+
 /* part_is_visible_user_rec - should user be able to see this partition */
 extern bool part_is_visible_user_rec(part_record_t *part_ptr,
 				     slurmdb_user_rec_t *user);
@@ -2187,7 +2256,7 @@ extern void qos_list_build(char *qos, bitstr_t **qos_bits);
 extern void queue_job_scheduler(void);
 
 /*
- * rehash_jobs - Create or rebuild the job hash table.
+ * rehash_jobs - Create the job hash tables, which grow as needed.
  * NOTE: run lock_slurmctld before entry: Read config, write job
  */
 extern void rehash_jobs(void);
@@ -2228,6 +2297,9 @@ extern void reset_node_load(char *node_name, uint32_t cpu_load);
 /* Reset a node's free memory value */
 extern void reset_node_free_mem(char *node_name, uint64_t free_mem);
 
+/* Reset job index lookup statistics */
+extern void reset_job_hash_stats(void);
+
 /* Reset all scheduling statistics
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level);
@@ -2576,6 +2648,13 @@ extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
  */
 extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up);
 
+/*
+ * validate_node_specs_batch_end - apply the node features reported by a
+ *	batch of queued registrations, once for each distinct value
+ * NOTE: Node write lock must still be held from validate_node_specs()
+ */
+extern void validate_node_specs_batch_end(void);
+
 /*
  * validate_nodes_via_front_end - validate all nodes on a cluster as having
  *	a valid configuration as soon as the front-end registers. Individual
@@ -37,16 +37,124 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/rpc_pool.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/common/forward.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
+#include "src/common/slab.h"
 #include "src/common/xstring.h"
 #include "src/common/slurmdbd_defs.h"
 
 extern int retry_list_size(void);
 
+/* Pack record pool (slab) usage */
+static void _pack_slab_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	slab_stats_t *stats;
+	uint32_t cnt = slab_get_stats(&stats);
+	char **name = xcalloc(cnt, sizeof(*name));
+	uint32_t *obj_size = xcalloc(cnt, sizeof(*obj_size));
+	uint32_t *in_use = xcalloc(cnt, sizeof(*in_use));
+	uint32_t *slabs = xcalloc(cnt, sizeof(*slabs));
+	uint64_t *allocs = xcalloc(cnt, sizeof(*allocs));
+
+	for (int i = 0; i < cnt; i++) {
+		name[i] = stats[i].name;
+		obj_size[i] = stats[i].obj_size;
+		in_use[i] = stats[i].in_use;
+		slabs[i] = stats[i].slabs;
+		allocs[i] = stats[i].allocs;
+	}
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		packstr_array(name, cnt, buffer);
+		pack32_array(obj_size, cnt, buffer);
+		pack32_array(in_use, cnt, buffer);
+		pack32_array(slabs, cnt, buffer);
+		pack64_array(allocs, cnt, buffer);
+	}
+
+	xfree(name);
+	xfree(obj_size);
+	xfree(in_use);
+	xfree(slabs);
+	xfree(allocs);
+	slab_free_stats(stats, cnt);
+}
+
+/* Pack message forwarding hop latency and failures */
+static void _pack_fwd_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	fwd_stats_t stats;
+
+	forward_get_stats(&stats);
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		pack32_array(stats.hop_usec, FWD_HOP_BUCKETS, buffer);
+		pack32_array(stats.hop_cnt, FWD_HOP_BUCKETS, buffer);
+		pack32(stats.failed, buffer);
+		pack32(stats.rerouted, buffer);
+	}
+}
+
+/* Pack lock wait and hold times by calling function */
+static void _pack_lock_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	lock_stats_t *stats = NULL;
+	uint32_t bucket_usec[LOCK_STATS_BUCKETS];
+	uint32_t cnt = lock_stats_get(&stats, bucket_usec);
+	char **caller = xcalloc(cnt, sizeof(*caller));
+	uint16_t *type = xcalloc(cnt, sizeof(*type));
+	uint16_t *level = xcalloc(cnt, sizeof(*level));
+	uint32_t *lock_cnt = xcalloc(cnt, sizeof(*lock_cnt));
+	uint64_t *wait_usec = xcalloc(cnt, sizeof(*wait_usec));
+	uint64_t *hold_usec = xcalloc(cnt, sizeof(*hold_usec));
+	uint32_t *wait_cnt = xcalloc(cnt * LOCK_STATS_BUCKETS,
+				     sizeof(*wait_cnt));
+	uint32_t *hold_cnt = xcalloc(cnt * LOCK_STATS_BUCKETS,
+				     sizeof(*hold_cnt));
+
+	for (int i = 0; i < cnt; i++) {
+		caller[i] = stats[i].caller;
+		type[i] = stats[i].type;
+		level[i] = stats[i].level;
+		lock_cnt[i] = stats[i].cnt;
+		wait_usec[i] = stats[i].wait_usec;
+		hold_usec[i] = stats[i].hold_usec;
+		memcpy(&wait_cnt[i * LOCK_STATS_BUCKETS], stats[i].wait_cnt,
+		       sizeof(stats[i].wait_cnt));
+		memcpy(&hold_cnt[i * LOCK_STATS_BUCKETS], stats[i].hold_cnt,
+		       sizeof(stats[i].hold_cnt));
+	}
+
+	if (protocol_version >= SLURM_22_05_PROTOCOL_VERSION) {
+		pack32_array(bucket_usec, LOCK_STATS_BUCKETS, buffer);
+		packstr_array(caller, cnt, buffer);
+		pack16_array(type, cnt, buffer);
+		pack16_array(level, cnt, buffer);
+		pack32_array(lock_cnt, cnt, buffer);
+		pack64_array(wait_usec, cnt, buffer);
+		pack64_array(hold_usec, cnt, buffer);
+		pack32_array(wait_cnt, cnt * LOCK_STATS_BUCKETS, buffer);
+		pack32_array(hold_cnt, cnt * LOCK_STATS_BUCKETS, buffer);
+	}
+
+	xfree(caller);
+	xfree(type);
+	xfree(level);
+	xfree(lock_cnt);
+	xfree(wait_usec);
+	xfree(hold_usec);
+	xfree(wait_cnt);
+	xfree(hold_cnt);
+	lock_stats_free(stats, cnt);
+}
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version)
@@ -147,6 +255,31 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
+/*
+ * Append the job hash, RPC pool, record pool, forwarding and lock statistics
+ * to a buffer made by pack_all_stat() and the RPC statistics after it
+ */
+extern void pack_extra_stat(int resp, char **buffer_ptr, int *buffer_size,
+			    uint16_t protocol_version)
+{
+	buf_t *buffer;
+
+	if (!resp)
+		return;
+
+	buffer = create_buf(*buffer_ptr, *buffer_size);
+	set_buf_offset(buffer, *buffer_size);
+
+	pack_job_hash_stats(buffer, protocol_version);
+	pack_rpc_pool_stats(buffer, protocol_version);
+	_pack_slab_stats(buffer, protocol_version);
+	_pack_fwd_stats(buffer, protocol_version);
+	_pack_lock_stats(buffer, protocol_version);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /* Reset all scheduling statistics
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level)
@@ -181,5 +314,10 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 
+	reset_job_hash_stats();
+	reset_rpc_pool_stats();
+	forward_reset_stats();
+	lock_stats_reset();
+
 	last_proc_req_start = time(NULL);
 }
@@ -58,6 +58,7 @@
 #include "src/common/forward.h"
 #include "src/common/gres.h"
 #include "src/common/node_select.h"
+#include "src/common/slab.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -87,6 +88,8 @@ typedef struct {
 	uid_t uid;
 } step_signal_t;
 
+static slab_pool_t *step_record_pool = NULL;
+
 static void _build_pending_step(job_record_t *job_ptr,
 				job_step_create_request_msg_t *step_specs);
 static int _step_partial_comp(step_record_t *step_ptr,
@@ -170,7 +173,7 @@ static int _opt_node_cnt(uint32_t step_min_nodes, uint32_t step_max_nodes,
  * IN job_ptr - pointer to job table entry to have step record added
  * IN protocol_version - slurm protocol version of client
  * RET a pointer to the record or NULL if error
- * NOTE: allocates memory that should be xfreed with delete_step_record
+ * NOTE: allocates memory that should be freed with free_step_record
  */
 static step_record_t *_create_step_record(job_record_t *job_ptr,
 					  uint16_t protocol_version)
@@ -187,7 +190,10 @@ static step_record_t *_create_step_record(job_record_t *job_ptr,
 		return NULL;
 	}
 
-	step_ptr = xmalloc(sizeof(*step_ptr));
+	if (!step_record_pool)
+		step_record_pool = slab_pool_create("step_record",
+						    sizeof(step_record_t));
+	step_ptr = slab_alloc(step_record_pool);
 
 	last_job_update = time(NULL);
 	step_ptr->job_ptr    = job_ptr;
@@ -466,7 +472,13 @@ extern void free_step_record(void *x)
 	xfree(step_ptr->tres_per_task);
 	xfree(step_ptr->memory_allocated);
 	step_ptr->magic = ~STEP_MAGIC;
-	xfree(step_ptr);
+	slab_free(step_record_pool, step_ptr);
+}
+
+extern void step_pool_fini(void)
+{
+	slab_pool_destroy(step_record_pool);
+	step_record_pool = NULL;
 }
 
 /*
@@ -53,6 +53,7 @@
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <grp.h>
+#include <poll.h>
 #include <pthread.h>
 #include <sched.h>
 #include <stdlib.h>
@@ -60,6 +61,7 @@
 #include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -80,6 +82,7 @@
 #include "src/common/list.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/net.h"
 #include "src/common/node_conf.h"
 #include "src/common/node_features.h"
 #include "src/common/node_select.h"
@@ -142,7 +145,11 @@ bool tres_packed = false;
  * count of active threads
  */
 static int             active_threads = 0;
+static int             idle_threads   = 0;	/* waiting on kept connections,
+						 * count toward MAX_THREADS */
+static int             thread_waiters = 0;	/* waiting for a thread slot */
 static pthread_mutex_t active_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static bool            reconfig_running = false;	/* active_mutex */
 static pthread_cond_t  active_cond    = PTHREAD_COND_INITIALIZER;
 
 static pthread_mutex_t fork_mutex     = PTHREAD_MUTEX_INITIALIZER;
@@ -204,6 +211,7 @@ static int       _resource_spec_init(void);
 static int       _restore_cred_state(slurm_cred_ctx_t ctx);
 static void      _select_spec_cores(void);
 static void     *_service_connection(void *);
+static bool      _wait_next_msg(int fd);
 static int       _set_slurmd_spooldir(const char *dir);
 static int       _set_topo_info(void);
 static int       _set_work_dir(void);
@@ -455,10 +463,17 @@ _msg_engine(void)
 			START_TIMER;
 			verbose("got reconfigure request");
 			/* Wait for RPCs to finish */
+			slurm_mutex_lock(&active_mutex);
+			reconfig_running = true;
+			slurm_mutex_unlock(&active_mutex);
 			_wait_for_all_threads(rpc_wait);
 			if (_shutdown)
 				break;
 			_reconfigure();
+			slurm_mutex_lock(&active_mutex);
+			reconfig_running = false;
+			slurm_cond_broadcast(&active_cond);
+			slurm_mutex_unlock(&active_mutex);
 			END_TIMER3("_reconfigure request - slurmd doesn't accept new connections during this time.",
 				   5000000);
 		}
@@ -503,13 +518,16 @@ _increment_thd_count(void)
 	bool logged = false;
 
 	slurm_mutex_lock(&active_mutex);
-	while (active_threads >= MAX_THREADS) {
+	while ((active_threads + idle_threads) >= MAX_THREADS) {
 		if (!logged) {
 			info("active_threads == MAX_THREADS(%d)",
 			     MAX_THREADS);
 			logged = true;
 		}
+		/* Idle kept connections give way, see _wait_next_msg() */
+		thread_waiters++;
 		slurm_cond_wait(&active_cond, &active_mutex);
+		thread_waiters--;
 	}
 	active_threads++;
 	slurm_mutex_unlock(&active_mutex);
@@ -556,14 +574,89 @@ static void _handle_connection(int fd, slurm_addr_t *cli)
 	slurm_thread_create_detached(NULL, _service_connection, arg);
 }
 
+/* RET true if a message can be read from fd without waiting */
+static bool _msg_pending(int fd, int timeout_ms, bool *closed)
+{
+	struct pollfd pfd;
+	char c;
+	int rc;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	while (((rc = poll(&pfd, 1, timeout_ms)) < 0) && (errno == EINTR))
+		;
+	if (rc == 0)
+		return false;
+	/* Readable without data once the sender closes it */
+	if ((rc < 0) || (recv(fd, &c, 1, MSG_PEEK) <= 0)) {
+		*closed = true;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Wait for another message on a connection the sender asked to keep open.
+ * The thread is counted as idle rather than active while it waits, so an
+ * idle connection does not hold up reconfiguration. Idle threads still count
+ * toward MAX_THREADS, and give up their connection when a new one is waiting
+ * for a thread.
+ * A message already sent on the connection is always served before it is
+ * closed, as the sender does not send it again once it was written.
+ * RET true if a message is ready to be read, the thread is active again,
+ *	otherwise the thread is no longer counted
+ */
+static bool _wait_next_msg(int fd)
+{
+	bool closed = false, resume = false;
+	int i;
+
+	slurm_mutex_lock(&active_mutex);
+	if (active_threads > 0)
+		active_threads--;
+	idle_threads++;
+	slurm_cond_signal(&active_cond);
+	slurm_mutex_unlock(&active_mutex);
+
+	/* Replies are written in two parts, do not hold back the second */
+	net_set_nodelay(fd);
+	for (i = 0; i < KEEP_CONN_IDLE_SECS; i++) {
+		if (_shutdown || _reconfig || thread_waiters)
+			break;
+		if ((resume = _msg_pending(fd, 1000, &closed)) || closed)
+			break;
+	}
+	/* Catch a message sent just before giving up the connection */
+	if (!resume && !closed)
+		resume = _msg_pending(fd, 0, &closed);
+
+	slurm_mutex_lock(&active_mutex);
+	/* Do not serve the message while slurmd is being reconfigured */
+	while (resume && reconfig_running && !_shutdown)
+		slurm_cond_wait(&active_cond, &active_mutex);
+	idle_threads--;
+	if (resume && !_shutdown)
+		active_threads++;
+	else
+		resume = false;
+	slurm_cond_broadcast(&active_cond);
+	slurm_mutex_unlock(&active_mutex);
+
+	return resume;
+}
+
 static void *
 _service_connection(void *arg)
 {
 	conn_t *con = (conn_t *) arg;
-	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	slurm_msg_t *msg;
 	int rc = SLURM_SUCCESS;
+	bool close_conn, keep_conn;
 
 	debug3("in the service_connection");
+next_msg:
+	msg = xmalloc(sizeof(slurm_msg_t));
 	slurm_msg_t_init(msg);
 	if ((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr, msg))
 	   != SLURM_SUCCESS) {
@@ -581,14 +674,27 @@ _service_connection(void *arg)
 	slurmd_req(msg);
 
 cleanup:
-	if ((msg->conn_fd >= 0) && close(msg->conn_fd) < 0)
-		error ("close(%d): %m", con->fd);
+	/*
+	 * Handlers may close the connection or take it over. Only slurmctld
+	 * keeps connections open, any other user would hold a thread.
+	 */
+	close_conn = (msg->conn_fd >= 0);
+	keep_conn = (close_conn && (rc == SLURM_SUCCESS) &&
+		     (msg->flags & SLURM_MSG_KEEP_CONN) &&
+		     msg->auth_uid_set &&
+		     ((msg->auth_uid == 0) ||
+		      (msg->auth_uid == slurm_conf.slurm_user_id)));
+	debug2("Finish processing RPC: %s", rpc_num2string(msg->msg_type));
+	slurm_free_msg(msg);
+	if (keep_conn && _wait_next_msg(con->fd))
+		goto next_msg;
+	if (!keep_conn)
+		_decrement_thd_count();
 
+	if (close_conn && (close(con->fd) < 0))
+		error ("close(%d): %m", con->fd);
 	xfree(con->cli_addr);
 	xfree(con);
-	debug2("Finish processing RPC: %s", rpc_num2string(msg->msg_type));
-	slurm_free_msg(msg);
-	_decrement_thd_count();
 	return NULL;
 }
 
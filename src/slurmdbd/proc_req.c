@@ -918,16 +918,15 @@ static int _get_events(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	return rc;
 }
 
-static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
-			  buf_t **out_buffer, uint32_t *uid)
+/*
+ * Reject a query of runaway jobs or one spanning more than MaxQueryTimeRange
+ * unless the user is an operator.
+ * RET SLURM_SUCCESS, or SLURM_ERROR with the reply in out_buffer.
+ */
+static int _check_jobs_cond(slurmdbd_conn_t *slurmdbd_conn,
+			    slurmdb_job_cond_t *job_cond, uint16_t msg_type,
+			    buf_t **out_buffer, uint32_t *uid)
 {
-	dbd_cond_msg_t *cond_msg = msg->data;
-	dbd_list_msg_t list_msg = { NULL };
-	slurmdb_job_cond_t *job_cond = cond_msg->cond;
-	int rc = SLURM_SUCCESS;
-
-	debug2("DBD_GET_JOBS_COND: called in CONN %d", slurmdbd_conn->conn->fd);
-
 	/* fail early if requesting runaways and not super user */
 	if ((job_cond->flags & JOBCOND_FLAG_RUNAWAY) &&
 	    !_validate_operator(*uid, slurmdbd_conn)) {
@@ -936,7 +935,7 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			slurmdbd_conn->conn,
 			ESLURM_ACCESS_DENIED,
 			"You must have an AdminLevel>=Operator to fix runaway jobs",
-			DBD_GET_JOBS_COND);
+			msg_type);
 		return SLURM_ERROR;
 	}
 	/* fail early if too wide a query */
@@ -957,11 +956,28 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
 								ESLURM_DB_QUERY_TOO_WIDE,
 								slurm_strerror(ESLURM_DB_QUERY_TOO_WIDE),
-								DBD_GET_JOBS_COND);
+								msg_type);
 			return SLURM_ERROR;
 		}
 	}
 
+	return SLURM_SUCCESS;
+}
+
+static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
+			  buf_t **out_buffer, uint32_t *uid)
+{
+	dbd_cond_msg_t *cond_msg = msg->data;
+	dbd_list_msg_t list_msg = { NULL };
+	slurmdb_job_cond_t *job_cond = cond_msg->cond;
+	int rc = SLURM_SUCCESS;
+
+	debug2("DBD_GET_JOBS_COND: called in CONN %d", slurmdbd_conn->conn->fd);
+
+	if (_check_jobs_cond(slurmdbd_conn, job_cond, DBD_GET_JOBS_COND,
+			     out_buffer, uid) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
 	list_msg.my_list = jobacct_storage_g_get_jobs_cond(
 		slurmdbd_conn->db_conn, *uid, job_cond);
 
@@ -985,6 +1001,65 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	return rc;
 }
 
+/* Send one DBD_GOT_JOBS_CHUNK reply ahead of the final DBD_GOT_JOBS */
+static int _send_jobs_chunk(List job_list, void *arg)
+{
+	slurmdbd_conn_t *slurmdbd_conn = arg;
+	dbd_list_msg_t list_msg = { .my_list = job_list };
+	buf_t *buffer = init_buf(BUF_SIZE);
+	int rc;
+
+	pack16((uint16_t) DBD_GOT_JOBS_CHUNK, buffer);
+	slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
+			       DBD_GOT_JOBS_CHUNK, buffer);
+	rc = slurm_persist_send_msg(slurmdbd_conn->conn, buffer);
+	free_buf(buffer);
+
+	if (rc != SLURM_SUCCESS)
+		error("CONN:%d Failed to send DBD_GOT_JOBS_CHUNK: %m",
+		      slurmdbd_conn->conn->fd);
+	return rc;
+}
+
+static int _get_jobs_cond_chunked(slurmdbd_conn_t *slurmdbd_conn,
+				  persist_msg_t *msg, buf_t **out_buffer,
+				  uint32_t *uid)
+{
+	dbd_cond_msg_t *cond_msg = msg->data;
+	dbd_list_msg_t list_msg = { NULL };
+	slurmdb_job_cond_t *job_cond = cond_msg->cond;
+	int rc;
+
+	debug2("DBD_GET_JOBS_COND_CHUNKED: called in CONN %d",
+	       slurmdbd_conn->conn->fd);
+
+	if (_check_jobs_cond(slurmdbd_conn, job_cond,
+			     DBD_GET_JOBS_COND_CHUNKED, out_buffer,
+			     uid) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	rc = jobacct_storage_g_get_jobs_cond_chunked(
+		slurmdbd_conn->db_conn, *uid, job_cond, _send_jobs_chunk,
+		slurmdbd_conn);
+
+	if (rc == SLURM_SUCCESS) {
+		/* An empty DBD_GOT_JOBS ends the reply */
+		list_msg.my_list = list_create(NULL);
+		*out_buffer = init_buf(1024);
+		pack16((uint16_t) DBD_GOT_JOBS, *out_buffer);
+		slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
+				       DBD_GOT_JOBS, *out_buffer);
+		FREE_NULL_LIST(list_msg.my_list);
+	} else {
+		*out_buffer = slurm_persist_make_rc_msg(
+			slurmdbd_conn->conn, rc, slurm_strerror(rc),
+			DBD_GET_JOBS_COND_CHUNKED);
+		rc = SLURM_ERROR;
+	}
+
+	return rc;
+}
+
 static int _get_probs(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 		      buf_t **out_buffer, uint32_t *uid)
 {
@@ -3244,6 +3319,10 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 	case DBD_GET_JOBS_COND:
 		rc = _get_jobs_cond(slurmdbd_conn, msg, out_buffer, uid);
 		break;
+	case DBD_GET_JOBS_COND_CHUNKED:
+		rc = _get_jobs_cond_chunked(slurmdbd_conn, msg, out_buffer,
+					    uid);
+		break;
 	case DBD_GET_PROBS:
 		rc = _get_probs(slurmdbd_conn, msg, out_buffer, uid);
 		break;
@@ -0,0 +1,179 @@
+/*
+ * bf_plan-test - check that the backfill plan pool evaluates every plan of a
+ *	batch exactly once and report the time taken by a batch of CPU bound
+ *	tests with 1 to 16 threads
+ *
+ * Usage: bf_plan-test [plan_count [usec_per_plan]]
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/xmalloc.h"
+#include "src/plugins/sched/backfill/bf_plan.h"
+
+#include <testsuite/dejagnu.h>
+
+#define PLAN_COUNT	64
+#define USEC_PER_PLAN	2000
+#define NODE_COUNT	1000
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+/* slurmctld functions used by bf_plan.c */
+extern void borrow_slurmctld_locks(slurmctld_lock_t lock_levels)
+{
+}
+
+extern void return_slurmctld_locks(slurmctld_lock_t lock_levels)
+{
+}
+
+static int eval_usec = USEC_PER_PLAN;
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+/* Spin for eval_usec, then record the evaluation in the plan */
+static void _eval(bf_plan_t *plan)
+{
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while (_usec(&start, &now) < eval_usec);
+
+	plan->rc++;
+	plan->start_time = (time_t) pthread_self();
+}
+
+static void _run(bf_plan_t **plans, int plan_cnt, int thread_cnt,
+		 slurmctld_lock_t locks)
+{
+	struct timespec start, end;
+	char msg[128];
+	int i, j, bad = 0, used = 0;
+
+	for (i = 0; i < plan_cnt; i++)
+		plans[i]->rc = 0;
+
+	bf_plan_pool_init(thread_cnt, locks);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bf_plan_pool_run(plans, plan_cnt, _eval);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < plan_cnt; i++) {
+		if (plans[i]->rc != 1)
+			bad++;
+		for (j = 0; j < i; j++) {
+			if (plans[j]->start_time == plans[i]->start_time)
+				break;
+		}
+		if (j == i)
+			used++;
+	}
+	printf("%2d threads: %d plans in %.0f usec, %d threads used\n",
+	       thread_cnt, plan_cnt, _usec(&start, &end), used);
+
+	snprintf(msg, sizeof(msg), "%d threads: each plan evaluated once",
+		 thread_cnt);
+	TEST(bad, msg);
+}
+
+static void _test_match(job_record_t *job, part_record_t *part)
+{
+	bitstr_t *avail = bit_alloc(NODE_COUNT), *cores = bit_alloc(64);
+	bf_plan_t *plan1, *plan2;
+
+	bit_nset(avail, 10, 99);
+	plan1 = bf_plan_create(job, part, 1, 4, 4, 0, avail, NULL);
+	plan2 = bf_plan_create(job, part, 1, 4, 4, 0, avail, NULL);
+	TEST(!bf_plan_match(plan1, plan2), "match: identical inputs");
+	bf_plan_free(plan2);
+
+	bit_clear(avail, 50);
+	plan2 = bf_plan_create(job, part, 1, 4, 4, 0, avail, NULL);
+	TEST(bf_plan_match(plan1, plan2), "match: different nodes");
+	bf_plan_free(plan2);
+
+	bit_set(avail, 50);
+	plan2 = bf_plan_create(job, part, 1, 4, 4, TEST_NOW_ONLY, avail, NULL);
+	TEST(bf_plan_match(plan1, plan2), "match: different test flags");
+	bf_plan_free(plan2);
+
+	plan2 = bf_plan_create(job, part, 1, 4, 4, 0, avail, cores);
+	TEST(bf_plan_match(plan1, plan2), "match: excluded cores");
+	bf_plan_free(plan2);
+
+	job->time_limit++;
+	plan2 = bf_plan_create(job, part, 1, 4, 4, 0, avail, NULL);
+	TEST(bf_plan_match(plan1, plan2), "match: different time limit");
+	bf_plan_free(plan2);
+
+	bf_plan_free(plan1);
+	bit_free(avail);
+	bit_free(cores);
+}
+
+int main(int argc, char *argv[])
+{
+	slurmctld_lock_t locks = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	int plan_cnt = PLAN_COUNT, i;
+	int threads[] = { 1, 2, 4, 8, 16 };
+	job_record_t *jobs;
+	struct job_details *details;
+	part_record_t part = { 0 };
+	bitstr_t *avail = bit_alloc(NODE_COUNT);
+	bf_plan_t **plans;
+
+	if (argc > 1)
+		plan_cnt = atoi(argv[1]);
+	if (argc > 2)
+		eval_usec = atoi(argv[2]);
+	if ((plan_cnt <= 0) || (eval_usec < 0)) {
+		fprintf(stderr, "Usage: %s [plan_count [usec_per_plan]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	jobs = xcalloc(plan_cnt, sizeof(*jobs));
+	details = xcalloc(plan_cnt, sizeof(*details));
+	plans = xcalloc(plan_cnt, sizeof(*plans));
+	for (i = 0; i < plan_cnt; i++) {
+		jobs[i].details = &details[i];
+		jobs[i].time_limit = 60;
+		plans[i] = bf_plan_create(&jobs[i], &part, 1, 1, 1, 0, avail,
+					  NULL);
+	}
+
+	_test_match(&jobs[0], &part);
+	for (i = 0; i < (sizeof(threads) / sizeof(threads[0])); i++)
+		_run(plans, plan_cnt, threads[i], locks);
+	bf_plan_pool_fini();
+
+	for (i = 0; i < plan_cnt; i++)
+		bf_plan_free(plans[i]);
+	xfree(plans);
+	xfree(details);
+	xfree(jobs);
+	bit_free(avail);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,222 @@
+/*
+ * bit_ops-test - check the word level bitstring set operations against bit by
+ *	bit reference versions and report their cost on 1k to 100k bit maps
+ *
+ * Usage: bit_ops-test [iterations]
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/common/bitstring.h"
+
+#include <testsuite/dejagnu.h>
+
+#define ITERATIONS	2000
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static int sizes[] = { 1, 63, 64, 65, 1000, 1024, 4097, 10000, 65536, 100000 };
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+/* Set roughly one bit in density, leaving padding bits set as bit_not does */
+static bitstr_t *_random_map(int nbits, int density)
+{
+	bitstr_t *b = bit_alloc(nbits);
+	int i;
+
+	for (i = 0; i < nbits; i++) {
+		if ((random() % density) != 0)
+			bit_set(b, i);
+	}
+	bit_not(b);
+
+	return b;
+}
+
+static int _ref_count(bitstr_t *b1, bitstr_t *b2)
+{
+	int i, cnt = 0;
+
+	for (i = 0; i < bit_size(b1); i++) {
+		if (bit_test(b1, i) && (!b2 || bit_test(b2, i)))
+			cnt++;
+	}
+
+	return cnt;
+}
+
+static int _ref_super_set(bitstr_t *b1, bitstr_t *b2)
+{
+	int i;
+
+	for (i = 0; i < bit_size(b1); i++) {
+		if (bit_test(b1, i) && !bit_test(b2, i))
+			return 0;
+	}
+
+	return 1;
+}
+
+static bitoff_t _ref_nff(bitstr_t *b, int n, bool set)
+{
+	int i, cnt = 0;
+
+	for (i = 0; i < bit_size(b); i++) {
+		if (bit_test(b, i) != set)
+			cnt = 0;
+		else if (++cnt >= n)
+			return i - (cnt - 1);
+	}
+
+	return -1;
+}
+
+static void _check(int nbits)
+{
+	bitstr_t *b1 = _random_map(nbits, 2);
+	bitstr_t *b2 = _random_map(nbits, 3);
+	bitstr_t *sparse = _random_map(nbits, 500);
+	bitstr_t *tmp = bit_copy(b1), *ref = bit_copy(b1);
+	char msg[128];
+	int i, bad = 0;
+
+	if (bit_set_count(b1) != _ref_count(b1, NULL))
+		bad |= 0x1;
+	if (bit_overlap(b1, b2) != _ref_count(b1, b2))
+		bad |= 0x2;
+	if (bit_overlap_any(b1, sparse) != (_ref_count(b1, sparse) != 0))
+		bad |= 0x4;
+
+	bit_copybits(tmp, b1);
+	bit_and(tmp, b2);
+	for (i = 0; i < nbits; i++) {
+		if (bit_test(tmp, i) != (bit_test(b1, i) && bit_test(b2, i)))
+			bad |= 0x8;
+	}
+	bit_copybits(ref, b1);
+	if ((bit_and_count(ref, b2) != _ref_count(b1, b2)) ||
+	    !bit_equal(ref, tmp))
+		bad |= 0x10;
+
+	bit_copybits(tmp, b1);
+	bit_or(tmp, b2);
+	for (i = 0; i < nbits; i++) {
+		if (bit_test(tmp, i) != (bit_test(b1, i) || bit_test(b2, i)))
+			bad |= 0x20;
+	}
+	if (!bit_super_set(b1, tmp) || !bit_super_set(b2, tmp) ||
+	    (bit_super_set(tmp, b1) != _ref_super_set(tmp, b1)))
+		bad |= 0x40;
+
+	bit_copybits(tmp, b1);
+	bit_and_not(tmp, b2);
+	for (i = 0; i < nbits; i++) {
+		if (bit_test(tmp, i) != (bit_test(b1, i) && !bit_test(b2, i)))
+			bad |= 0x80;
+	}
+
+	for (i = 1; (i <= 8) && (i < nbits); i++) {
+		if ((bit_nffc(sparse, i) != _ref_nff(sparse, i, false)) ||
+		    (bit_nffs(b1, i) != _ref_nff(b1, i, true)))
+			bad |= 0x100;
+	}
+	if ((bit_ffc(b1) != _ref_nff(b1, 1, false)) ||
+	    (bit_ffs(sparse) != _ref_nff(sparse, 1, true)))
+		bad |= 0x200;
+
+	snprintf(msg, sizeof(msg), "%d bits: results match reference (%#x)",
+		 nbits, bad);
+	TEST(bad, msg);
+
+	bit_free(b1);
+	bit_free(b2);
+	bit_free(sparse);
+	bit_free(tmp);
+	bit_free(ref);
+}
+
+static void _bench(int nbits, int iterations)
+{
+	bitstr_t *b1 = _random_map(nbits, 2);
+	bitstr_t *b2 = _random_map(nbits, 2);
+	bitstr_t *none = bit_alloc(nbits);
+	struct timespec start, end;
+	volatile int32_t sink = 0;
+	double usec[4];
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++)
+		sink += bit_set_count(b1);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usec[0] = _usec(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++) {
+		bit_and(b2, b1);
+		sink += bit_set_count(b2);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usec[1] = _usec(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++)
+		sink += bit_and_count(b2, b1);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usec[2] = _usec(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; i++)
+		sink += bit_overlap_any(b1, none) + bit_super_set(b1, b2);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usec[3] = _usec(&start, &end);
+
+	printf("%6d bits: nsec per call set_count:%.0f and+set_count:%.0f "
+	       "and_count:%.0f overlap_any+super_set:%.0f\n", nbits,
+	       (usec[0] * 1000) / iterations, (usec[1] * 1000) / iterations,
+	       (usec[2] * 1000) / iterations, (usec[3] * 1000) / iterations);
+
+	bit_free(b1);
+	bit_free(b2);
+	bit_free(none);
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = ITERATIONS, i;
+
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+	if (iterations <= 0) {
+		fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	srandom(1);
+	for (i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+		_check(sizes[i]);
+	for (i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		if (sizes[i] >= 1000)
+			_bench(sizes[i], iterations);
+	}
+
+	totals();
+	return failed;
+}
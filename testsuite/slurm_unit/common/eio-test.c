@@ -0,0 +1,289 @@
+/*
+ * eio-test - check that both eio backends deliver events and report their
+ *	wakeup latency with many idle file descriptors, and that events from a
+ *	closed fd's file are not delivered to the next object using its number
+ *
+ * Usage: eio-test [fd_count [wakeup_count]]
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/common/eio.h"
+#include "src/common/read_config.h"
+#include "src/common/xmalloc.h"
+
+#include <testsuite/dejagnu.h>
+
+#define FD_COUNT	10000
+#define WAKEUP_COUNT	1000
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static pthread_mutex_t handled_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t handled_cond = PTHREAD_COND_INITIALIZER;
+static int handled = 0;
+
+static bool _readable(eio_obj_t *obj)
+{
+	return !obj->shutdown;
+}
+
+static int _handle_read(eio_obj_t *obj, List objs)
+{
+	char buf[16];
+
+	while (read(obj->fd, buf, sizeof(buf)) > 0)
+		;
+
+	pthread_mutex_lock(&handled_mutex);
+	handled++;
+	pthread_cond_signal(&handled_cond);
+	pthread_mutex_unlock(&handled_mutex);
+
+	return 0;
+}
+
+static struct io_operations ops = {
+	.readable = _readable,
+	.handle_read = _handle_read,
+};
+
+/* Closes its fd and moves the reuse object onto the same fd number */
+static eio_obj_t *reuse_obj = NULL;
+static int reuse_fd = -1;
+static int spurious = 0;
+
+static int _handle_read_reuse(eio_obj_t *obj, List objs)
+{
+	char buf[16];
+
+	if (read(obj->fd, buf, sizeof(buf)) <= 0) {
+		pthread_mutex_lock(&handled_mutex);
+		spurious++;
+		pthread_mutex_unlock(&handled_mutex);
+		return 0;
+	}
+
+	return _handle_read(obj, objs);
+}
+
+static struct io_operations reuse_ops = {
+	.readable = _readable,
+	.handle_read = _handle_read_reuse,
+};
+
+static int _handle_read_close(eio_obj_t *obj, List objs)
+{
+	int fd = obj->fd;
+
+	close(obj->fd);
+	obj->fd = -1;
+	obj->shutdown = true;
+	if (dup2(reuse_fd, fd) < 0)
+		perror("dup2");
+	close(reuse_fd);
+	reuse_obj = eio_obj_create(fd, &reuse_ops, NULL);
+	list_append(objs, reuse_obj);
+
+	return _handle_read(obj, objs);
+}
+
+static struct io_operations close_ops = {
+	.readable = _readable,
+	.handle_read = _handle_read_close,
+};
+
+static void *_mainloop(void *arg)
+{
+	eio_handle_t *eio = arg;
+	static int rc;
+
+	rc = eio_handle_mainloop(eio);
+	return &rc;
+}
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+static void _run(char *comm_params, char *name, int fd_cnt, int wakeup_cnt)
+{
+	eio_handle_t *eio;
+	pthread_t tid;
+	int (*pipes)[2], i, *rc, created = 0;
+	double usec, total = 0.0, max = 0.0;
+	struct timespec start, end;
+	char msg[256];
+
+	slurm_conf.comm_params = comm_params;
+	eio = eio_handle_create(0);
+	slurm_conf.comm_params = NULL;
+
+	pipes = xcalloc(fd_cnt, sizeof(*pipes));
+	for (i = 0; i < fd_cnt; i++) {
+		if (pipe(pipes[i]) < 0) {
+			perror("pipe");
+			break;
+		}
+		fcntl(pipes[i][0], F_SETFL, O_NONBLOCK);
+		eio_new_initial_obj(eio, eio_obj_create(pipes[i][0], &ops,
+							NULL));
+		created++;
+	}
+	snprintf(msg, sizeof(msg), "%s: created %d pipes", name, fd_cnt);
+	TEST(created != fd_cnt, msg);
+
+	handled = 0;
+	pthread_create(&tid, NULL, _mainloop, eio);
+
+	for (i = 0; i < wakeup_cnt; i++) {
+		/* spread wakeups across the fds */
+		int inx = (int) (((long) i * 7919) % created);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (write(pipes[inx][1], "x", 1) != 1)
+			perror("write");
+		pthread_mutex_lock(&handled_mutex);
+		while (handled <= i)
+			pthread_cond_wait(&handled_cond, &handled_mutex);
+		pthread_mutex_unlock(&handled_mutex);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		usec = _usec(&start, &end);
+		total += usec;
+		if (usec > max)
+			max = usec;
+	}
+
+	eio_signal_shutdown(eio);
+	pthread_join(tid, (void **) &rc);
+
+	printf("%s: %d fds, %d wakeups, latency mean %.1f usec, max %.1f usec\n",
+	       name, created, wakeup_cnt, (total / wakeup_cnt), max);
+
+	snprintf(msg, sizeof(msg), "%s: %d wakeups handled", name, wakeup_cnt);
+	TEST(handled != wakeup_cnt, msg);
+	snprintf(msg, sizeof(msg), "%s: mainloop return code", name);
+	TEST(*rc != 0, msg);
+
+	for (i = 0; i < created; i++) {
+		close(pipes[i][0]);
+		close(pipes[i][1]);
+	}
+	xfree(pipes);
+	eio_handle_destroy(eio);
+}
+
+static void _wait_handled(int cnt)
+{
+	pthread_mutex_lock(&handled_mutex);
+	while (handled < cnt)
+		pthread_cond_wait(&handled_cond, &handled_mutex);
+	pthread_mutex_unlock(&handled_mutex);
+}
+
+/*
+ * Close an fd whose file is still open through a dup(), reuse its number
+ * for another object and write to the old file
+ */
+static void _run_reuse(char *comm_params, char *name)
+{
+	eio_handle_t *eio;
+	pthread_t tid;
+	int old_pipe[2], new_pipe[2], old_dup, *rc;
+	char msg[256];
+
+	if ((pipe(old_pipe) < 0) || (pipe(new_pipe) < 0)) {
+		perror("pipe");
+		return;
+	}
+	fcntl(old_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(new_pipe[0], F_SETFL, O_NONBLOCK);
+	old_dup = dup(old_pipe[0]);
+	reuse_fd = new_pipe[0];
+
+	slurm_conf.comm_params = comm_params;
+	eio = eio_handle_create(0);
+	slurm_conf.comm_params = NULL;
+	eio_new_initial_obj(eio, eio_obj_create(old_pipe[0], &close_ops,
+						NULL));
+
+	handled = 0;
+	spurious = 0;
+	pthread_create(&tid, NULL, _mainloop, eio);
+
+	if (write(old_pipe[1], "x", 1) != 1)
+		perror("write");
+	_wait_handled(1);
+
+	/* Only the file behind old_dup sees this */
+	if (write(old_pipe[1], "x", 1) != 1)
+		perror("write");
+	usleep(100000);
+	if (write(new_pipe[1], "x", 1) != 1)
+		perror("write");
+	_wait_handled(2);
+
+	eio_signal_shutdown(eio);
+	pthread_join(tid, (void **) &rc);
+
+	snprintf(msg, sizeof(msg), "%s: no event from closed fd's file", name);
+	TEST(spurious != 0, msg);
+	snprintf(msg, sizeof(msg), "%s: reused fd mainloop return code", name);
+	TEST(*rc != 0, msg);
+
+	close(reuse_obj->fd);
+	close(old_dup);
+	close(old_pipe[1]);
+	close(new_pipe[1]);
+	eio_handle_destroy(eio);
+}
+
+int main(int argc, char *argv[])
+{
+	int fd_cnt = FD_COUNT, wakeup_cnt = WAKEUP_COUNT;
+	struct rlimit rlim;
+
+	if (argc > 1)
+		fd_cnt = atoi(argv[1]);
+	if (argc > 2)
+		wakeup_cnt = atoi(argv[2]);
+
+	/* Each pipe needs two fds, leave some for everything else */
+	if (!getrlimit(RLIMIT_NOFILE, &rlim)) {
+		rlim.rlim_cur = rlim.rlim_max;
+		(void) setrlimit(RLIMIT_NOFILE, &rlim);
+		(void) getrlimit(RLIMIT_NOFILE, &rlim);
+		if ((rlim.rlim_cur != RLIM_INFINITY) &&
+		    (fd_cnt > ((rlim.rlim_cur - 64) / 2))) {
+			fd_cnt = (rlim.rlim_cur - 64) / 2;
+			printf("NOTE: RLIMIT_NOFILE limits test to %d fds\n",
+			       fd_cnt);
+		}
+	}
+
+	_run("EioPoll", "poll", fd_cnt, wakeup_cnt);
+	_run(NULL, "epoll", fd_cnt, wakeup_cnt);
+	_run_reuse("EioPoll", "poll");
+	_run_reuse(NULL, "epoll");
+
+	totals();
+	return failed;
+}
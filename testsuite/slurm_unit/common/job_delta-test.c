@@ -0,0 +1,126 @@
+/*
+ * job_delta-test - check the job delta generations, purge history and epochs
+ *	behind delta job info requests
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/xmalloc.h"
+#include "src/slurmctld/job_delta.h"
+
+#include <testsuite/dejagnu.h>
+
+#define JOB_COUNT	10
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static job_record_t jobs[JOB_COUNT];
+
+/* Client's view, as squeue keeps it between requests */
+static time_t client_epoch = 0;
+static uint64_t client_gen = 0;
+
+static int _get(time_t part_update, bool *full, uint32_t **purged_ids,
+		uint32_t *purged_cnt)
+{
+	return job_delta_get(part_update, &client_epoch, &client_gen, full,
+			     purged_ids, purged_cnt);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t *purged_ids = NULL, purged_cnt = 0;
+	uint64_t gen;
+	time_t epoch;
+	bool full = false;
+	int i, rc;
+
+	for (i = 0; i < JOB_COUNT; i++) {
+		jobs[i].job_id = i + 1;
+		job_delta_stamp(&jobs[i]);
+	}
+	TEST((jobs[JOB_COUNT - 1].update_gen <= jobs[0].update_gen),
+	     "generations increase");
+
+	/* A new client loads all jobs */
+	rc = _get(1, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || !full || !client_epoch ||
+	      (client_gen != jobs[JOB_COUNT - 1].update_gen)),
+	     "new client gets a full response");
+
+	rc = _get(1, &full, &purged_ids, &purged_cnt);
+	TEST((rc != SLURM_NO_CHANGE_IN_DATA), "no change without stamps");
+
+	/* One changed job, which a delta must send */
+	gen = client_gen;
+	job_delta_stamp(&jobs[3]);
+	rc = _get(1, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || full || purged_cnt ||
+	      (jobs[3].update_gen <= gen) || (jobs[2].update_gen > gen) ||
+	      (client_gen != jobs[3].update_gen)),
+	     "delta has only the changed job");
+
+	/* Purged jobs, only if a client could have seen them */
+	gen = client_gen;
+	job_delta_purge(&jobs[5]);
+	jobs[5].job_id = NO_VAL;
+	job_delta_purge(&jobs[5]);
+	memset(&jobs[6], 0, sizeof(job_record_t));
+	jobs[6].job_id = 7;
+	job_delta_purge(&jobs[6]);
+	rc = _get(1, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || full || (purged_cnt != 1) ||
+	      (purged_ids[0] != 6) || (client_gen <= gen)),
+	     "delta lists each purged job once");
+	xfree(purged_ids);
+
+	/* A client ahead of the controller, as after a restart */
+	client_gen += 100;
+	rc = _get(1, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || !full || purged_cnt),
+	     "unknown generation gets a full response");
+
+	/* Partition changes start a new epoch */
+	epoch = client_epoch;
+	rc = _get(2, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || !full || (client_epoch <= epoch)),
+	     "partition change starts new epoch");
+	client_epoch = epoch;
+	rc = _get(2, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || !full),
+	     "old epoch gets a full response");
+
+	/* Purges beyond the history make older clients load all jobs */
+	gen = client_gen;
+	epoch = client_epoch;
+	for (i = 0; i <= JOB_DELTA_PURGE_MAX; i++) {
+		jobs[7].job_id = 1000 + i;
+		job_delta_purge(&jobs[7]);
+	}
+	rc = _get(2, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || !full || purged_cnt),
+	     "generation older than purge history gets a full response");
+	TEST((client_epoch != epoch), "lost purge history keeps epoch");
+
+	client_gen -= 10;
+	rc = _get(2, &full, &purged_ids, &purged_cnt);
+	TEST(((rc != SLURM_SUCCESS) || full || (purged_cnt != 10) ||
+	      (purged_ids[0] != 1000 + JOB_DELTA_PURGE_MAX - 9) ||
+	      (purged_ids[9] != 1000 + JOB_DELTA_PURGE_MAX)),
+	     "purge history keeps the newest purges in order");
+	xfree(purged_ids);
+
+	job_delta_fini();
+	totals();
+	return failed;
+}
@@ -0,0 +1,310 @@
+/*
+ * job_queue_sort-test - check that job_queue_sort_recs() orders a job queue
+ *	as sort_job_queue2() does and report the time taken to sort it and to
+ *	sort it with list_sort(), with no previous order and after a
+ *	scheduling pass has changed part of the queue
+ *
+ * Usage: job_queue_sort-test [job_count ...]
+ *
+ * Without arguments a queue of JOB_COUNT jobs is checked. Give larger counts,
+ * e.g. "100000 1000000", to time queues of a busy controller.
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/common/list.h"
+#include "src/common/xmalloc.h"
+#include "src/slurmctld/job_queue_sort.h"
+
+#include <testsuite/dejagnu.h>
+
+#define JOB_COUNT	10000
+#define PART_COUNT	4
+#define MULTI_PART_INTERVAL	10	/* one job in 10 uses two partitions */
+#define RESV_INTERVAL	50		/* one job in 50 uses a reservation */
+#define ARRAY_INTERVAL	20		/* one job in 20 is an array task */
+#define CHANGE_INTERVAL	100		/* one job in 100 changes per pass */
+#define SUBMIT_TIME	1000000000
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+typedef struct {
+	job_record_t *jobs;
+	struct job_details *details;
+	job_queue_rec_t *recs;
+	int job_cnt;
+	int rec_cnt;
+	int next_job_id;
+} queue_t;
+
+static part_record_t parts[PART_COUNT];
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+/* sort_job_queue2() without preemption or bf_hetjob_prio */
+static int _ref_sort(void *x, void *y)
+{
+	job_queue_rec_t *job_rec1 = *(job_queue_rec_t **) x;
+	job_queue_rec_t *job_rec2 = *(job_queue_rec_t **) y;
+	bool has_resv1, has_resv2;
+	uint32_t job_id1, job_id2, p1, p2;
+
+	has_resv1 = (job_rec1->job_ptr->resv_id != 0) || job_rec1->resv_ptr;
+	has_resv2 = (job_rec2->job_ptr->resv_id != 0) || job_rec2->resv_ptr;
+	if (has_resv1 && !has_resv2)
+		return -1;
+	if (!has_resv1 && has_resv2)
+		return 1;
+
+	p1 = job_rec1->part_ptr->priority_tier;
+	p2 = job_rec2->part_ptr->priority_tier;
+	if (p1 < p2)
+		return 1;
+	if (p1 > p2)
+		return -1;
+
+	if (job_rec1->job_ptr->part_ptr_list &&
+	    job_rec1->job_ptr->priority_array)
+		p1 = job_rec1->priority;
+	else
+		p1 = job_rec1->job_ptr->priority;
+	if (job_rec2->job_ptr->part_ptr_list &&
+	    job_rec2->job_ptr->priority_array)
+		p2 = job_rec2->priority;
+	else
+		p2 = job_rec2->job_ptr->priority;
+	if (p1 < p2)
+		return 1;
+	if (p1 > p2)
+		return -1;
+
+	if (job_rec1->job_ptr->details->submit_time >
+	    job_rec2->job_ptr->details->submit_time)
+		return 1;
+	if (job_rec2->job_ptr->details->submit_time >
+	    job_rec1->job_ptr->details->submit_time)
+		return -1;
+
+	if (job_rec1->array_task_id == NO_VAL)
+		job_id1 = job_rec1->job_id;
+	else
+		job_id1 = job_rec1->job_ptr->array_job_id;
+	if (job_rec2->array_task_id == NO_VAL)
+		job_id2 = job_rec2->job_id;
+	else
+		job_id2 = job_rec2->job_ptr->array_job_id;
+	if (job_id1 > job_id2)
+		return 1;
+	else if (job_id1 < job_id2)
+		return -1;
+
+	if (job_rec1->array_task_id > job_rec2->array_task_id)
+		return 1;
+
+	return -1;
+}
+
+/* Submit a new pending job in slot inx */
+static void _submit(queue_t *q, int inx)
+{
+	job_record_t *job_ptr = &q->jobs[inx];
+
+	xfree(job_ptr->priority_array);
+	memset(job_ptr, 0, sizeof(*job_ptr));
+	job_ptr->details = &q->details[inx];
+	job_ptr->job_id = q->next_job_id++;
+	job_ptr->priority = random() % 100000;
+	job_ptr->details->submit_time = SUBMIT_TIME + job_ptr->job_id / 4;
+	if ((random() % RESV_INTERVAL) == 0)
+		job_ptr->resv_id = 1;
+	if ((random() % ARRAY_INTERVAL) == 0) {
+		job_ptr->array_job_id = job_ptr->job_id - (random() % 8);
+		job_ptr->array_task_id = job_ptr->job_id % 1000;
+	} else {
+		job_ptr->array_task_id = NO_VAL;
+	}
+	if ((random() % MULTI_PART_INTERVAL) == 0) {
+		job_ptr->part_ptr_list = (List) job_ptr;    /* only tested */
+		job_ptr->priority_array = xcalloc(2, sizeof(uint32_t));
+		job_ptr->priority_array[0] = random() % 100000;
+		job_ptr->priority_array[1] = random() % 100000;
+	}
+}
+
+/* Rebuild the records for the current jobs, as build_job_queue() would */
+static void _build(queue_t *q)
+{
+	int i, p;
+
+	q->rec_cnt = 0;
+	for (i = 0; i < q->job_cnt; i++) {
+		job_record_t *job_ptr = &q->jobs[i];
+
+		for (p = 0; p < (job_ptr->priority_array ? 2 : 1); p++) {
+			job_queue_rec_t *rec = &q->recs[q->rec_cnt++];
+
+			rec->array_task_id = job_ptr->array_task_id;
+			rec->job_id = job_ptr->job_id;
+			rec->job_ptr = job_ptr;
+			rec->part_ptr = &parts[(i + p) % PART_COUNT];
+			if (job_ptr->priority_array)
+				rec->priority = job_ptr->priority_array[p];
+			else
+				rec->priority = job_ptr->priority;
+		}
+	}
+}
+
+/*
+ * One scheduling pass: some jobs started and new ones were submitted in
+ * their place, and the priority of some others was recalculated
+ */
+static void _change(queue_t *q)
+{
+	job_record_t *job_ptr;
+	int i;
+
+	for (i = 0; i < q->job_cnt; i++) {
+		switch (random() % CHANGE_INTERVAL) {
+		case 0:
+			_submit(q, i);
+			break;
+		case 1:
+			job_ptr = &q->jobs[i];
+			job_ptr->priority += random() % 1000;
+			if (job_ptr->priority_array)
+				job_ptr->priority_array[0] += random() % 1000;
+			break;
+		}
+	}
+	_build(q);
+}
+
+/* RET count of records out of order or not sorted exactly once */
+static int _check(queue_t *q, job_queue_rec_t **sorted)
+{
+	char *seen = xcalloc(q->rec_cnt, 1);
+	int i, bad = 0;
+
+	for (i = 0; i < q->rec_cnt; i++) {
+		int inx = sorted[i] - q->recs;
+
+		if ((inx < 0) || (inx >= q->rec_cnt) || seen[inx]++)
+			bad++;
+		if ((i > 0) && (_ref_sort(&sorted[i - 1], &sorted[i]) > 0))
+			bad++;
+	}
+	xfree(seen);
+
+	return bad;
+}
+
+static double _time_list_sort(queue_t *q)
+{
+	List job_queue = list_create(NULL);
+	struct timespec start, end;
+	int i;
+
+	for (i = 0; i < q->rec_cnt; i++)
+		list_append(job_queue, &q->recs[i]);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	list_sort(job_queue, _ref_sort);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	FREE_NULL_LIST(job_queue);
+
+	return _usec(&start, &end);
+}
+
+static double _time_sort(queue_t *q, job_queue_rec_t **sorted)
+{
+	struct timespec start, end;
+	int i;
+
+	for (i = 0; i < q->rec_cnt; i++)
+		sorted[i] = &q->recs[i];
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	job_queue_sort_recs(sorted, q->rec_cnt);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return _usec(&start, &end);
+}
+
+static void _run(int job_cnt)
+{
+	queue_t q = { 0 };
+	job_queue_rec_t **sorted;
+	double list_usec, cold_usec, warm_usec;
+	char msg[128];
+	int i;
+
+	q.jobs = xcalloc(job_cnt, sizeof(job_record_t));
+	q.details = xcalloc(job_cnt, sizeof(struct job_details));
+	q.recs = xcalloc(job_cnt * 2, sizeof(job_queue_rec_t));
+	sorted = xcalloc(job_cnt * 2, sizeof(job_queue_rec_t *));
+	q.job_cnt = job_cnt;
+	q.next_job_id = 1;
+	for (i = 0; i < job_cnt; i++)
+		_submit(&q, i);
+	_build(&q);
+
+	list_usec = _time_list_sort(&q);
+	cold_usec = _time_sort(&q, sorted);
+	snprintf(msg, sizeof(msg), "%d jobs: first sort order", job_cnt);
+	TEST(_check(&q, sorted), msg);
+
+	_change(&q);
+	warm_usec = _time_sort(&q, sorted);
+	snprintf(msg, sizeof(msg), "%d jobs: next pass sort order", job_cnt);
+	TEST(_check(&q, sorted), msg);
+
+	printf("%7d jobs, %7d records: list_sort %.0f usec, "
+	       "first sort %.0f usec, next pass %.0f usec\n", job_cnt,
+	       q.rec_cnt, list_usec, cold_usec, warm_usec);
+
+	for (i = 0; i < job_cnt; i++)
+		xfree(q.jobs[i].priority_array);
+	xfree(q.jobs);
+	xfree(q.details);
+	xfree(q.recs);
+	xfree(sorted);
+}
+
+int main(int argc, char *argv[])
+{
+	int i;
+
+	for (i = 0; i < PART_COUNT; i++)
+		parts[i].priority_tier = i % 2;
+
+	srandom(1);
+	if (argc > 1) {
+		for (i = 1; i < argc; i++) {
+			if (atoi(argv[i]) <= 0) {
+				fprintf(stderr, "Usage: %s [job_count ...]\n",
+					argv[0]);
+				return 1;
+			}
+			_run(atoi(argv[i]));
+		}
+	} else {
+		_run(JOB_COUNT);
+	}
+
+	totals();
+	return failed;
+}
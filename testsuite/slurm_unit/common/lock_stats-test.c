@@ -0,0 +1,190 @@
+/*
+ * lock_stats-test - check the slurmctld lock statistics recorded for threads
+ *	contending for the job write lock and report the cost of recording on
+ *	uncontended lock_slurmctld() and unlock_slurmctld() calls
+ *
+ * Usage: lock_stats-test [iterations]
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/common/read_config.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/locks.h"
+
+#include <testsuite/dejagnu.h>
+
+#define ITERATIONS	1000000
+#define THREAD_COUNT	4
+#define LOCKS_PER_THREAD	50
+#define HOLD_USEC	200
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+static void *_writer(void *arg)
+{
+	slurmctld_lock_t job_write_lock = { .job = WRITE_LOCK };
+
+	for (int i = 0; i < LOCKS_PER_THREAD; i++) {
+		lock_slurmctld(job_write_lock);
+		usleep(HOLD_USEC);
+		unlock_slurmctld(job_write_lock);
+	}
+
+	return NULL;
+}
+
+static void _reader(void)
+{
+	slurmctld_lock_t read_lock = { .conf = READ_LOCK, .node = READ_LOCK };
+
+	lock_slurmctld(read_lock);
+	unlock_slurmctld(read_lock);
+}
+
+static uint32_t _hist_sum(uint32_t *cnt)
+{
+	uint32_t sum = 0;
+
+	for (int i = 0; i < LOCK_STATS_BUCKETS; i++)
+		sum += cnt[i];
+
+	return sum;
+}
+
+/* Check the statistics recorded by _writer() threads and _reader() */
+static void _check(void)
+{
+	lock_stats_t *stats = NULL;
+	uint32_t bucket_usec[LOCK_STATS_BUCKETS];
+	uint32_t cnt = lock_stats_get(&stats, bucket_usec);
+	int writer = -1, reader_conf = -1, reader_node = -1;
+	int bad = 0;
+
+	for (int i = 0; i < cnt; i++) {
+		if (!xstrcmp(stats[i].caller, "_writer") &&
+		    (stats[i].type == JOB_LOCK) &&
+		    (stats[i].level == WRITE_LOCK))
+			writer = i;
+		else if (!xstrcmp(stats[i].caller, "_reader") &&
+			 (stats[i].type == CONF_LOCK) &&
+			 (stats[i].level == READ_LOCK))
+			reader_conf = i;
+		else if (!xstrcmp(stats[i].caller, "_reader") &&
+			 (stats[i].type == NODE_LOCK) &&
+			 (stats[i].level == READ_LOCK))
+			reader_node = i;
+		else
+			bad++;
+		if ((i > 0) && (stats[i - 1].wait_usec < stats[i].wait_usec))
+			bad++;
+	}
+	TEST(bad || (cnt != 3) || (writer < 0) || (reader_conf < 0) ||
+	     (reader_node < 0), "one record per caller, lock and mode");
+	if (writer < 0) {
+		lock_stats_free(stats, cnt);
+		return;
+	}
+
+	TEST((stats[writer].cnt != (THREAD_COUNT * LOCKS_PER_THREAD)) ||
+	     (_hist_sum(stats[writer].wait_cnt) != stats[writer].cnt) ||
+	     (_hist_sum(stats[writer].hold_cnt) != stats[writer].cnt),
+	     "writer lock count and histograms");
+	TEST((stats[writer].hold_usec <
+	      ((uint64_t) stats[writer].cnt * HOLD_USEC)),
+	     "writer hold time covers its sleep");
+	/* Each writer waits for the others most of the time */
+	TEST((stats[writer].wait_usec <
+	      ((uint64_t) stats[writer].cnt * HOLD_USEC)),
+	     "writer wait time shows contention");
+	TEST((bucket_usec[LOCK_STATS_BUCKETS - 1] != NO_VAL),
+	     "last histogram bucket has no limit");
+
+	printf("_writer job write: count:%u ave_wait:%"PRIu64" "
+	       "ave_hold:%"PRIu64" usec\n", stats[writer].cnt,
+	       stats[writer].wait_usec / stats[writer].cnt,
+	       stats[writer].hold_usec / stats[writer].cnt);
+	lock_stats_free(stats, cnt);
+}
+
+static double _time_uncontended(int iterations)
+{
+	slurmctld_lock_t lock = { .job = READ_LOCK, .node = WRITE_LOCK };
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < iterations; i++) {
+		lock_slurmctld(lock);
+		unlock_slurmctld(lock);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (_usec(&start, &end) * 1000) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t threads[THREAD_COUNT];
+	lock_stats_t *stats = NULL;
+	uint32_t bucket_usec[LOCK_STATS_BUCKETS], cnt;
+	double off_nsec, on_nsec;
+	int iterations = ITERATIONS;
+
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+	if (iterations <= 0) {
+		fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	/* Nothing is recorded until enabled */
+	_reader();
+	cnt = lock_stats_get(&stats, bucket_usec);
+	TEST(cnt, "nothing recorded when disabled");
+	lock_stats_free(stats, cnt);
+
+	slurm_conf.slurmctld_params = xstrdup("lock_stats");
+	lock_stats_config();
+
+	for (int i = 0; i < THREAD_COUNT; i++)
+		pthread_create(&threads[i], NULL, _writer, NULL);
+	for (int i = 0; i < THREAD_COUNT; i++)
+		pthread_join(threads[i], NULL);
+	_reader();
+	_check();
+
+	lock_stats_reset();
+	cnt = lock_stats_get(&stats, bucket_usec);
+	TEST(cnt, "nothing left after reset");
+	lock_stats_free(stats, cnt);
+
+	on_nsec = _time_uncontended(iterations);
+	xfree(slurm_conf.slurmctld_params);
+	lock_stats_config();
+	off_nsec = _time_uncontended(iterations);
+	printf("uncontended lock and unlock: %.0f nsec, %.0f nsec with "
+	       "lock_stats\n", off_nsec, on_nsec);
+
+	totals();
+	return failed;
+}
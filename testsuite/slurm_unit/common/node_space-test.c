@@ -0,0 +1,356 @@
+/*
+ * node_space-test - replay a queue of backfill reservations against the
+ *	backfill node_space map and the linked array it replaced, checking that
+ *	both give the same availability and reporting the time taken by each
+ *
+ * Usage: node_space-test [node_count | queue_file]
+ *
+ * The queue file's first line holds the node count and the window length in
+ * seconds. Each following line holds one job, in scheduling order, as
+ * "<start> <end> <nodes>" where start and end are seconds into the window and
+ * nodes is the node index list the job uses (e.g. "0-15,32"). Without a file
+ * a queue of one running job per node followed by half as many pending jobs
+ * is generated for node_count nodes (default NODE_COUNT). Use a node count of
+ * 4000 or more to time the two at the scale of a large cluster.
+ *
+ * For each job the earliest time at which at least as many nodes as it uses
+ * are free is looked up first, as backfill does before testing a job, then
+ * the job's nodes are reserved.
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/plugins/sched/backfill/node_space.h"
+
+#include <testsuite/dejagnu.h>
+
+#define NODE_COUNT	400
+#define WINDOW		(7 * 24 * 60 * 60)
+#define BEGIN_TIME	1000000000
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+typedef struct {
+	time_t start;
+	time_t end;
+	bitstr_t *nodes;
+	int node_cnt;
+	time_t earliest;	/* result of the lookup before reserving */
+} job_t;
+
+/* The linked array used by backfill before node_space.c */
+typedef struct {
+	time_t begin_time;
+	time_t end_time;
+	bitstr_t *avail_bitmap;
+	int next;
+} array_rec_t;
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+static void _array_add(time_t start_time, time_t end_reserve,
+		       bitstr_t *res_bitmap, array_rec_t *node_space,
+		       int *node_space_recs)
+{
+	bool placed = false;
+	int i, j;
+
+	start_time = MAX(start_time, node_space[0].begin_time);
+	for (j = 0; ; ) {
+		if (node_space[j].end_time > start_time) {
+			i = *node_space_recs;
+			node_space[i].begin_time = start_time;
+			node_space[i].end_time = node_space[j].end_time;
+			node_space[j].end_time = start_time;
+			node_space[i].avail_bitmap =
+				bit_copy(node_space[j].avail_bitmap);
+			node_space[i].next = node_space[j].next;
+			node_space[j].next = i;
+			(*node_space_recs)++;
+			placed = true;
+		}
+		if (node_space[j].end_time == start_time)
+			placed = true;
+		if (placed == true) {
+			while ((j = node_space[j].next)) {
+				if (end_reserve < node_space[j].end_time) {
+					i = *node_space_recs;
+					node_space[i].begin_time = end_reserve;
+					node_space[i].end_time =
+						node_space[j].end_time;
+					node_space[j].end_time = end_reserve;
+					node_space[i].avail_bitmap =
+						bit_copy(node_space[j].
+							 avail_bitmap);
+					node_space[i].next = node_space[j].next;
+					node_space[j].next = i;
+					(*node_space_recs)++;
+					break;
+				}
+				if (end_reserve == node_space[j].end_time)
+					break;
+			}
+			break;
+		}
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+
+	for (j = 0; ; ) {
+		if ((node_space[j].begin_time >= start_time) &&
+		    (node_space[j].end_time <= end_reserve))
+			bit_and(node_space[j].avail_bitmap, res_bitmap);
+		if ((node_space[j].begin_time >= end_reserve) ||
+		    ((j = node_space[j].next) == 0))
+			break;
+	}
+
+	for (i = 0; ; ) {
+		if ((j = node_space[i].next) == 0)
+			break;
+		if (!bit_equal(node_space[i].avail_bitmap,
+			       node_space[j].avail_bitmap)) {
+			i = j;
+			continue;
+		}
+		node_space[i].end_time = node_space[j].end_time;
+		node_space[i].next = node_space[j].next;
+		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
+		break;
+	}
+}
+
+static time_t _array_earliest(array_rec_t *node_space, time_t when,
+			      int node_cnt)
+{
+	int j;
+
+	for (j = 0; ; ) {
+		if ((node_space[j].end_time > when) &&
+		    (bit_set_count(node_space[j].avail_bitmap) >= node_cnt))
+			return MAX(when, node_space[j].begin_time);
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+
+	return 0;
+}
+
+static bitstr_t *_array_at(array_rec_t *node_space, time_t when)
+{
+	int j;
+
+	for (j = 0; ; ) {
+		if ((node_space[j].begin_time <= when) &&
+		    (node_space[j].end_time > when))
+			return node_space[j].avail_bitmap;
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+
+	return NULL;
+}
+
+static job_t *_gen_queue(int gen_nodes, int *job_cnt, int *node_cnt,
+			 time_t *window)
+{
+	int running_jobs = gen_nodes, pending_jobs = gen_nodes / 2;
+	job_t *jobs = xcalloc(running_jobs + pending_jobs, sizeof(*jobs));
+	int i, first, cnt;
+
+	*job_cnt = running_jobs + pending_jobs;
+	*node_cnt = gen_nodes;
+	*window = WINDOW;
+
+	srandom(1);
+	for (i = 0; i < *job_cnt; i++) {
+		cnt = 1 + (random() % 32);
+		first = random() % (gen_nodes - cnt);
+		jobs[i].nodes = bit_alloc(gen_nodes);
+		bit_nset(jobs[i].nodes, first, first + cnt - 1);
+		if (i < running_jobs) {
+			jobs[i].start = 0;
+			jobs[i].end = 60 * (1 + (random() % (WINDOW / 120)));
+		} else {
+			jobs[i].start = 60 * (random() % (WINDOW / 60));
+			jobs[i].end = jobs[i].start +
+				      60 * (1 + (random() % (24 * 60)));
+		}
+	}
+
+	return jobs;
+}
+
+static job_t *_read_queue(char *file, int *job_cnt, int *node_cnt,
+			  time_t *window)
+{
+	FILE *fp = fopen(file, "r");
+	job_t *jobs = NULL;
+	char nodes[4096];
+	long start, end, win;
+	int alloc = 0;
+
+	*job_cnt = 0;
+	if (!fp) {
+		perror(file);
+		return NULL;
+	}
+	if (fscanf(fp, "%d %ld", node_cnt, &win) != 2) {
+		fprintf(stderr, "%s: missing node count and window\n", file);
+		fclose(fp);
+		return NULL;
+	}
+	*window = win;
+
+	while (fscanf(fp, "%ld %ld %4095s", &start, &end, nodes) == 3) {
+		if (*job_cnt >= alloc) {
+			alloc = alloc ? alloc * 2 : 1024;
+			xrecalloc(jobs, alloc, sizeof(*jobs));
+		}
+		jobs[*job_cnt].start = start;
+		jobs[*job_cnt].end = end;
+		jobs[*job_cnt].nodes = bit_alloc(*node_cnt);
+		if (bit_unfmt(jobs[*job_cnt].nodes, nodes)) {
+			fprintf(stderr, "%s: bad node list %s\n", file, nodes);
+			bit_free(jobs[*job_cnt].nodes);
+			continue;
+		}
+		(*job_cnt)++;
+	}
+	fclose(fp);
+
+	return jobs;
+}
+
+int main(int argc, char *argv[])
+{
+	node_space_map_t *map;
+	node_space_rec_t *ns;
+	array_rec_t *array;
+	job_t *jobs;
+	bitstr_t *all;
+	struct timespec start, end;
+	double array_usec, map_usec;
+	time_t window;
+	int job_cnt, node_cnt, array_recs, i, bad = 0;
+	char msg[128];
+
+	if ((argc > 1) && (argv[1][strspn(argv[1], "0123456789")] != '\0'))
+		jobs = _read_queue(argv[1], &job_cnt, &node_cnt, &window);
+	else if ((argc > 1) && (atoi(argv[1]) <= 32))
+		jobs = NULL;	/* generated jobs use up to 32 nodes */
+	else
+		jobs = _gen_queue((argc > 1) ? atoi(argv[1]) : NODE_COUNT,
+				  &job_cnt, &node_cnt, &window);
+	if (!jobs || !job_cnt) {
+		fprintf(stderr, "Usage: %s [node_count | queue_file]\n",
+			argv[0]);
+		return 1;
+	}
+	for (i = 0; i < job_cnt; i++) {
+		jobs[i].start += BEGIN_TIME;
+		jobs[i].end += BEGIN_TIME;
+		jobs[i].node_cnt = bit_set_count(jobs[i].nodes);
+		bit_not(jobs[i].nodes);		/* nodes left available */
+	}
+	all = bit_alloc(node_cnt);
+	bit_set_all(all);
+
+	/* Replay against the linked array */
+	array = xcalloc((2 * job_cnt) + 1, sizeof(*array));
+	array[0].begin_time = BEGIN_TIME;
+	array[0].end_time = BEGIN_TIME + window;
+	array[0].avail_bitmap = bit_copy(all);
+	array_recs = 1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < job_cnt; i++) {
+		jobs[i].earliest = _array_earliest(array, jobs[i].start,
+						   jobs[i].node_cnt);
+		_array_add(jobs[i].start, jobs[i].end, jobs[i].nodes, array,
+			   &array_recs);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	array_usec = _usec(&start, &end);
+
+	/* Replay against the map */
+	map = node_space_create(BEGIN_TIME, BEGIN_TIME + window,
+				bit_copy(all));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < job_cnt; i++) {
+		time_t earliest = 0;
+
+		if ((ns = node_space_first_fit(map, jobs[i].start,
+					       jobs[i].node_cnt)))
+			earliest = MAX(jobs[i].start, ns->begin_time);
+		if (earliest != jobs[i].earliest)
+			bad++;
+		node_space_add_resv(map, jobs[i].start, jobs[i].end,
+				    jobs[i].nodes);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	map_usec = _usec(&start, &end);
+
+	printf("%d jobs, %d nodes, %ld sec window\n", job_cnt, node_cnt,
+	       (long) window);
+	for (i = 0, array_recs = 1; (i = array[i].next); array_recs++)
+		;
+	printf("array: %d records, %.0f usec\n", array_recs, array_usec);
+	printf("map:   %d records, %.0f usec\n", map->rec_cnt, map_usec);
+
+	snprintf(msg, sizeof(msg), "earliest start matches for %d jobs",
+		 job_cnt);
+	TEST(bad, msg);
+
+	/* Compare availability at every record boundary of both */
+	bad = 0;
+	for (ns = map->head; ns; ns = ns->next) {
+		if (!bit_equal(ns->avail_bitmap,
+			       _array_at(array, ns->begin_time)))
+			bad++;
+		if (bit_set_count(ns->avail_bitmap) != ns->avail_cnt)
+			bad++;
+		if (ns->next && ((ns->end_time != ns->next->begin_time) ||
+				 (ns->next->prev != ns)))
+			bad++;
+	}
+	for (i = 0; ; ) {
+		/* The array can leave empty records at a reservation start */
+		if ((array[i].begin_time != array[i].end_time) &&
+		    (!(ns = node_space_find(map, array[i].begin_time)) ||
+		     !bit_equal(ns->avail_bitmap, array[i].avail_bitmap)))
+			bad++;
+		if ((i = array[i].next) == 0)
+			break;
+	}
+	TEST(bad, "availability matches at every record boundary");
+
+	node_space_destroy(map);
+	for (i = 0; i < (2 * job_cnt) + 1; i++)
+		FREE_NULL_BITMAP(array[i].avail_bitmap);
+	xfree(array);
+	for (i = 0; i < job_cnt; i++)
+		bit_free(jobs[i].nodes);
+	xfree(jobs);
+	bit_free(all);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,281 @@
+/*
+ * slab-test - check slab pool allocation and compare heap use against
+ *	xmalloc() for a stream of job records being submitted and purged
+ *
+ * Usage: slab-test [job_count [live_jobs]]
+ *
+ * The defaults are a quick check. Run "slab-test 1000000 10000" to compare
+ * the allocators at the scale of a busy controller.
+ *
+ * Each job allocates a job record, job details and one step record, sized as
+ * in slurmctld. Jobs are purged oldest first once live_jobs are held, except
+ * that one job in LONG_RUNNING_INTERVAL is kept until the end, as long
+ * running jobs are in a real controller. Each allocator is run in its own
+ * process so heap state from one does not affect the other.
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/common/slab.h"
+#include "src/common/xmalloc.h"
+
+#include <testsuite/dejagnu.h>
+
+extern pid_t waitpid(pid_t pid, int *status, int options);
+
+#define JOB_COUNT		20000
+#define LIVE_JOBS		1000
+#define LONG_RUNNING_INTERVAL	100
+
+#define JOB_RECORD_SIZE		1040
+#define JOB_DETAILS_SIZE	456
+#define STEP_RECORD_SIZE	392
+
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+typedef struct {
+	uint32_t *job;
+	uint32_t *details;
+	uint32_t *step;
+} job_t;
+
+static slab_pool_t *job_pool, *details_pool, *step_pool;
+
+static void *_alloc(slab_pool_t *pool, size_t size)
+{
+	if (pool)
+		return slab_alloc(pool);
+	return xmalloc(size);
+}
+
+static void _free(slab_pool_t *pool, void *obj)
+{
+	if (pool)
+		slab_free(pool, obj);
+	else
+		xfree(obj);
+}
+
+static long _rss_kb(void)
+{
+	long pages = 0;
+	FILE *fp = fopen("/proc/self/statm", "r");
+
+	if (!fp)
+		return 0;
+	if (fscanf(fp, "%*s %ld", &pages) != 1)
+		pages = 0;
+	fclose(fp);
+
+	return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static double _usec(struct timespec *start, struct timespec *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e6) +
+	       ((end->tv_nsec - start->tv_nsec) / 1e3);
+}
+
+static bool _create(job_t *job, uint32_t id, bool slab)
+{
+	job->job = _alloc(slab ? job_pool : NULL, JOB_RECORD_SIZE);
+	job->details = _alloc(slab ? details_pool : NULL, JOB_DETAILS_SIZE);
+	job->step = _alloc(slab ? step_pool : NULL, STEP_RECORD_SIZE);
+
+	if (job->job[0] || job->details[0] || job->step[0])
+		return false;	/* not zeroed */
+
+	job->job[0] = job->details[0] = job->step[0] = id;
+	job->job[(JOB_RECORD_SIZE / sizeof(uint32_t)) - 1] = id;
+	return true;
+}
+
+static bool _purge(job_t *job, uint32_t id, bool slab)
+{
+	bool ok = ((job->job[0] == id) && (job->details[0] == id) &&
+		   (job->step[0] == id) &&
+		   (job->job[(JOB_RECORD_SIZE / sizeof(uint32_t)) - 1] == id));
+
+	_free(slab ? step_pool : NULL, job->step);
+	_free(slab ? details_pool : NULL, job->details);
+	_free(slab ? job_pool : NULL, job->job);
+	memset(job, 0, sizeof(*job));
+
+	return ok;
+}
+
+/* RET 0 on success, 1 on corrupt or unzeroed records */
+static int _run(char *name, bool slab, uint32_t job_cnt, uint32_t live_cnt)
+{
+	job_t *live = xcalloc(live_cnt, sizeof(*live));
+	job_t *kept = xcalloc((job_cnt / LONG_RUNNING_INTERVAL) + 1,
+			      sizeof(*kept));
+	uint32_t *kept_id = xcalloc((job_cnt / LONG_RUNNING_INTERVAL) + 1,
+				    sizeof(*kept_id));
+	uint32_t *live_id = xcalloc(live_cnt, sizeof(*live_id));
+	uint32_t kept_cnt = 0, slot, i;
+	long rss_start, rss_peak, rss_end;
+	struct timespec start, end;
+	int rc = 0;
+
+	if (slab) {
+		job_pool = slab_pool_create("job_record", JOB_RECORD_SIZE);
+		details_pool = slab_pool_create("job_details",
+						JOB_DETAILS_SIZE);
+		step_pool = slab_pool_create("step_record", STEP_RECORD_SIZE);
+	}
+
+	rss_start = _rss_kb();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < job_cnt; i++) {
+		slot = i % live_cnt;
+		if (live[slot].job) {
+			if ((live_id[slot] % LONG_RUNNING_INTERVAL) == 0) {
+				kept[kept_cnt] = live[slot];
+				kept_id[kept_cnt++] = live_id[slot];
+			} else if (!_purge(&live[slot], live_id[slot], slab)) {
+				rc = 1;
+			}
+		}
+		if (!_create(&live[slot], i, slab))
+			rc = 1;
+		live_id[slot] = i;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	rss_peak = _rss_kb();
+
+	for (i = 0; i < live_cnt; i++) {
+		if (live[i].job && !_purge(&live[i], live_id[i], slab))
+			rc = 1;
+	}
+	for (i = 0; i < kept_cnt; i++) {
+		if (!_purge(&kept[i], kept_id[i], slab))
+			rc = 1;
+	}
+	rss_end = _rss_kb();
+
+	printf("%-6s: %u jobs, %u live, %u long running, %.0f nsec per job, "
+	       "RSS growth %ld KB peak, %ld KB after purge\n",
+	       name, job_cnt, live_cnt, kept_cnt,
+	       (_usec(&start, &end) * 1000) / job_cnt,
+	       (rss_peak - rss_start), (rss_end - rss_start));
+
+	if (slab) {
+		slab_stats_t *stats;
+		uint32_t cnt = slab_get_stats(&stats);
+
+		for (i = 0; i < cnt; i++) {
+			printf("\t%-12s size:%u per_slab:%u slabs:%u "
+			       "in_use:%u allocs:%"PRIu64" frees:%"PRIu64"\n",
+			       stats[i].name, stats[i].obj_size,
+			       stats[i].objs_per_slab, stats[i].slabs,
+			       stats[i].in_use, stats[i].allocs,
+			       stats[i].frees);
+			if (stats[i].in_use || (stats[i].allocs != job_cnt) ||
+			    (stats[i].frees != job_cnt) || (stats[i].slabs > 1))
+				rc = 1;
+		}
+		if (cnt != 3)
+			rc = 1;
+		slab_free_stats(stats, cnt);
+
+		slab_pool_destroy(job_pool);
+		slab_pool_destroy(details_pool);
+		slab_pool_destroy(step_pool);
+	} else {
+		printf("\theap allocations: %u\n", job_cnt * 3);
+	}
+
+	xfree(live);
+	xfree(live_id);
+	xfree(kept);
+	xfree(kept_id);
+
+	return rc;
+}
+
+static void _fork_run(char *name, bool slab, uint32_t job_cnt,
+		      uint32_t live_cnt)
+{
+	char msg[128];
+	int status = -1;
+	pid_t pid;
+
+	fflush(stdout);
+	if ((pid = fork()) == 0) {
+		int rc = _run(name, slab, job_cnt, live_cnt);
+		fflush(stdout);
+		_exit(rc);
+	}
+	if (pid > 0)
+		(void) waitpid(pid, &status, 0);
+
+	snprintf(msg, sizeof(msg), "%s: records intact and released", name);
+	TEST(status != 0, msg);
+}
+
+static void _test_reuse(void)
+{
+	slab_pool_t *pool = slab_pool_create("reuse", 24);
+	void *objs[1000];
+	slab_stats_t *stats;
+	uint32_t cnt;
+	int i;
+
+	for (i = 0; i < 1000; i++)
+		objs[i] = slab_alloc(pool);
+	for (i = 0; i < 1000; i += 2)
+		slab_free(pool, objs[i]);
+	for (i = 0; i < 1000; i += 2)
+		objs[i] = slab_alloc(pool);
+
+	cnt = slab_get_stats(&stats);
+	TEST((cnt != 1) || (stats[0].in_use != 1000) ||
+	     (stats[0].allocs != 1500) || (stats[0].frees != 500),
+	     "reuse: allocation counts");
+	/* 1000 objects of 48 bytes with header fit in one 64KB block */
+	TEST(stats[0].slabs != 1, "reuse: freed objects reused");
+	slab_free_stats(stats, cnt);
+
+	for (i = 0; i < 1000; i++)
+		slab_free(pool, objs[i]);
+	slab_free(pool, NULL);
+	slab_pool_destroy(pool);
+
+	cnt = slab_get_stats(&stats);
+	TEST(cnt != 0, "reuse: pool destroyed");
+	slab_free_stats(stats, cnt);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t job_cnt = JOB_COUNT, live_cnt = LIVE_JOBS;
+
+	if (argc > 1)
+		job_cnt = atoi(argv[1]);
+	if (argc > 2)
+		live_cnt = atoi(argv[2]);
+	if (!job_cnt || !live_cnt) {
+		fprintf(stderr, "Usage: %s [job_count [live_jobs]]\n", argv[0]);
+		return 1;
+	}
+
+	_test_reuse();
+	_fork_run("xmalloc", false, job_cnt, live_cnt);
+	_fork_run("slab", true, job_cnt, live_cnt);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,126 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "src/common/list.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/common/slurm_protocol_common.h"
+
+START_TEST(pack_empty_list)
+{
+	int rc;
+	buf_t *buf = init_buf(1024);
+
+	slurm_msg_t msg = {0};
+	List pack_list = list_create(slurm_destroy_submit_response_object);
+
+	msg.msg_type         = RESPONSE_SUBMIT_BATCH_JOB_LIST;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	msg.data             = pack_list;
+
+	rc = pack_msg(&msg, buf);
+	ck_assert_int_eq(rc, SLURM_SUCCESS);
+
+	set_buf_offset(buf, 0);
+
+	msg.data = NULL;
+	rc = unpack_msg(&msg, buf);
+	ck_assert_int_eq(rc, SLURM_SUCCESS);
+	ck_assert(!msg.data);
+
+	free_buf(buf);
+	FREE_NULL_LIST(pack_list);
+}
+END_TEST
+
+START_TEST(pack_list)
+{
+	int rc;
+	buf_t *buf = init_buf(1024);
+
+	slurm_msg_t msg = {0};
+	List pack_list = list_create(slurm_destroy_submit_response_object);
+	submit_response_msg_t *pack_resp, *unpack_resp;
+	ListIterator pack_iter, unpack_iter;
+
+	/* An accepted job followed by a rejected one */
+	pack_resp = xmalloc(sizeof(submit_response_msg_t));
+	pack_resp->job_id = 12345;
+	pack_resp->step_id = SLURM_BATCH_SCRIPT;
+	list_append(pack_list, pack_resp);
+	pack_resp = xmalloc(sizeof(submit_response_msg_t));
+	pack_resp->step_id = SLURM_BATCH_SCRIPT;
+	pack_resp->error_code = ESLURM_INVALID_PARTITION_NAME;
+	pack_resp->job_submit_user_msg = xstrdup("blah");
+	list_append(pack_list, pack_resp);
+
+	msg.msg_type         = RESPONSE_SUBMIT_BATCH_JOB_LIST;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	msg.data             = pack_list;
+
+	rc = pack_msg(&msg, buf);
+	ck_assert_int_eq(rc, SLURM_SUCCESS);
+
+	set_buf_offset(buf, 0);
+
+	msg.data = NULL;
+	rc = unpack_msg(&msg, buf);
+	ck_assert_int_eq(rc, SLURM_SUCCESS);
+	ck_assert(msg.data);
+	ck_assert_int_eq(list_count(msg.data), list_count(pack_list));
+
+	pack_iter = list_iterator_create(pack_list);
+	unpack_iter = list_iterator_create(msg.data);
+	while ((pack_resp = list_next(pack_iter))) {
+		unpack_resp = list_next(unpack_iter);
+		ck_assert(unpack_resp);
+		ck_assert_uint_eq(unpack_resp->job_id, pack_resp->job_id);
+		ck_assert_uint_eq(unpack_resp->step_id, pack_resp->step_id);
+		ck_assert_uint_eq(unpack_resp->error_code,
+				  pack_resp->error_code);
+		if (pack_resp->job_submit_user_msg)
+			ck_assert_str_eq(unpack_resp->job_submit_user_msg,
+					 pack_resp->job_submit_user_msg);
+		else
+			ck_assert(!unpack_resp->job_submit_user_msg);
+	}
+	list_iterator_destroy(pack_iter);
+	list_iterator_destroy(unpack_iter);
+
+	free_buf(buf);
+	FREE_NULL_LIST(pack_list);
+	slurm_free_msg_data(msg.msg_type, msg.data);
+}
+END_TEST
+
+/*****************************************************************************
+ * TEST SUITE                                                                *
+ ****************************************************************************/
+
+Suite *suite(void)
+{
+	Suite *s = suite_create("Pack submit_response_msg_t list");
+	TCase *tc_core = tcase_create("Pack submit_response_msg_t list");
+	tcase_add_test(tc_core, pack_empty_list);
+	tcase_add_test(tc_core, pack_list);
+	suite_add_tcase(s, tc_core);
+	return s;
+}
+
+/*****************************************************************************
+ * TEST RUNNER                                                               *
+ ****************************************************************************/
+
+int main(void)
+{
+	int number_failed;
+	SRunner *sr = srunner_create(suite());
+
+	srunner_run_all(sr, CK_VERBOSE);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}